@@ -38,6 +38,8 @@ class IDATA
 		uint16_t SMOI_DATA[MAX_DEVICES]	=	{ 0 };
 
 		float BATT_DATA[MAX_DEVICES]	=	{ 0 };
+
+		uint8_t PRED_FLAGS[MAX_DEVICES]	=	{ 0 };	// Bit per metric (TEMP = bit 0) filled in by the predictor
 };
 
 #endif
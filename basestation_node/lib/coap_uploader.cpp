@@ -0,0 +1,148 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#include "system_node.hpp"
+
+void COAP_UPLOADER_class::Initialize()
+{
+	_udp.begin(COAP_LOCAL_PORT);
+	_messageId = random(0x10000);
+}
+
+void COAP_UPLOADER_class::sendRound(IDATA &IData, time_t timestamp)
+{
+	ROUND_HEADER header = { ROUND_RECORD_VERSION, 0, (uint32_t)timestamp };
+	uint8_t length = 0;
+
+	// Rounds are an hour apart, one still waiting for its ACK by now isn't coming back
+	if (_pending)
+	{
+		#ifdef DEBUGGING
+			Serial.println(F("X: Collector Never Acknowledged Last Round!"));
+		#endif
+	}
+
+	_messageId++;
+
+	// Version, type and token length, then code and message ID in network order
+	_packet[length++] = (COAP_VERSION << 6) | (COAP_TYPE_CON << 4) | COAP_TOKEN_LEN;
+	_packet[length++] = COAP_POST;
+	_packet[length++] = _messageId >> 8;
+	_packet[length++] = _messageId & 0xFF;
+
+	// Only one exchange is ever in flight, the message ID doubles as the token
+	_packet[length++] = _messageId >> 8;
+	_packet[length++] = _messageId & 0xFF;
+
+	_packet[length++] = (COAP_OPTION_URI_PATH << 4) | (sizeof(COAP_URI_PATH) - 1);
+	memcpy(&_packet[length], COAP_URI_PATH, sizeof(COAP_URI_PATH) - 1);
+	length += sizeof(COAP_URI_PATH) - 1;
+	_packet[length++] = COAP_PAYLOAD_MARKER;
+
+	// Header goes in once the entries are counted
+	uint8_t headerAt = length;
+	length += sizeof(header);
+
+	for (uint8_t i = 0; i < MAX_DEVICES; i++)
+	{
+		if (config::ACTIVE_DEVICES[i] != ACTIVE) continue;
+
+		ROUND_ENTRY entry;
+		entry.hwid = i;
+		entry.flags = IData.PRED_FLAGS[i];
+		entry.temperature = lroundf(IData.TEMP_DATA[i] * 100);
+		entry.humidity = lroundf(IData.HUMI_DATA[i] * 100);
+		entry.soilTemperature = lroundf(IData.STMP_DATA[i] * 100);
+		entry.soilMoisture = IData.SMOI_DATA[i];
+		entry.battery = lroundf(IData.BATT_DATA[i] * 1000);
+
+		memcpy(&_packet[length], &entry, sizeof(entry));
+		length += sizeof(entry);
+		header.count++;
+	}
+
+	memcpy(&_packet[headerAt], &header, sizeof(header));
+	_packetLength = length;
+
+	_pending = true;
+	_retransmits = 0;
+	_timeout = COAP_ACK_TIMEOUT + random(COAP_ACK_TIMEOUT * (COAP_ACK_RANDOM - 1000L) / 1000);
+	_firstSentAt = millis();
+	transmit();
+
+	#ifdef DEBUGGING
+		Serial.print(F("Round Record Sent: "));
+		Serial.print(_packetLength);
+		Serial.println(F(" bytes"));
+	#endif
+}
+
+void COAP_UPLOADER_class::Run()
+{
+	if (_udp.parsePacket() >= 4)
+	{
+		uint8_t reply[4];
+		_udp.read(reply, sizeof(reply));
+
+		uint8_t type = (reply[0] >> 4) & 0x03;
+		uint16_t messageId = reply[2] << 8 | reply[3];
+
+		// ACK or RST for the round in flight, anything else is stale
+		if (_pending && messageId == _messageId && (type == COAP_TYPE_ACK || type == COAP_TYPE_RST))
+		{
+			_pending = false;
+
+			#ifdef DEBUGGING
+				bool accepted = type == COAP_TYPE_ACK && (reply[1] >> 5) == 2;
+				Serial.print(accepted ? F("Round Record Acknowledged | RTT ") : F("X: Round Record Refused | RTT "));
+				Serial.print(millis() - _firstSentAt);
+				Serial.println(F(" ms"));
+			#endif
+		}
+		_udp.flush();
+	}
+
+	if (!_pending || millis() - _sentAt < _timeout) return;
+
+	if (_retransmits >= COAP_MAX_RETRANSMIT)
+	{
+		_pending = false;
+
+		#ifdef DEBUGGING
+			Serial.println(F("X: Collector Unreachable, Round Record Dropped!"));
+		#endif
+
+		return;
+	}
+
+	_retransmits++;
+	_timeout *= 2;
+	transmit();
+}
+
+void COAP_UPLOADER_class::transmit()
+{
+	_udp.beginPacket(config::COLLECTOR_HOST, config::COLLECTOR_PORT);
+	_udp.write(_packet, _packetLength);
+	_udp.endPacket();
+	_sentAt = millis();
+}
@@ -0,0 +1,90 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#ifndef coap_uploader_h
+#define coap_uploader_h
+
+#include "system_node.hpp"
+
+// CoAP (RFC 7252), just enough for one confirmable POST per round
+#define COAP_VERSION			1
+#define COAP_TYPE_CON			0
+#define COAP_TYPE_ACK			2
+#define COAP_TYPE_RST			3
+#define COAP_POST				0x02		// 0.02
+#define COAP_CHANGED			0x44		// 2.04
+#define COAP_OPTION_URI_PATH	11
+#define COAP_PAYLOAD_MARKER		0xFF
+#define COAP_TOKEN_LEN			2
+#define COAP_URI_PATH			"r"			// Round records
+#define COAP_LOCAL_PORT			5683
+
+// Retransmission, ACK_TIMEOUT * ACK_RANDOM_FACTOR then doubling, gives up 62 to 93 s after the first send
+#define COAP_ACK_TIMEOUT		2000
+#define COAP_ACK_RANDOM			1500		// Upper bound of the random factor in thousandths
+#define COAP_MAX_RETRANSMIT		4
+
+#define ROUND_RECORD_VERSION	1
+#define COAP_PACKET_LEN			(4 + COAP_TOKEN_LEN + 2 + 1 + sizeof(ROUND_HEADER) + MAX_DEVICES * sizeof(ROUND_ENTRY))
+
+// Round record, little endian, one entry per active device
+struct __attribute__((packed)) ROUND_HEADER
+{
+	uint8_t version;
+	uint8_t count;
+	uint32_t timestamp;			// Epoch of the round
+};
+
+struct __attribute__((packed)) ROUND_ENTRY
+{
+	uint8_t hwid;
+	uint8_t flags;				// Predicted metrics, bit per metric
+	int16_t temperature;		// Hundredths
+	uint16_t humidity;			// Hundredths
+	int16_t soilTemperature;	// Hundredths
+	uint16_t soilMoisture;
+	uint16_t battery;			// Millivolts
+};
+
+class COAP_UPLOADER_class
+{
+	private:
+		WiFiUDP _udp;
+		uint8_t _packet[COAP_PACKET_LEN];
+		uint8_t _packetLength = 0;
+		uint16_t _messageId = 0;
+		bool _pending = false;
+		uint8_t _retransmits = 0;
+		unsigned long _sentAt = 0;
+		unsigned long _firstSentAt = 0;
+		unsigned long _timeout = 0;
+
+		void transmit();
+
+	public:
+		void Initialize();
+		void sendRound(IDATA &IData, time_t timestamp);
+		void Run();
+		bool isPending() { return _pending; }
+};
+
+#endif
@@ -61,6 +61,36 @@ namespace config
 		NOT_IN_USE  // HW_ID 8
 	};
 
+	// ThingSpeak Server, point it at tools/thingspeak_standin to test uploads locally
+	constexpr const char* THINGSPEAK_HOST            = "api.thingspeak.com";
+	constexpr uint16_t THINGSPEAK_PORT               = 80;
+
+	// Collector for COAP_UPLOADS, a Linux box running tools/collector
+	constexpr const char* COLLECTOR_HOST             = "192.168.1.100";
+	constexpr uint16_t COLLECTOR_PORT                = 5683;
+
+	// Broker for MQTT_UPLOADS, topics are MQTT_TOPIC_ROOT/<HW_ID>/data, /event and /history
+	constexpr const char* MQTT_HOST                  = "192.168.1.100";
+	constexpr uint16_t MQTT_PORT                     = 1883;
+	constexpr const char* MQTT_CLIENT_ID             = "turfroof-basestation";
+	constexpr const char* MQTT_TOPIC_ROOT            = "turfroof";
+
+	// Channel IDs for bulk updates, 0 sends one update per entry instead
+	constexpr uint32_t THINGSPEAK_CHANNEL_IDS[MAX_DEVICES] =
+	{
+		0,                             // HW_ID 0
+		0,                             // HW_ID 1
+		0,                             // HW_ID 2
+		0,                             // HW_ID 3
+		0,                             // HW_ID 4
+		0,                             // HW_ID 5
+		0,                             // HW_ID 6
+		0,                             // HW_ID 7
+
+		// This is US and also for checksum, WARNING: DO NOT USE!
+		0                              // HW_ID 8
+	};
+
 	// API Write Keys for ThingSpeak
 	constexpr const char* THINGSPEAK_API_KEYS[MAX_DEVICES] =
 	{
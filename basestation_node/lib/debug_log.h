@@ -0,0 +1,127 @@
+/*
+  ============================================================
+  Master's Thesis in Electrical and Computer Engineering
+  Faculty of Electrical and Computer Engineering
+  School of Engineering and Natural Sciences, University of Iceland
+
+  Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+		 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+  Researcher: Jezreel Tan
+  Email: jvt6@hi.is
+
+  Supervisors:
+  Helgi Þorbergsson
+  Email: thorberg@hi.is
+
+  Dórótea Höeg Sigurðardóttir
+  Email: dorotea@hi.is
+
+  ============================================================
+*/
+
+#ifndef debug_log_h
+#define debug_log_h
+
+#include "system_node.hpp"
+#include "log_messages.h"
+
+// Record: sync, length of the rest, message ID, millis(), then one tagged value per argument
+#define LOG_RING_BYTES		1024	// Power of two, the indexes run free and wrap with it
+#define LOG_SYNC			0xFE	// Never in the plain prints, they stay ASCII
+#define LOG_HEADER_BYTES	7
+#define LOG_TEXT_MAX		96		// Longest text or byte dump kept, a whole LoRa payload
+#define LOG_UART_FIFO		128		// ESP8266 UART transmit FIFO
+
+// Argument tags, the low nibble of a number tag is its size in bytes
+#define LOG_ARG_UNSIGNED	0x10
+#define LOG_ARG_SIGNED		0x20
+#define LOG_ARG_FLOAT		0x34
+#define LOG_ARG_TEXT		0x40	// Length byte, then the characters
+#define LOG_ARG_BYTES		0x50	// Length byte, then the bytes
+#define LOG_ARG_FLOATS		0x60	// Count byte, then 4 bytes each
+
+enum LOG_ID : uint8_t
+{
+	#define LOG_ID_ENTRY(id, format) id,
+	LOG_MESSAGES(LOG_ID_ENTRY)
+	#undef LOG_ID_ENTRY
+	LOG_IDS
+};
+
+// Anything longer than a number is passed by pointer and copied into the ring as a block
+struct LOG_BLOCK
+{
+	uint8_t tag;
+	uint8_t count;
+	uint8_t size;
+	const void *data;
+};
+
+inline LOG_BLOCK logText(const char *text)
+{
+	return {LOG_ARG_TEXT, (uint8_t)strnlen(text, LOG_TEXT_MAX), 1, text};
+}
+
+inline LOG_BLOCK logBytes(const void *data, uint8_t length)
+{
+	return {LOG_ARG_BYTES, length < LOG_TEXT_MAX ? length : (uint8_t)LOG_TEXT_MAX, 1, data};
+}
+
+inline LOG_BLOCK logFloats(const float *values, uint8_t count)
+{
+	return {LOG_ARG_FLOATS, count, sizeof(float), values};
+}
+
+// Deferred logging: a record costs a copy into RAM, the UART only sees it between radio work.
+// Only log from the main loop, the ring is not guarded against interrupts.
+class DEBUG_LOG_class
+{
+	private:
+		uint8_t _ring[LOG_RING_BYTES];
+		uint16_t _head;
+		uint16_t _tail;
+		uint16_t _dropped;
+
+		bool open(uint8_t id, uint8_t argBytes);
+		void header(uint8_t id, uint8_t argBytes);
+		void put(uint8_t value);
+		void put(const void *data, uint8_t length);
+
+		template <typename T>
+		static uint8_t argSize(T) { return 1 + sizeof(T); }
+		static uint8_t argSize(float) { return 1 + sizeof(float); }
+		static uint8_t argSize(double) { return 1 + sizeof(float); }
+		static uint8_t argSize(LOG_BLOCK block) { return 2 + block.count * block.size; }
+
+		template <typename T>
+		void arg(T value)
+		{
+			// No <type_traits> on AVR, the sign shows in how -1 converts
+			put((T(-1) < T(0) ? LOG_ARG_SIGNED : LOG_ARG_UNSIGNED) | sizeof(T));
+			put(&value, sizeof(T));
+		}
+		void arg(float value);
+		void arg(double value) { arg((float)value); }
+		void arg(LOG_BLOCK block);
+
+	public:
+		template <typename... T>
+		void log(uint8_t id, T... args)
+		{
+			uint8_t sizes[] = {0, argSize(args)...};
+			uint8_t argBytes = 0;
+			for (uint8_t size : sizes) argBytes += size;
+
+			if (!open(id, argBytes)) return;
+
+			int expand[] = {0, (arg(args), 0)...};
+			(void)expand;
+		}
+
+		void drain();
+};
+
+extern DEBUG_LOG_class debugLog;
+
+#endif
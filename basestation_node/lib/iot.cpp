@@ -50,99 +50,766 @@ void IOT_class::Initialize()
 		Serial.println(WiFi.localIP());
 	#endif
 
-	// Start NTP client
+	// Start NTP client, it keeps the clock between answers and we do the asking
 	timeClient.begin();
+	WiFi.hostByName(NTP_SERVER, _ntpServer);
+
+	#ifdef COAP_UPLOADS
+		_coap.Initialize();
+	#endif
+
+	// Whatever was still waiting before a reboot goes out first
+	#ifdef PERSISTENT_UPLOADS
+		_store.Initialize();
+		_nextLoad = _store.head();
+	#endif
+}
+
+unsigned long IOT_class::updateTime()
+{
+	// forceUpdate() waits up to a second for the answer, with the radio unserviced. Ask on one pass, look on the next ones
+	if (!_ntpPending)
+	{
+		return sendTimeRequest() ? NTP_POLL_MS : NTP_UPDATE_MS_FINAL;
+	}
+
+	if (!readTimeReply())
+	{
+		if (millis() - _ntpSentAt < NTP_TIMEOUT) return NTP_POLL_MS;
+
+		// No answer, look the pool up again on the next request in case this server went away
+		_ntpPending = false;
+		_ntpServer = IPAddress();
+
+		return _timeSynced ? nextTimeUpdate() : NTP_UPDATE_MS_FINAL;
+	}
+
+	_ntpPending = false;
+
+	#ifdef DEBUGGING
+		Serial.print(F("Current time: "));
+		Serial.println(timeClient.getFormattedTime());
+	#endif
+
+	return nextTimeUpdate();
+}
+
+bool IOT_class::sendTimeRequest()
+{
+	uint8_t packet[NTP_PACKET_SIZE] = { 0 };
+
+	// Only blocks on the first request and after a server stopped answering
+	if (!_ntpServer.isSet() && !WiFi.hostByName(NTP_SERVER, _ntpServer)) return false;
+
+	// A late answer to a request that was given up is dropped here
+	while (ntpUDP.parsePacket() > 0);
+
+	// Unsynchronised, version 4, client mode, the same request NTPClient sends
+	packet[0] = 0b11100011;
+	packet[2] = 6;
+	packet[3] = 0xEC;
+	packet[12] = 49;
+	packet[13] = 0x4E;
+	packet[14] = 49;
+	packet[15] = 52;
+
+	ntpUDP.beginPacket(_ntpServer, NTP_PORT);
+	ntpUDP.write(packet, NTP_PACKET_SIZE);
+	if (!ntpUDP.endPacket()) return false;
+
+	_ntpSentAt = millis();
+	_ntpPending = true;
+
+	return true;
+}
+
+bool IOT_class::readTimeReply()
+{
+	uint8_t packet[NTP_PACKET_SIZE];
+
+	if (ntpUDP.parsePacket() < NTP_PACKET_SIZE) return false;
+
+	unsigned long receivedAt = millis();
+	ntpUDP.read(packet, NTP_PACKET_SIZE);
+
+	// Transmit timestamp, seconds and a 32 bit fraction since 1900. Zero is a kiss-o'-death, not a time
+	unsigned long seconds = (unsigned long)packet[40] << 24 | (unsigned long)packet[41] << 16 | (unsigned long)packet[42] << 8 | packet[43];
+	unsigned long fraction = (unsigned long)packet[44] << 24 | (unsigned long)packet[45] << 16 | (unsigned long)packet[46] << 8 | packet[47];
+	if (seconds == 0) return false;
+
+	// NTPClient runs the whole seconds on from here, the phase is counted from the fraction
+	timeClient.setEpochTime(seconds - NTP_UNIX_OFFSET);
+	_timeSynced = true;
+	_syncEpoch = timeClient.getEpochTime();
+	_syncMillis = receivedAt - (unsigned long)(((uint64_t)fraction * 1000) >> 32);
+
+	return true;
+}
+
+unsigned long IOT_class::nextTimeUpdate()
+{
+	// Sync more often as the round gets closer
+	int minutesLeft = (MINUTE_BREAK - timeClient.getMinutes() + 60) % 60;
+	if (minutesLeft >= THRESH_MIN_LONG)
+	{
+		return NTP_UPDATE_MS_LONG;
+	}
+	else if (minutesLeft >= THRESH_MIN_MID)
+	{
+		return NTP_UPDATE_MS_MID;
+	}
+	else if (minutesLeft >= FINAL_THRESH_MIN_SHORT)
+	{
+		return NTP_UPDATE_MS_SHORT;
+	}
+	else if (minutesLeft > 0)
+	{
+		return NTP_UPDATE_MS_FINAL;
+	}
+
+	// Round minute, the clock was just synced
+	return NTP_UPDATE_MS_LONG;
+}
+
+unsigned long IOT_class::getEpochTime(uint16_t *millisecond)
+{
+	if (!_timeSynced)
+	{
+		*millisecond = 0;
+		return timeClient.getEpochTime();
+	}
+
+	unsigned long elapsed = millis() - _syncMillis;
+	*millisecond = elapsed % 1000;
+	return _syncEpoch + elapsed / 1000;
+}
+
+bool IOT_class::isQueryTime()
+{
+	if (!_timeSynced) return false;
+
+	// SECOND_BREAK into MINUTE_BREAK, only one round per hour
+	if (timeClient.getMinutes() == MINUTE_BREAK && timeClient.getSeconds() * 1000UL >= SECOND_BREAK && timeClient.getHours() != _lastQueryHour)
+	{
+		_lastQueryHour = timeClient.getHours();
+		return true;
+	}
+
+	return false;
+}
+
+void IOT_class::queueData(IDATA IData)
+{
+	#ifdef COAP_UPLOADS
+		// The whole round in one datagram, events and backfill still go to ThingSpeak
+		_coap.sendRound(IData, timeClient.getEpochTime());
+	#else
+		UPLOAD_JOB job = {};
+		job.type = UPLOAD_DATA;
+		job.timestamp = timeClient.getEpochTime();
+
+		for (uint8_t i = 0; i < MAX_DEVICES; i++)
+		{
+			if (config::ACTIVE_DEVICES[i] != ACTIVE) continue;
+
+			job.hwid = i;
+			job.flags = IData.PRED_FLAGS[i];
+			job.temperature = IData.TEMP_DATA[i];
+			job.humidity = IData.HUMI_DATA[i];
+			job.soilTemperature = IData.STMP_DATA[i];
+			job.soilMoisture = IData.SMOI_DATA[i];
+			job.battery = IData.BATT_DATA[i];
+			queueJob(job);
+		}
+	#endif
 }
 
-void IOT_class::waitUntilQueryTime()
+void IOT_class::pollCollector()
 {
-	while (true)
+	// ACKs and retransmissions, cheap enough for every loop pass so the RTT isn't stretched by the upload task
+	#ifdef COAP_UPLOADS
+		_coap.Run();
+	#endif
+}
+
+void IOT_class::queueEvent(uint8_t hwid, uint8_t rule, float value)
+{
+	UPLOAD_JOB job = {};
+
+	if (hwid >= MAX_DEVICES || config::ACTIVE_DEVICES[hwid] != ACTIVE) return;
+
+	job.type = UPLOAD_EVENT;
+	job.hwid = hwid;
+	job.timestamp = timeClient.getEpochTime();
+	job.flags = rule;
+	job.eventValue = value;
+	queueJob(job);
+}
+
+void IOT_class::queueHistory(uint8_t hwid, time_t timestamp, float temp, float humi, float stmp, uint16_t smoi, float batt)
+{
+	UPLOAD_JOB job = {};
+
+	if (hwid >= MAX_DEVICES || config::ACTIVE_DEVICES[hwid] != ACTIVE) return;
+
+	job.type = UPLOAD_HISTORY;
+	job.hwid = hwid;
+	job.timestamp = timestamp;
+	job.temperature = temp;
+	job.humidity = humi;
+	job.soilTemperature = stmp;
+	job.soilMoisture = smoi;
+	job.battery = batt;
+	queueJob(job);
+}
+
+void IOT_class::queueHealth(uint8_t hwid, const uint16_t *counters, float drift)
+{
+	UPLOAD_JOB job = {};
+
+	if (hwid >= MAX_DEVICES || config::ACTIVE_DEVICES[hwid] != ACTIVE) return;
+
+	job.type = UPLOAD_HEALTH;
+	job.hwid = hwid;
+	job.timestamp = timeClient.getEpochTime();
+	memcpy(job.counters, counters, sizeof(job.counters));
+	job.eventValue = drift;
+	queueJob(job);
+}
+
+bool IOT_class::uploadNext()
+{
+	bool batch[UPLOAD_QUEUE_SIZE] = { false };
+	bool accepted;
+	int statusCode;
+	uint8_t first = 0;
+
+	refillQueue();
+
+	// Our own broker, no per-channel limit and the whole window pipelined on one session
+	#ifdef MQTT_UPLOADS
+		return publishQueue();
+	#endif
+
+	// Nothing to try while Wi-Fi is down, and after a failed request only one probe per backoff window
+	if (WiFi.status() != WL_CONNECTED) return false;
+	if (_backoff > 0 && millis() - _lastFailure < _backoff) return false;
+
+	// Oldest job whose channel is out of its rate limit window, keeps each channel in order
+	while (first < _queueCount)
 	{
-		timeClient.update();
+		uint8_t hwid = _uploadQueue[first].hwid;
+
+		if (_lastChannelUpload[hwid] == 0 || millis() - _lastChannelUpload[hwid] >= CHANNEL_INTERVAL) break;
+		first++;
+	}
+
+	if (first >= _queueCount) return false;
+
+	UPLOAD_JOB &job = _uploadQueue[first];
+	_lastChannelUpload[job.hwid] = millis();
+
+	// Everything queued for the channel in one bulk update when its ID is known
+	if (config::THINGSPEAK_CHANNEL_IDS[job.hwid] != 0)
+	{
+		char path[HTTP_LINE_LEN];
+		uint8_t entries = buildBulk(first, batch);
+
+		snprintf(path, sizeof(path), "/channels/%lu/bulk_update.json", (unsigned long)config::THINGSPEAK_CHANNEL_IDS[job.hwid]);
+		// Bulk updates are answered with 202 Accepted
+		statusCode = httpPost(path, "application/json");
+		accepted = statusCode >= HTTP_CODE_OK && statusCode < 300 && strstr(_response, "\"success\":true") != NULL;
+
+		#ifdef DEBUGGING
+			Serial.print(F("Bulk Update Entries: "));
+			Serial.println(entries);
+		#endif
+	}
+	else
+	{
+		buildSingle(job);
+		batch[first] = true;
+		statusCode = httpPost("/update", "application/x-www-form-urlencoded");
+		accepted = statusCode >= HTTP_CODE_OK && statusCode < 300 && atol(_response) > 0;
+	}
+
+	// No answer, or the server can't take it right now, the jobs wait without using up their retries
+	if (statusCode == HTTP_NO_RESPONSE || statusCode == 429 || statusCode >= 500)
+	{
+		_backoff = _backoff == 0 ? OUTAGE_BACKOFF_MIN : _backoff * 2;
+		if (_backoff > OUTAGE_BACKOFF_MAX) _backoff = OUTAGE_BACKOFF_MAX;
+		_lastFailure = millis();
 
 		#ifdef DEBUGGING
-			Serial.print(F("Current time: "));
-			Serial.println(timeClient.getFormattedTime());
+			Serial.print(F("X: ThingSpeak Unavailable, Retrying In "));
+			Serial.print(_backoff / 1000);
+			Serial.println(F(" s"));
 		#endif
 
-		int currentMinute = timeClient.getMinutes();
-		if (currentMinute == MINUTE_BREAK)
+		return true;
+	}
+	_backoff = 0;
+
+	#ifdef DEBUGGING
+		Serial.print(F("Device "));
+		Serial.print(job.hwid);
+		Serial.println(accepted ? F(" | Upload Accepted") : F(" | X: Upload Rejected"));
+	#endif
+
+	// Drop what went through or ran out of retries, keep the rest in order
+	uint8_t kept = 0;
+	for (uint8_t i = 0; i < _queueCount; i++)
+	{
+		if (batch[i] && (accepted || ++_uploadQueue[i].attempts >= UPLOAD_RETRIES)) continue;
+		if (kept != i) _uploadQueue[kept] = _uploadQueue[i];
+		kept++;
+	}
+	_queueCount = kept;
+	releaseStore();
+
+	return true;
+}
+
+#ifdef MQTT_UPLOADS
+	bool IOT_class::publishQueue()
+	{
+		char topic[MQTT_TOPIC_LEN];
+		uint16_t packetId;
+		uint8_t inFlight = 0;
+
+		_mqtt.Run();
+
+		// PUBACKed jobs are done
+		while (_mqtt.takeAck(packetId))
+		{
+			for (uint8_t i = 0; i < _queueCount; i++)
+			{
+				if (_uploadQueue[i].packetId != packetId) continue;
+
+				memmove(&_uploadQueue[i], &_uploadQueue[i + 1], (_queueCount - i - 1) * sizeof(UPLOAD_JOB));
+				_queueCount--;
+				break;
+			}
+		}
+		releaseStore();
+
+		if (!_mqtt.isConnected()) return false;
+
+		// After a reconnect everything still unacknowledged goes again, in order and ahead of new jobs
+		bool resend = _mqtt.takeReconnect();
+
+		for (uint8_t i = 0; i < _queueCount; i++)
 		{
-			delay(SECOND_BREAK);
-			break;
+			if (_uploadQueue[i].packetId != 0) inFlight++;
 		}
 
-		int minutesLeft = (MINUTE_BREAK - currentMinute + 60) % 60;
-		if (minutesLeft >= THRESH_MIN_LONG)
+		for (uint8_t i = 0; i < _queueCount; i++)
 		{
-			delay(NTP_UPDATE_MS_LONG);
+			UPLOAD_JOB &job = _uploadQueue[i];
+
+			if (job.packetId != 0 && !resend) continue;
+			if (job.packetId == 0 && inFlight >= MQTT_WINDOW) break;
+
+			buildMessage(job, topic);
+			packetId = _mqtt.publish(topic, _body, _bodyLength, job.packetId);
+
+			// Connection went, the rest waits for the next CONNACK
+			if (packetId == 0) break;
+
+			if (job.packetId == 0) inFlight++;
+			job.packetId = packetId;
 		}
-		else if (minutesLeft >= THRESH_MIN_MID)
+
+		return true;
+	}
+
+	void IOT_class::buildMessage(UPLOAD_JOB &job, char *topic)
+	{
+		const char *kind = job.type == UPLOAD_EVENT ? "event" : job.type == UPLOAD_HISTORY ? "history" : job.type == UPLOAD_HEALTH ? "health" : "data";
+
+		snprintf(topic, MQTT_TOPIC_LEN, "%s/%u/%s", config::MQTT_TOPIC_ROOT, job.hwid, kind);
+
+		// {"time":1767225570,"temp":12.34,...}, epoch seconds so a late backfill can't be mistaken for now
+		_bodyLength = 0;
+		appendText("{\"time\":");
+		appendUnsigned(job.timestamp);
+
+		if (job.type == UPLOAD_EVENT)
 		{
-			delay(NTP_UPDATE_MS_MID);
+			appendText(",\"rule\":");
+			appendUnsigned(job.flags);
+			appendText(",\"value\":");
+			appendFixed(job.eventValue, FIELD_DECIMALS);
 		}
-		else if (minutesLeft >= FINAL_THRESH_MIN_SHORT)
+		else if (job.type == UPLOAD_HEALTH)
 		{
-			delay(NTP_UPDATE_MS_SHORT);
+			for (uint8_t i = 0; i < UPLOAD_COUNTERS; i++)
+			{
+				appendText(",\"");
+				appendText(UPLOAD_COUNTER_NAMES[i]);
+				appendText("\":");
+				appendUnsigned(job.counters[i]);
+			}
+			appendText(",\"drift\":");
+			appendFixed(job.eventValue, DRIFT_DECIMALS);
 		}
 		else
 		{
-			delay(NTP_UPDATE_MS_FINAL);
+			appendText(",\"temp\":");
+			appendFixed(job.temperature, FIELD_DECIMALS);
+			appendText(",\"humi\":");
+			appendFixed(job.humidity, FIELD_DECIMALS);
+			appendText(",\"stmp\":");
+			appendFixed(job.soilTemperature, FIELD_DECIMALS);
+			appendText(",\"smoi\":");
+			appendUnsigned(job.soilMoisture);
+			appendText(",\"batt\":");
+			appendFixed(job.battery, BATTERY_DECIMALS);
+
+			if (job.type == UPLOAD_DATA)
+			{
+				appendText(",\"pred\":");
+				appendUnsigned(job.flags);
+			}
 		}
+
+		appendText("}");
+	}
+#endif
+
+void IOT_class::queueJob(UPLOAD_JOB &job)
+{
+	job.stored = false;
+
+	// Into flash first, refillQueue() brings it into the window in order
+	if (_store.isMounted())
+	{
+		if (_store.count() >= STORE_MAX_RECORDS) evictOldest();
+		if (_store.append(job)) return;
+	}
+
+	if (_queueCount >= UPLOAD_QUEUE_SIZE)
+	{
+		#ifdef DEBUGGING
+			Serial.println(F("X: Upload Queue Full, Dropping Upload!"));
+		#endif
+
+		return;
+	}
+
+	_uploadQueue[_queueCount++] = job;
+}
+
+void IOT_class::refillQueue()
+{
+	UPLOAD_JOB job;
+
+	while (_queueCount < UPLOAD_QUEUE_SIZE && _nextLoad < _store.tail())
+	{
+		// A record failing its CRC is skipped, the head moves past it with the rest
+		if (_store.read(_nextLoad, job)) _uploadQueue[_queueCount++] = job;
+		_nextLoad++;
 	}
 }
 
-void IOT_class::getTime()
+void IOT_class::evictOldest()
 {
-	timeClient.update();
+	uint32_t oldest = _store.head();
+
+	// Oldest goes first, the newest rounds are the ones the dashboard is missing
+	for (uint8_t i = 0; i < _queueCount; i++)
+	{
+		if (!_uploadQueue[i].stored || _uploadQueue[i].seq != oldest) continue;
+
+		memmove(&_uploadQueue[i], &_uploadQueue[i + 1], (_queueCount - i - 1) * sizeof(UPLOAD_JOB));
+		_queueCount--;
+		break;
+	}
+	if (_nextLoad <= oldest) _nextLoad = oldest + 1;
+
+	releaseStore();
 
 	#ifdef DEBUGGING
-		Serial.print(F("Current time: "));
-		Serial.println(timeClient.getFormattedTime());
+		Serial.println(F("X: Upload Store Full, Dropping Oldest Upload!"));
 	#endif
 }
 
-void IOT_class::uploadData(IDATA IData)
+void IOT_class::releaseStore()
+{
+	uint32_t head = _nextLoad;
+
+	// Everything before the oldest job still in the window is uploaded or dropped
+	for (uint8_t i = 0; i < _queueCount; i++)
+	{
+		if (_uploadQueue[i].stored && _uploadQueue[i].seq < head) head = _uploadQueue[i].seq;
+	}
+
+	_store.release(head);
+}
+
+uint8_t IOT_class::buildBulk(uint8_t first, bool *batch)
+{
+	uint8_t hwid = _uploadQueue[first].hwid;
+	uint8_t entries = 0;
+
+	// {"write_api_key":"KEY","updates":[{...},{...}]}
+	_bodyLength = 0;
+	appendText("{\"write_api_key\":\"");
+	appendText(config::THINGSPEAK_API_KEYS[hwid]);
+	appendText("\",\"updates\":[");
+
+	for (uint8_t i = first; i < _queueCount && entries < BULK_MAX_UPDATES; i++)
+	{
+		if (_uploadQueue[i].hwid != hwid) continue;
+		if (_bodyLength + UPLOAD_ENTRY_LEN >= (int)sizeof(_body)) break;
+
+		if (entries++ > 0) appendText(",");
+		appendEntry(_uploadQueue[i], true);
+		batch[i] = true;
+	}
+
+	appendText("]}");
+
+	return entries;
+}
+
+void IOT_class::buildSingle(UPLOAD_JOB &job)
+{
+	// api_key=KEY&created_at=...&field1=...
+	_bodyLength = 0;
+	appendText("api_key=");
+	appendText(config::THINGSPEAK_API_KEYS[job.hwid]);
+	appendEntry(job, false);
+}
+
+void IOT_class::appendEntry(UPLOAD_JOB &job, bool json)
 {
-	char url[MAX_URL_LEN];
-    WiFiClient client;
+	appendText(json ? "{\"created_at\":\"" : "&created_at=");
+	appendTime(job.timestamp);
+	if (json) appendText("\"");
 
-	for (uint8_t i = 0; i < MAX_DEVICES; i++)
+	if (job.type == UPLOAD_EVENT)
 	{
-		if(config::ACTIVE_DEVICES[i] == ACTIVE)
+		// Events go to the device's own channel on the spare fields
+		appendField(7, json);
+		appendUnsigned(job.flags);
+		appendField(8, json);
+		appendFixed(job.eventValue, FIELD_DECIMALS);
+	}
+	else if (job.type == UPLOAD_HEALTH)
+	{
+		// All eight fields are taken, the counters go to the status text as "send:0 header:1 ..."
+		appendText(json ? ",\"status\":\"" : "&status=");
+		for (uint8_t i = 0; i < UPLOAD_COUNTERS; i++)
+		{
+			if (i > 0) appendText(json ? " " : "+");
+			appendText(UPLOAD_COUNTER_NAMES[i]);
+			appendText(":");
+			appendUnsigned(job.counters[i]);
+		}
+		appendText(json ? " drift:" : "+drift:");
+		appendFixed(job.eventValue, DRIFT_DECIMALS);
+		if (json) appendText("\"");
+	}
+	else
+	{
+		appendField(1, json);
+		appendFixed(job.temperature, FIELD_DECIMALS);
+		appendField(2, json);
+		appendFixed(job.humidity, FIELD_DECIMALS);
+		appendField(3, json);
+		appendFixed(job.soilTemperature, FIELD_DECIMALS);
+		appendField(4, json);
+		appendUnsigned(job.soilMoisture);
+		appendField(5, json);
+		appendFixed(job.battery, BATTERY_DECIMALS);
+
+		if (job.type == UPLOAD_DATA)
 		{
-			snprintf(url, MAX_URL_LEN,
-                "http://api.thingspeak.com/update?api_key=%s&field1=%.5f&field2=%.5f&field3=%.5f&field4=%u&field5=%.5f",
-                config::THINGSPEAK_API_KEYS[i],
-                IData.TEMP_DATA[i],
-                IData.HUMI_DATA[i],
-                IData.STMP_DATA[i],
-                IData.SMOI_DATA[i],
-                IData.BATT_DATA[i]);
-
-            HTTPClient http;
-            http.begin(client, url);
-            int httpResponseCode = http.GET();
+			appendField(6, json);
+			appendUnsigned(job.flags);
+		}
+	}
+
+	if (json) appendText("}");
+}
 
+void IOT_class::appendField(uint8_t field, bool json)
+{
+	appendText(json ? ",\"field" : "&field");
+	appendUnsigned(field);
+	appendText(json ? "\":" : "=");
+}
+
+void IOT_class::appendText(const char *text)
+{
+	while (*text && _bodyLength < sizeof(_body) - 1)
+	{
+		_body[_bodyLength++] = *text++;
+	}
+	_body[_bodyLength] = '\0';
+}
+
+void IOT_class::appendUnsigned(unsigned long value)
+{
+	char digits[11];
+	uint8_t count = 0;
+
+	do
+	{
+		digits[count++] = '0' + value % 10;
+		value /= 10;
+	} while (value > 0);
+
+	while (count > 0 && _bodyLength < sizeof(_body) - 1)
+	{
+		_body[_bodyLength++] = digits[--count];
+	}
+	_body[_bodyLength] = '\0';
+}
+
+void IOT_class::appendFixed(float value, uint8_t decimals)
+{
+	// Integer maths only, scaled once and split at the decimal point
+	unsigned long scale = 1;
+	for (uint8_t i = 0; i < decimals; i++) scale *= 10;
+
+	long scaled = lroundf(value * scale);
+	unsigned long magnitude = scaled < 0 ? -scaled : scaled;
+	unsigned long fraction = magnitude % scale;
+
+	if (scaled < 0) appendText("-");
+	appendUnsigned(magnitude / scale);
+	appendText(".");
+
+	// Leading zeros of the fraction
+	for (unsigned long digit = scale / 10; digit > fraction && digit > 1; digit /= 10) appendText("0");
+	appendUnsigned(fraction);
+}
+
+void IOT_class::appendTime(time_t timestamp)
+{
+	// 2026-01-31T23:59:30Z
+	char createdAt[21];
+	struct tm timeInfo;
+
+	gmtime_r(&timestamp, &timeInfo);
+	strftime(createdAt, sizeof(createdAt), "%Y-%m-%dT%H:%M:%SZ", &timeInfo);
+	appendText(createdAt);
+}
+
+int IOT_class::httpPost(const char *path, const char *contentType)
+{
+	char header[HTTP_HEADER_LEN];
+	char line[HTTP_LINE_LEN];
+	int statusCode = 0;
+	long contentLength = -1;
+	bool chunked = false;
+	bool keepAlive = true;
+	uint8_t responseLength = 0;
+
+	memset(_response, 0, sizeof(_response));
+
+	// Reconnect only when the server closed the last connection
+	if (!_client.connected())
+	{
+		_client.stop();
+		_client.setTimeout(HTTP_TIMEOUT);
+
+		if (!_client.connect(config::THINGSPEAK_HOST, config::THINGSPEAK_PORT))
+		{
 			#ifdef DEBUGGING
-				Serial.println(F("Uploading Data to ThingSpeak!"));
-				Serial.print(F("Device "));
-				Serial.print(i);
-				Serial.print(F(" Status | "));
-
-				if (httpResponseCode > 0)
-				{
-					Serial.print(F("ThingSpeak Response Code: "));
-					Serial.println(httpResponseCode);
-				}
-				else
-				{
-					Serial.print(F("Error sending to ThingSpeak: "));
-					Serial.println(http.errorToString(httpResponseCode));
-				}
+				Serial.println(F("X: Can't Reach ThingSpeak!"));
 			#endif
 
-			http.end();
+			return HTTP_NO_RESPONSE;
+		}
+	}
+
+	uint8_t headerLength = snprintf(header, sizeof(header),
+		"POST %s HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\nContent-Type: %s\r\nContent-Length: %u\r\n\r\n",
+		path,
+		config::THINGSPEAK_HOST,
+		contentType,
+		_bodyLength);
+
+	_client.write((const uint8_t*)header, headerLength);
+	_client.write((const uint8_t*)_body, _bodyLength);
+
+	// Status line, then headers up to the blank line
+	if (!readLine(line, sizeof(line)) || sscanf(line, "HTTP/1.%*d %d", &statusCode) != 1)
+	{
+		_client.stop();
+		return HTTP_NO_RESPONSE;
+	}
+
+	while (readLine(line, sizeof(line)) && line[0] != '\0')
+	{
+		if (strncasecmp(line, "Content-Length:", 15) == 0) contentLength = atol(&line[15]);
+		else if (strncasecmp(line, "Transfer-Encoding: chunked", 26) == 0) chunked = true;
+		else if (strncasecmp(line, "Connection: close", 17) == 0) keepAlive = false;
+	}
+
+	// Body into the small response buffer, anything past it is read and dropped
+	while (chunked || contentLength > 0)
+	{
+		long length = contentLength;
+
+		if (chunked)
+		{
+			if (!readLine(line, sizeof(line))) break;
+			length = strtol(line, NULL, 16);
+			if (length == 0)
+			{
+				readLine(line, sizeof(line));
+				break;
+			}
+		}
+
+		for (long i = 0; i < length; i++)
+		{
+			int c = _client.read();
+
+			// read() doesn't wait, give the rest of the body time to arrive
+			unsigned long start = millis();
+			while (c < 0 && millis() - start < HTTP_TIMEOUT && _client.connected())
+			{
+				yield();
+				c = _client.read();
+			}
+
+			if (c < 0)
+			{
+				_client.stop();
+				return HTTP_NO_RESPONSE;
+			}
+			if (responseLength < sizeof(_response) - 1) _response[responseLength++] = c;
 		}
+
+		if (!chunked) break;
+		readLine(line, sizeof(line));
 	}
+
+	if (!keepAlive) _client.stop();
+
+	#ifdef DEBUGGING
+		Serial.print(F("ThingSpeak Response Code: "));
+		Serial.print(statusCode);
+		Serial.print(F(" | "));
+		Serial.println(_response);
+	#endif
+
+	return statusCode;
+}
+
+bool IOT_class::readLine(char *line, uint8_t size)
+{
+	// Lines longer than the buffer are cut, only the start of a header matters here
+	size_t length = _client.readBytesUntil('\n', line, size - 1);
+
+	if (length == 0 && !_client.connected()) return false;
+	if (length > 0 && line[length - 1] == '\r') length--;
+	line[length] = '\0';
+
+	return true;
 }
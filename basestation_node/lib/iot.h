@@ -42,8 +42,37 @@
 #define NTP_UPDATE_MS_SHORT		60000      		// Update every minute
 #define NTP_UPDATE_MS_FINAL		5000			// Update every 5 seconds
 
+// NTP Exchange, asked on one loop pass and read on later ones so the radio never waits on it
+#define NTP_PORT				123
+#define NTP_PACKET_SIZE			48
+#define NTP_TIMEOUT				1000			// ms without an answer before the request is given up
+#define NTP_POLL_MS				10				// Between looks for the answer
+#define NTP_UNIX_OFFSET			2208988800UL	// NTP counts from 1900
+
 #define CONN_DELAY				500
 
+// Upload Queue Settings
+#define UPLOAD_QUEUE_SIZE		32
+#define CHANNEL_INTERVAL		15000			// ThingSpeak free tier takes one update per channel every 15 s
+#define UPLOAD_RETRIES			3
+#define HTTP_TIMEOUT			2000			// Keeps the loop from stalling on a dead connection
+#define HTTP_LINE_LEN			96
+#define HTTP_HEADER_LEN			192
+#define HTTP_RESPONSE_LEN		64
+#define UPLOAD_BODY_LEN			3072			// Preallocated, sized for a full backfill batch
+#define UPLOAD_ENTRY_LEN		160				// Worst case for one update entry
+#define BULK_MAX_UPDATES		24
+
+// Outages, probe with one request per backoff window instead of one per channel every 15 s
+#define OUTAGE_BACKOFF_MIN		15000
+#define OUTAGE_BACKOFF_MAX		600000			// 10 minutes
+#define HTTP_NO_RESPONSE		0
+
+// Fixed-Point Output
+#define FIELD_DECIMALS			2
+#define BATTERY_DECIMALS		3
+#define DRIFT_DECIMALS			1				// Tenths of a ppm, as the node sends it
+
 class IOT_class
 {
 	friend class LORA_MODULE_class;
@@ -52,13 +81,71 @@ class IOT_class
 		WiFiUDP ntpUDP;
 		NTPClient timeClient;
 
+		bool _timeSynced = false;
+		unsigned long _syncEpoch = 0;			// NTPClient keeps whole seconds, the phase is counted from its last answer
+		unsigned long _syncMillis = 0;
+		IPAddress _ntpServer;					// Looked up once, DNS blocks
+		bool _ntpPending = false;
+		unsigned long _ntpSentAt = 0;
+		int _lastQueryHour = -1;
+		UPLOAD_JOB _uploadQueue[UPLOAD_QUEUE_SIZE];
+		uint8_t _queueCount = 0;
+		unsigned long _lastChannelUpload[MAX_DEVICES] = { 0 };
+
+		// Every job goes through the store, the queue above is the window being uploaded
+		UPLOAD_STORE_class _store;
+		uint32_t _nextLoad = 0;
+		unsigned long _backoff = 0;
+		unsigned long _lastFailure = 0;
+
+		#ifdef COAP_UPLOADS
+			COAP_UPLOADER_class _coap;
+		#endif
+
+		#ifdef MQTT_UPLOADS
+			MQTT_CLIENT_class _mqtt;
+
+			bool publishQueue();
+			void buildMessage(UPLOAD_JOB &job, char *topic);
+		#endif
+
+		// One connection kept open across uploads, one buffer for every request body
+		WiFiClient _client;
+		char _body[UPLOAD_BODY_LEN];
+		uint16_t _bodyLength;
+		char _response[HTTP_RESPONSE_LEN];
+
+		bool sendTimeRequest();
+		bool readTimeReply();
+		unsigned long nextTimeUpdate();
+		void queueJob(UPLOAD_JOB &job);
+		void refillQueue();
+		void evictOldest();
+		void releaseStore();
+		uint8_t buildBulk(uint8_t first, bool *batch);
+		void buildSingle(UPLOAD_JOB &job);
+		void appendEntry(UPLOAD_JOB &job, bool json);
+		void appendField(uint8_t field, bool json);
+		void appendText(const char *text);
+		void appendUnsigned(unsigned long value);
+		void appendFixed(float value, uint8_t decimals);
+		void appendTime(time_t timestamp);
+		int httpPost(const char *path, const char *contentType);
+		bool readLine(char *line, uint8_t size);
+
 	public:
 		IOT_class() : timeClient(ntpUDP, NTP_SERVER, UTC_OFFSET, NTP_UPDATE_MS_FINAL) {}
 
 		void Initialize();
-		void getTime();
-		void waitUntilQueryTime();
-		void uploadData(IDATA IData);
+		unsigned long updateTime();
+		bool isQueryTime();
+		bool uploadNext();
+		void pollCollector();
+		void queueData(IDATA IData);
+		void queueEvent(uint8_t hwid, uint8_t rule, float value);
+		void queueHistory(uint8_t hwid, time_t timestamp, float temp, float humi, float stmp, uint16_t smoi, float batt);
+		void queueHealth(uint8_t hwid, const uint16_t *counters, float drift);
+		unsigned long getEpochTime(uint16_t *millisecond);
 };
 
 #endif
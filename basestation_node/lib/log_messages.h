@@ -0,0 +1,64 @@
+/*
+  ============================================================
+  Master's Thesis in Electrical and Computer Engineering
+  Faculty of Electrical and Computer Engineering
+  School of Engineering and Natural Sciences, University of Iceland
+
+  Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+		 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+  Researcher: Jezreel Tan
+  Email: jvt6@hi.is
+
+  Supervisors:
+  Helgi Þorbergsson
+  Email: thorberg@hi.is
+
+  Dórótea Höeg Sigurðardóttir
+  Email: dorotea@hi.is
+
+  ============================================================
+*/
+
+#ifndef log_messages_h
+#define log_messages_h
+
+// Tokenized debug messages, the basestation only sends the ID and the raw arguments. tools/log_decode
+// is built against this list and puts the text back, the Linux gateway expands them itself.
+// Append only: IDs are positions, a log decodes against the list its firmware was built with.
+//
+// %d %u %x integers, %t epoch seconds, %.5f floats and float lists, %s text, %x on bytes is a hex dump
+#define LOG_MESSAGES(X) \
+	X(LOG_DROPPED,				"X: %u debug records dropped, ring full") \
+	X(LOG_LORA_FAILED,			"X: ERROR: LoRa Initialization Failed!") \
+	X(LOG_LORA_SETUP,			"LoRa Setup Complete! Backoff Time (ms): %u, CSMA Timeout (ms): %u") \
+	X(LOG_ALL_REPORTED,			"All active devices have reported data!") \
+	X(LOG_SEND_REQUEST,			"Request to Send: %s") \
+	X(LOG_REQUEST_SENT,			"Request Sent Sucessfully! (%u/%u)") \
+	X(LOG_PACKET,				"Packet received! Signal strength [RSSI] (dBm): %d") \
+	X(LOG_PAYLOAD,				"Payload: %s") \
+	X(LOG_BAD_HEADER,			"X: Invalid Packet Header!") \
+	X(LOG_NO_DATA,				"X: Unable to Locate Data!") \
+	X(LOG_BAD_CHARACTER,		"X: Invalid Character Found!") \
+	X(LOG_BAD_DATA,				"X: Invalid Data Found!") \
+	X(LOG_BAD_NUMBER,			"Invalid Number Found!") \
+	X(LOG_CHECKSUM,				"Calculating Checksum: %.5f vs %.5f") \
+	X(LOG_CHECKSUM_BAD,			"Checksum is BAD!") \
+	X(LOG_CHECKSUM_GOOD,		"Checksum is GOOD!") \
+	X(LOG_MERGED_DATA,			"Merged Data: [%.5f]") \
+	X(LOG_MERGED_RAW,			"Merged Data: [%.0f]") \
+	X(LOG_SEND_LIMIT,			"Send Limit Reached!") \
+	X(LOG_SEND_PAYLOAD,			"Payload to Send: %s") \
+	X(LOG_SENT,					"Payload Sent Sucessfully! (%u/%u) after %u backoff slots") \
+	X(LOG_NO_EVENT_DATA,		"X: Unable to Locate Event Data!") \
+	X(LOG_BAD_EVENT_CHARACTER,	"X: Invalid Event Character Found!") \
+	X(LOG_EVENT_CHECKSUM_BAD,	"Event Checksum is BAD!") \
+	X(LOG_EVENT,				"Event from Device %u | Rule: %u | Value: %.5f") \
+	X(LOG_BAD_HISTORY,			"X: Invalid History Data Found!") \
+	X(LOG_HISTORY_CHECKSUM_BAD,	"History Checksum is BAD!") \
+	X(LOG_BACKFILL,				"Backfill from Device %u | Hours Ago: %u") \
+	X(LOG_BAD_HEALTH,			"X: Invalid Health Data Found!") \
+	X(LOG_HEALTH_CHECKSUM_BAD,	"Health Checksum is BAD!") \
+	X(LOG_HEALTH,				"Health from Device %u | Seq: %u")
+
+#endif
@@ -25,13 +25,13 @@
 void LORA_MODULE_class::Initialize()
 {
 	// Configure Pins
-	LoRa.setPins(LORA_NSS, LORA_RST);
+	LoRa.setPins(LORA_NSS, LORA_RST, LORA_DI0);
 
 	// Start LoRa
 	if (!LoRa.begin(FREQUENCY))
 	{
 		#ifdef DEBUGGING
-			Serial.println(F("X: ERROR: LoRa Initialization Failed!"));
+			debugLog.log(LOG_LORA_FAILED);
 		#endif
 	}
 
@@ -53,74 +53,205 @@ void LORA_MODULE_class::Initialize()
 	_backoffTime = BACKOFF_MUL + _hwid * BACKOFF_MUL;
 	_csmaTimeout = CSMA_TOUT_MIN + (CSMA_TOUT_MUL * _hwid);
 
+	// No events or gaps seen yet
+	_missedBaseHour = 0;
+	for (uint8_t i = 0; i < MAX_DEVICES; i++)
+	{
+		_lastEventSeq[i] = -1;
+		_lastHealthSeq[i] = -1;
+		_missedHours[i] = 0;
+	}
+
 	#ifdef DEBUGGING
-		Serial.print(F("Backoff Time (ms): "));
-		Serial.println(_backoffTime);
-		Serial.print(F("CSMA Timeout (ms): "));
-		Serial.println(_csmaTimeout);
-		Serial.println(F("LoRa Setup Complete!"));
+		debugLog.log(LOG_LORA_SETUP, _backoffTime, _csmaTimeout);
+	#endif
+}
+
+void LORA_MODULE_class::startRound(IOT_class *iot)
+{
+	_roundHour = iot->timeClient.getEpochTime() / HOUR_SECONDS;
+	_reportedDevices = 0;
+	_roundActive = true;
+
+	// What happened between rounds is dropped, a dump covers one round
+	#ifdef EVENT_TRACE
+		eventTrace.open(iot->timeClient.getEpochTime());
 	#endif
+
+	openRequest(TEMPERATURE, iot);
 }
 
-void LORA_MODULE_class::startLoRaMesh(IDATA *IData, IOT_class *iot)
+uint8_t LORA_MODULE_class::Run(IDATA *IData, IOT_class *iot, PREDICTOR_class *predictor, bool packetReceived)
 {
-	for (uint8_t i = TEMPERATURE; i < VALID_HEADERS; i++)
+	// parsePacket() leaves continuous receive whether or not there was a frame
+	if (packetReceived) _listening = false;
+
+	// Frames are flagged by the DIO0 interrupt, or read early while backing off in sendPayloadData
+	if (_newpayloadAlert || (packetReceived && LoRa.parsePacket() && getLoRaPayload(_roundActive ? _roundIndex : (uint8_t)EVENTS_ONLY)))
 	{
-		// Reset Everything
-		resetValues();
+		handlePacket(iot);
+	}
 
-		// Send Requests
-		sendRequest(i, iot);
-		_hasNodeReplied = false;
+	uint8_t status = ROUND_IDLE;
 
-		while (millis() - _lastSystemUpdateTime <= LORA_REQ_TIMEOUT)
+	if (_roundActive)
+	{
+		status = ROUND_BUSY;
+
+		if (_hasNodeReplied == false && millis() - _lastSystemUpdateTime >= LORA_REQ_TIMEOUT / LORA_REQ_RESEND_DIV)
 		{
-			if (LoRa.parsePacket() || _newpayloadAlert)
-			{
-				if (!_newpayloadAlert && !getLoRaPayload(i)) continue;
-				processPayloadData();
-				sendPayloadData(i);
-				_hasNodeReplied = true;
-			}
+			sendRequest(_roundIndex, iot);
+			_hasNodeReplied = true;
+			_listening = false;
+			_lastSystemUpdateTime = millis();
+		}
 
-			if (_hasNodeReplied == false && millis() - _lastSystemUpdateTime >= LORA_REQ_TIMEOUT / LORA_REQ_RESEND_DIV)
-			{
-				sendRequest(i, iot);
-				_hasNodeReplied = true;
-				_lastSystemUpdateTime = millis();
-			}
+		// All active devices have sent data, or nobody is left talking
+		if ((_roundIndex == BACKFILL ? !hasMissedHours() : checkComplete()) || millis() - _lastSystemUpdateTime > LORA_REQ_TIMEOUT)
+		{
+			status = closeRequest(IData, iot, predictor);
+		}
+	}
 
-			// Check if all active devices have sent data
-			if (checkComplete()) break;
+	// Sending and parsePacket() both take the radio out of continuous receive
+	if (!_listening)
+	{
+		LoRa.receive();
+		_listening = true;
+	}
 
-			yield();
+	return status;
+}
+
+void LORA_MODULE_class::handlePacket(IOT_class *iot)
+{
+	_listening = false;
+
+	// Backfill replies, health reports and urgent events are queued for upload as they come in
+	if (isHistoryFrame())
+	{
+		_newpayloadAlert = false;
+		handleHistory(iot);
+		return;
+	}
+
+	if (isHealthFrame())
+	{
+		_newpayloadAlert = false;
+		handleHealth(iot);
+		return;
+	}
+
+	if (isEventFrame())
+	{
+		_newpayloadAlert = false;
+		handleEvent(iot);
+		if (_roundActive && _hasNodeReplied && _sendAttempts < SEND_ATTEMPTS) sendPayloadData(_roundIndex);
+		return;
+	}
+
+	if (!_roundActive) return;
+
+	processPayloadData();
+	sendPayloadData(_roundIndex);
+	_hasNodeReplied = true;
+}
+
+void LORA_MODULE_class::openRequest(uint8_t index, IOT_class *iot)
+{
+	// Reset Everything
+	_roundIndex = index;
+	resetValues();
+
+	#ifdef EVENT_TRACE
+		eventTrace.add(TRACE_REQUEST, index, 0);
+	#endif
+
+	// Send Requests
+	sendRequest(index, iot);
+	_hasNodeReplied = false;
+	_listening = false;
+}
+
+uint8_t LORA_MODULE_class::closeRequest(IDATA *IData, IOT_class *iot, PREDICTOR_class *predictor)
+{
+	uint8_t status = ROUND_BUSY;
+	uint8_t next = _roundIndex + 1;
+
+	#ifdef EVENT_TRACE
+		uint16_t reported = 0;
+		for (uint8_t i = 0; i < MAX_DEVICES - 1; i++)
+		{
+			if (_systemValues[i] != 0) reported |= bit(i);
 		}
+		eventTrace.add(TRACE_CLOSE, _roundIndex, reported);
+	#endif
+
+	// Store data to IDATA
+	logData(IData, _roundIndex, predictor);
+	if (_roundIndex == BATT_VOLTAGE) status = ROUND_DATA_READY;
 
-		// Store data to IDATA
-		logData(IData, i);
+	// Only ask for backfill when someone went missing
+	if (next == BACKFILL)
+	{
+		#ifdef STORE_AND_FORWARD
+			updateMissedHours();
+			if (!hasMissedHours()) next = VALID_HEADERS;
+		#else
+			next = VALID_HEADERS;
+		#endif
+	}
+
+	if (next < VALID_HEADERS)
+	{
+		openRequest(next, iot);
+	}
+	else
+	{
+		_roundActive = false;
+
+		#ifdef EVENT_TRACE
+			eventTrace.dump(config::HW_ID, iot->timeClient.getEpochTime());
+		#endif
 	}
+
+	return status;
 }
 
-void LORA_MODULE_class::logData(IDATA *IData, uint8_t index)
+void LORA_MODULE_class::logData(IDATA *IData, uint8_t index, PREDICTOR_class *predictor)
 {
 	for (uint8_t i = 0; i < MAX_DEVICES - 1; i++)
 	{
+		float value = _systemValues[i];
+
+		#ifdef PREDICTING
+			// Fill in predicted slots with our copy of the node's model and flag them
+			if (index < BACKFILL && config::ACTIVE_DEVICES[i])
+			{
+				bool predicted;
+				value = predictor->Resolve(i, index, value, &predicted);
+				if (predicted) IData->PRED_FLAGS[i] |= bit(index);
+			}
+		#endif
+
+		if (index < BACKFILL && value != 0) _reportedDevices |= bit(i);
+
 		switch (index)
 		{
 			case TEMPERATURE:
-				IData->TEMP_DATA[i] = _systemValues[i];
+				IData->TEMP_DATA[i] = value;
 				break;
 			case HUMIDITY:
-				IData->HUMI_DATA[i] = _systemValues[i];
+				IData->HUMI_DATA[i] = value;
 				break;
 			case SOIL_TEMPERATURE:
-				IData->STMP_DATA[i] = _systemValues[i];
+				IData->STMP_DATA[i] = value;
 				break;
 			case SOIL_MOISTURE:
-				IData->SMOI_DATA[i] = static_cast<uint16_t>(_systemValues[i]);
+				IData->SMOI_DATA[i] = static_cast<uint16_t>(value);
 				break;
 			case BATT_VOLTAGE:
-				IData->BATT_DATA[i] = _systemValues[i];
+				IData->BATT_DATA[i] = value;
 				break;
 		}
 	}
@@ -128,6 +259,7 @@ void LORA_MODULE_class::logData(IDATA *IData, uint8_t index)
 
 bool LORA_MODULE_class::checkComplete()
 {
+	// Predicted slots (PREDICTED_VALUE) count as reported, the node is alive and within bounds
 	for (uint8_t i = 0; i < MAX_DEVICES - 1; i++)
 	{
 		if (config::ACTIVE_DEVICES[i] && _systemValues[i] == 0)
@@ -137,7 +269,7 @@ bool LORA_MODULE_class::checkComplete()
 	}
 
 	#ifdef DEBUGGING
-		Serial.println(F("All active devices have reported data!"));
+		debugLog.log(LOG_ALL_REPORTED);
 	#endif
 
 	return true;
@@ -156,31 +288,23 @@ void LORA_MODULE_class::resetValues()
 
 void LORA_MODULE_class::sendRequest(uint8_t index, IOT_class *iot)
 {
-	char sendPayload[index == DATE ? MAX_MESSAGE_LENGTH : REQUEST_LENGTH] = {0};
+	char sendPayload[index == BACKFILL ? MAX_MESSAGE_LENGTH : REQUEST_LENGTH] = {0};
 	snprintf(_loraprevHeader, sizeof(_loraprevHeader), "%s", _validHeaders[index]);
 
-	if (index == DATE)
-	{
-		iot->timeClient.update();
-		unsigned long epochTime = iot->timeClient.getEpochTime();
-		uint8_t currentHour   = hour(epochTime);
-		uint8_t currentMinute = minute(epochTime);
-		uint8_t currentSecond = second(epochTime);
-		uint8_t currentDay    = day(epochTime);
-		uint8_t currentMonth  = month(epochTime);
-		uint8_t currentYear   = year(epochTime) % 100;
-		uint8_t checkSum = currentHour + currentMinute + currentSecond + currentDay + currentMonth + currentYear;
-
-		snprintf(sendPayload, sizeof(sendPayload), "%s[%02d,%02d,%02d,%02d,%02d,%02d,*,*,%02d]",
-			_validHeaders[index],
-			currentHour,
-			currentMinute,
-			currentSecond,
-			currentDay,
-			currentMonth,
-			currentYear,
-			checkSum
-		);
+	if (index == BACKFILL)
+	{
+		// One hour mask per node, two digits minimum so single digits aren't taken for placeholders
+		uint8_t pos = snprintf(sendPayload, sizeof(sendPayload), "%s[", _validHeaders[index]);
+		unsigned long checkSum = 0;
+
+		for (uint8_t i = 0; i < MAX_DEVICES - 1; i++)
+		{
+			uint16_t mask = config::ACTIVE_DEVICES[i] ? _missedHours[i] : 0;
+			pos += mask ? snprintf(&sendPayload[pos], sizeof(sendPayload) - pos, "%02u,", mask) : snprintf(&sendPayload[pos], sizeof(sendPayload) - pos, "%c,", BLANK_PLACEHOLDER);
+			checkSum += mask;
+		}
+
+		snprintf(&sendPayload[pos], sizeof(sendPayload) - pos, "%02lu]", checkSum);
 	}
 	else
 	{
@@ -188,29 +312,32 @@ void LORA_MODULE_class::sendRequest(uint8_t index, IOT_class *iot)
 	}
 
 	#ifdef DEBUGGING
-		Serial.print(F("Payload to Send: "));
-		Serial.println(sendPayload);
+		debugLog.log(LOG_SEND_REQUEST, logText(sendPayload));
 	#endif
 
-	uint8_t payloadSize = strlen(sendPayload) + 1;
+	uint8_t requestLength = strlen(sendPayload);
 
-	#ifdef ENCRYPTING
-		char encryptedPayload[payloadSize] = {0};
-		strncpy(encryptedPayload, sendPayload, payloadSize);
-		rc4EncryptDecrypt(encryptedPayload, payloadSize);
+	for (uint8_t j = 0; j < SEND_ATTEMPTS; j++)
+	{
+		// Every copy carries the time it went out at, the nodes add the airtime themselves
+		formatTimeTag(&sendPayload[requestLength], sizeof(sendPayload) - requestLength, iot);
 
-		#ifdef DEBUGGING
-			Serial.print(F("Encrypted Message: "));
-			for (uint8_t i = 0; i < payloadSize - 1; i++)
-			{
-				Serial.print(encryptedPayload[i]);
-			}
-			Serial.println();
+		uint8_t payloadSize = strlen(sendPayload) + 1;
+
+		#ifdef ENCRYPTING
+			char encryptedPayload[sizeof(sendPayload)] = {0};
+			memcpy(encryptedPayload, sendPayload, payloadSize);
+			rc4EncryptDecrypt(encryptedPayload, payloadSize);
 		#endif
-	#endif
 
-	for (uint8_t j = 0; j < SEND_ATTEMPTS; j++)
-	{
+		#ifdef EVENT_TRACE
+			#ifdef ENCRYPTING
+				uint16_t frameId = TRACE_MODULE_class::frameId(encryptedPayload, payloadSize - 1);
+			#else
+				uint16_t frameId = TRACE_MODULE_class::frameId(sendPayload, payloadSize - 1);
+			#endif
+			eventTrace.add(TRACE_TX_START, payloadSize - 1, frameId);
+		#endif
 		LoRa.beginPacket();
 		#ifdef ENCRYPTING
 			LoRa.write((const uint8_t*)encryptedPayload, payloadSize - 1);	// -1 Don't send null terminator
@@ -218,25 +345,30 @@ void LORA_MODULE_class::sendRequest(uint8_t index, IOT_class *iot)
 			LoRa.write((const uint8_t*)sendPayload, payloadSize - 1);		// -1 Don't send null terminator
 		#endif
 		LoRa.endPacket();
+		#ifdef EVENT_TRACE
+			eventTrace.add(TRACE_TX_END, payloadSize - 1, frameId);
+		#endif
 		#ifdef DEBUGGING
-			Serial.print(F("\nPayload Sent Sucessfully! ("));
-			Serial.print(j + 1);
-			Serial.print('/');
-			Serial.print(SEND_ATTEMPTS);
-			Serial.println(')');
+			debugLog.log(LOG_REQUEST_SENT, (uint8_t)(j + 1), (uint8_t)SEND_ATTEMPTS);
 		#endif
 
 		delay(_csmaTimeout / DELAY_DIVIDER);
 	}
 }
 
+void LORA_MODULE_class::formatTimeTag(char *tag, uint8_t size, IOT_class *iot)
+{
+	uint16_t millisecond;
+	unsigned long epoch = iot->getEpochTime(&millisecond);
+
+	snprintf(tag, size, "%c%lu.%03u", TIME_TAG, epoch, millisecond);
+}
+
 bool LORA_MODULE_class::getLoRaPayload(uint8_t current_header_index)
 {
 	#ifdef DEBUGGING
-		//	Display Signal Strength (RSSI) of the Received Packet
-		Serial.println(F("\nPacket received!"));
-		Serial.print(F("Signal strength [RSSI] (dBm): "));
-		Serial.println(LoRa.packetRssi());
+		//	Signal Strength (RSSI) of the Received Packet
+		debugLog.log(LOG_PACKET, (int16_t)LoRa.packetRssi());
 	#endif
 
 	//	Get Payload content
@@ -251,25 +383,33 @@ bool LORA_MODULE_class::getLoRaPayload(uint8_t current_header_index)
 	// Flush remaining bytes (if any)
 	while (LoRa.available()) LoRa.read();
 
-	#ifdef ENCRYPTING
-		#ifdef DEBUGGING
-			Serial.print(F("Encrypted Payload: "));
-			Serial.println(_loraPayload);
-		#endif
+	#ifdef EVENT_TRACE
+		uint16_t frameId = TRACE_MODULE_class::frameId(_loraPayload, payloadIndex - 1);
+		eventTrace.add(TRACE_RX, payloadIndex - 1, frameId);
+	#endif
 
+	#ifdef ENCRYPTING
 		char decryptedPayload[MAX_MESSAGE_LENGTH];
 		memcpy(decryptedPayload, _loraPayload, payloadIndex);
 		rc4EncryptDecrypt(decryptedPayload, payloadIndex);
 		memcpy(_loraPayload, decryptedPayload, payloadIndex);
 	#endif
 
+	// A node's relay of the first request brings our own time back, only the frame is wanted
+	char *tag = strchr(_loraPayload, TIME_TAG);
+	if (tag != nullptr) memset(tag, 0, strlen(tag));
+
 	#ifdef DEBUGGING
-		//	Print LoRa Payload
-		Serial.print(F("Payload: "));
-		Serial.println(_loraPayload);
+		debugLog.log(LOG_PAYLOAD, logText(_loraPayload));
+	#endif
+
+	bool valid = checkMessageValidity(current_header_index);
+
+	#ifdef EVENT_TRACE
+		if (!valid) eventTrace.add(TRACE_INVALID, isEventFrame() ? TRACE_EVENT_FRAME : isHistoryFrame() ? TRACE_HISTORY_FRAME : isHealthFrame() ? TRACE_HEALTH_FRAME : TRACE_DATA_FRAME, frameId);
 	#endif
 
-	return checkMessageValidity(current_header_index);
+	return valid;
 }
 
 int8_t LORA_MODULE_class::getcharIndex(char c)
@@ -297,7 +437,7 @@ float *LORA_MODULE_class::getpayloadValues()
 	uint8_t index = 0;
 	while (token != nullptr && index < MAX_DEVICES)
 	{
-		tempValues[index++] = atof(token);
+		tempValues[index++] = *token == PREDICTED_PLACEHOLDER ? PREDICTED_VALUE : atof(token);
 		token = strtok(nullptr, ",");
 	}
 
@@ -306,16 +446,21 @@ float *LORA_MODULE_class::getpayloadValues()
 
 bool LORA_MODULE_class::checkMessageValidity(uint8_t current_header_index)
 {
-	uint8_t startIdx = getcharIndex('[');
-	uint8_t endIdx = getcharIndex(']');
+	int8_t startIdx = getcharIndex('[');
+	int8_t endIdx = getcharIndex(']');
 	uint8_t payloadLen = strlen(_loraPayload);
 	bool checkforCharacters = true;
 
+	// Event, backfill and health frames have their own layouts and are accepted at any time
+	if (isEventFrame()) return checkEventValidity();
+	if (isHistoryFrame()) return checkHistoryValidity();
+	if (isHealthFrame()) return checkHealthValidity();
+
 	// Check header if it's the correct one we are looking for
-	if (strncmp(_loraPayload, _validHeaders[current_header_index], strlen(_validHeaders[current_header_index])) != 0)
+	if (current_header_index >= VALID_HEADERS || strncmp(_loraPayload, _validHeaders[current_header_index], strlen(_validHeaders[current_header_index])) != 0)
 	{
 		#ifdef DEBUGGING
-			Serial.println(F("X: Invalid Packet Header!"));
+			debugLog.log(LOG_BAD_HEADER);
 		#endif
 
 		return false;
@@ -325,7 +470,7 @@ bool LORA_MODULE_class::checkMessageValidity(uint8_t current_header_index)
 	if (startIdx == -1 && endIdx == -1)
 	{
 		#ifdef DEBUGGING
-			Serial.println(F("X: Unable to Locate Data!"));
+			debugLog.log(LOG_NO_DATA);
 		#endif
 
 		return false;
@@ -338,12 +483,12 @@ bool LORA_MODULE_class::checkMessageValidity(uint8_t current_header_index)
 
 		if (checkforCharacters)
 		{
-			if (payloadChar == BLANK_PLACEHOLDER || (payloadChar == '[' && _loraPayload[i + 1] == ']')) continue;
+			if (payloadChar == BLANK_PLACEHOLDER || payloadChar == PREDICTED_PLACEHOLDER || (payloadChar == '[' && _loraPayload[i + 1] == ']')) continue;
 
 			if (payloadChar != '[' && payloadChar != ']' && payloadChar != ',')
 			{
 				#ifdef DEBUGGING
-					Serial.println(F("X: Invalid Character Found!"));
+					debugLog.log(LOG_BAD_CHARACTER);
 				#endif
 
 				return false;
@@ -351,10 +496,10 @@ bool LORA_MODULE_class::checkMessageValidity(uint8_t current_header_index)
 
 			if ((payloadChar == '[' && _loraPayload[i + 2] == ',') || (payloadChar == ',' && _loraPayload[i + 2] == ',') || (payloadChar == ',' && _loraPayload[i + 2] == ']'))
 			{
-				if (_loraPayload[i + 1] != BLANK_PLACEHOLDER)
+				if (_loraPayload[i + 1] != BLANK_PLACEHOLDER && _loraPayload[i + 1] != PREDICTED_PLACEHOLDER)
 				{
 					#ifdef DEBUGGING
-						Serial.println(F("X: Invalid Data Found!"));
+						debugLog.log(LOG_BAD_DATA);
 					#endif
 
 					return false;
@@ -370,7 +515,7 @@ bool LORA_MODULE_class::checkMessageValidity(uint8_t current_header_index)
 			if ((payloadChar < '0' || payloadChar > '9') && payloadChar != '.' && payloadChar != '-')
 			{
 				#ifdef DEBUGGING
-					Serial.println(F("Invalid Number Found!"));
+					debugLog.log(LOG_BAD_NUMBER);
 				#endif
 
 				return false;
@@ -391,20 +536,17 @@ bool LORA_MODULE_class::checkMessageValidity(uint8_t current_header_index)
 		float sum = 0;
 		for (uint8_t i = 0; i < CHECKSUM; i++)
 		{
-			sum += tempValues[i];
+			if (tempValues[i] != PREDICTED_VALUE) sum += tempValues[i];
 		}
 
 		#ifdef DEBUGGING
-			Serial.print(F("Calculating Checksum: "));
-			Serial.print(sum, DECIMAL_VALUES);
-			Serial.print(F(" vs "));
-			Serial.println(tempValues[CHECKSUM], DECIMAL_VALUES);
+			debugLog.log(LOG_CHECKSUM, sum, tempValues[CHECKSUM]);
 		#endif
 
 		if (fabs(sum - tempValues[CHECKSUM]) > EPSILON)
 		{
 			#ifdef DEBUGGING
-				Serial.println(F("Checksum is BAD!"));
+				debugLog.log(LOG_CHECKSUM_BAD);
 			#endif
 
 			return false;
@@ -412,7 +554,7 @@ bool LORA_MODULE_class::checkMessageValidity(uint8_t current_header_index)
 		#ifdef DEBUGGING
 			else
 			{
-				Serial.println(F("Checksum is GOOD!"));
+				debugLog.log(LOG_CHECKSUM_GOOD);
 			}
 		#endif
 	}
@@ -431,13 +573,14 @@ void LORA_MODULE_class::processPayloadData()
 		//	Merge current values with data from Payload only when new data is different
 		if (fabs(tempValues[i] - _systemValues[i]) > EPSILON)
 		{
-			bool isDate = strcmp(_loraprevHeader, _validHeaders[DATE]);
+			// Requests are relayed verbatim
+			bool isRequest = strcmp(_loraprevHeader, _validHeaders[BACKFILL]) == 0;
 			_sendAttempts = 0;
 			_systemValues[CHECKSUM] = 0;
 
 			for (uint8_t i = 0; i < MAX_DEVICES - 1; i++)
 			{
-				if(isDate == 0)
+				if(isRequest)
 				{
 					_systemValues[i] = tempValues[i];
 				}
@@ -447,18 +590,21 @@ void LORA_MODULE_class::processPayloadData()
 				}
 
 				// Update Checksum
-				_systemValues[CHECKSUM] += _systemValues[i];
+				if (_systemValues[i] != PREDICTED_VALUE) _systemValues[CHECKSUM] += _systemValues[i];
 			}
 
 			#ifdef DEBUGGING
-				//	Print merged values
-				Serial.print(F("Merged Data: ["));
-				for (uint8_t i = 0; i < MAX_DEVICES; i++)
+				//	Merged values
+				debugLog.log(strcmp(_loraprevHeader, _validHeaders[SOIL_MOISTURE]) == 0 ? LOG_MERGED_RAW : LOG_MERGED_DATA, logFloats(_systemValues, MAX_DEVICES));
+			#endif
+
+			#ifdef EVENT_TRACE
+				uint16_t filled = 0;
+				for (uint8_t i = 0; i < MAX_DEVICES - 1; i++)
 				{
-					Serial.print(strcmp(_loraprevHeader, _validHeaders[SOIL_MOISTURE]) == 0 ? (uint16_t)_systemValues[i] : _systemValues[i], DECIMAL_VALUES);
-					if (i < (MAX_DEVICES - 1)) Serial.print(',');
+					if (_systemValues[i] != 0) filled |= bit(i);
 				}
-				Serial.println(']');
+				eventTrace.add(TRACE_MERGE, 0, filled);
 			#endif
 
 			break;
@@ -475,7 +621,7 @@ void LORA_MODULE_class::sendPayloadData(uint8_t current_header_index)
 	if (_sendAttempts >= SEND_ATTEMPTS)
 	{
 		#ifdef DEBUGGING
-			Serial.println(F("Send Limit Reached!"));
+			debugLog.log(LOG_SEND_LIMIT);
 		#endif
 
 		return;
@@ -492,6 +638,11 @@ void LORA_MODULE_class::sendPayloadData(uint8_t current_header_index)
 			numStr[0] = BLANK_PLACEHOLDER;
     		numStr[1] = '\0';
 		}
+		else if (_systemValues[i] == PREDICTED_VALUE)
+		{
+			numStr[0] = PREDICTED_PLACEHOLDER;
+			numStr[1] = '\0';
+		}
 		else
 		{
 			uint8_t width = MAX_NUMBER_LENGTH;
@@ -510,9 +661,9 @@ void LORA_MODULE_class::sendPayloadData(uint8_t current_header_index)
 				width -= 3;
 			}
 
-			if (strcmp(_loraprevHeader, _validHeaders[SOIL_MOISTURE]) == 0)
+			if (strcmp(_loraprevHeader, _validHeaders[SOIL_MOISTURE]) == 0 || strcmp(_loraprevHeader, _validHeaders[BACKFILL]) == 0)
 			{
-				snprintf(numStr, sizeof(numStr), "%u", (uint16_t)_systemValues[i]);
+				snprintf(numStr, sizeof(numStr), "%02lu", (unsigned long)_systemValues[i]);
 			}
 			else
 			{
@@ -531,25 +682,23 @@ void LORA_MODULE_class::sendPayloadData(uint8_t current_header_index)
 	uint8_t payloadLen = strlen(sendPayload) + 1;
 
 	#ifdef DEBUGGING
-		Serial.print(F("Payload to Send: "));
-		Serial.println(sendPayload);
+		debugLog.log(LOG_SEND_PAYLOAD, logText(sendPayload));
 	#endif
 
 	// Encryption
 	#ifdef ENCRYPTING
 		char encryptedPayload[payloadLen] = {0};
-		strncpy(encryptedPayload, sendPayload, payloadLen);
+		memcpy(encryptedPayload, sendPayload, payloadLen);
 
 		// Encrypt Data
 		rc4EncryptDecrypt(encryptedPayload, payloadLen);
+	#endif
 
-		#ifdef DEBUGGING
-			Serial.print(F("Encrypted Message: "));
-			for (uint8_t i = 0; i < payloadLen; i++)
-			{
-				Serial.print(encryptedPayload[i]);
-			}
-			Serial.println();
+	#ifdef EVENT_TRACE
+		#ifdef ENCRYPTING
+			uint16_t frameId = TRACE_MODULE_class::frameId(encryptedPayload, payloadLen - 1);
+		#else
+			uint16_t frameId = TRACE_MODULE_class::frameId(sendPayload, payloadLen - 1);
 		#endif
 	#endif
 
@@ -559,11 +708,23 @@ void LORA_MODULE_class::sendPayloadData(uint8_t current_header_index)
 		unsigned long startTime = millis();
 		unsigned long lastCheckTime = millis();
 
+		#ifdef DEBUGGING
+			uint16_t backoffSlots = 0;
+		#endif
+
+		#ifdef EVENT_TRACE
+			eventTrace.add(TRACE_BACKOFF, _sendAttempts, _csmaTimeout);
+		#endif
+
 		while (millis() - startTime < _csmaTimeout)
 		{
 			// Check for incoming messages
 			if (LoRa.parsePacket() && getLoRaPayload(current_header_index))
 			{
+				#ifdef EVENT_TRACE
+					eventTrace.add(TRACE_CSMA_INTERRUPT, _sendAttempts, 0);
+				#endif
+
 				_newpayloadAlert = true;
 				return;
 			}
@@ -572,32 +733,39 @@ void LORA_MODULE_class::sendPayloadData(uint8_t current_header_index)
 				lastCheckTime = millis();
 
 				#ifdef DEBUGGING
-					Serial.print('.');
+					backoffSlots++;
 				#endif
 
 				// Perform backoff without blocking execution
 				if (LoRa.packetRssi() < CSMA_NOISE_LIM) break;
 			}
 
+			// Nothing to do but wait, so this is when the debug log goes out
+			#ifdef DEBUGGING
+				debugLog.drain();
+			#endif
+
 			yield();
 		}
 
 		// Send the payload over LoRa
+		#ifdef EVENT_TRACE
+			eventTrace.add(TRACE_TX_START, payloadLen - 1, frameId);
+		#endif
 		LoRa.beginPacket();
 		#ifdef ENCRYPTING
 			LoRa.write((const uint8_t*)encryptedPayload, payloadLen - 1);	// -1 Don't send null terminator
 		#else
 			LoRa.write((const uint8_t*)sendPayload, payloadLen - 1);		// -1 Don't send null terminator
 		#endif
-		LoRa.endPacket(true);												// Set true for non blocking sending
+		LoRa.endPacket();													// Blocking, polling for the next attempt would cut an async send short
+		#ifdef EVENT_TRACE
+			eventTrace.add(TRACE_TX_END, payloadLen - 1, frameId);
+		#endif
 
 		// Debugging output for the sent message
 		#ifdef DEBUGGING
-			Serial.print(F("\nPayload Sent Sucessfully! ("));
-			Serial.print(_sendAttempts + 1);
-			Serial.print('/');
-			Serial.print(SEND_ATTEMPTS);
-			Serial.println(')');
+			debugLog.log(LOG_SENT, (uint8_t)(_sendAttempts + 1), (uint8_t)SEND_ATTEMPTS, backoffSlots);
 		#endif
 
 		// Increment attempts
@@ -605,6 +773,288 @@ void LORA_MODULE_class::sendPayloadData(uint8_t current_header_index)
 	}
 }
 
+bool LORA_MODULE_class::isEventFrame()
+{
+	return strncmp(_loraPayload, EVENT_HEADER, START_OF_BRACKET) == 0;
+}
+
+bool LORA_MODULE_class::checkEventValidity()
+{
+	uint8_t fields = 1;
+	int8_t endIdx = getcharIndex(']');
+
+	if (_loraPayload[START_OF_BRACKET] != '[' || endIdx == -1)
+	{
+		#ifdef DEBUGGING
+			debugLog.log(LOG_NO_EVENT_DATA);
+		#endif
+
+		return false;
+	}
+
+	// Strictly numbers, no placeholders in events
+	for (uint8_t i = START_OF_BRACKET + 1; i < endIdx; i++)
+	{
+		char payloadChar = _loraPayload[i];
+
+		if (payloadChar == ',')
+		{
+			if (_loraPayload[i - 1] == ',' || _loraPayload[i - 1] == '[') return false;
+			fields++;
+		}
+		else if ((payloadChar < '0' || payloadChar > '9') && payloadChar != '.' && payloadChar != '-')
+		{
+			#ifdef DEBUGGING
+				debugLog.log(LOG_BAD_EVENT_CHARACTER);
+			#endif
+
+			return false;
+		}
+	}
+
+	if (fields != EVENT_FIELDS) return false;
+
+	// Last field is the checksum of the others
+	float* tempValues = getpayloadValues();
+	float sum = 0;
+	for (uint8_t i = 0; i < EVENT_FIELDS - 1; i++)
+	{
+		sum += tempValues[i];
+	}
+
+	// The hwid indexes the dedupe table and the seq is kept as a byte
+	if (fabs(sum - tempValues[EVENT_FIELDS - 1]) > EPSILON || tempValues[0] < 0 || tempValues[0] >= MAX_DEVICES - 1 || tempValues[3] < 0 || tempValues[3] > UINT8_MAX)
+	{
+		#ifdef DEBUGGING
+			debugLog.log(LOG_EVENT_CHECKSUM_BAD);
+		#endif
+
+		return false;
+	}
+
+	return true;
+}
+
+void LORA_MODULE_class::handleEvent(IOT_class *iot)
+{
+	float* tempValues = getpayloadValues();
+	uint8_t eventHwid = (uint8_t)tempValues[0];
+	uint8_t eventRule = (uint8_t)tempValues[1];
+	float eventValue = tempValues[2];
+	uint8_t eventSeq = (uint8_t)tempValues[3];
+
+	// Relays and retries repeat the same event, upload it only once
+	if (_lastEventSeq[eventHwid] == eventSeq) return;
+	_lastEventSeq[eventHwid] = eventSeq;
+
+	#ifdef DEBUGGING
+		debugLog.log(LOG_EVENT, eventHwid, eventRule, eventValue);
+	#endif
+
+	iot->queueEvent(eventHwid, eventRule, eventValue);
+}
+
+bool LORA_MODULE_class::isHistoryFrame()
+{
+	return strncmp(_loraPayload, HISTORY_HEADER, START_OF_BRACKET) == 0;
+}
+
+bool LORA_MODULE_class::checkHistoryValidity()
+{
+	// HIST:[hwid,(ago,temp,humi,stmp,smoi,batt)...,checksum], integers only
+	if (_loraPayload[START_OF_BRACKET] != '[' || getcharIndex(']') == -1) return false;
+
+	char *cursor = &_loraPayload[START_OF_BRACKET + 1];
+	long values[2] = { 0, 0 };
+	long sum = 0;
+	uint8_t fields = 0;
+
+	while (*cursor != ']')
+	{
+		char *end;
+		long value = strtol(cursor, &end, 10);
+
+		if (end == cursor || (*end != ',' && *end != ']'))
+		{
+			#ifdef DEBUGGING
+				debugLog.log(LOG_BAD_HISTORY);
+			#endif
+
+			return false;
+		}
+
+		// Keep a running sum that always excludes the latest field, which is the checksum at the end
+		sum += values[1];
+		values[1] = value;
+		if (fields++ == 0) values[0] = value;
+
+		cursor = *end == ',' ? end + 1 : end;
+	}
+
+	if (fields < HISTORY_FIELDS + 2 || (fields - 2) % HISTORY_FIELDS != 0 || values[0] < 0 || values[0] >= MAX_DEVICES - 1 || sum != values[1])
+	{
+		#ifdef DEBUGGING
+			debugLog.log(LOG_HISTORY_CHECKSUM_BAD);
+		#endif
+
+		return false;
+	}
+
+	return true;
+}
+
+void LORA_MODULE_class::handleHistory(IOT_class *iot)
+{
+	char *cursor = &_loraPayload[START_OF_BRACKET + 1];
+	uint8_t hwid = strtol(cursor, &cursor, 10);
+	uint8_t fields = 1;
+	long current[HISTORY_FIELDS] = { 0 };
+
+	// Keep listening while replies are still trickling in
+	_lastSystemUpdateTime = millis();
+
+	for (char *c = cursor; *c != ']'; c++)
+	{
+		if (*c == ',') fields++;
+	}
+
+	// Undo the delta encoding record by record, the trailing field is the checksum
+	for (uint8_t record = 0; record < (fields - 2) / HISTORY_FIELDS; record++)
+	{
+		for (uint8_t i = 0; i < HISTORY_FIELDS; i++)
+		{
+			current[i] += strtol(cursor + 1, &cursor, 10);
+		}
+
+		uint8_t hoursAgo = (uint8_t)current[0];
+
+		// Relays repeat frames, only take hours we are still missing
+		if (hoursAgo >= BACKFILL_HOURS || !(_missedHours[hwid] & bit(hoursAgo))) continue;
+		_missedHours[hwid] &= ~bit(hoursAgo);
+
+		#ifdef DEBUGGING
+			debugLog.log(LOG_BACKFILL, hwid, hoursAgo);
+		#endif
+
+		iot->queueHistory(hwid, (time_t)(_roundHour - hoursAgo) * HOUR_SECONDS,
+			(float)current[1] / HISTORY_CENTI,
+			(float)current[2] / HISTORY_CENTI,
+			(float)current[3] / HISTORY_CENTI,
+			(uint16_t)current[4],
+			(float)current[5] / HISTORY_MILLI);
+	}
+}
+
+bool LORA_MODULE_class::isHealthFrame()
+{
+	return strncmp(_loraPayload, HEALTH_HEADER, START_OF_BRACKET) == 0;
+}
+
+bool LORA_MODULE_class::checkHealthValidity()
+{
+	// HLTH:[hwid,seq,counters...,min free RAM,RTC drift,checksum], integers, only the drift can be negative
+	if (_loraPayload[START_OF_BRACKET] != '[' || getcharIndex(']') == -1) return false;
+
+	char *cursor = &_loraPayload[START_OF_BRACKET + 1];
+	long values[HEALTH_FIELDS];
+	long sum = 0;
+	uint8_t fields = 0;
+
+	while (*cursor != ']')
+	{
+		char *end;
+		long value = strtol(cursor, &end, 10);
+
+		if (end == cursor || (*cursor == '-' && fields != HEALTH_FIELDS - 2) || (*end != ',' && *end != ']') || fields == HEALTH_FIELDS)
+		{
+			#ifdef DEBUGGING
+				debugLog.log(LOG_BAD_HEALTH);
+			#endif
+
+			return false;
+		}
+
+		values[fields++] = value;
+		cursor = *end == ',' ? end + 1 : end;
+	}
+
+	for (uint8_t i = 0; i < fields - 1; i++)
+	{
+		sum += values[i];
+	}
+
+	if (fields != HEALTH_FIELDS || values[0] >= MAX_DEVICES - 1 || sum != values[HEALTH_FIELDS - 1])
+	{
+		#ifdef DEBUGGING
+			debugLog.log(LOG_HEALTH_CHECKSUM_BAD);
+		#endif
+
+		return false;
+	}
+
+	return true;
+}
+
+void LORA_MODULE_class::handleHealth(IOT_class *iot)
+{
+	char *cursor = &_loraPayload[START_OF_BRACKET + 1];
+	uint8_t hwid = strtoul(cursor, &cursor, 10);
+	uint8_t seq = strtoul(cursor + 1, &cursor, 10);
+
+	// Keep listening, a relayed report can arrive late in the round
+	_lastSystemUpdateTime = millis();
+
+	// Every relay repeats the report, upload it only once
+	if (_lastHealthSeq[hwid] == seq) return;
+	_lastHealthSeq[hwid] = seq;
+
+	#ifdef DEBUGGING
+		debugLog.log(LOG_HEALTH, hwid, seq);
+	#endif
+
+	#ifdef HEALTH_REPORTS
+		uint16_t counters[UPLOAD_COUNTERS];
+
+		for (uint8_t i = 0; i < UPLOAD_COUNTERS; i++)
+		{
+			counters[i] = strtoul(cursor + 1, &cursor, 10);
+		}
+
+		// Tenths of a ppm on the air
+		float drift = strtol(cursor + 1, &cursor, 10) / 10.0f;
+
+		iot->queueHealth(hwid, counters, drift);
+	#endif
+}
+
+void LORA_MODULE_class::updateMissedHours()
+{
+	// Age the masks to this round, then mark who stayed silent
+	uint32_t shift = _roundHour - _missedBaseHour;
+
+	for (uint8_t i = 0; i < MAX_DEVICES - 1; i++)
+	{
+		_missedHours[i] = shift >= BACKFILL_HOURS ? 0 : (uint16_t)(_missedHours[i] << shift);
+
+		if (config::ACTIVE_DEVICES[i] && !(_reportedDevices & bit(i)))
+		{
+			_missedHours[i] |= bit(0);
+		}
+	}
+
+	_missedBaseHour = _roundHour;
+}
+
+bool LORA_MODULE_class::hasMissedHours()
+{
+	for (uint8_t i = 0; i < MAX_DEVICES - 1; i++)
+	{
+		if (config::ACTIVE_DEVICES[i] && _missedHours[i] != 0) return true;
+	}
+
+	return false;
+}
+
 #ifdef ENCRYPTING
 	void LORA_MODULE_class::rc4EncryptDecrypt(char *data, uint8_t len)
 	{
@@ -28,6 +28,7 @@
 // LoRa Pins
 #define LORA_RST			D1
 #define LORA_NSS			D8
+#define LORA_DI0			D2		// RxDone interrupt
 
 // LoRa Settings
 #define FREQUENCY			433E6  // 433 MHz
@@ -47,11 +48,36 @@
 #define CSMA_TOUT_MUL		250
 #define CSMA_TOUT_MIN		1500
 
+// Event Frame Settings
+#define EVENT_HEADER		"EVNT:"
+#define EVENT_FIELDS		5		// [hwid,rule,value,seq,checksum]
+#define EVENTS_ONLY			VALID_HEADERS
+
+// Store-and-Forward Settings
+#define HISTORY_HEADER		"HIST:"
+#define HISTORY_FIELDS		6		// Per record: hours ago, temp, humi, stmp, smoi, batt (deltas after the first)
+#define BACKFILL_HOURS		16		// Bits in the per-node request mask
+#define HISTORY_CENTI		100		// Temperature and humidity in hundredths
+#define HISTORY_MILLI		1000	// Battery in millivolts
+#define HOUR_SECONDS		3600UL
+
+// Health Frame Settings
+#define HEALTH_HEADER		"HLTH:"
+#define HEALTH_FIELDS		10		// [hwid,seq,send limits,bad headers,bad frames,bad checksums,watchdog resets,min free RAM,RTC drift,checksum]
+
+// Time Sync Settings
+#define TIME_TAG			'@'		// Requests end in "@epoch.ms", our time as the copy goes on air
+
+// Round Status
+#define ROUND_IDLE			0
+#define ROUND_BUSY			1
+#define ROUND_DATA_READY	2		// Sensor requests done, data can go out while BKFL runs
+
 // Algorithm Settings
 #define CHECKSUM			8
 #define START_OF_BRACKET	5
 #define DECIMAL_VALUES  	5
-#define REQUEST_LENGTH		8
+#define REQUEST_LENGTH		23		// "TEMP:[]@4294967295.999" is 22, but +1 for null terminator
 #define MAX_HEADER_LENGTH	6		// "TEMP:" is 5 actually, but +1 for null terminator
 #define MAX_NUMBER_LENGTH	10		// "000.00000" is 9, but +1 for null terminator
 #define MAX_MESSAGE_LENGTH  97		// "TEMP:[000.00000,000.00000,000.00000,000.00000,000.00000,000.00000,000.00000,000.00000,000.00000]" is 96, but + 1 for null terminator
@@ -70,7 +96,7 @@ class LORA_MODULE_class
 			SOIL_TEMPERATURE,
 			SOIL_MOISTURE,
 			BATT_VOLTAGE,
-			DATE,
+			BACKFILL,
 			VALID_HEADERS
 		};
 		const char* _validHeaders[VALID_HEADERS] =
@@ -80,13 +106,22 @@ class LORA_MODULE_class
 			"STMP:",
 			"SMOI:",
 			"BATT:",
-			"DATE:"
+			"BKFL:"
 		};
 
 		bool _newpayloadAlert;
 		bool _hasNodeReplied;
+		bool _roundActive = false;
+		bool _listening = false;
+		uint8_t _roundIndex;
 		uint8_t _hwid;
 		uint8_t _sendAttempts;
+		int16_t _lastEventSeq[MAX_DEVICES];
+		int16_t _lastHealthSeq[MAX_DEVICES];
+		uint8_t _reportedDevices;
+		uint16_t _missedHours[MAX_DEVICES];		// Bit n set: no data from that node n rounds ago
+		uint32_t _missedBaseHour;
+		uint32_t _roundHour;
 		uint16_t _backoffTime;
 		uint16_t _csmaTimeout;
 		unsigned long _lastSystemUpdateTime;
@@ -102,8 +137,23 @@ class LORA_MODULE_class
 		void processPayloadData();
 		void sendPayloadData(uint8_t current_header_index);
 		void sendRequest(uint8_t index, IOT_class *iot);
+		void formatTimeTag(char *tag, uint8_t size, IOT_class *iot);
+		void openRequest(uint8_t index, IOT_class *iot);
+		uint8_t closeRequest(IDATA *IData, IOT_class *iot, PREDICTOR_class *predictor);
+		void handlePacket(IOT_class *iot);
 		bool checkComplete();
-		void logData(IDATA *IData, uint8_t index);
+		void logData(IDATA *IData, uint8_t index, PREDICTOR_class *predictor);
+		bool isEventFrame();
+		bool checkEventValidity();
+		void handleEvent(IOT_class *iot);
+		bool isHistoryFrame();
+		bool checkHistoryValidity();
+		void handleHistory(IOT_class *iot);
+		bool isHealthFrame();
+		bool checkHealthValidity();
+		void handleHealth(IOT_class *iot);
+		void updateMissedHours();
+		bool hasMissedHours();
 
 		#ifdef ENCRYPTING
 			void rc4EncryptDecrypt(char *data, uint8_t len);
@@ -111,7 +161,8 @@ class LORA_MODULE_class
 
 	public:
 		void Initialize();
-		void startLoRaMesh(IDATA *IData, IOT_class *iot);
+		void startRound(IOT_class *iot);
+		uint8_t Run(IDATA *IData, IOT_class *iot, PREDICTOR_class *predictor, bool packetReceived);
 };
 
 #endif
@@ -0,0 +1,244 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#include "system_node.hpp"
+
+void MQTT_CLIENT_class::Run()
+{
+	if (_state == MQTT_DISCONNECTED)
+	{
+		if (WiFi.status() != WL_CONNECTED || (_lastAttempt != 0 && millis() - _lastAttempt < _backoff)) return;
+
+		connect();
+		return;
+	}
+
+	if (!_client.connected())
+	{
+		disconnect();
+		return;
+	}
+
+	int count = _client.available();
+	if (count > (int)sizeof(_rx) - _rxLength) count = sizeof(_rx) - _rxLength;
+	if (count > 0) _rxLength += _client.read(&_rx[_rxLength], count);
+
+	// Whole packets off the front of the buffer, all of them fit a one byte remaining length
+	while (_state != MQTT_DISCONNECTED && _rxLength >= 2)
+	{
+		uint8_t total = 2 + _rx[1];
+
+		if ((_rx[1] & 0x80) || total > sizeof(_rx))
+		{
+			disconnect();
+			return;
+		}
+		if (_rxLength < total) break;
+
+		_lastReceived = millis();
+		handlePacket(_rx[0] & 0xF0, &_rx[2], _rx[1]);
+
+		memmove(_rx, &_rx[total], _rxLength - total);
+		_rxLength -= total;
+	}
+
+	if (_state == MQTT_CONNECTING)
+	{
+		if (millis() - _lastAttempt >= MQTT_CONNACK_TIMEOUT) disconnect();
+	}
+	else if (_state == MQTT_CONNECTED)
+	{
+		// Ping at half the keep-alive when idle, nothing heard back for one and a half means the link is dead
+		if (millis() - _lastSent >= MQTT_KEEPALIVE * 500UL)
+		{
+			_tx[0] = MQTT_PINGREQ;
+			_tx[1] = 0;
+			send(2);
+		}
+		if (millis() - _lastReceived >= MQTT_KEEPALIVE * 1500UL) disconnect();
+	}
+}
+
+uint16_t MQTT_CLIENT_class::publish(const char *topic, const char *payload, uint16_t length, uint16_t packetId)
+{
+	uint16_t remaining = 2 + strlen(topic) + 2 + length;
+	uint8_t type = MQTT_PUBLISH | MQTT_QOS1;
+
+	if (_state != MQTT_CONNECTED || remaining + 3U > sizeof(_tx)) return 0;
+
+	// A resend keeps its packet ID and says so
+	if (packetId != 0)
+	{
+		type |= MQTT_DUP;
+	}
+	else
+	{
+		if (++_packetId == 0) _packetId = 1;
+		packetId = _packetId;
+	}
+
+	uint16_t at = putHeader(type, remaining);
+	at = putString(at, topic);
+	_tx[at++] = packetId >> 8;
+	_tx[at++] = packetId & 0xFF;
+	memcpy(&_tx[at], payload, length);
+	at += length;
+
+	return send(at) ? packetId : 0;
+}
+
+bool MQTT_CLIENT_class::takeAck(uint16_t &packetId)
+{
+	if (_ackCount == 0) return false;
+
+	packetId = _acks[--_ackCount];
+
+	return true;
+}
+
+bool MQTT_CLIENT_class::takeReconnect()
+{
+	bool reconnected = _reconnected;
+	_reconnected = false;
+
+	return reconnected;
+}
+
+void MQTT_CLIENT_class::connect()
+{
+	_lastAttempt = millis();
+
+	if (!_client.connect(config::MQTT_HOST, config::MQTT_PORT))
+	{
+		#ifdef DEBUGGING
+			Serial.println(F("X: Can't Reach MQTT Broker!"));
+		#endif
+
+		disconnect();
+		return;
+	}
+
+	// Protocol name and level, flags, keep-alive, then the client ID as the whole payload
+	uint16_t at = putHeader(MQTT_CONNECT, 6 + 1 + 1 + 2 + 2 + strlen(config::MQTT_CLIENT_ID));
+	at = putString(at, "MQTT");
+	_tx[at++] = MQTT_LEVEL;
+	_tx[at++] = 0;				// Clean session off, the broker keeps our session across reconnects
+	_tx[at++] = MQTT_KEEPALIVE >> 8;
+	_tx[at++] = MQTT_KEEPALIVE & 0xFF;
+	at = putString(at, config::MQTT_CLIENT_ID);
+
+	_state = MQTT_CONNECTING;
+	_rxLength = 0;
+	send(at);
+}
+
+void MQTT_CLIENT_class::disconnect()
+{
+	_client.stop();
+	_state = MQTT_DISCONNECTED;
+	_rxLength = 0;
+
+	// Backoff doubles on every failure and starts over once a CONNACK comes back
+	_backoff = _backoff == 0 ? MQTT_BACKOFF_MIN : _backoff * 2;
+	if (_backoff > MQTT_BACKOFF_MAX) _backoff = MQTT_BACKOFF_MAX;
+	_lastAttempt = millis();
+
+	#ifdef DEBUGGING
+		Serial.print(F("X: MQTT Disconnected, Retrying In "));
+		Serial.print(_backoff);
+		Serial.println(F(" ms"));
+	#endif
+}
+
+void MQTT_CLIENT_class::handlePacket(uint8_t type, const uint8_t *body, uint8_t length)
+{
+	switch (type)
+	{
+		case MQTT_CONNACK:
+			if (length < 2 || body[1] != 0)
+			{
+				#ifdef DEBUGGING
+					Serial.print(F("X: MQTT Connection Refused: "));
+					Serial.println(length < 2 ? 0 : body[1]);
+				#endif
+
+				disconnect();
+				break;
+			}
+
+			_state = MQTT_CONNECTED;
+			_reconnected = true;
+			_backoff = 0;
+
+			#ifdef DEBUGGING
+				Serial.println(body[0] & 0x01 ? F("MQTT Connected, Session Resumed") : F("MQTT Connected, New Session"));
+			#endif
+			break;
+
+		case MQTT_PUBACK:
+			if (length >= 2 && _ackCount < MQTT_WINDOW) _acks[_ackCount++] = body[0] << 8 | body[1];
+			break;
+
+		default:
+			break;
+	}
+}
+
+uint16_t MQTT_CLIENT_class::putHeader(uint8_t type, uint16_t remaining)
+{
+	uint16_t at = 0;
+
+	// Remaining length, seven bits per byte with the top bit saying another follows
+	_tx[at++] = type;
+	do
+	{
+		uint8_t digit = remaining & 0x7F;
+		remaining >>= 7;
+		_tx[at++] = remaining > 0 ? digit | 0x80 : digit;
+	} while (remaining > 0);
+
+	return at;
+}
+
+uint16_t MQTT_CLIENT_class::putString(uint16_t at, const char *text)
+{
+	uint16_t length = strlen(text);
+
+	_tx[at++] = length >> 8;
+	_tx[at++] = length & 0xFF;
+	memcpy(&_tx[at], text, length);
+
+	return at + length;
+}
+
+bool MQTT_CLIENT_class::send(uint16_t length)
+{
+	if (_client.write(_tx, length) != length)
+	{
+		disconnect();
+		return false;
+	}
+
+	_lastSent = millis();
+
+	return true;
+}
@@ -0,0 +1,86 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#ifndef mqtt_client_h
+#define mqtt_client_h
+
+#include "system_node.hpp"
+
+// MQTT 3.1.1, just the packets a QoS 1 publisher needs
+#define MQTT_CONNECT			0x10
+#define MQTT_CONNACK			0x20
+#define MQTT_PUBLISH			0x30
+#define MQTT_PUBACK				0x40
+#define MQTT_PINGREQ			0xC0
+#define MQTT_PINGRESP			0xD0
+#define MQTT_QOS1				0x02
+#define MQTT_DUP				0x08
+#define MQTT_LEVEL				4
+
+#define MQTT_DISCONNECTED		0
+#define MQTT_CONNECTING			1
+#define MQTT_CONNECTED			2
+
+#define MQTT_KEEPALIVE			60				// Seconds
+#define MQTT_CONNACK_TIMEOUT	5000
+#define MQTT_BACKOFF_MIN		1000
+#define MQTT_BACKOFF_MAX		60000
+#define MQTT_WINDOW				8				// Publishes sent ahead of their PUBACKs
+#define MQTT_TOPIC_LEN			48
+#define MQTT_TX_LEN				256
+#define MQTT_RX_LEN				16				// CONNACK, PUBACK and PINGRESP are all we expect back
+
+class MQTT_CLIENT_class
+{
+	private:
+		WiFiClient _client;
+		uint8_t _state = MQTT_DISCONNECTED;
+		bool _reconnected = false;
+		uint16_t _packetId = 0;
+		unsigned long _backoff = 0;
+		unsigned long _lastAttempt = 0;
+		unsigned long _lastSent = 0;
+		unsigned long _lastReceived = 0;
+
+		uint8_t _rx[MQTT_RX_LEN];
+		uint8_t _rxLength = 0;
+		uint8_t _tx[MQTT_TX_LEN];
+		uint16_t _acks[MQTT_WINDOW];
+		uint8_t _ackCount = 0;
+
+		void connect();
+		void disconnect();
+		void handlePacket(uint8_t type, const uint8_t *body, uint8_t length);
+		uint16_t putHeader(uint8_t type, uint16_t remaining);
+		uint16_t putString(uint16_t at, const char *text);
+		bool send(uint16_t length);
+
+	public:
+		void Run();
+		uint16_t publish(const char *topic, const char *payload, uint16_t length, uint16_t packetId);
+		bool takeAck(uint16_t &packetId);
+		bool takeReconnect();
+
+		bool isConnected() { return _state == MQTT_CONNECTED; }
+};
+
+#endif
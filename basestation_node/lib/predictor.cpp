@@ -0,0 +1,63 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#include "system_node.hpp"
+
+float PREDICTOR_class::Resolve(uint8_t device, uint8_t metric, float value, bool *predicted)
+{
+	*predicted = false;
+
+	if (device >= MAX_DEVICES || metric >= PREDICT_METRICS) return value;
+
+	float &level = _level[device][metric];
+	float &slope = _slope[device][metric];
+	float prediction = level + slope;
+
+	// Real value received, mirror the node's model update
+	if (value != 0 && value != PREDICTED_VALUE)
+	{
+		#if PREDICT_MODE == PREDICT_LINEAR_TREND
+			slope = _primed[device][metric] ? TREND_GAIN * (value - level) : 0;
+		#else
+			slope = 0;
+		#endif
+
+		level = value;
+		_primed[device][metric] = true;
+
+		return value;
+	}
+
+	// Nothing to predict from yet, wait for the node's next forced refresh
+	if (!_primed[device][metric]) return 0;
+
+	// The node samples every hour whether or not we heard it, so step the model on a miss too
+	level = prediction;
+
+	if (value == PREDICTED_VALUE)
+	{
+		*predicted = true;
+		return prediction;
+	}
+
+	return 0;
+}
@@ -0,0 +1,52 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#ifndef predictor_h
+#define predictor_h
+
+#include "system_node.hpp"
+
+// Payload Markers
+#define PREDICTED_PLACEHOLDER	'~'		// Slot is alive and within the shared prediction
+#define PREDICTED_VALUE			-1000	// Outside every sensor range, never summed into the checksum
+
+// Predictor Modes
+#define PREDICT_LAST_VALUE		0
+#define PREDICT_LINEAR_TREND	1
+
+// Predictor Settings (Must match the nodes!)
+#define PREDICT_MODE			PREDICT_LINEAR_TREND
+#define TREND_GAIN				0.5		// Damping on the per-round slope, raw differences are noisy
+#define PREDICT_METRICS			5		// TEMP, HUMI, STMP, SMOI, BATT
+
+class PREDICTOR_class
+{
+	private:
+		bool _primed[MAX_DEVICES][PREDICT_METRICS];
+		float _level[MAX_DEVICES][PREDICT_METRICS];
+		float _slope[MAX_DEVICES][PREDICT_METRICS];
+
+	public:
+		float Resolve(uint8_t device, uint8_t metric, float value, bool *predicted);
+};
+
+#endif
@@ -0,0 +1,40 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#include "system_node.hpp"
+
+void SCHEDULER_class::setTask(uint8_t task, unsigned long interval)
+{
+	// Counted from now, so the task first runs one interval later
+	_interval[task] = interval;
+	_lastRun[task] = millis();
+}
+
+bool SCHEDULER_class::isDue(uint8_t task)
+{
+	// Unsigned subtraction keeps working across the millis() rollover
+	if (millis() - _lastRun[task] < _interval[task]) return false;
+
+	_lastRun[task] = millis();
+
+	return true;
+}
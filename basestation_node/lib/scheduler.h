@@ -0,0 +1,48 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#ifndef scheduler_h
+#define scheduler_h
+
+#include "system_node.hpp"
+
+// Tasks
+#define NTP_TASK			0
+#define QUERY_TASK			1
+#define UPLOAD_TASK			2
+#define MAX_TASKS			3
+
+#define QUERY_CHECK_MS		1000
+#define UPLOAD_CHECK_MS		250
+
+class SCHEDULER_class
+{
+	private:
+		unsigned long _interval[MAX_TASKS] = { 0 };
+		unsigned long _lastRun[MAX_TASKS] = { 0 };
+
+	public:
+		void setTask(uint8_t task, unsigned long interval);
+		bool isDue(uint8_t task);
+};
+
+#endif
@@ -22,6 +22,8 @@
 
 #include "system_node.hpp"
 
+// Define static functions
+volatile bool SYSTEM_class::_interruptbyLoRa = false;
 
 void SYSTEM_class::Initialize()
 {
@@ -31,28 +33,66 @@ void SYSTEM_class::Initialize()
     // Initialize IoT
     _iot.Initialize();
 
-    // Initialize LoRa
+    // Initialize LoRa, then keep it listening on interrupts
     _lora_module.Initialize();
+    attachInterrupt(digitalPinToInterrupt(LORA_DI0), wakeonLoRa, RISING);
+
+    // Time first, the rest starts once the clock is set
+    _scheduler.setTask(NTP_TASK, 0);
+    _scheduler.setTask(QUERY_TASK, QUERY_CHECK_MS);
+    _scheduler.setTask(UPLOAD_TASK, UPLOAD_CHECK_MS);
 }
 
 void SYSTEM_class::Run()
 {
-    // Wait until the scheduled query time
-    _iot.waitUntilQueryTime();
+    // Take the flag atomically so a frame landing right now isn't lost
+    noInterrupts();
+    bool packetReceived = _interruptbyLoRa;
+    _interruptbyLoRa = false;
+    interrupts();
+
+    // Radio first, every other task is short enough to never leave a frame waiting long
+    if (_lora_module.Run(&_IData, &_iot, &_predictor, packetReceived) == ROUND_DATA_READY)
+    {
+        // Display collected data if debugging is enabled
+        #ifdef DEBUGGING
+            displayData();
+        #endif
+
+        // Uploads go out while the backfill request is still running
+        _iot.queueData(_IData);
+    }
+
+    if (_scheduler.isDue(NTP_TASK))
+    {
+        _scheduler.setTask(NTP_TASK, _iot.updateTime());
+    }
 
-    // Clear previous sensor data
-    clearData();
+    if (_scheduler.isDue(QUERY_TASK) && _iot.isQueryTime())
+    {
+        // Clear previous sensor data, then collect via the LoRa mesh network
+        clearData();
+        _lora_module.startRound(&_iot);
+    }
 
-    // Collect sensor data via the LoRa mesh network
-    _lora_module.startLoRaMesh(&_IData, &_iot);
+    // One HTTP request per pass
+    if (_scheduler.isDue(UPLOAD_TASK))
+    {
+        _iot.uploadNext();
+    }
+    _iot.pollCollector();
 
-    // Display collected data if debugging is enabled
+    // The radio's debug log goes out between passes, never in the middle of a frame
     #ifdef DEBUGGING
-        displayData();
+        debugLog.drain();
     #endif
 
-    // Upload the collected data to the cloud
-    _iot.uploadData(_IData);
+    yield();
+}
+
+IRAM_ATTR void SYSTEM_class::wakeonLoRa()
+{
+    _interruptbyLoRa = true;
 }
 
 void SYSTEM_class::clearData()
@@ -62,6 +102,7 @@ void SYSTEM_class::clearData()
     memset(_IData.STMP_DATA, 0, sizeof(_IData.STMP_DATA));
     memset(_IData.SMOI_DATA, 0, sizeof(_IData.SMOI_DATA));
     memset(_IData.BATT_DATA, 0, sizeof(_IData.BATT_DATA));
+    memset(_IData.PRED_FLAGS, 0, sizeof(_IData.PRED_FLAGS));
 }
 
 void SYSTEM_class::Initialize_System()
@@ -151,6 +192,14 @@ void SYSTEM_class::Initialize_System()
         }
         Serial.println("]");
 
+        Serial.print("Predicted Flags: [");
+        for (uint8_t i = 0; i < MAX_DEVICES; ++i)
+        {
+            Serial.print(_IData.PRED_FLAGS[i], BIN);
+            if (i < MAX_DEVICES - 1) Serial.print(", ");
+        }
+        Serial.println("]");
+
         Serial.println("----------------------------------------\n");
     }
 #endif
@@ -29,9 +29,14 @@ class SYSTEM_class
 {
 	private:
 		IDATA&              _IData;
+		SCHEDULER_class&    _scheduler;
 		IOT_class&	        _iot;
+		PREDICTOR_class&    _predictor;
 		LORA_MODULE_class&  _lora_module;
 
+    static volatile bool _interruptbyLoRa;
+
+    static IRAM_ATTR void wakeonLoRa();
     void Initialize_System();
     void clearData();
   
@@ -40,7 +45,7 @@ class SYSTEM_class
     #endif
 
 	public:
-		SYSTEM_class(SystemComponents& class_lib) : _IData(class_lib._IData), _iot(class_lib._iot), _lora_module(class_lib._lora_module) {}
+		SYSTEM_class(SystemComponents& class_lib) : _IData(class_lib._IData), _scheduler(class_lib._scheduler), _iot(class_lib._iot), _predictor(class_lib._predictor), _lora_module(class_lib._lora_module) {}
 
 		void Initialize();
 		void Run();
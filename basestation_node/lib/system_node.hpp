@@ -25,13 +25,25 @@
 
 #define SERIAL_BAUD     115200
 
-#define DEBUGGING
+#define DEBUGGING				// Radio messages are tokenized, read them with tools/log_decode
 #define ENCRYPTING
+#define PREDICTING				// Must match the nodes
+#define STORE_AND_FORWARD		// Must match the nodes
+#define HEALTH_REPORTS			// Node retry and failure counters go to the channel status, must match the nodes
+#define PERSISTENT_UPLOADS		// Upload queue kept on LittleFS through outages and reboots
+// #define COAP_UPLOADS			// Rounds go to our own collector as one CoAP record instead of ThingSpeak
+// #define MQTT_UPLOADS			// Upload queue drains to our own broker instead of ThingSpeak
+// #define EVENT_TRACE			// Radio events of each round dumped to the UART, view with tools/trace_view
 #ifdef ENCRYPTING
 	#define RC4_BYTES 		255
 	#define ENCRYPTION_KEY  "G7v!Xz@a?>Qp!d$1"
 #endif
 
+// gateway_node builds the same LoRa round for Linux, with its own platform layer and uplink
+#ifdef GATEWAY_NODE
+#include "gateway.hpp"
+#else
+
 #include <ESP8266WiFi.h>
 #include <ESP8266HTTPClient.h>
 #include <WiFiClient.h>
@@ -39,11 +51,30 @@
 #include <WiFiUdp.h>
 #include <NTPClient.h>
 #include <LoRa.h>
+#include <LittleFS.h>
 
 #include "config.hpp"
 #include "IDevice.h"
+#ifdef DEBUGGING
+	#include "debug_log.h"
+	#include "debug_log.cpp"
+#endif
+#ifdef EVENT_TRACE
+	#include "trace_module.h"
+	#include "trace_module.cpp"
+#endif
+#include "scheduler.h"
+#include "scheduler.cpp"
+#include "upload_store.h"
+#include "upload_store.cpp"
+#include "coap_uploader.h"
+#include "coap_uploader.cpp"
+#include "mqtt_client.h"
+#include "mqtt_client.cpp"
 #include "iot.h"
 #include "iot.cpp"
+#include "predictor.h"
+#include "predictor.cpp"
 #include "lora_module.h"
 #include "lora_module.cpp"
 
@@ -51,7 +82,9 @@ struct SystemComponents
 {
 	IDATA      			_IData;
 
+	SCHEDULER_class		_scheduler;
 	IOT_class			_iot;
+	PREDICTOR_class		_predictor;
 	LORA_MODULE_class   _lora_module;
 };
 SystemComponents class_lib;
@@ -60,3 +93,5 @@ SystemComponents class_lib;
 #include "system.cpp"
 
 #endif
+
+#endif
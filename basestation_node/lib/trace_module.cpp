@@ -0,0 +1,141 @@
+/*
+  ============================================================
+  Master's Thesis in Electrical and Computer Engineering
+  Faculty of Electrical and Computer Engineering
+  School of Engineering and Natural Sciences, University of Iceland
+
+  Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+		 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+  Researcher: Jezreel Tan
+  Email: jvt6@hi.is
+
+  Supervisors:
+  Helgi Þorbergsson
+  Email: thorberg@hi.is
+
+  Dórótea Höeg Sigurðardóttir
+  Email: dorotea@hi.is
+
+  ============================================================
+*/
+
+#include "system_node.hpp"
+
+TRACE_MODULE_class eventTrace;
+
+void TRACE_MODULE_class::add(uint8_t event, uint8_t length, uint16_t arg)
+{
+	TRACE_RECORD &record = _records[_head];
+	record.time = millis();
+	record.event = event;
+	record.length = length;
+	record.arg = arg;
+
+	_head = (_head + 1) % TRACE_RECORDS;
+	if (_count < TRACE_RECORDS) _count++;
+	else if (_dropped < UINT16_MAX) _dropped++;
+}
+
+void TRACE_MODULE_class::open(time_t t)
+{
+	clear();
+
+	_openEpoch = (uint32_t)t;
+	_openMillis = millis();
+}
+
+void TRACE_MODULE_class::dump(uint8_t hwid, time_t t)
+{
+	_checkSum = 0;
+	writeRaw(TRACE_END);
+	writeByte(TRACE_MAGIC);
+	writeByte(hwid);
+	writeWord(_count);
+	writeWord(_dropped);
+	writeLong(_openEpoch);
+	writeLong(_openMillis);
+	writeLong((uint32_t)t);
+	writeLong(millis());
+
+	// Oldest first
+	for (uint16_t i = 0; i < _count; i++)
+	{
+		const TRACE_RECORD &record = _records[(_head + TRACE_RECORDS - _count + i) % TRACE_RECORDS];
+		writeLong(record.time);
+		writeByte(record.event);
+		writeByte(record.length);
+		writeWord(record.arg);
+	}
+
+	writeByte(_checkSum);
+	writeRaw(TRACE_END);
+
+	#ifdef GATEWAY_NODE
+		if (_output) fflush(_output);
+	#endif
+
+	clear();
+}
+
+void TRACE_MODULE_class::clear()
+{
+	_head = 0;
+	_count = 0;
+	_dropped = 0;
+}
+
+uint16_t TRACE_MODULE_class::frameId(const char *data, uint8_t length)
+{
+	// Hash of the bytes on air, a sender's TX and every receiver's RX of the same frame carry the same ID
+	uint16_t id = 0;
+	for (uint8_t i = 0; i < length; i++) id = id * 33 + (uint8_t)data[i];
+
+	return id;
+}
+
+void TRACE_MODULE_class::writeRaw(uint8_t value)
+{
+	#ifdef GATEWAY_NODE
+		// The gateway's Serial is line based text, dumps go to the --trace file instead
+		if (_output) fputc(value, _output);
+	#else
+		Serial.write(value);
+	#endif
+}
+
+void TRACE_MODULE_class::writeByte(uint8_t value)
+{
+	_checkSum += value;
+
+	switch (value)
+	{
+		case TRACE_END:
+			writeRaw(TRACE_ESC);
+			writeRaw(TRACE_ESC_END);
+			break;
+		case TRACE_ESC:
+			writeRaw(TRACE_ESC);
+			writeRaw(TRACE_ESC_ESC);
+			break;
+		case TRACE_OPENLOG_ESC:
+			writeRaw(TRACE_ESC);
+			writeRaw(TRACE_ESC_SUB);
+			break;
+		default:
+			writeRaw(value);
+			break;
+	}
+}
+
+void TRACE_MODULE_class::writeWord(uint16_t value)
+{
+	writeByte(value & 0xFF);
+	writeByte(value >> 8);
+}
+
+void TRACE_MODULE_class::writeLong(uint32_t value)
+{
+	writeWord(value & 0xFFFF);
+	writeWord(value >> 16);
+}
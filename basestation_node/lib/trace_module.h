@@ -0,0 +1,104 @@
+/*
+  ============================================================
+  Master's Thesis in Electrical and Computer Engineering
+  Faculty of Electrical and Computer Engineering
+  School of Engineering and Natural Sciences, University of Iceland
+
+  Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+		 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+  Researcher: Jezreel Tan
+  Email: jvt6@hi.is
+
+  Supervisors:
+  Helgi Þorbergsson
+  Email: thorberg@hi.is
+
+  Dórótea Höeg Sigurðardóttir
+  Email: dorotea@hi.is
+
+  ============================================================
+*/
+
+#ifndef trace_module_h
+#define trace_module_h
+
+#include "system_node.hpp"
+
+// One round of radio events, opened with the round and dumped to the UART when it ends (tools/trace_view)
+#define TRACE_RECORDS		256		// 8 bytes each, the oldest are overwritten
+#define TRACE_MAGIC			0x54
+
+// Frame: same SLIP framing and checksum as the node's OpenLog frames
+// END, [TRACE_MAGIC, hwid, count u16, dropped u16, open epoch u32, open millis u32, close epoch u32, close millis u32,
+// count x TRACE_RECORD, sum8] escaped, END
+#define TRACE_END			0xC0
+#define TRACE_ESC			0xDB
+#define TRACE_ESC_END		0xDC
+#define TRACE_ESC_ESC		0xDD
+#define TRACE_ESC_SUB		0xDE
+#define TRACE_OPENLOG_ESC	0x1A
+
+// Events, same numbers on the nodes
+#define TRACE_RX			1		// Frame read after RxDone, length = bytes on air, arg = frame ID
+#define TRACE_INVALID		2		// Frame rejected, length = frame kind below, arg = frame ID
+#define TRACE_MERGE			3		// Merged data changed, arg = mask of the filled slots
+#define TRACE_BACKOFF		4		// CSMA wait starts, length = attempt, arg = timeout in ms
+#define TRACE_CSMA_INTERRUPT	5	// A frame arrived during the wait, length = attempt
+#define TRACE_TX_START		6		// length = bytes on air, arg = frame ID
+#define TRACE_TX_END		7		// length = bytes on air, arg = frame ID
+#define TRACE_SLEEP			8		// Nodes only
+#define TRACE_WAKE			9		// Nodes only
+#define TRACE_REQUEST		10		// Request opens, length = header index
+#define TRACE_CLOSE			11		// Request closes, length = header index, arg = mask of the reported nodes
+
+// Frame kinds for TRACE_INVALID
+#define TRACE_DATA_FRAME	0
+#define TRACE_EVENT_FRAME	1
+#define TRACE_HISTORY_FRAME	2
+#define TRACE_HEALTH_FRAME	3
+
+struct TRACE_RECORD
+{
+	uint32_t time;						// millis()
+	uint8_t event;
+	uint8_t length;
+	uint16_t arg;
+};
+
+class TRACE_MODULE_class
+{
+	private:
+		TRACE_RECORD _records[TRACE_RECORDS];
+		uint16_t _head;
+		uint16_t _count;
+		uint16_t _dropped;
+		uint32_t _openEpoch;			// NTP and millis() at the round's start, how tools/trace_view places it
+		uint32_t _openMillis;
+		uint8_t _checkSum;
+
+		#ifdef GATEWAY_NODE
+			FILE *_output = nullptr;
+		#endif
+
+		void writeRaw(uint8_t value);
+		void writeByte(uint8_t value);
+		void writeWord(uint16_t value);
+		void writeLong(uint32_t value);
+
+	public:
+		void add(uint8_t event, uint8_t length, uint16_t arg);
+		void open(time_t t);
+		void dump(uint8_t hwid, time_t t);
+		void clear();
+
+		#ifdef GATEWAY_NODE
+			void setOutput(FILE *output) { _output = output; }
+		#endif
+
+		static uint16_t frameId(const char *data, uint8_t length);
+};
+
+extern TRACE_MODULE_class eventTrace;
+
+#endif
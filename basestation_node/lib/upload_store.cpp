@@ -0,0 +1,274 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#include "system_node.hpp"
+
+bool UPLOAD_STORE_class::Initialize()
+{
+	STORE_HEADER header;
+	STORE_INDEX index;
+	bool torn = false;
+
+	// LittleFS formats itself the first time it can't mount
+	_mounted = LittleFS.begin();
+	if (!_mounted)
+	{
+		#ifdef DEBUGGING
+			Serial.println(F("X: LittleFS Mount Failed, Uploads Kept In RAM Only!"));
+		#endif
+
+		return false;
+	}
+
+	// Left behind when power went during a rewrite, the data file is still the old one
+	if (LittleFS.exists(STORE_TEMP_FILE)) LittleFS.remove(STORE_TEMP_FILE);
+
+	File indexFile = LittleFS.open(STORE_INDEX_FILE, "r");
+	bool indexValid = indexFile && indexFile.read((uint8_t*)&index, sizeof(index)) == sizeof(index) && index.check == ~index.head;
+	if (indexFile) indexFile.close();
+
+	File file = LittleFS.open(STORE_DATA_FILE, "r");
+	if (file && file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) && header.magic == STORE_MAGIC)
+	{
+		uint32_t records = (file.size() - sizeof(header)) / sizeof(UPLOAD_RECORD);
+
+		// Only the end of an append-only file can be torn, walk back to the last whole record
+		while (records > 0)
+		{
+			UPLOAD_RECORD record;
+			uint8_t crc;
+
+			file.seek(sizeof(header) + (records - 1) * sizeof(UPLOAD_RECORD), SeekSet);
+			if (file.read((uint8_t*)&record, sizeof(record)) == sizeof(record))
+			{
+				crc = record.crc;
+				record.crc = 0;
+				if (crc8((uint8_t*)&record, sizeof(record)) == crc) break;
+			}
+			records--;
+		}
+
+		_base = header.base;
+		_tail = _base + records;
+		torn = file.size() != sizeof(header) + records * sizeof(UPLOAD_RECORD);
+		file.close();
+	}
+	else
+	{
+		if (file) file.close();
+
+		// Fresh store, sequence numbers carry on from the index if there is one
+		_base = _tail = indexValid ? index.head : 0;
+		torn = true;
+	}
+
+	_head = indexValid ? index.head : _base;
+	if (_head < _base) _head = _base;
+	if (_head > _tail) _head = _tail;
+
+	if (torn) rewrite();
+
+	#ifdef DEBUGGING
+		Serial.print(F("Upload Store Records: "));
+		Serial.println(count());
+	#endif
+
+	return true;
+}
+
+bool UPLOAD_STORE_class::append(UPLOAD_JOB &job)
+{
+	UPLOAD_RECORD record;
+
+	if (!_mounted) return false;
+
+	encode(job, record);
+
+	File file = LittleFS.open(STORE_DATA_FILE, "a");
+	if (!file) return false;
+
+	bool written = file.write((const uint8_t*)&record, sizeof(record)) == sizeof(record);
+
+	// Cut a short write off again so the next append lands on a record boundary
+	if (!written) file.truncate(sizeof(STORE_HEADER) + (_tail - _base) * sizeof(UPLOAD_RECORD));
+	file.close();
+
+	if (!written)
+	{
+		#ifdef DEBUGGING
+			Serial.println(F("X: Upload Store Write Failed!"));
+		#endif
+
+		return false;
+	}
+
+	job.stored = true;
+	job.seq = _tail++;
+
+	return true;
+}
+
+bool UPLOAD_STORE_class::read(uint32_t seq, UPLOAD_JOB &job)
+{
+	UPLOAD_RECORD record;
+
+	if (!_mounted || seq < _base || seq >= _tail) return false;
+
+	File file = LittleFS.open(STORE_DATA_FILE, "r");
+	if (!file) return false;
+
+	file.seek(sizeof(STORE_HEADER) + (seq - _base) * sizeof(UPLOAD_RECORD), SeekSet);
+	bool complete = file.read((uint8_t*)&record, sizeof(record)) == sizeof(record);
+	file.close();
+
+	uint8_t crc = record.crc;
+	record.crc = 0;
+	if (!complete || crc8((uint8_t*)&record, sizeof(record)) != crc) return false;
+
+	decode(record, job);
+	job.stored = true;
+	job.seq = seq;
+
+	return true;
+}
+
+void UPLOAD_STORE_class::release(uint32_t head)
+{
+	if (!_mounted || head <= _head) return;
+	if (head > _tail) head = _tail;
+
+	_head = head;
+
+	// Drop uploaded records from the start of the file once it's empty or carrying enough dead weight
+	if ((_head == _tail && _tail != _base) || _head - _base >= STORE_COMPACT_RECORDS) rewrite();
+
+	saveIndex();
+}
+
+bool UPLOAD_STORE_class::rewrite()
+{
+	STORE_HEADER header = { STORE_MAGIC, _head };
+	UPLOAD_RECORD record;
+
+	File temp = LittleFS.open(STORE_TEMP_FILE, "w");
+	if (!temp) return false;
+
+	temp.write((const uint8_t*)&header, sizeof(header));
+
+	File file = LittleFS.open(STORE_DATA_FILE, "r");
+	if (file)
+	{
+		file.seek(sizeof(header) + (_head - _base) * sizeof(UPLOAD_RECORD), SeekSet);
+		for (uint32_t seq = _head; seq < _tail; seq++)
+		{
+			if (file.read((uint8_t*)&record, sizeof(record)) != sizeof(record)) break;
+			temp.write((const uint8_t*)&record, sizeof(record));
+		}
+		file.close();
+	}
+	temp.close();
+
+	// The rename swaps records and header in one step, so the index never has to move with them
+	if (!LittleFS.rename(STORE_TEMP_FILE, STORE_DATA_FILE)) return false;
+
+	_base = _head;
+
+	return true;
+}
+
+bool UPLOAD_STORE_class::saveIndex()
+{
+	STORE_INDEX index = { _head, ~_head };
+
+	File file = LittleFS.open(STORE_INDEX_FILE, "w");
+	if (!file) return false;
+
+	bool written = file.write((const uint8_t*)&index, sizeof(index)) == sizeof(index);
+	file.close();
+
+	return written;
+}
+
+uint8_t UPLOAD_STORE_class::crc8(const uint8_t *data, uint8_t length)
+{
+	// Dallas/Maxim CRC-8, reflected
+	uint8_t crc = 0;
+
+	while (length--)
+	{
+		crc ^= *data++;
+		for (uint8_t i = 0; i < 8; i++) crc = crc & 0x01 ? (crc >> 1) ^ 0x8C : crc >> 1;
+	}
+
+	return crc;
+}
+
+void UPLOAD_STORE_class::encode(const UPLOAD_JOB &job, UPLOAD_RECORD &record)
+{
+	memset(&record, 0, sizeof(record));
+
+	record.timestamp = job.timestamp;
+	record.type = job.type;
+	record.hwid = job.hwid;
+	record.flags = job.flags;
+
+	if (job.type == UPLOAD_HEALTH)
+	{
+		memcpy(record.counters, job.counters, sizeof(record.counters));
+	}
+	else
+	{
+		record.temperature = lroundf(job.temperature * 100);
+		record.humidity = lroundf(job.humidity * 100);
+		record.soilTemperature = lroundf(job.soilTemperature * 100);
+		record.soilMoisture = job.soilMoisture;
+		record.battery = lroundf(job.battery * 1000);
+	}
+
+	record.eventValue = lroundf(job.eventValue * 100);
+	record.crc = crc8((uint8_t*)&record, sizeof(record));
+}
+
+void UPLOAD_STORE_class::decode(const UPLOAD_RECORD &record, UPLOAD_JOB &job)
+{
+	memset(&job, 0, sizeof(job));
+
+	job.timestamp = record.timestamp;
+	job.type = record.type;
+	job.hwid = record.hwid;
+	job.flags = record.flags;
+
+	if (record.type == UPLOAD_HEALTH)
+	{
+		memcpy(job.counters, record.counters, sizeof(job.counters));
+	}
+	else
+	{
+		job.temperature = record.temperature / 100.0f;
+		job.humidity = record.humidity / 100.0f;
+		job.soilTemperature = record.soilTemperature / 100.0f;
+		job.soilMoisture = record.soilMoisture;
+		job.battery = record.battery / 1000.0f;
+	}
+
+	job.eventValue = record.eventValue / 100.0f;
+}
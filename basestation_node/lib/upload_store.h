@@ -0,0 +1,128 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#ifndef upload_store_h
+#define upload_store_h
+
+#include "system_node.hpp"
+
+#define UPLOAD_DATA				0
+#define UPLOAD_EVENT			1
+#define UPLOAD_HISTORY			2
+#define UPLOAD_HEALTH			3
+#define UPLOAD_COUNTERS			6
+
+// Health report counters as they are named in the uploads
+static const char *const UPLOAD_COUNTER_NAMES[UPLOAD_COUNTERS] = { "send", "header", "frame", "checksum", "watchdog", "ram" };
+
+// LittleFS Files
+#define STORE_DATA_FILE			"/uploads.bin"	// Header, then records oldest first, only ever appended to
+#define STORE_INDEX_FILE		"/uploads.idx"	// Sequence number of the oldest record not uploaded yet
+#define STORE_TEMP_FILE			"/uploads.tmp"
+#define STORE_MAGIC				0x55504C44		// "UPLD"
+
+#define STORE_MAX_RECORDS		2048			// 48 KB, three weeks of rounds from four nodes
+#define STORE_COMPACT_RECORDS	256				// Rewrite the file once this many uploaded records sit at its start
+
+struct UPLOAD_JOB
+{
+	uint8_t type;
+	uint8_t hwid;
+	uint8_t attempts;
+	uint8_t flags;				// Predicted metrics for data, rule for events
+	bool stored;				// Has a record in the store, seq is valid
+	uint32_t seq;
+	uint16_t packetId;			// MQTT publish waiting on its PUBACK, 0 when not sent
+	time_t timestamp;			// Measurement time, sent as created_at
+	float temperature;
+	float humidity;
+	float soilTemperature;
+	uint16_t soilMoisture;
+	float battery;
+	float eventValue;			// RTC drift in ppm for health reports
+	uint16_t counters[UPLOAD_COUNTERS];
+};
+
+// Fixed point at the precision the upload is sent with, so nothing is lost on the way through flash
+struct UPLOAD_RECORD
+{
+	uint32_t timestamp;
+	uint8_t type;
+	uint8_t hwid;
+	uint8_t flags;
+	uint8_t crc;				// Over the whole record with this byte at 0
+	union
+	{
+		struct
+		{
+			int16_t temperature;		// Hundredths
+			int16_t humidity;
+			int16_t soilTemperature;
+			uint16_t soilMoisture;
+			uint16_t battery;			// Millivolts
+			uint16_t reserved;
+		};
+		uint16_t counters[UPLOAD_COUNTERS];	// Health reports carry no readings
+	};
+	int32_t eventValue;			// Hundredths
+};
+static_assert(sizeof(UPLOAD_RECORD) == 24, "UPLOAD_RECORD must stay 24 bytes");
+
+struct STORE_HEADER
+{
+	uint32_t magic;
+	uint32_t base;				// Sequence number of the first record in the file
+};
+
+struct STORE_INDEX
+{
+	uint32_t head;
+	uint32_t check;				// ~head, catches a torn write
+};
+
+class UPLOAD_STORE_class
+{
+	private:
+		bool _mounted = false;
+		uint32_t _base = 0;
+		uint32_t _head = 0;
+		uint32_t _tail = 0;
+
+		bool rewrite();
+		bool saveIndex();
+		uint8_t crc8(const uint8_t *data, uint8_t length);
+		void encode(const UPLOAD_JOB &job, UPLOAD_RECORD &record);
+		void decode(const UPLOAD_RECORD &record, UPLOAD_JOB &job);
+
+	public:
+		bool Initialize();
+		bool append(UPLOAD_JOB &job);
+		bool read(uint32_t seq, UPLOAD_JOB &job);
+		void release(uint32_t head);
+
+		bool isMounted() { return _mounted; }
+		uint32_t head() { return _head; }
+		uint32_t tail() { return _tail; }
+		uint32_t count() { return _tail - _head; }
+};
+
+#endif
@@ -0,0 +1,130 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+/*
+	turfroofd, the basestation on a Linux board with an SX127x on SPI (Raspberry Pi and a LoRa hat).
+	Runs the same LoRa round as basestation_node and uploads to ThingSpeak over parallel keep-alive
+	connections from a thread of its own.
+
+	Build from the repository root:
+		g++ -std=c++17 -O2 -Wall -pthread -Ibasestation_node/lib -Igateway_node/lib -o turfroofd gateway_node/gateway_node.cpp
+
+	Run:
+		./turfroofd                                   SX127x on /dev/spidev0.0, DIO0 on GPIO 25, RESET on GPIO 17
+		./turfroofd --fake --speed 20 --once          Simulated nodes, one round at 20x, exit 0 if every active node reported
+		./turfroofd --thingspeak 127.0.0.1:8080       Uploads to tools/thingspeak_standin instead
+		./turfroofd --trace rounds.bin                Built with -DEVENT_TRACE, radio events of each round for tools/trace_view
+*/
+
+#define GATEWAY_NODE
+#include "system_node.hpp"
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  --fake               Simulated nodes instead of the SX127x\n"
+		"  --fake-loss P        Drop each simulated reply with probability P\n"
+		"  --speed N            Run the radio side N times faster than real time\n"
+		"  --once               One round now, then drain the uploads and exit\n"
+		"  --spi PATH           spidev device (%s)\n"
+		"  --gpiochip PATH      GPIO character device (%s)\n"
+		"  --dio0 LINE          DIO0 line offset (%d)\n"
+		"  --reset LINE         RESET line offset (%d)\n"
+		"  --thingspeak HOST:PORT\n"
+		"  --quiet              No round debug output\n"
+		#ifdef EVENT_TRACE
+		"  --trace PATH         Append each round's radio events to PATH\n"
+		#endif
+		, name, SPI_DEVICE, GPIO_CHIP, GPIO_DIO0, GPIO_RESET);
+}
+
+int main(int argc, char **argv)
+{
+	const char *spiPath = SPI_DEVICE;
+	const char *chipPath = GPIO_CHIP;
+	uint32_t dio0Line = GPIO_DIO0;
+	uint32_t resetLine = GPIO_RESET;
+	std::string host = config::THINGSPEAK_HOST;
+	uint16_t port = config::THINGSPEAK_PORT;
+	bool fake = false;
+	bool once = false;
+	double loss = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string option = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (option == "--fake") fake = true;
+		else if (option == "--once") once = true;
+		else if (option == "--quiet") Serial.enabled = false;
+		else if (option == "--fake-loss" && hasValue) loss = atof(argv[++i]);
+		else if (option == "--speed" && hasValue) COMPAT_CLOCK_class::setSpeed(std::max(atof(argv[++i]), 0.01));
+		else if (option == "--spi" && hasValue) spiPath = argv[++i];
+		else if (option == "--gpiochip" && hasValue) chipPath = argv[++i];
+		else if (option == "--dio0" && hasValue) dio0Line = atoi(argv[++i]);
+		else if (option == "--reset" && hasValue) resetLine = atoi(argv[++i]);
+		else if (option == "--thingspeak" && hasValue)
+		{
+			std::string value = argv[++i];
+			size_t colon = value.rfind(':');
+
+			host = value.substr(0, colon);
+			if (colon != std::string::npos) port = atoi(value.c_str() + colon + 1);
+		}
+		#ifdef EVENT_TRACE
+		else if (option == "--trace" && hasValue)
+		{
+			FILE *trace = fopen(argv[++i], "ab");
+			if (trace == nullptr)
+			{
+				fprintf(stderr, "X: ERROR: Cannot open %s: %s\n", argv[i], strerror(errno));
+				return 1;
+			}
+			eventTrace.setOutput(trace);
+		}
+		#endif
+		else
+		{
+			usage(argv[0]);
+			return 2;
+		}
+	}
+
+	RADIO_class *radio;
+	if (fake) radio = new FAKE_RADIO_class(loss);
+	else radio = new SX127X_class(spiPath, chipPath, dio0Line, resetLine);
+
+	GATEWAY_class gateway(class_lib, radio);
+
+	if (!gateway.Initialize(host.c_str(), port))
+	{
+		fprintf(stderr, "X: ERROR: Gateway Initialization Failed!\n");
+		return 1;
+	}
+
+	int exitCode = gateway.Run(once);
+	delete radio;
+
+	return exitCode;
+}
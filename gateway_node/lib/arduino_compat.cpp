@@ -0,0 +1,112 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#include "system_node.hpp"
+
+double COMPAT_CLOCK_class::_speed = 1;
+std::chrono::steady_clock::time_point COMPAT_CLOCK_class::_start = std::chrono::steady_clock::now();
+COMPAT_SERIAL_class Serial;
+
+unsigned long COMPAT_CLOCK_class::now()
+{
+	auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _start);
+
+	return (unsigned long)(elapsed.count() * _speed / 1000);
+}
+
+int COMPAT_CLOCK_class::realMs(unsigned long virtualMs)
+{
+	return (int)ceil(virtualMs / _speed);
+}
+
+unsigned long millis()
+{
+	return COMPAT_CLOCK_class::now();
+}
+
+void delay(unsigned long ms)
+{
+	std::this_thread::sleep_for(std::chrono::milliseconds(COMPAT_CLOCK_class::realMs(ms)));
+}
+
+void yield()
+{
+	// Busy loops like the CSMA backoff poll the radio in here, don't spin a whole core on them
+	std::this_thread::sleep_for(std::chrono::microseconds(200));
+}
+
+char *dtostrf(double value, signed char width, unsigned char precision, char *buffer)
+{
+	sprintf(buffer, "%*.*f", width, precision, value);
+
+	return buffer;
+}
+
+static struct tm utc(time_t t)
+{
+	struct tm timeInfo;
+	gmtime_r(&t, &timeInfo);
+
+	return timeInfo;
+}
+
+int hour(time_t t) { return utc(t).tm_hour; }
+int minute(time_t t) { return utc(t).tm_min; }
+int second(time_t t) { return utc(t).tm_sec; }
+int day(time_t t) { return utc(t).tm_mday; }
+int month(time_t t) { return utc(t).tm_mon + 1; }
+int year(time_t t) { return utc(t).tm_year + 1900; }
+
+void COMPAT_SERIAL_class::printNumber(unsigned long value, bool negative, int base)
+{
+	char digits[66];
+	uint8_t count = 0;
+
+	do
+	{
+		uint8_t digit = value % base;
+		digits[count++] = digit < 10 ? '0' + digit : 'A' + digit - 10;
+		value /= base;
+	} while (value > 0);
+
+	if (negative) _line += '-';
+	while (count > 0) _line += digits[--count];
+}
+
+void COMPAT_SERIAL_class::print(double value, int digits)
+{
+	char text[48];
+
+	if (!enabled) return;
+
+	snprintf(text, sizeof(text), "%.*f", digits, value);
+	_line += text;
+}
+
+void COMPAT_SERIAL_class::println()
+{
+	if (!enabled) return;
+
+	_line += '\n';
+	fputs(_line.c_str(), stderr);
+	_line.clear();
+}
@@ -0,0 +1,116 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#ifndef arduino_compat_h
+#define arduino_compat_h
+
+#include "system_node.hpp"
+
+// Pin names the LoRa setup passes through, the gateway wires its radio by GPIO line instead
+#define D1						5
+#define D2						4
+#define D8						15
+
+#define DEC						10
+#define HEX						16
+#define BIN						2
+
+#define F(text)					text
+#define bit(n)					(1UL << (n))
+
+// Clock the Arduino code sees, can run faster than real time so a fake round fits in a CI job
+class COMPAT_CLOCK_class
+{
+	private:
+		static double _speed;
+		static std::chrono::steady_clock::time_point _start;
+
+	public:
+		static void setSpeed(double speed) { _speed = speed; }
+		static double getSpeed() { return _speed; }
+		static unsigned long now();
+		static int realMs(unsigned long virtualMs);
+};
+
+unsigned long millis();
+void delay(unsigned long ms);
+void yield();
+char *dtostrf(double value, signed char width, unsigned char precision, char *buffer);
+
+// TimeLib, always UTC like the basestation
+int hour(time_t t);
+int minute(time_t t);
+int second(time_t t);
+int day(time_t t);
+int month(time_t t);
+int year(time_t t);
+
+// Debug output goes to stderr, one line at a time so the uplink thread's lines don't tear it
+class COMPAT_SERIAL_class
+{
+	private:
+		std::string _line;
+
+		void printNumber(unsigned long value, bool negative, int base);
+
+	public:
+		bool enabled = true;
+
+		void print(const char *text) { if (enabled) _line += text; }
+		void print(char c) { if (enabled) _line += c; }
+		void print(double value, int digits = 2);
+		void println();
+
+		template <typename T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+		void print(T value, int base = DEC)
+		{
+			if (!enabled) return;
+
+			if constexpr (std::is_signed<T>::value)
+			{
+				if (value < 0)
+				{
+					printNumber(-(long)value, true, base);
+					return;
+				}
+			}
+			printNumber(value, false, base);
+		}
+
+		template <typename T>
+		void println(T value)
+		{
+			print(value);
+			println();
+		}
+
+		template <typename T>
+		void println(T value, int format)
+		{
+			print(value, format);
+			println();
+		}
+};
+
+extern COMPAT_SERIAL_class Serial;
+
+#endif
@@ -0,0 +1,293 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#include "system_node.hpp"
+
+static const char *fakeHeaders[FAKE_HEADERS] = { "TEMP:", "HUMI:", "STMP:", "SMOI:", "BATT:" };
+
+FAKE_RADIO_class::~FAKE_RADIO_class()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_running = false;
+	}
+	_wake.notify_one();
+
+	if (_thread.joinable()) _thread.join();
+	if (_event >= 0) close(_event);
+}
+
+bool FAKE_RADIO_class::begin(long frequency)
+{
+	// Every fake node shares the one channel
+	(void)frequency;
+
+	_event = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (_event < 0) return false;
+
+	_running = true;
+	_thread = std::thread(&FAKE_RADIO_class::loop, this);
+
+	return true;
+}
+
+void FAKE_RADIO_class::loop()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	while (_running)
+	{
+		if (_scheduled.empty())
+		{
+			_wake.wait(lock);
+			continue;
+		}
+
+		unsigned long now = millis();
+		if (_scheduled.front().deliverAt > now)
+		{
+			_wake.wait_for(lock, std::chrono::milliseconds(COMPAT_CLOCK_class::realMs(_scheduled.front().deliverAt - now)));
+			continue;
+		}
+
+		// Frame is off the air, raise DIO0
+		_received.push_back(_scheduled.front());
+		_scheduled.pop_front();
+
+		uint64_t one = 1;
+		if (write(_event, &one, sizeof(one)) < 0) break;
+	}
+}
+
+void FAKE_RADIO_class::transmit(const uint8_t *data, uint8_t length)
+{
+	char frame[RADIO_PACKET_LEN + 1];
+
+	memcpy(frame, data, length);
+	#ifdef ENCRYPTING
+		rc4((uint8_t*)frame, length);
+	#endif
+	frame[length] = '\0';
+
+	// Blocking like a real endPacket(), the nodes hear it once it is done
+	delay(airtime(length));
+	handleRequest(frame);
+}
+
+void FAKE_RADIO_class::handleRequest(const char *frame)
+{
+	uint8_t header = 0;
+	char reply[MAX_MESSAGE_LENGTH];
+	unsigned long now = millis();
+	unsigned long deliverAt = now;
+
+	while (header < FAKE_HEADERS && strncmp(frame, fakeHeaders[header], START_OF_BRACKET) != 0) header++;
+
+	// Relays of replies, BKFL and events are not asked of the fake nodes
+	if (header == FAKE_HEADERS) return;
+	if (strncmp(frame + START_OF_BRACKET, "[]", 2) != 0 || (frame[START_OF_BRACKET + 2] != '\0' && frame[START_OF_BRACKET + 2] != TIME_TAG)) return;
+
+	// The time the request went on air at, its last symbol came in a request airtime later
+	unsigned long epoch = 0, millisecond = 0;
+	bool tagged = sscanf(frame + START_OF_BRACKET + 2, "@%lu.%lu", &epoch, &millisecond) == 2;
+	millisecond += airtime(strlen(frame));
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	for (uint8_t hwid = 0; hwid < MAX_DEVICES; hwid++)
+	{
+		if (config::ACTIVE_DEVICES[hwid] != ACTIVE) continue;
+
+		// Copies of the same request, and the gateway's resends within the holdoff, get one answer
+		if (_answeredAt[hwid][header] != 0 && now - _answeredAt[hwid][header] < FAKE_REQUEST_HOLDOFF) continue;
+		_answeredAt[hwid][header] = now | 1;
+
+		if (header == 0) _rounds[hwid]++;
+		buildReply(reply, sizeof(reply), header, hwid);
+
+		// Stamped for the moment the reply starts, the gateway has to cut it off before the frame is checked
+		if (tagged && header == 0 && hwid == FAKE_TIME_RELAY)
+		{
+			size_t length = strlen(reply);
+			unsigned long at = millisecond + (deliverAt + FAKE_REPLY_GAP - now);
+			snprintf(&reply[length], sizeof(reply) - length, "%c%lu.%03lu", TIME_TAG, epoch + at / 1000, at % 1000);
+		}
+
+		// Nodes take turns, one reply on air at a time
+		deliverAt += FAKE_REPLY_GAP + airtime(strlen(reply));
+		if (std::uniform_real_distribution<double>(0, 1)(_random) >= _loss) schedule(reply, deliverAt);
+
+		// Every round rather than every few, behind the data reply like a node's quiet-window report.
+		// Ahead of it, the last node's BATT landed while the gateway was still relaying and the round closed without it
+		#ifdef HEALTH_REPORTS
+			if (header == FAKE_BATT)
+			{
+				char health[MAX_MESSAGE_LENGTH];
+
+				buildHealth(health, sizeof(health), hwid);
+				deliverAt += FAKE_REPLY_GAP + airtime(strlen(health));
+				schedule(health, deliverAt);
+			}
+		#endif
+	}
+
+	_wake.notify_one();
+}
+
+void FAKE_RADIO_class::buildReply(char *text, size_t size, uint8_t header, uint8_t hwid)
+{
+	// Values drift a little round to round, all at least two characters so none reads as a placeholder
+	std::mt19937 values(hwid * 1000 + _rounds[hwid] * FAKE_HEADERS + header);
+	double value;
+	char number[MAX_NUMBER_LENGTH];
+
+	switch (header)
+	{
+		case 0:  value = round(std::uniform_real_distribution<double>(2, 14)(values) * 100) / 100; break;
+		case 1:  value = round(std::uniform_real_distribution<double>(60, 95)(values) * 100) / 100; break;
+		case 2:  value = round(std::uniform_real_distribution<double>(3, 10)(values) * 100) / 100; break;
+		case 3:  value = std::uniform_int_distribution<int>(20, 60)(values); break;
+		default: value = round(std::uniform_real_distribution<double>(3.6, 4.1)(values) * 1000) / 1000; break;
+	}
+
+	if (header == 3) snprintf(number, sizeof(number), "%02lu", (unsigned long)value);
+	else dtostrf(value, 0, DECIMAL_VALUES, number);
+
+	int pos = snprintf(text, size, "%s[", fakeHeaders[header]);
+	for (uint8_t i = 0; i < MAX_DEVICES - 1; i++)
+	{
+		pos += snprintf(&text[pos], size - pos, "%s,", i == hwid ? number : "*");
+	}
+
+	// Only one slot filled, the checksum is the value itself
+	snprintf(&text[pos], size - pos, "%s]", number);
+}
+
+void FAKE_RADIO_class::buildHealth(char *text, size_t size, uint8_t hwid)
+{
+	// HLTH:[hwid,seq,send limits,bad headers,bad frames,bad checksums,watchdog resets,min free RAM,RTC drift,checksum]
+	uint16_t counters[UPLOAD_COUNTERS] = { (uint16_t)(_rounds[hwid] % 3), 0, 0, 0, 0, (uint16_t)(FAKE_FREE_RAM + hwid) };
+	uint8_t seq = _rounds[hwid];
+	int drift = FAKE_DRIFT - hwid;
+	long sum = hwid + seq + drift;
+
+	int pos = snprintf(text, size, "%s[%u,%u,", HEALTH_HEADER, hwid, seq);
+	for (uint8_t i = 0; i < UPLOAD_COUNTERS; i++)
+	{
+		pos += snprintf(&text[pos], size - pos, "%u,", counters[i]);
+		sum += counters[i];
+	}
+
+	snprintf(&text[pos], size - pos, "%d,%ld]", drift, sum);
+}
+
+void FAKE_RADIO_class::schedule(const char *text, unsigned long deliverAt)
+{
+	FAKE_FRAME frame;
+
+	frame.deliverAt = deliverAt;
+	frame.length = strlen(text);
+	memcpy(frame.data, text, frame.length);
+	#ifdef ENCRYPTING
+		rc4(frame.data, frame.length);
+	#endif
+
+	auto at = _scheduled.begin();
+	while (at != _scheduled.end() && at->deliverAt <= deliverAt) at++;
+	_scheduled.insert(at, frame);
+}
+
+int FAKE_RADIO_class::receive(uint8_t *data)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if (_received.empty()) return 0;
+
+	FAKE_FRAME &frame = _received.front();
+	uint8_t length = frame.length;
+	memcpy(data, frame.data, length);
+	_received.pop_front();
+
+	return length;
+}
+
+int FAKE_RADIO_class::packetRssi()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	unsigned long now = millis();
+
+	// Busy channel while a reply is waiting or on air, so the CSMA backoff has something to see
+	if (!_received.empty()) return FAKE_FRAME_RSSI;
+	if (!_scheduled.empty() && _scheduled.front().deliverAt - airtime(_scheduled.front().length) <= now) return FAKE_FRAME_RSSI;
+
+	return FAKE_NOISE_RSSI;
+}
+
+void FAKE_RADIO_class::clearEvent()
+{
+	uint64_t value;
+
+	if (read(_event, &value, sizeof(value)) < 0) return;
+}
+
+unsigned long FAKE_RADIO_class::airtime(uint8_t length)
+{
+	// Semtech AN1200.13, explicit header with CRC
+	double symbol = (double)(1L << _spreadingFactor) / _bandwidth * 1000;
+	int lowRate = symbol > 16 ? 1 : 0;
+	double payload = ceil((8.0 * length - 4 * _spreadingFactor + 28 + 16) / (4 * (_spreadingFactor - 2 * lowRate)));
+
+	return (unsigned long)((_preamble + 4.25) * symbol + (8 + std::max(payload, 0.0) * _codingRate) * symbol);
+}
+
+#ifdef ENCRYPTING
+	void FAKE_RADIO_class::rc4(uint8_t *data, uint8_t length)
+	{
+		// Copy of the basestation's cipher, 255 byte state and all
+		uint8_t S[RC4_BYTES];
+		for (uint8_t i = 0; i < RC4_BYTES; i++)
+		{
+			S[i] = i;
+		}
+
+		uint8_t j = 0, temp;
+		uint8_t enc_len = strlen(ENCRYPTION_KEY);
+		for (uint8_t i = 0; i < RC4_BYTES; i++)
+		{
+			j = (j + S[i] + ENCRYPTION_KEY[i % enc_len]) % RC4_BYTES;
+			temp = S[i];
+			S[i] = S[j];
+			S[j] = temp;
+		}
+
+		uint8_t i = 0; j = 0;
+		for (uint8_t n = 0; n < length; n++)
+		{
+			i = (i + 1) % RC4_BYTES;
+			j = (j + S[i]) % RC4_BYTES;
+			temp = S[i];
+			S[i] = S[j];
+			S[j] = temp;
+			data[n] ^= S[(S[i] + S[j]) % RC4_BYTES];
+		}
+	}
+#endif
@@ -0,0 +1,98 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#ifndef fake_radio_h
+#define fake_radio_h
+
+#include "system_node.hpp"
+
+#define FAKE_NOISE_RSSI			-118
+#define FAKE_FRAME_RSSI			-62
+#define FAKE_REPLY_GAP			250				// Between one node's reply ending and the next one's starting
+#define FAKE_REQUEST_HOLDOFF	(LORA_REQ_TIMEOUT / LORA_REQ_RESEND_DIV / 2)	// Copies of one request get one answer
+#define FAKE_TIME_RELAY			1				// HW ID whose TEMP reply carries the request's time on, like a relay's
+#define FAKE_HEADERS			5				// TEMP to BATT answered with data
+#define FAKE_BATT				4
+#define FAKE_FREE_RAM			412				// Bytes between heap and stack a node reports
+#define FAKE_DRIFT				3				// Tenths of a ppm the RTC of node 0 runs fast, one less per hwid after
+
+struct FAKE_FRAME
+{
+	unsigned long deliverAt;					// Virtual ms
+	uint8_t length;
+	uint8_t data[RADIO_PACKET_LEN];
+};
+
+// The active nodes of config.hpp answering over the air, so the daemon can run a full round in CI
+// without hardware. Replies go through the same RC4 and validity checks a real node's would.
+class FAKE_RADIO_class : public RADIO_class
+{
+	private:
+		int _event = -1;
+		std::thread _thread;
+		std::mutex _mutex;
+		std::condition_variable _wake;
+		bool _running = false;
+
+		std::deque<FAKE_FRAME> _scheduled;		// Replies still in the air, ordered by deliverAt
+		std::deque<FAKE_FRAME> _received;		// Delivered, waiting for receive()
+		unsigned long _answeredAt[MAX_DEVICES][FAKE_HEADERS] = {};
+		uint16_t _rounds[MAX_DEVICES] = {};
+
+		int _spreadingFactor = SPREAD_FACTOR;
+		long _bandwidth = BANDWIDTH;
+		int _codingRate = CODING_RATE;
+		long _preamble = PREAMBLE;
+		double _loss;
+		std::mt19937 _random;
+
+		void loop();
+		void handleRequest(const char *frame);
+		void schedule(const char *text, unsigned long deliverAt);
+		void buildReply(char *text, size_t size, uint8_t header, uint8_t hwid);
+		void buildHealth(char *text, size_t size, uint8_t hwid);
+		unsigned long airtime(uint8_t length);
+
+		#ifdef ENCRYPTING
+			void rc4(uint8_t *data, uint8_t length);
+		#endif
+
+	public:
+		FAKE_RADIO_class(double loss) : _loss(loss), _random(config::HW_ID) {}
+		~FAKE_RADIO_class();
+
+		bool begin(long frequency) override;
+		void setSignalBandwidth(long bandwidth) override { _bandwidth = bandwidth; }
+		void setSpreadingFactor(int spreadingFactor) override { _spreadingFactor = spreadingFactor; }
+		void setCodingRate4(int denominator) override { _codingRate = denominator; }
+		void setPreambleLength(long length) override { _preamble = length; }
+
+		void transmit(const uint8_t *data, uint8_t length) override;
+		void listen() override {}
+		int receive(uint8_t *data) override;
+		int packetRssi() override;
+
+		int eventFd() override { return _event; }
+		void clearEvent() override;
+};
+
+#endif
@@ -0,0 +1,103 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#ifndef gateway_hpp_included
+#define gateway_hpp_included
+
+// Linux gateway build, pulled in by system_node.hpp when GATEWAY_NODE is set. The LoRa round and
+// predictor are the basestation's own files, compiled against the Arduino and LoRa stand-ins below.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <linux/gpio.h>
+#include <linux/spi/spidev.h>
+
+#include "arduino_compat.h"
+#include "arduino_compat.cpp"
+#include "lora_compat.h"
+#include "lora_compat.cpp"
+
+#include "config.hpp"
+#include "IDevice.h"
+#ifdef DEBUGGING
+	#include "log_format.h"
+	#include "debug_log.h"
+	#include "debug_log.cpp"
+#endif
+#ifdef EVENT_TRACE
+	#include "trace_module.h"
+	#include "trace_module.cpp"
+#endif
+#include "upload_store.h"
+#include "spsc_queue.h"
+#include "uplink.h"
+#include "uplink.cpp"
+#include "gateway_iot.h"
+#include "gateway_iot.cpp"
+#include "predictor.h"
+#include "predictor.cpp"
+#include "lora_module.h"
+#include "lora_module.cpp"
+#include "sx127x_radio.h"
+#include "sx127x_radio.cpp"
+#include "fake_radio.h"
+#include "fake_radio.cpp"
+
+struct SystemComponents
+{
+	IDATA      			_IData;
+
+	IOT_class			_iot;
+	PREDICTOR_class		_predictor;
+	LORA_MODULE_class   _lora_module;
+	UPLINK_class		_uplink;
+};
+SystemComponents class_lib;
+
+#include "gateway_system.h"
+#include "gateway_system.cpp"
+
+#endif
@@ -0,0 +1,125 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#include "system_node.hpp"
+
+void IOT_class::Initialize(UPLINK_class *uplink)
+{
+	_uplink = uplink;
+}
+
+bool IOT_class::isQueryTime()
+{
+	time_t now = timeClient.getEpochTime();
+
+	// SECOND_BREAK into MINUTE_BREAK, only one round per hour
+	if (minute(now) == MINUTE_BREAK && second(now) * 1000UL >= SECOND_BREAK && hour(now) != _lastQueryHour)
+	{
+		_lastQueryHour = hour(now);
+		return true;
+	}
+
+	return false;
+}
+
+void IOT_class::queueData(IDATA IData)
+{
+	UPLOAD_JOB job = {};
+	job.type = UPLOAD_DATA;
+	job.timestamp = timeClient.getEpochTime();
+
+	for (uint8_t i = 0; i < MAX_DEVICES; i++)
+	{
+		if (config::ACTIVE_DEVICES[i] != ACTIVE) continue;
+
+		job.hwid = i;
+		job.flags = IData.PRED_FLAGS[i];
+		job.temperature = IData.TEMP_DATA[i];
+		job.humidity = IData.HUMI_DATA[i];
+		job.soilTemperature = IData.STMP_DATA[i];
+		job.soilMoisture = IData.SMOI_DATA[i];
+		job.battery = IData.BATT_DATA[i];
+		queueJob(job);
+	}
+}
+
+void IOT_class::queueEvent(uint8_t hwid, uint8_t rule, float value)
+{
+	UPLOAD_JOB job = {};
+
+	if (hwid >= MAX_DEVICES || config::ACTIVE_DEVICES[hwid] != ACTIVE) return;
+
+	job.type = UPLOAD_EVENT;
+	job.hwid = hwid;
+	job.timestamp = timeClient.getEpochTime();
+	job.flags = rule;
+	job.eventValue = value;
+	queueJob(job);
+}
+
+void IOT_class::queueHistory(uint8_t hwid, time_t timestamp, float temp, float humi, float stmp, uint16_t smoi, float batt)
+{
+	UPLOAD_JOB job = {};
+
+	if (hwid >= MAX_DEVICES || config::ACTIVE_DEVICES[hwid] != ACTIVE) return;
+
+	job.type = UPLOAD_HISTORY;
+	job.hwid = hwid;
+	job.timestamp = timestamp;
+	job.temperature = temp;
+	job.humidity = humi;
+	job.soilTemperature = stmp;
+	job.soilMoisture = smoi;
+	job.battery = batt;
+	queueJob(job);
+}
+
+void IOT_class::queueHealth(uint8_t hwid, const uint16_t *counters, float drift)
+{
+	UPLOAD_JOB job = {};
+
+	if (hwid >= MAX_DEVICES || config::ACTIVE_DEVICES[hwid] != ACTIVE) return;
+
+	job.type = UPLOAD_HEALTH;
+	job.hwid = hwid;
+	job.timestamp = timeClient.getEpochTime();
+	memcpy(job.counters, counters, sizeof(job.counters));
+	job.eventValue = drift;
+	queueJob(job);
+}
+
+void IOT_class::queueJob(UPLOAD_JOB &job)
+{
+	// Never blocks the radio thread, the uplink only falls this far behind if it is stuck
+	if (!_uplink->jobs.push(job))
+	{
+		_dropped++;
+
+		#ifdef DEBUGGING
+			Serial.println(F("X: Uplink queue full, job dropped!"));
+		#endif
+
+		return;
+	}
+
+	_uplink->notify();
+}
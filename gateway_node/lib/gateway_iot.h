@@ -0,0 +1,73 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#ifndef gateway_iot_h
+#define gateway_iot_h
+
+#include "system_node.hpp"
+
+#define MINUTE_BREAK			0
+#define SECOND_BREAK			30000
+
+// The host keeps its own time with chrony or systemd-timesyncd, no NTP client of our own
+class SYSTEM_CLOCK_class
+{
+	public:
+		unsigned long getEpochTime() { return (unsigned long)time(NULL); }
+
+		unsigned long getEpochTime(uint16_t *millisecond)
+		{
+			struct timespec now;
+			clock_gettime(CLOCK_REALTIME, &now);
+			*millisecond = now.tv_nsec / 1000000;
+			return (unsigned long)now.tv_sec;
+		}
+};
+
+// Same interface the LoRa round calls into on the basestation, jobs go to the uplink thread instead
+class IOT_class
+{
+	friend class LORA_MODULE_class;
+
+	private:
+		SYSTEM_CLOCK_class timeClient;
+
+		UPLINK_class *_uplink = NULL;
+		int _lastQueryHour = -1;
+		unsigned long _dropped = 0;
+
+		void queueJob(UPLOAD_JOB &job);
+
+	public:
+		void Initialize(UPLINK_class *uplink);
+		bool isQueryTime();
+		void queueData(IDATA IData);
+		void queueEvent(uint8_t hwid, uint8_t rule, float value);
+		void queueHistory(uint8_t hwid, time_t timestamp, float temp, float humi, float stmp, uint16_t smoi, float batt);
+		void queueHealth(uint8_t hwid, const uint16_t *counters, float drift);
+
+		unsigned long getEpochTime() { return timeClient.getEpochTime(); }
+		unsigned long getEpochTime(uint16_t *millisecond) { return timeClient.getEpochTime(millisecond); }
+		unsigned long dropped() { return _dropped; }
+};
+
+#endif
@@ -0,0 +1,205 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#include "system_node.hpp"
+
+bool GATEWAY_class::Initialize(const char *host, uint16_t port)
+{
+	sigset_t signals;
+	epoll_event event = {};
+
+	// Taken through signalfd, and blocked before any thread starts so every thread inherits the mask
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &signals, NULL);
+	_signal = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+
+	// Uplink first, the round can queue jobs as soon as it starts
+	if (!_uplink.Initialize(host, port)) return false;
+	_uplink.start();
+	_iot.Initialize(&_uplink);
+
+	LoRa.setRadio(_radio);
+	_lora_module.Initialize();
+
+	_epoll = epoll_create1(EPOLL_CLOEXEC);
+	if (_epoll < 0 || _signal < 0 || _radio->eventFd() < 0) return false;
+
+	event.events = EPOLLIN;
+	event.data.u32 = EVENT_RADIO;
+	epoll_ctl(_epoll, EPOLL_CTL_ADD, _radio->eventFd(), &event);
+
+	event.data.u32 = EVENT_SIGNAL;
+	epoll_ctl(_epoll, EPOLL_CTL_ADD, _signal, &event);
+
+	return true;
+}
+
+int GATEWAY_class::Run(bool once)
+{
+	uint8_t status = ROUND_IDLE;
+	bool reported = false;
+	bool stopping = false;
+
+	if (once)
+	{
+		clearData();
+		_lora_module.startRound(&_iot);
+		status = ROUND_BUSY;
+	}
+
+	while (!stopping)
+	{
+		epoll_event events[2];
+		bool packetReceived = false;
+		int count = epoll_wait(_epoll, events, 2, status == ROUND_IDLE ? IDLE_POLL_MS : COMPAT_CLOCK_class::realMs(ROUND_POLL_MS));
+
+		for (int i = 0; i < count; i++)
+		{
+			if (events[i].data.u32 == EVENT_RADIO)
+			{
+				_radio->clearEvent();
+				packetReceived = true;
+			}
+			else
+			{
+				stopping = true;
+			}
+		}
+
+		status = _lora_module.Run(&_IData, &_iot, &_predictor, packetReceived);
+
+		// Expanded here rather than on a UART, before anything else prints
+		#ifdef DEBUGGING
+			debugLog.drain();
+		#endif
+
+		if (status == ROUND_DATA_READY)
+		{
+			#ifdef DEBUGGING
+				displayData();
+			#endif
+
+			// Uploads go out on the uplink thread while the backfill request is still running
+			_iot.queueData(_IData);
+			reported = allReported();
+		}
+
+		if (once)
+		{
+			if (status == ROUND_IDLE) break;
+		}
+		else if (status == ROUND_IDLE && _iot.isQueryTime())
+		{
+			clearData();
+			_lora_module.startRound(&_iot);
+			status = ROUND_BUSY;
+		}
+	}
+
+	// Whatever is still queued gets its chance to go out
+	_uplink.stop();
+
+	if (_iot.dropped() > 0) fprintf(stderr, "Gateway: %lu jobs dropped on a full uplink queue\n", _iot.dropped());
+
+	return once && !reported ? 1 : 0;
+}
+
+bool GATEWAY_class::allReported()
+{
+	for (uint8_t i = 0; i < MAX_DEVICES; i++)
+	{
+		if (config::ACTIVE_DEVICES[i] != ACTIVE) continue;
+
+		if (_IData.TEMP_DATA[i] == 0 || _IData.HUMI_DATA[i] == 0 || _IData.STMP_DATA[i] == 0 || _IData.SMOI_DATA[i] == 0 || _IData.BATT_DATA[i] == 0) return false;
+	}
+
+	return true;
+}
+
+void GATEWAY_class::clearData()
+{
+	memset(_IData.TEMP_DATA, 0, sizeof(_IData.TEMP_DATA));
+	memset(_IData.HUMI_DATA, 0, sizeof(_IData.HUMI_DATA));
+	memset(_IData.STMP_DATA, 0, sizeof(_IData.STMP_DATA));
+	memset(_IData.SMOI_DATA, 0, sizeof(_IData.SMOI_DATA));
+	memset(_IData.BATT_DATA, 0, sizeof(_IData.BATT_DATA));
+	memset(_IData.PRED_FLAGS, 0, sizeof(_IData.PRED_FLAGS));
+}
+
+#ifdef DEBUGGING
+	void GATEWAY_class::displayRow(const char *name, const float *values)
+	{
+		Serial.print(name);
+		Serial.print(": [");
+		for (uint8_t i = 0; i < MAX_DEVICES; ++i)
+		{
+			if (values[i] == 0)
+			{
+				Serial.print(BLANK_PLACEHOLDER);
+			}
+			else
+			{
+				Serial.print(values[i], DECIMAL_VALUES);
+			}
+			if (i < MAX_DEVICES - 1) Serial.print(", ");
+		}
+		Serial.println("]");
+	}
+
+	void GATEWAY_class::displayData()
+	{
+		Serial.println("\n---- Sensor Data Contents ----");
+
+		displayRow("Air Temperature", _IData.TEMP_DATA);
+		displayRow("Humidity", _IData.HUMI_DATA);
+		displayRow("Soil Temperature", _IData.STMP_DATA);
+
+		Serial.print("Soil Moisture: [");
+		for (uint8_t i = 0; i < MAX_DEVICES; ++i)
+		{
+			if (_IData.SMOI_DATA[i] == 0)
+			{
+				Serial.print(BLANK_PLACEHOLDER);
+			}
+			else
+			{
+				Serial.print(_IData.SMOI_DATA[i]);
+			}
+			if (i < MAX_DEVICES - 1) Serial.print(", ");
+		}
+		Serial.println("]");
+
+		displayRow("Battery Voltage", _IData.BATT_DATA);
+
+		Serial.print("Predicted Flags: [");
+		for (uint8_t i = 0; i < MAX_DEVICES; ++i)
+		{
+			Serial.print(_IData.PRED_FLAGS[i], BIN);
+			if (i < MAX_DEVICES - 1) Serial.print(", ");
+		}
+		Serial.println("]");
+
+		Serial.println("----------------------------------------\n");
+	}
+#endif
@@ -0,0 +1,65 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#ifndef gateway_system_h
+#define gateway_system_h
+
+#include "system_node.hpp"
+
+#define ROUND_POLL_MS			20				// Virtual ms between passes while a round runs, timeouts and resends
+#define IDLE_POLL_MS			1000			// Real ms, only the query time to check between frames
+
+// epoll tags
+#define EVENT_RADIO				0
+#define EVENT_SIGNAL			1
+
+// The basestation's SYSTEM_class on Linux. This thread is the radio thread, the round runs here
+// exactly as on the ESP, woken by DIO0 through epoll instead of an interrupt flag.
+class GATEWAY_class
+{
+	private:
+		IDATA&              _IData;
+		IOT_class&	        _iot;
+		PREDICTOR_class&    _predictor;
+		LORA_MODULE_class&  _lora_module;
+		UPLINK_class&       _uplink;
+		RADIO_class*        _radio;
+
+		int _epoll = -1;
+		int _signal = -1;
+
+		void clearData();
+		bool allReported();
+
+		#ifdef DEBUGGING
+			void displayRow(const char *name, const float *values);
+			void displayData();
+		#endif
+
+	public:
+		GATEWAY_class(SystemComponents& class_lib, RADIO_class *radio) : _IData(class_lib._IData), _iot(class_lib._iot), _predictor(class_lib._predictor), _lora_module(class_lib._lora_module), _uplink(class_lib._uplink), _radio(radio) {}
+
+		bool Initialize(const char *host, uint16_t port);
+		int Run(bool once);
+};
+
+#endif
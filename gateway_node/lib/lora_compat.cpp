@@ -0,0 +1,58 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#include "system_node.hpp"
+
+LoRaClass LoRa;
+
+int LoRaClass::beginPacket()
+{
+	_txLength = 0;
+
+	return 1;
+}
+
+size_t LoRaClass::write(const uint8_t *buffer, size_t size)
+{
+	if (size > sizeof(_tx) - _txLength) size = sizeof(_tx) - _txLength;
+
+	memcpy(&_tx[_txLength], buffer, size);
+	_txLength += size;
+
+	return size;
+}
+
+int LoRaClass::endPacket()
+{
+	_radio->transmit(_tx, _txLength);
+
+	return 1;
+}
+
+int LoRaClass::parsePacket()
+{
+	// Whole frame comes off the radio in one go, read() hands it out byte by byte like the FIFO does
+	_rxLength = _radio->receive(_rx);
+	_rxIndex = 0;
+
+	return _rxLength;
+}
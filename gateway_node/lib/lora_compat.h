@@ -0,0 +1,90 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#ifndef lora_compat_h
+#define lora_compat_h
+
+#include "system_node.hpp"
+
+#define RADIO_PACKET_LEN		256
+
+// What a radio backend has to do, the LoRa library calls below are built on it
+class RADIO_class
+{
+	public:
+		virtual ~RADIO_class() {}
+
+		virtual bool begin(long frequency) = 0;
+		virtual void setTxPower(int level) { (void)level; }
+		virtual void setSignalBandwidth(long bandwidth) { (void)bandwidth; }
+		virtual void setSyncWord(int syncWord) { (void)syncWord; }
+		virtual void setSpreadingFactor(int spreadingFactor) { (void)spreadingFactor; }
+		virtual void setCodingRate4(int denominator) { (void)denominator; }
+		virtual void setPreambleLength(long length) { (void)length; }
+		virtual void enableCrc() {}
+
+		virtual void transmit(const uint8_t *data, uint8_t length) = 0;	// Returns once the frame is on air and done
+		virtual void listen() = 0;											// Continuous receive
+		virtual int receive(uint8_t *data) = 0;								// Length of a waiting frame, 0 if none
+		virtual int packetRssi() = 0;
+
+		virtual int eventFd() = 0;											// Readable when a frame may be waiting, for epoll
+		virtual void clearEvent() = 0;
+};
+
+// The sandeepmistry LoRa API the basestation round is written against
+class LoRaClass
+{
+	private:
+		RADIO_class *_radio = NULL;
+		uint8_t _rx[RADIO_PACKET_LEN];
+		uint8_t _tx[RADIO_PACKET_LEN];
+		int _rxLength = 0;
+		int _rxIndex = 0;
+		int _txLength = 0;
+
+	public:
+		void setRadio(RADIO_class *radio) { _radio = radio; }
+
+		void setPins(int ss, int reset, int dio0) { (void)ss; (void)reset; (void)dio0; }
+		int begin(long frequency) { return _radio->begin(frequency); }
+		void setTxPower(int level) { _radio->setTxPower(level); }
+		void setSignalBandwidth(long bandwidth) { _radio->setSignalBandwidth(bandwidth); }
+		void setSyncWord(int syncWord) { _radio->setSyncWord(syncWord); }
+		void setSpreadingFactor(int spreadingFactor) { _radio->setSpreadingFactor(spreadingFactor); }
+		void setCodingRate4(int denominator) { _radio->setCodingRate4(denominator); }
+		void setPreambleLength(long length) { _radio->setPreambleLength(length); }
+		void enableCrc() { _radio->enableCrc(); }
+
+		int beginPacket();
+		size_t write(const uint8_t *buffer, size_t size);
+		int endPacket();
+		int parsePacket();
+		int available() { return _rxLength - _rxIndex; }
+		int read() { return _rxIndex < _rxLength ? _rx[_rxIndex++] : -1; }
+		int packetRssi() { return _radio->packetRssi(); }
+		void receive() { _radio->listen(); }
+};
+
+extern LoRaClass LoRa;
+
+#endif
@@ -0,0 +1,73 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#ifndef spsc_queue_h
+#define spsc_queue_h
+
+#include "system_node.hpp"
+
+#define CACHE_LINE				64
+
+// Single producer, single consumer ring, no locks. Head and tail sit on their own cache lines so
+// the radio thread pushing and the uplink thread popping don't keep stealing the line from each other.
+template <typename T, size_t N>
+class SPSC_QUEUE
+{
+	static_assert(N > 0 && (N & (N - 1)) == 0, "SPSC_QUEUE size must be a power of two");
+
+	private:
+		alignas(CACHE_LINE) std::atomic<size_t> _head{0};		// Written by the consumer only
+		alignas(CACHE_LINE) std::atomic<size_t> _tail{0};		// Written by the producer only
+		alignas(CACHE_LINE) T _items[N];
+
+	public:
+		bool push(const T &item)
+		{
+			size_t tail = _tail.load(std::memory_order_relaxed);
+
+			if (tail - _head.load(std::memory_order_acquire) == N) return false;
+
+			_items[tail & (N - 1)] = item;
+			_tail.store(tail + 1, std::memory_order_release);
+
+			return true;
+		}
+
+		bool pop(T &item)
+		{
+			size_t head = _head.load(std::memory_order_relaxed);
+
+			if (head == _tail.load(std::memory_order_acquire)) return false;
+
+			item = _items[head & (N - 1)];
+			_head.store(head + 1, std::memory_order_release);
+
+			return true;
+		}
+
+		size_t size()
+		{
+			return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+		}
+};
+
+#endif
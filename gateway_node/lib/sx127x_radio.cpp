@@ -0,0 +1,314 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#include "system_node.hpp"
+
+SX127X_class::~SX127X_class()
+{
+	if (_spi >= 0) close(_spi);
+	if (_dio0 >= 0) close(_dio0);
+	if (_reset >= 0) close(_reset);
+}
+
+bool SX127X_class::begin(long frequency)
+{
+	uint8_t mode = SPI_MODE_0;
+	uint32_t speed = SPI_SPEED_HZ;
+
+	_spi = open(_spiPath, O_RDWR | O_CLOEXEC);
+	if (_spi < 0 || ioctl(_spi, SPI_IOC_WR_MODE, &mode) < 0 || ioctl(_spi, SPI_IOC_WR_MAX_SPEED_HZ, &speed) < 0)
+	{
+		fprintf(stderr, "X: ERROR: Cannot open %s: %s\n", _spiPath, strerror(errno));
+		return false;
+	}
+
+	if (!requestLine(_dio0Line, false) || !requestLine(_resetLine, true)) return false;
+
+	// Reset pulse, then the chip has to answer with the right version
+	setResetLine(false);
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	setResetLine(true);
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	if (readRegister(REG_VERSION) != SX127X_VERSION) return false;
+
+	writeRegister(REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_SLEEP);
+
+	_frequency = frequency;
+	uint64_t frf = ((uint64_t)frequency << 19) / 32000000;
+	writeRegister(REG_FRF_MSB, (uint8_t)(frf >> 16));
+	writeRegister(REG_FRF_MID, (uint8_t)(frf >> 8));
+	writeRegister(REG_FRF_LSB, (uint8_t)(frf >> 0));
+
+	// Whole FIFO for either direction, LNA boost on, AGC on
+	writeRegister(REG_FIFO_TX_BASE_ADDR, 0);
+	writeRegister(REG_FIFO_RX_BASE_ADDR, 0);
+	writeRegister(REG_LNA, readRegister(REG_LNA) | 0x03);
+	writeRegister(REG_MODEM_CONFIG_3, 0x04);
+	setTxPower(17);
+	idle();
+
+	return true;
+}
+
+bool SX127X_class::requestLine(uint32_t line, bool output)
+{
+	gpio_v2_line_request request = {};
+	int chip = open(_chipPath, O_RDWR | O_CLOEXEC);
+
+	if (chip < 0)
+	{
+		fprintf(stderr, "X: ERROR: Cannot open %s: %s\n", _chipPath, strerror(errno));
+		return false;
+	}
+
+	request.offsets[0] = line;
+	request.num_lines = 1;
+	strncpy(request.consumer, "turfroofd", sizeof(request.consumer) - 1);
+
+	if (output)
+	{
+		request.config.flags = GPIO_V2_LINE_FLAG_OUTPUT;
+		request.config.num_attrs = 1;
+		request.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+		request.config.attrs[0].attr.values = 1;
+		request.config.attrs[0].mask = 1;
+	}
+	else
+	{
+		// RxDone, the line fd turns readable on the edge so it goes straight into epoll
+		request.config.flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_RISING;
+	}
+
+	bool requested = ioctl(chip, GPIO_V2_GET_LINE_IOCTL, &request) == 0;
+	close(chip);
+
+	if (!requested)
+	{
+		fprintf(stderr, "X: ERROR: Cannot request GPIO line %u: %s\n", line, strerror(errno));
+		return false;
+	}
+
+	fcntl(request.fd, F_SETFL, fcntl(request.fd, F_GETFL) | O_NONBLOCK);
+	(output ? _reset : _dio0) = request.fd;
+
+	return true;
+}
+
+void SX127X_class::setResetLine(bool high)
+{
+	gpio_v2_line_values values = {};
+
+	values.bits = high ? 1 : 0;
+	values.mask = 1;
+	ioctl(_reset, GPIO_V2_LINE_SET_VALUES_IOCTL, &values);
+}
+
+void SX127X_class::transfer(uint8_t *tx, uint8_t *rx, uint16_t length)
+{
+	spi_ioc_transfer message = {};
+
+	message.tx_buf = (uintptr_t)tx;
+	message.rx_buf = (uintptr_t)rx;
+	message.len = length;
+	message.speed_hz = SPI_SPEED_HZ;
+	message.bits_per_word = 8;
+
+	ioctl(_spi, SPI_IOC_MESSAGE(1), &message);
+}
+
+uint8_t SX127X_class::readRegister(uint8_t address)
+{
+	uint8_t tx[2] = { (uint8_t)(address & 0x7f), 0 };
+	uint8_t rx[2] = { 0 };
+
+	transfer(tx, rx, sizeof(tx));
+
+	return rx[1];
+}
+
+void SX127X_class::writeRegister(uint8_t address, uint8_t value)
+{
+	uint8_t tx[2] = { (uint8_t)(address | 0x80), value };
+	uint8_t rx[2];
+
+	transfer(tx, rx, sizeof(tx));
+}
+
+void SX127X_class::idle()
+{
+	writeRegister(REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_STDBY);
+}
+
+void SX127X_class::setTxPower(int level)
+{
+	// PA_BOOST pin, the high power DAC above 17 dBm
+	if (level > 17)
+	{
+		if (level > 20) level = 20;
+		level -= 3;
+		writeRegister(REG_PA_DAC, 0x87);
+		setOcp(140);
+	}
+	else
+	{
+		if (level < 2) level = 2;
+		writeRegister(REG_PA_DAC, 0x84);
+		setOcp(100);
+	}
+
+	writeRegister(REG_PA_CONFIG, 0x80 | (level - 2));
+}
+
+void SX127X_class::setOcp(uint8_t mA)
+{
+	uint8_t trim = 27;
+
+	if (mA <= 120) trim = (mA - 45) / 5;
+	else if (mA <= 240) trim = (mA + 30) / 10;
+
+	writeRegister(REG_OCP, 0x20 | (0x1F & trim));
+}
+
+void SX127X_class::setSignalBandwidth(long bandwidth)
+{
+	static const long steps[] = { 7800, 10400, 15600, 20800, 31250, 41700, 62500, 125000, 250000 };
+	uint8_t index = 0;
+
+	while (index < sizeof(steps) / sizeof(steps[0]) && bandwidth > steps[index]) index++;
+
+	writeRegister(REG_MODEM_CONFIG_1, (readRegister(REG_MODEM_CONFIG_1) & 0x0f) | (index << 4));
+	setLdoFlag();
+}
+
+void SX127X_class::setSpreadingFactor(int spreadingFactor)
+{
+	if (spreadingFactor < 6) spreadingFactor = 6;
+	if (spreadingFactor > 12) spreadingFactor = 12;
+
+	writeRegister(REG_DETECTION_OPTIMIZE, spreadingFactor == 6 ? 0xc5 : 0xc3);
+	writeRegister(REG_DETECTION_THRESHOLD, spreadingFactor == 6 ? 0x0c : 0x0a);
+	writeRegister(REG_MODEM_CONFIG_2, (readRegister(REG_MODEM_CONFIG_2) & 0x0f) | ((spreadingFactor << 4) & 0xf0));
+	setLdoFlag();
+}
+
+void SX127X_class::setLdoFlag()
+{
+	// Low data rate optimisation is required once a symbol is longer than 16 ms
+	static const long bandwidths[] = { 7800, 10400, 15600, 20800, 31250, 41700, 62500, 125000, 250000, 500000 };
+	long bandwidth = bandwidths[readRegister(REG_MODEM_CONFIG_1) >> 4 < 10 ? readRegister(REG_MODEM_CONFIG_1) >> 4 : 9];
+	uint8_t spreadingFactor = readRegister(REG_MODEM_CONFIG_2) >> 4;
+	long symbolDuration = 1000 / (bandwidth / (1L << spreadingFactor));
+	uint8_t config3 = readRegister(REG_MODEM_CONFIG_3);
+
+	writeRegister(REG_MODEM_CONFIG_3, symbolDuration > 16 ? config3 | 0x08 : config3 & ~0x08);
+}
+
+void SX127X_class::setCodingRate4(int denominator)
+{
+	if (denominator < 5) denominator = 5;
+	if (denominator > 8) denominator = 8;
+
+	writeRegister(REG_MODEM_CONFIG_1, (readRegister(REG_MODEM_CONFIG_1) & 0xf1) | ((denominator - 4) << 1));
+}
+
+void SX127X_class::setPreambleLength(long length)
+{
+	writeRegister(REG_PREAMBLE_MSB, (uint8_t)(length >> 8));
+	writeRegister(REG_PREAMBLE_LSB, (uint8_t)(length >> 0));
+}
+
+void SX127X_class::setSyncWord(int syncWord)
+{
+	writeRegister(REG_SYNC_WORD, syncWord);
+}
+
+void SX127X_class::enableCrc()
+{
+	writeRegister(REG_MODEM_CONFIG_2, readRegister(REG_MODEM_CONFIG_2) | 0x04);
+}
+
+void SX127X_class::transmit(const uint8_t *data, uint8_t length)
+{
+	uint8_t tx[RADIO_PACKET_LEN + 1];
+	uint8_t rx[RADIO_PACKET_LEN + 1];
+
+	// Explicit header, whole frame into the FIFO in one burst
+	idle();
+	writeRegister(REG_MODEM_CONFIG_1, readRegister(REG_MODEM_CONFIG_1) & 0xfe);
+	writeRegister(REG_FIFO_ADDR_PTR, 0);
+
+	tx[0] = REG_FIFO | 0x80;
+	memcpy(&tx[1], data, length);
+	transfer(tx, rx, length + 1);
+
+	writeRegister(REG_PAYLOAD_LENGTH, length);
+	writeRegister(REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_TX);
+
+	// Blocking like endPacket() on the basestation, a frame takes at most a second or so at SF10
+	for (uint16_t waited = 0; !(readRegister(REG_IRQ_FLAGS) & IRQ_TX_DONE_MASK) && waited < SX127X_TX_TIMEOUT_MS * 1000 / SX127X_TX_POLL_US; waited++)
+	{
+		std::this_thread::sleep_for(std::chrono::microseconds(SX127X_TX_POLL_US));
+	}
+
+	writeRegister(REG_IRQ_FLAGS, IRQ_TX_DONE_MASK);
+}
+
+void SX127X_class::listen()
+{
+	// DIO0 on RxDone
+	writeRegister(REG_DIO_MAPPING_1, 0x00);
+	writeRegister(REG_MODEM_CONFIG_1, readRegister(REG_MODEM_CONFIG_1) & 0xfe);
+	writeRegister(REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_RX_CONTINUOUS);
+}
+
+int SX127X_class::receive(uint8_t *data)
+{
+	uint8_t flags = readRegister(REG_IRQ_FLAGS);
+	uint8_t tx[RADIO_PACKET_LEN + 1] = { 0 };
+	uint8_t rx[RADIO_PACKET_LEN + 1];
+
+	writeRegister(REG_IRQ_FLAGS, flags);
+
+	if (!(flags & IRQ_RX_DONE_MASK) || (flags & IRQ_PAYLOAD_CRC_ERROR)) return 0;
+
+	uint8_t length = readRegister(REG_RX_NB_BYTES);
+	writeRegister(REG_FIFO_ADDR_PTR, readRegister(REG_FIFO_RX_CURRENT));
+
+	tx[0] = REG_FIFO & 0x7f;
+	transfer(tx, rx, length + 1);
+	memcpy(data, &rx[1], length);
+
+	return length;
+}
+
+int SX127X_class::packetRssi()
+{
+	return readRegister(REG_PKT_RSSI_VALUE) - (_frequency < 868000000 ? 164 : 157);
+}
+
+void SX127X_class::clearEvent()
+{
+	gpio_v2_line_event events[16];
+
+	while (read(_dio0, events, sizeof(events)) > 0);
+}
@@ -0,0 +1,126 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#ifndef sx127x_radio_h
+#define sx127x_radio_h
+
+#include "system_node.hpp"
+
+#define SPI_DEVICE				"/dev/spidev0.0"
+#define GPIO_CHIP				"/dev/gpiochip0"
+#define GPIO_DIO0				25				// BCM numbering, the usual Raspberry Pi LoRa hat wiring
+#define GPIO_RESET				17
+#define SPI_SPEED_HZ			8000000
+
+// Registers
+#define REG_FIFO				0x00
+#define REG_OP_MODE				0x01
+#define REG_FRF_MSB				0x06
+#define REG_FRF_MID				0x07
+#define REG_FRF_LSB				0x08
+#define REG_PA_CONFIG			0x09
+#define REG_OCP					0x0b
+#define REG_LNA					0x0c
+#define REG_FIFO_ADDR_PTR		0x0d
+#define REG_FIFO_TX_BASE_ADDR	0x0e
+#define REG_FIFO_RX_BASE_ADDR	0x0f
+#define REG_FIFO_RX_CURRENT		0x10
+#define REG_IRQ_FLAGS			0x12
+#define REG_RX_NB_BYTES			0x13
+#define REG_PKT_RSSI_VALUE		0x1a
+#define REG_MODEM_CONFIG_1		0x1d
+#define REG_MODEM_CONFIG_2		0x1e
+#define REG_PREAMBLE_MSB		0x20
+#define REG_PREAMBLE_LSB		0x21
+#define REG_PAYLOAD_LENGTH		0x22
+#define REG_MODEM_CONFIG_3		0x26
+#define REG_DETECTION_OPTIMIZE	0x31
+#define REG_DETECTION_THRESHOLD	0x37
+#define REG_SYNC_WORD			0x39
+#define REG_DIO_MAPPING_1		0x40
+#define REG_VERSION				0x42
+#define REG_PA_DAC				0x4d
+
+// Modes
+#define MODE_LONG_RANGE_MODE	0x80
+#define MODE_SLEEP				0x00
+#define MODE_STDBY				0x01
+#define MODE_TX					0x03
+#define MODE_RX_CONTINUOUS		0x05
+
+// IRQ Flags
+#define IRQ_TX_DONE_MASK		0x08
+#define IRQ_PAYLOAD_CRC_ERROR	0x20
+#define IRQ_RX_DONE_MASK		0x40
+
+#define SX127X_VERSION			0x12
+#define SX127X_TX_POLL_US		1000
+#define SX127X_TX_TIMEOUT_MS	5000
+
+// SX1276/8 over spidev with DIO0 and RESET on the GPIO character device, the same register
+// sequence the sandeepmistry library runs on the basestation
+class SX127X_class : public RADIO_class
+{
+	private:
+		const char *_spiPath;
+		const char *_chipPath;
+		uint32_t _dio0Line;
+		uint32_t _resetLine;
+
+		int _spi = -1;
+		int _dio0 = -1;
+		int _reset = -1;
+		long _frequency = 0;
+
+		uint8_t readRegister(uint8_t address);
+		void writeRegister(uint8_t address, uint8_t value);
+		void transfer(uint8_t *tx, uint8_t *rx, uint16_t length);
+		bool requestLine(uint32_t line, bool output);
+		void setResetLine(bool high);
+		void setOcp(uint8_t mA);
+		void setLdoFlag();
+		void idle();
+
+	public:
+		SX127X_class(const char *spiPath, const char *chipPath, uint32_t dio0Line, uint32_t resetLine)
+			: _spiPath(spiPath), _chipPath(chipPath), _dio0Line(dio0Line), _resetLine(resetLine) {}
+		~SX127X_class();
+
+		bool begin(long frequency) override;
+		void setTxPower(int level) override;
+		void setSignalBandwidth(long bandwidth) override;
+		void setSyncWord(int syncWord) override;
+		void setSpreadingFactor(int spreadingFactor) override;
+		void setCodingRate4(int denominator) override;
+		void setPreambleLength(long length) override;
+		void enableCrc() override;
+
+		void transmit(const uint8_t *data, uint8_t length) override;
+		void listen() override;
+		int receive(uint8_t *data) override;
+		int packetRssi() override;
+
+		int eventFd() override { return _dio0; }
+		void clearEvent() override;
+};
+
+#endif
@@ -0,0 +1,498 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#include "system_node.hpp"
+
+bool UPLINK_class::Initialize(const char *host, uint16_t port)
+{
+	_host = host;
+	_port = port;
+	_epoll = epoll_create1(EPOLL_CLOEXEC);
+	_wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+	epoll_event event = {};
+	event.events = EPOLLIN;
+	event.data.u32 = UPLINK_WAKE;
+
+	return _epoll >= 0 && _wake >= 0 && epoll_ctl(_epoll, EPOLL_CTL_ADD, _wake, &event) == 0;
+}
+
+void UPLINK_class::start()
+{
+	_running = true;
+	_thread = std::thread(&UPLINK_class::loop, this);
+}
+
+void UPLINK_class::stop()
+{
+	// Whatever is still queued gets UPLINK_DRAIN_MS to go out
+	_running = false;
+	notify();
+	if (_thread.joinable()) _thread.join();
+
+	fprintf(stderr, "Uplink: %lu uploaded, %lu dropped\n", _uploaded, _dropped);
+}
+
+void UPLINK_class::notify()
+{
+	uint64_t one = 1;
+	if (write(_wake, &one, sizeof(one)) < 0) return;
+}
+
+void UPLINK_class::loop()
+{
+	unsigned long drainStart = 0;
+
+	while (true)
+	{
+		epoll_event events[MAX_DEVICES + 1];
+		int count = epoll_wait(_epoll, events, MAX_DEVICES + 1, UPLINK_IDLE_POLL);
+
+		for (int i = 0; i < count; i++)
+		{
+			if (events[i].data.u32 == UPLINK_WAKE)
+			{
+				uint64_t value;
+				if (read(_wake, &value, sizeof(value)) < 0) continue;
+			}
+			else
+			{
+				handleEvent(events[i].data.u32, events[i].events);
+			}
+		}
+
+		take();
+
+		if (!_running)
+		{
+			if (drainStart == 0) drainStart = now();
+			if (!hasWork() || now() - drainStart >= UPLINK_DRAIN_MS) break;
+		}
+
+		// Every channel on its own connection, so a round's uploads go out side by side
+		for (uint8_t hwid = 0; hwid < MAX_DEVICES; hwid++)
+		{
+			UPLINK_CHANNEL &channel = _channels[hwid];
+
+			if (channel.busy)
+			{
+				if (now() - channel.startedAt >= UPLINK_TIMEOUT) finish(hwid, HTTP_NO_RESPONSE);
+				continue;
+			}
+
+			if (channel.backlog.empty()) continue;
+			if (channel.lastUpload != 0 && now() - channel.lastUpload < UPLINK_CHANNEL_INTERVAL) continue;
+			if (channel.backoff != 0 && now() - channel.failedAt < channel.backoff) continue;
+
+			startUpload(hwid);
+		}
+	}
+
+	for (uint8_t hwid = 0; hwid < MAX_DEVICES; hwid++)
+	{
+		_dropped += _channels[hwid].backlog.size();
+		closeChannel(hwid);
+	}
+}
+
+void UPLINK_class::take()
+{
+	UPLOAD_JOB job;
+
+	while (jobs.pop(job))
+	{
+		if (job.hwid >= MAX_DEVICES) continue;
+
+		std::deque<UPLOAD_JOB> &backlog = _channels[job.hwid].backlog;
+
+		// Oldest goes first, and never one a request is still carrying
+		if (backlog.size() >= UPLINK_BACKLOG_MAX && backlog.size() > _channels[job.hwid].batch)
+		{
+			backlog.erase(backlog.begin() + _channels[job.hwid].batch);
+			_dropped++;
+		}
+		backlog.push_back(job);
+	}
+}
+
+bool UPLINK_class::hasWork()
+{
+	if (jobs.size() > 0) return true;
+
+	for (uint8_t hwid = 0; hwid < MAX_DEVICES; hwid++)
+	{
+		if (!_channels[hwid].backlog.empty()) return true;
+	}
+
+	return false;
+}
+
+bool UPLINK_class::resolve()
+{
+	addrinfo hints = {};
+	addrinfo *result;
+	char port[6];
+
+	if (_addressLength != 0) return true;
+
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	snprintf(port, sizeof(port), "%u", _port);
+
+	if (getaddrinfo(_host, port, &hints, &result) != 0) return false;
+
+	memcpy(&_address, result->ai_addr, result->ai_addrlen);
+	_addressLength = result->ai_addrlen;
+	freeaddrinfo(result);
+
+	return true;
+}
+
+void UPLINK_class::startUpload(uint8_t hwid)
+{
+	UPLINK_CHANNEL &channel = _channels[hwid];
+	epoll_event event = {};
+
+	channel.busy = true;
+	channel.startedAt = now();
+	channel.lastUpload = channel.startedAt;
+
+	if (channel.fd < 0)
+	{
+		if (!resolve())
+		{
+			finish(hwid, HTTP_NO_RESPONSE);
+			return;
+		}
+
+		channel.fd = socket(_address.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (channel.fd < 0 || (connect(channel.fd, (sockaddr*)&_address, _addressLength) < 0 && errno != EINPROGRESS))
+		{
+			finish(hwid, HTTP_NO_RESPONSE);
+			return;
+		}
+
+		channel.connected = false;
+		event.events = EPOLLOUT | EPOLLIN;
+		event.data.u32 = hwid;
+		epoll_ctl(_epoll, EPOLL_CTL_ADD, channel.fd, &event);
+	}
+	else
+	{
+		event.events = EPOLLOUT | EPOLLIN;
+		event.data.u32 = hwid;
+		epoll_ctl(_epoll, EPOLL_CTL_MOD, channel.fd, &event);
+	}
+
+	buildRequest(hwid);
+	channel.sent = 0;
+	channel.response.clear();
+	channel.body.clear();
+	channel.keepAlive = true;
+}
+
+void UPLINK_class::buildRequest(uint8_t hwid)
+{
+	UPLINK_CHANNEL &channel = _channels[hwid];
+	std::string body;
+	char header[256];
+	const char *path;
+	const char *contentType;
+	char bulkPath[64];
+
+	// Everything waiting for the channel in one bulk update when its ID is known
+	if (config::THINGSPEAK_CHANNEL_IDS[hwid] != 0)
+	{
+		channel.batch = std::min<size_t>(channel.backlog.size(), UPLINK_BULK_MAX);
+
+		body = "{\"write_api_key\":\"";
+		body += config::THINGSPEAK_API_KEYS[hwid];
+		body += "\",\"updates\":[";
+		for (size_t i = 0; i < channel.batch; i++)
+		{
+			if (i > 0) body += ',';
+			appendEntry(body, channel.backlog[i], true);
+		}
+		body += "]}";
+
+		snprintf(bulkPath, sizeof(bulkPath), "/channels/%lu/bulk_update.json", (unsigned long)config::THINGSPEAK_CHANNEL_IDS[hwid]);
+		path = bulkPath;
+		contentType = "application/json";
+	}
+	else
+	{
+		channel.batch = 1;
+
+		body = "api_key=";
+		body += config::THINGSPEAK_API_KEYS[hwid];
+		appendEntry(body, channel.backlog.front(), false);
+
+		path = "/update";
+		contentType = "application/x-www-form-urlencoded";
+	}
+
+	snprintf(header, sizeof(header),
+		"POST %s HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\nContent-Type: %s\r\nContent-Length: %zu\r\n\r\n",
+		path, _host, contentType, body.size());
+
+	channel.request = header;
+	channel.request += body;
+}
+
+void UPLINK_class::appendEntry(std::string &text, const UPLOAD_JOB &job, bool json)
+{
+	// Same fields as the basestation, so both feed the same channels
+	char entry[320];
+	char createdAt[21];
+	struct tm timeInfo;
+	const char *format;
+
+	gmtime_r(&job.timestamp, &timeInfo);
+	strftime(createdAt, sizeof(createdAt), "%Y-%m-%dT%H:%M:%SZ", &timeInfo);
+
+	if (job.type == UPLOAD_EVENT)
+	{
+		format = json ? "{\"created_at\":\"%s\",\"field7\":%u,\"field8\":%.2f}" : "&created_at=%s&field7=%u&field8=%.2f";
+		snprintf(entry, sizeof(entry), format, createdAt, job.flags, job.eventValue);
+	}
+	else if (job.type == UPLOAD_HEALTH)
+	{
+		int length = snprintf(entry, sizeof(entry), json ? "{\"created_at\":\"%s\",\"status\":\"" : "&created_at=%s&status=", createdAt);
+
+		for (uint8_t i = 0; i < UPLOAD_COUNTERS; i++)
+		{
+			length += snprintf(&entry[length], sizeof(entry) - length, "%s%s:%u", i == 0 ? "" : json ? " " : "+", UPLOAD_COUNTER_NAMES[i], job.counters[i]);
+		}
+		length += snprintf(&entry[length], sizeof(entry) - length, "%sdrift:%.1f", json ? " " : "+", job.eventValue);
+		if (json) snprintf(&entry[length], sizeof(entry) - length, "\"}");
+	}
+	else
+	{
+		format = json ? "{\"created_at\":\"%s\",\"field1\":%.2f,\"field2\":%.2f,\"field3\":%.2f,\"field4\":%u,\"field5\":%.3f"
+					  : "&created_at=%s&field1=%.2f&field2=%.2f&field3=%.2f&field4=%u&field5=%.3f";
+		int length = snprintf(entry, sizeof(entry), format, createdAt, job.temperature, job.humidity, job.soilTemperature, job.soilMoisture, job.battery);
+
+		if (job.type == UPLOAD_DATA) length += snprintf(&entry[length], sizeof(entry) - length, json ? ",\"field6\":%u" : "&field6=%u", job.flags);
+		if (json) snprintf(&entry[length], sizeof(entry) - length, "}");
+	}
+
+	text += entry;
+}
+
+void UPLINK_class::handleEvent(uint8_t hwid, uint32_t events)
+{
+	UPLINK_CHANNEL &channel = _channels[hwid];
+	bool closed = false;
+
+	if (hwid >= MAX_DEVICES || channel.fd < 0) return;
+
+	// Nothing asked for on an idle keep-alive connection, the server is closing it
+	if (!channel.busy)
+	{
+		closeChannel(hwid);
+		return;
+	}
+
+	if (!channel.connected && (events & (EPOLLOUT | EPOLLERR | EPOLLHUP)))
+	{
+		int error = 0;
+		socklen_t length = sizeof(error);
+
+		getsockopt(channel.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+		if (error != 0)
+		{
+			finish(hwid, HTTP_NO_RESPONSE);
+			return;
+		}
+		channel.connected = true;
+	}
+
+	if ((events & EPOLLOUT) && channel.sent < channel.request.size())
+	{
+		ssize_t sent = send(channel.fd, channel.request.data() + channel.sent, channel.request.size() - channel.sent, MSG_NOSIGNAL);
+
+		if (sent < 0 && errno != EAGAIN)
+		{
+			finish(hwid, HTTP_NO_RESPONSE);
+			return;
+		}
+		if (sent > 0) channel.sent += sent;
+
+		// Request out, only the response is left to wait for
+		if (channel.sent == channel.request.size())
+		{
+			epoll_event event = {};
+			event.events = EPOLLIN;
+			event.data.u32 = hwid;
+			epoll_ctl(_epoll, EPOLL_CTL_MOD, channel.fd, &event);
+		}
+	}
+
+	if (events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+	{
+		char buffer[2048];
+
+		while (true)
+		{
+			ssize_t received = recv(channel.fd, buffer, sizeof(buffer), 0);
+
+			if (received > 0)
+			{
+				channel.response.append(buffer, received);
+				continue;
+			}
+			if (received == 0 || errno != EAGAIN) closed = true;
+			break;
+		}
+
+		int statusCode;
+		if (parseResponse(channel, statusCode, closed))
+		{
+			if (closed) channel.keepAlive = false;
+			finish(hwid, statusCode);
+		}
+		else if (closed)
+		{
+			finish(hwid, HTTP_NO_RESPONSE);
+		}
+	}
+}
+
+bool UPLINK_class::parseResponse(UPLINK_CHANNEL &channel, int &statusCode, bool closed)
+{
+	size_t headerEnd = channel.response.find("\r\n\r\n");
+	long contentLength = -1;
+	bool chunked = false;
+
+	if (headerEnd == std::string::npos || sscanf(channel.response.c_str(), "HTTP/1.%*d %d", &statusCode) != 1) return false;
+
+	// Header names are case-insensitive
+	std::string headers = channel.response.substr(0, headerEnd + 2);
+	std::transform(headers.begin(), headers.end(), headers.begin(), ::tolower);
+
+	size_t found = headers.find("\r\ncontent-length:");
+	if (found != std::string::npos) contentLength = atol(headers.c_str() + found + 17);
+	chunked = headers.find("\r\ntransfer-encoding: chunked") != std::string::npos;
+	if (headers.find("\r\nconnection: close") != std::string::npos) channel.keepAlive = false;
+
+	size_t at = headerEnd + 4;
+
+	if (chunked)
+	{
+		std::string body;
+
+		while (true)
+		{
+			size_t lineEnd = channel.response.find("\r\n", at);
+			if (lineEnd == std::string::npos) return false;
+
+			long length = strtol(channel.response.c_str() + at, NULL, 16);
+			if (length == 0) break;
+			if (channel.response.size() < lineEnd + 2 + length + 2) return false;
+
+			body.append(channel.response, lineEnd + 2, length);
+			at = lineEnd + 2 + length + 2;
+		}
+		channel.body = body;
+	}
+	else if (contentLength >= 0)
+	{
+		if (channel.response.size() < at + contentLength) return false;
+		channel.body = channel.response.substr(at, contentLength);
+	}
+	else
+	{
+		// No length, the body runs until the server closes
+		if (!closed) return false;
+		channel.body = channel.response.substr(at);
+		channel.keepAlive = false;
+	}
+
+	return true;
+}
+
+void UPLINK_class::finish(uint8_t hwid, int statusCode)
+{
+	UPLINK_CHANNEL &channel = _channels[hwid];
+	bool bulk = config::THINGSPEAK_CHANNEL_IDS[hwid] != 0;
+	bool success = statusCode >= 200 && statusCode < 300;
+	bool accepted = success && (bulk ? channel.body.find("\"success\":true") != std::string::npos : atol(channel.body.c_str()) > 0);
+
+	channel.busy = false;
+
+	// No answer, or the server can't take it right now, the jobs wait without using up their retries
+	if (statusCode == HTTP_NO_RESPONSE || statusCode == 429 || statusCode >= 500)
+	{
+		channel.backoff = channel.backoff == 0 ? UPLINK_BACKOFF_MIN : std::min<unsigned long>(channel.backoff * 2, UPLINK_BACKOFF_MAX);
+		channel.failedAt = now();
+		channel.batch = 0;
+		closeChannel(hwid);
+
+		fprintf(stderr, "Uplink: device %u unavailable (%d), retrying in %lu s\n", hwid, statusCode, channel.backoff / 1000);
+		return;
+	}
+
+	channel.backoff = 0;
+
+	for (size_t i = 0; i < channel.batch; i++)
+	{
+		if (accepted)
+		{
+			_uploaded++;
+		}
+		else if (++channel.backlog.front().attempts < UPLINK_RETRIES)
+		{
+			// Rejected, back to the end of the line with one retry used
+			channel.backlog.push_back(channel.backlog.front());
+		}
+		else
+		{
+			_dropped++;
+		}
+		channel.backlog.pop_front();
+	}
+
+	fprintf(stderr, "Uplink: device %u %s %zu (%d)\n", hwid, accepted ? "uploaded" : "rejected", channel.batch, statusCode);
+
+	channel.batch = 0;
+	if (!channel.keepAlive) closeChannel(hwid);
+}
+
+void UPLINK_class::closeChannel(uint8_t hwid)
+{
+	UPLINK_CHANNEL &channel = _channels[hwid];
+
+	if (channel.fd >= 0)
+	{
+		epoll_ctl(_epoll, EPOLL_CTL_DEL, channel.fd, NULL);
+		close(channel.fd);
+	}
+
+	channel.fd = -1;
+	channel.connected = false;
+}
+
+unsigned long UPLINK_class::now()
+{
+	// Real time, the rate limits are ThingSpeak's whatever speed the radio side runs at
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,98 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#ifndef uplink_h
+#define uplink_h
+
+#include "system_node.hpp"
+
+#define UPLINK_QUEUE_LEN		1024			// Jobs between the radio and uplink threads
+#define UPLINK_BACKLOG_MAX		100000			// Per channel, RAM is cheap here, oldest goes past this
+#define UPLINK_BULK_MAX			100
+#define UPLINK_CHANNEL_INTERVAL	15000			// ThingSpeak free tier takes one update per channel every 15 s
+#define UPLINK_TIMEOUT			10000			// Connect and response, per request
+#define UPLINK_BACKOFF_MIN		15000
+#define UPLINK_BACKOFF_MAX		600000
+#define UPLINK_RETRIES			3
+#define UPLINK_DRAIN_MS			30000			// How long a shutdown waits on the backlog
+#define UPLINK_IDLE_POLL		1000
+#define UPLINK_WAKE				MAX_DEVICES		// epoll tag of the wake eventfd, channels use their HW ID
+#define HTTP_NO_RESPONSE		0
+
+struct UPLINK_CHANNEL
+{
+	int fd = -1;
+	bool connected = false;
+	bool busy = false;
+	bool keepAlive = true;
+	std::deque<UPLOAD_JOB> backlog;
+	size_t batch = 0;							// Jobs at the front of the backlog in the request in flight
+	std::string request;
+	size_t sent = 0;
+	std::string response;
+	std::string body;
+	unsigned long startedAt = 0;
+	unsigned long lastUpload = 0;
+	unsigned long failedAt = 0;
+	unsigned long backoff = 0;
+};
+
+class UPLINK_class
+{
+	private:
+		int _epoll = -1;
+		int _wake = -1;
+		std::thread _thread;
+		std::atomic<bool> _running{false};
+
+		const char *_host;
+		uint16_t _port;
+		sockaddr_storage _address;
+		socklen_t _addressLength = 0;
+
+		UPLINK_CHANNEL _channels[MAX_DEVICES];
+		unsigned long _uploaded = 0;
+		unsigned long _dropped = 0;
+
+		void loop();
+		void take();
+		bool hasWork();
+		bool resolve();
+		void startUpload(uint8_t hwid);
+		void buildRequest(uint8_t hwid);
+		void appendEntry(std::string &text, const UPLOAD_JOB &job, bool json);
+		void handleEvent(uint8_t hwid, uint32_t events);
+		bool parseResponse(UPLINK_CHANNEL &channel, int &statusCode, bool closed);
+		void finish(uint8_t hwid, int statusCode);
+		void closeChannel(uint8_t hwid);
+		static unsigned long now();
+
+	public:
+		SPSC_QUEUE<UPLOAD_JOB, UPLINK_QUEUE_LEN> jobs;
+
+		bool Initialize(const char *host, uint16_t port);
+		void start();
+		void stop();
+		void notify();
+};
+
+#endif
@@ -0,0 +1,106 @@
+/*
+  ============================================================
+  Master's Thesis in Electrical and Computer Engineering
+  Faculty of Electrical and Computer Engineering
+  School of Engineering and Natural Sciences, University of Iceland
+
+  Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+		 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+  Researcher: Jezreel Tan
+  Email: jvt6@hi.is
+
+  Supervisors:
+  Helgi Þorbergsson
+  Email: thorberg@hi.is
+
+  Dórótea Höeg Sigurðardóttir
+  Email: dorotea@hi.is
+
+  ============================================================
+*/
+
+#include "../system_node.hpp"
+
+DEBUG_LOG_class debugLog;
+
+bool DEBUG_LOG_class::open(uint8_t id, uint8_t argBytes)
+{
+	uint16_t room = LOG_RING_BYTES - (uint16_t)(_head - _tail);
+	uint16_t needed = LOG_HEADER_BYTES + argBytes;
+
+	// Say how much went missing as soon as there is room again
+	if (_dropped > 0) needed += LOG_HEADER_BYTES + argSize(_dropped);
+
+	if (room < needed)
+	{
+		if (_dropped < UINT16_MAX) _dropped++;
+		return false;
+	}
+
+	if (_dropped > 0)
+	{
+		header(LOG_DROPPED, argSize(_dropped));
+		arg(_dropped);
+		_dropped = 0;
+	}
+
+	header(id, argBytes);
+	return true;
+}
+
+void DEBUG_LOG_class::header(uint8_t id, uint8_t argBytes)
+{
+	uint32_t stamp = millis();
+
+	put(LOG_SYNC);
+	put(LOG_HEADER_BYTES - 2 + argBytes);
+	put(id);
+	put(&stamp, sizeof(stamp));
+}
+
+void DEBUG_LOG_class::put(uint8_t value)
+{
+	_ring[_head++ % LOG_RING_BYTES] = value;
+}
+
+void DEBUG_LOG_class::put(const void *data, uint8_t length)
+{
+	const uint8_t *bytes = (const uint8_t *)data;
+	for (uint8_t i = 0; i < length; i++) put(bytes[i]);
+}
+
+void DEBUG_LOG_class::arg(float value)
+{
+	put(LOG_ARG_FLOAT);
+	put(&value, sizeof(value));
+}
+
+void DEBUG_LOG_class::arg(LOG_BLOCK block)
+{
+	put(block.tag);
+	put(block.count);
+	put(block.data, block.count * block.size);
+}
+
+void DEBUG_LOG_class::drain()
+{
+	// Only what the UART buffer takes, its interrupt sends it out while the caller carries on
+	int room = Serial.availableForWrite();
+
+	while (room-- > 0 && _tail != _head)
+	{
+		Serial.write(_ring[_tail++ % LOG_RING_BYTES]);
+	}
+}
+
+void DEBUG_LOG_class::flush()
+{
+	// The UART stops in sleep, so everything goes out before it
+	while (_tail != _head)
+	{
+		Serial.write(_ring[_tail++ % LOG_RING_BYTES]);
+	}
+
+	Serial.flush();
+}
@@ -0,0 +1,219 @@
+/*
+  ============================================================
+  Master's Thesis in Electrical and Computer Engineering
+  Faculty of Electrical and Computer Engineering
+  School of Engineering and Natural Sciences, University of Iceland
+
+  Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+		 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+  Researcher: Jezreel Tan
+  Email: jvt6@hi.is
+
+  Supervisors:
+  Helgi Þorbergsson
+  Email: thorberg@hi.is
+
+  Dórótea Höeg Sigurðardóttir
+  Email: dorotea@hi.is
+
+  ============================================================
+*/
+
+#ifndef log_format_h
+#define log_format_h
+
+// Puts the text back into a tokenized record. Host side only, tools/log_decode includes it next to
+// log_messages.h, the node never formats its own records. Layout is in debug_log.h.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#define LOG_SYNC			0xFE
+#define LOG_HEADER_BYTES	7
+#define LOG_ARG_UNSIGNED	0x10
+#define LOG_ARG_SIGNED		0x20
+#define LOG_ARG_FLOAT		0x34
+#define LOG_ARG_TEXT		0x40
+#define LOG_ARG_BYTES		0x50
+#define LOG_ARG_FLOATS		0x60
+
+struct LOG_ARG
+{
+	uint8_t tag;
+	uint8_t count;
+	const uint8_t *data;
+};
+
+static uint64_t logLittleEndian(const uint8_t *data, uint8_t size)
+{
+	uint64_t value = 0;
+	for (uint8_t i = 0; i < size; i++) value |= (uint64_t)data[i] << (8 * i);
+	return value;
+}
+
+static float logFloat(const uint8_t *data)
+{
+	uint32_t bits = (uint32_t)logLittleEndian(data, sizeof(bits));
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+// Splits the arguments, false when the tags run past the record, e.g. one torn by a plain print
+static bool logArgs(const uint8_t *data, size_t length, std::vector<LOG_ARG> &args)
+{
+	size_t pos = 0;
+
+	while (pos < length)
+	{
+		uint8_t tag = data[pos++];
+		uint8_t kind = tag & 0xF0;
+		size_t size;
+		LOG_ARG arg = {tag, 1, nullptr};
+
+		if (kind == LOG_ARG_UNSIGNED || kind == LOG_ARG_SIGNED)
+		{
+			size = tag & 0x0F;
+			if (size != 1 && size != 2 && size != 4 && size != 8) return false;
+		}
+		else if (tag == LOG_ARG_FLOAT)
+		{
+			size = sizeof(float);
+		}
+		else if (tag == LOG_ARG_TEXT || tag == LOG_ARG_BYTES || tag == LOG_ARG_FLOATS)
+		{
+			if (pos >= length) return false;
+			arg.count = data[pos++];
+			size = arg.count * (tag == LOG_ARG_FLOATS ? sizeof(float) : 1);
+		}
+		else
+		{
+			return false;
+		}
+
+		if (pos + size > length) return false;
+		arg.data = data + pos;
+		pos += size;
+		args.push_back(arg);
+	}
+
+	return true;
+}
+
+static std::string logNumber(const std::string &spec, char conversion, const LOG_ARG &arg)
+{
+	char text[64];
+	uint8_t size = arg.tag & 0x0F;
+	uint64_t raw = logLittleEndian(arg.data, size);
+	bool isSigned = (arg.tag & 0xF0) == LOG_ARG_SIGNED;
+	double real;
+
+	// Sign extend from the size the node sent
+	if (isSigned && size < 8 && (raw >> (8 * size - 1)) & 1) raw |= ~(uint64_t)0 << (8 * size);
+
+	if (arg.tag == LOG_ARG_FLOAT) real = logFloat(arg.data);
+	else real = isSigned ? (double)(int64_t)raw : (double)raw;
+
+	// A table from another build can pair anything with anything, never hand printf a mismatch
+	if (!strchr("tfegdiouxX", conversion)) conversion = isSigned ? 'd' : 'u';
+
+	if (conversion == 't')
+	{
+		time_t t = (time_t)raw;
+		struct tm timeInfo;
+		gmtime_r(&t, &timeInfo);
+		strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &timeInfo);
+	}
+	else if (conversion == 'f' || conversion == 'e' || conversion == 'g' || arg.tag == LOG_ARG_FLOAT)
+	{
+		snprintf(text, sizeof(text), (spec + (conversion == 'e' || conversion == 'g' ? conversion : 'f')).c_str(), real);
+	}
+	else if (isSigned)
+	{
+		snprintf(text, sizeof(text), (spec + "ll" + conversion).c_str(), (long long)(int64_t)raw);
+	}
+	else
+	{
+		snprintf(text, sizeof(text), (spec + "ll" + conversion).c_str(), (unsigned long long)raw);
+	}
+
+	return text;
+}
+
+static std::string logValue(const std::string &spec, char conversion, const LOG_ARG &arg)
+{
+	std::string text;
+	char hex[4];
+
+	switch (arg.tag)
+	{
+		case LOG_ARG_TEXT:
+			return std::string((const char *)arg.data, arg.count);
+
+		case LOG_ARG_BYTES:
+			if (conversion == 's') return std::string((const char *)arg.data, arg.count);
+			for (uint8_t i = 0; i < arg.count; i++)
+			{
+				snprintf(hex, sizeof(hex), i ? " %02X" : "%02X", arg.data[i]);
+				text += hex;
+			}
+			return text;
+
+		case LOG_ARG_FLOATS:
+			for (uint8_t i = 0; i < arg.count; i++)
+			{
+				LOG_ARG value = {LOG_ARG_FLOAT, 1, arg.data + i * sizeof(float)};
+				if (i) text += ',';
+				text += logNumber(spec, conversion, value);
+			}
+			return text;
+
+		default:
+			return logNumber(spec, conversion, arg);
+	}
+}
+
+// record starts at the message ID, right after the length byte
+static bool expandLogRecord(const uint8_t *record, size_t length, const char *const *formats, size_t formatCount, std::string &text, uint32_t &stamp)
+{
+	std::vector<LOG_ARG> args;
+
+	if (length < LOG_HEADER_BYTES - 2 || record[0] >= formatCount) return false;
+	if (!logArgs(record + LOG_HEADER_BYTES - 2, length - (LOG_HEADER_BYTES - 2), args)) return false;
+
+	stamp = (uint32_t)logLittleEndian(record + 1, sizeof(stamp));
+	text.clear();
+
+	size_t next = 0;
+	for (const char *c = formats[record[0]]; *c; c++)
+	{
+		if (*c != '%')
+		{
+			text += *c;
+			continue;
+		}
+
+		if (c[1] == '%')
+		{
+			text += *++c;
+			continue;
+		}
+
+		std::string spec = "%";
+		while (c[1] && strchr("-+ #0123456789.", c[1])) spec += *++c;
+		if (!c[1]) return false;
+
+		char conversion = *++c;
+		if (next >= args.size()) return false;
+		text += logValue(spec, conversion, args[next++]);
+	}
+
+	return next == args.size();
+}
+
+#endif
@@ -0,0 +1,74 @@
+/*
+  ============================================================
+  Master's Thesis in Electrical and Computer Engineering
+  Faculty of Electrical and Computer Engineering
+  School of Engineering and Natural Sciences, University of Iceland
+
+  Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+		 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+  Researcher: Jezreel Tan
+  Email: jvt6@hi.is
+
+  Supervisors:
+  Helgi Þorbergsson
+  Email: thorberg@hi.is
+
+  Dórótea Höeg Sigurðardóttir
+  Email: dorotea@hi.is
+
+  ============================================================
+*/
+
+#ifndef log_messages_h
+#define log_messages_h
+
+// Tokenized debug messages, the node only sends the ID and the raw arguments. tools/log_decode
+// is built against this list and puts the text back, so the strings never take flash here.
+// Append only: IDs are positions, a log decodes against the list its firmware was built with.
+//
+// %d %u %x integers, %t epoch seconds, %.5f floats and float lists, %s text, %x on bytes is a hex dump
+#define LOG_MESSAGES(X) \
+	X(LOG_DROPPED,				"X: %u debug records dropped, ring full") \
+	X(LOG_LORA_FAILED,			"X: ERROR: LoRa Initialization Failed!") \
+	X(LOG_LORA_SETUP,			"LoRa Setup Complete! Backoff Time (ms): %u, CSMA Timeout (ms): %u") \
+	X(LOG_PACKET,				"Packet received! Signal strength [RSSI] (dBm): %d") \
+	X(LOG_PAYLOAD,				"Payload: %s") \
+	X(LOG_BAD_HEADER,			"X: Invalid Packet Header!") \
+	X(LOG_NO_DATA,				"X: Unable to Locate Data!") \
+	X(LOG_BAD_CHARACTER,		"X: Invalid Character Found!") \
+	X(LOG_BAD_DATA,				"X: Invalid Data Found!") \
+	X(LOG_BAD_NUMBER,			"Invalid Number Found!") \
+	X(LOG_CHECKSUM,				"Calculating Checksum: %.5f vs %.5f") \
+	X(LOG_CHECKSUM_BAD,			"Checksum is BAD!") \
+	X(LOG_CHECKSUM_GOOD,		"Checksum is GOOD!") \
+	X(LOG_CURRENT_DATA,			"Current Data: [%.5f]") \
+	X(LOG_CURRENT_RAW,			"Current Data: [%.0f]") \
+	X(LOG_MERGED_DATA,			"Merged Data: [%.5f]") \
+	X(LOG_MERGED_RAW,			"Merged Data: [%.0f]") \
+	X(LOG_SEND_LIMIT,			"Send Limit Reached!") \
+	X(LOG_RTC_SYNC_LORA,		"Syncing RTC via LoRa") \
+	X(LOG_SEND_PAYLOAD,			"Payload to Send: %s") \
+	X(LOG_SENT,					"Payload Sent Sucessfully! (%u/%u) after %u backoff slots") \
+	X(LOG_NO_EVENT_DATA,		"X: Unable to Locate Event Data!") \
+	X(LOG_BAD_EVENT_CHARACTER,	"X: Invalid Event Character Found!") \
+	X(LOG_EVENT_CHECKSUM_BAD,	"Event Checksum is BAD!") \
+	X(LOG_SEND_EVENT,			"Event to Send: %s") \
+	X(LOG_RELAY_EVENT,			"Relaying Event!") \
+	X(LOG_BAD_HISTORY,			"X: Invalid History Data Found!") \
+	X(LOG_HISTORY_CHECKSUM_BAD,	"History Checksum is BAD!") \
+	X(LOG_RELAY_HISTORY,		"Relaying History: %s") \
+	X(LOG_SEND_HISTORY,			"History to Send: %s") \
+	X(LOG_BAD_DATETIME,			"X: Invalid datettime Data Found!") \
+	X(LOG_DATETIME_LORA,		"Datetime from LoRa: %u:%u:%u %u-%u-20%02u") \
+	X(LOG_RTC_SYNC_FAILED,		"X: ERROR: Failed to Sync RTC!") \
+	X(LOG_RTC_SYNC,				"RTC Sync: %t") \
+	X(LOG_SLEEP,				"Entering Sleep Mode...") \
+	X(LOG_LIGHT_SLEEP,			"Entering Light Sleep Mode...") \
+	X(LOG_BAD_HEALTH,			"X: Invalid Health Data Found!") \
+	X(LOG_SEND_HEALTH,			"Health to Send: %s") \
+	X(LOG_DATETIME_DELAY,		"Datetime delayed on the way (ms): %u") \
+	X(LOG_RTC_DRIFT,			"RTC off by %d ms after %d s, drift %d tenths of a ppm") \
+	X(LOG_RTC_AGING,			"RTC aging offset now %d, trimmed for %d tenths of a ppm")
+
+#endif
@@ -0,0 +1,76 @@
+/*
+  ============================================================
+  Master's Thesis in Electrical and Computer Engineering
+  Faculty of Electrical and Computer Engineering
+  School of Engineering and Natural Sciences, University of Iceland
+
+  Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+		 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+  Researcher: Jezreel Tan
+  Email: jvt6@hi.is
+
+  Supervisors:
+  Helgi Þorbergsson
+  Email: thorberg@hi.is
+
+  Dórótea Höeg Sigurðardóttir
+  Email: dorotea@hi.is
+
+  ============================================================
+*/
+
+#include "../system_node.hpp"
+
+uint8_t EVENT_MODULE_class::checkRules(IDATA IData)
+{
+	uint8_t tripped = NO_EVENT;
+
+	// Frost: fire once when crossing the limit, re-arm with hysteresis
+	if (!_frostLatched && IData.SOIL_TEMPERATURE <= FROST_LIMIT)
+	{
+		_frostLatched = true;
+		tripped |= bit(EVENT_FROST);
+	}
+	else if (_frostLatched && IData.SOIL_TEMPERATURE >= FROST_CLEAR)
+	{
+		_frostLatched = false;
+	}
+
+	// Sudden drying: compare against the previous check, skip the very first reading. Like frost it
+	// fires once, and re-arms when the soil is wetted back to near where it was before the jump
+	if (!_moistureLatched && _lastMoisture != 0 && IData.SOIL_MOISTURE > _lastMoisture + MOISTURE_JUMP_LIM)
+	{
+		_moistureLatched = true;
+		_moistureClear = _lastMoisture + MOISTURE_CLEAR;
+		tripped |= bit(EVENT_MOISTURE_DROP);
+	}
+	else if (_moistureLatched && IData.SOIL_MOISTURE <= _moistureClear)
+	{
+		_moistureLatched = false;
+	}
+	_lastMoisture = IData.SOIL_MOISTURE;
+
+	#ifdef DEBUGGING
+		if (tripped != NO_EVENT)
+		{
+			Serial.print(F("Event Rules Tripped: "));
+			Serial.println(tripped, BIN);
+		}
+	#endif
+
+	return tripped;
+}
+
+float EVENT_MODULE_class::getRuleValue(uint8_t rule, IDATA IData)
+{
+	switch (rule)
+	{
+		case EVENT_FROST:
+			return IData.SOIL_TEMPERATURE;
+		case EVENT_MOISTURE_DROP:
+			return IData.SOIL_MOISTURE;
+	}
+
+	return 0;
+}
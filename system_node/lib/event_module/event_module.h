@@ -0,0 +1,53 @@
+/*
+  ============================================================
+  Master's Thesis in Electrical and Computer Engineering
+  Faculty of Electrical and Computer Engineering
+  School of Engineering and Natural Sciences, University of Iceland
+
+  Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+		 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+  Researcher: Jezreel Tan
+  Email: jvt6@hi.is
+
+  Supervisors:
+  Helgi Þorbergsson
+  Email: thorberg@hi.is
+
+  Dórótea Höeg Sigurðardóttir
+  Email: dorotea@hi.is
+
+  ============================================================
+*/
+
+#ifndef event_module_h
+#define event_module_h
+
+#include "../system_node.hpp"
+
+// Event Rules (IDs are sent in the event frame, keep in sync with the basestation)
+#define NO_EVENT			0
+#define EVENT_FROST			1
+#define EVENT_MOISTURE_DROP	2
+#define EVENT_RULES			3
+
+// Rule Thresholds
+#define FROST_LIMIT			0.0		// C, soil surface at or below freezing
+#define FROST_CLEAR			1.0		// C, re-arm once the turf has warmed back up
+#define MOISTURE_JUMP_LIM	60		// Raw ADC rise between checks, capacitive probe reads higher as soil dries
+#define MOISTURE_CLEAR		20		// Raw ADC over the reading before the jump, re-arm once rewetted back under it
+
+class EVENT_MODULE_class
+{
+	private:
+		bool _frostLatched;
+		bool _moistureLatched;
+		uint16_t _lastMoisture;
+		uint16_t _moistureClear;
+
+	public:
+		uint8_t checkRules(IDATA IData);
+		float getRuleValue(uint8_t rule, IDATA IData);
+};
+
+#endif
@@ -0,0 +1,312 @@
+/*
+  ============================================================
+  Master's Thesis in Electrical and Computer Engineering
+  Faculty of Electrical and Computer Engineering
+  School of Engineering and Natural Sciences, University of Iceland
+
+  Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+		 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+  Researcher: Jezreel Tan
+  Email: jvt6@hi.is
+
+  Supervisors:
+  Helgi Þorbergsson
+  Email: thorberg@hi.is
+
+  Dórótea Höeg Sigurðardóttir
+  Email: dorotea@hi.is
+
+  ============================================================
+*/
+
+#include "flash_log.h"
+
+bool FLASH_LOG_class::mount()
+{
+	FLASH_HEADER header;
+	FLASH_SLOT record;
+	uint16_t firstSlot;
+
+	_sectorCount = _device.getSectorCount();
+	_headSector = FLASH_NO_SECTOR;
+	_tailSequence = FLASH_NO_KEY;
+	_lastHourKey = FLASH_NO_KEY;
+
+	if (_sectorCount < 2) return false;
+
+	// Newest committed header is the head, the oldest one the tail
+	for (uint16_t i = 0; i < _sectorCount; i++)
+	{
+		if (!readHeader(i, header)) continue;
+
+		if (_headSector == FLASH_NO_SECTOR || header.sequence > _headSequence)
+		{
+			_headSector = i;
+			_headSequence = header.sequence;
+		}
+		if (header.sequence < _tailSequence) _tailSequence = header.sequence;
+	}
+
+	if (_headSector == FLASH_NO_SECTOR)
+	{
+		// Blank chip, start the ring at sector 0
+		_headSector = _sectorCount - 1;
+		_headSequence = 0;
+		_tailSequence = 1;
+		openSector();
+
+		return true;
+	}
+
+	// Only one lap of the ring can be live
+	if (_headSequence - _tailSequence >= _sectorCount) _tailSequence = _headSequence - _sectorCount + 1;
+
+	// Slots fill in order, so the first fully erased one is where writing resumes. Torn slots are stepped over.
+	_writeSlot = FLASH_FIRST_SLOT;
+	for (uint16_t i = FLASH_FIRST_SLOT; i < FLASH_SLOTS; i++)
+	{
+		bool erased = true;
+
+		_device.read(getAddress(_headSector, i), &record, sizeof(record));
+		for (uint8_t j = 0; j < sizeof(record); j++)
+		{
+			if (((uint8_t *)&record)[j] != FLASH_ERASED) erased = false;
+		}
+		if (erased) break;
+
+		_writeSlot = i + 1;
+	}
+
+	// Power may have gone between a sector's first record and its index entry
+	_headFirstKey = getFirstKey(_headSector, firstSlot);
+	readHeader(_headSector, header);
+	if (header.firstHourKey == FLASH_NO_KEY && _headFirstKey != FLASH_NO_KEY) setFirstKey(_headSector, _headFirstKey, firstSlot);
+
+	_lastHourKey = getLastKey(_headSector);
+	if (_lastHourKey == FLASH_NO_KEY && _headSequence > _tailSequence) _lastHourKey = getLastKey(getSector(_headSequence - 1));
+
+	return true;
+}
+
+bool FLASH_LOG_class::append(uint32_t hourKey, const void *data, uint8_t length)
+{
+	FLASH_SLOT record;
+
+	if (_headSector == FLASH_NO_SECTOR || length > FLASH_PAYLOAD_MAX || hourKey == FLASH_NO_KEY) return false;
+
+	// The hour index relies on keys only going up
+	if (_lastHourKey != FLASH_NO_KEY && hourKey <= _lastHourKey) return false;
+
+	if (_writeSlot >= FLASH_SLOTS) openSector();
+
+	memset(&record, FLASH_ERASED, sizeof(record));
+	record.hourKey = hourKey;
+	record.length = length;
+	memcpy(record.payload, data, length);
+	record.crc = getCRC(record);
+
+	uint32_t address = getAddress(_headSector, _writeSlot);
+	_device.program(address, &record, sizeof(record));
+	commit(address);
+
+	if (_headFirstKey == FLASH_NO_KEY)
+	{
+		setFirstKey(_headSector, hourKey, _writeSlot);
+		_headFirstKey = hourKey;
+	}
+
+	_writeSlot++;
+	_lastHourKey = hourKey;
+
+	return true;
+}
+
+bool FLASH_LOG_class::find(uint32_t hourKey, void *data, uint8_t &length)
+{
+	FLASH_SLOT record;
+	uint32_t lowSequence = _tailSequence;
+	uint32_t highSequence = _headSequence;
+	uint32_t found = 0;
+	uint16_t firstSlot;
+
+	if (_lastHourKey == FLASH_NO_KEY || hourKey > _lastHourKey) return false;
+
+	// Binary search the header index for the last sector starting at or before the hour
+	while (lowSequence <= highSequence)
+	{
+		uint32_t mid = lowSequence + (highSequence - lowSequence) / 2;
+		uint32_t firstKey = getFirstKey(getSector(mid), firstSlot);
+
+		if (firstKey != FLASH_NO_KEY && firstKey <= hourKey)
+		{
+			found = mid;
+			lowSequence = mid + 1;
+		}
+		else
+		{
+			highSequence = mid - 1;
+		}
+	}
+
+	if (found == 0) return false;
+
+	uint16_t sector = getSector(found);
+	uint32_t firstKey = getFirstKey(sector, firstSlot);
+	uint32_t estimate = hourKey - firstKey + firstSlot;
+	uint16_t low = firstSlot;
+	uint16_t high = sector == _headSector ? _writeSlot - 1 : FLASH_SLOTS - 1;
+
+	// Then the slots, starting where hourly logging without gaps puts the hour
+	uint16_t mid = estimate < high ? estimate : high;
+
+	while (low <= high)
+	{
+		uint16_t probe = mid;
+
+		// Torn slots hold no key, take the next good one up
+		while (probe <= high && !readSlot(sector, probe, record)) probe++;
+
+		if (probe <= high && record.hourKey == hourKey)
+		{
+			memcpy(data, record.payload, record.length);
+			length = record.length;
+
+			return true;
+		}
+
+		if (probe <= high && record.hourKey < hourKey) low = probe + 1;
+		else high = mid - 1;
+
+		mid = low + (high - low) / 2;
+	}
+
+	return false;
+}
+
+uint32_t FLASH_LOG_class::getAddress(uint16_t sector, uint16_t slot)
+{
+	return sector * FLASH_SECTOR_BYTES + (uint32_t)slot * FLASH_SLOT_BYTES;
+}
+
+uint16_t FLASH_LOG_class::getSector(uint32_t sequence)
+{
+	// Sequences step one sector at a time around the ring, counting back from the head
+	return (_headSector + _sectorCount - (_headSequence - sequence) % _sectorCount) % _sectorCount;
+}
+
+uint32_t FLASH_LOG_class::getFirstKey(uint16_t sector, uint16_t &firstSlot)
+{
+	FLASH_HEADER header;
+	FLASH_SLOT record;
+
+	// Check the entry against its slot, power lost while programming it leaves a half written key
+	if (readHeader(sector, header) && header.firstSlot >= FLASH_FIRST_SLOT && header.firstSlot < FLASH_SLOTS &&
+		readSlot(sector, header.firstSlot, record) && record.hourKey == header.firstHourKey)
+	{
+		firstSlot = header.firstSlot;
+		return header.firstHourKey;
+	}
+
+	// Index entry missing or torn, fall back to the first good slot
+	uint16_t lastSlot = sector == _headSector ? _writeSlot : FLASH_SLOTS;
+
+	for (uint16_t i = FLASH_FIRST_SLOT; i < lastSlot; i++)
+	{
+		if (!readSlot(sector, i, record)) continue;
+
+		firstSlot = i;
+		return record.hourKey;
+	}
+
+	return FLASH_NO_KEY;
+}
+
+uint32_t FLASH_LOG_class::getLastKey(uint16_t sector)
+{
+	FLASH_SLOT record;
+	uint16_t lastSlot = sector == _headSector ? _writeSlot : FLASH_SLOTS;
+
+	for (uint16_t i = lastSlot; i > FLASH_FIRST_SLOT; i--)
+	{
+		if (readSlot(sector, i - 1, record)) return record.hourKey;
+	}
+
+	return FLASH_NO_KEY;
+}
+
+bool FLASH_LOG_class::readHeader(uint16_t sector, FLASH_HEADER &header)
+{
+	_device.read(getAddress(sector, 0), &header, sizeof(header));
+
+	return header.magic == FLASH_MAGIC && header.commit == FLASH_COMMITTED;
+}
+
+bool FLASH_LOG_class::readSlot(uint16_t sector, uint16_t slot, FLASH_SLOT &record)
+{
+	_device.read(getAddress(sector, slot), &record, sizeof(record));
+
+	return record.commit == FLASH_COMMITTED && record.length <= FLASH_PAYLOAD_MAX && record.crc == getCRC(record);
+}
+
+void FLASH_LOG_class::setFirstKey(uint16_t sector, uint32_t hourKey, uint8_t slot)
+{
+	FLASH_HEADER header;
+
+	// Both fields are still erased, so they can be programmed in place
+	header.firstHourKey = hourKey;
+	header.firstSlot = slot;
+	_device.program(getAddress(sector, 0) + offsetof(FLASH_HEADER, firstHourKey), &header.firstHourKey, sizeof(header.firstHourKey) + sizeof(header.firstSlot));
+}
+
+void FLASH_LOG_class::commit(uint32_t address)
+{
+	uint8_t marker = FLASH_COMMITTED;
+
+	_device.program(address + FLASH_SLOT_BYTES - 1, &marker, sizeof(marker));
+}
+
+void FLASH_LOG_class::openSector()
+{
+	FLASH_HEADER header;
+	uint16_t sector = (_headSector + 1) % _sectorCount;
+
+	// Plain rotation: every sector is erased once per lap, so wear stays level.
+	// The count is carried over for diagnostics, a torn header restarts it.
+	uint32_t eraseCount = readHeader(sector, header) ? header.eraseCount : 0;
+
+	_device.eraseSector(getAddress(sector, 0));
+
+	memset(&header, FLASH_ERASED, sizeof(header));
+	header.magic = FLASH_MAGIC;
+	header.sequence = _headSequence + 1;
+	header.eraseCount = eraseCount + 1;
+	_device.program(getAddress(sector, 0), &header, sizeof(header));
+	commit(getAddress(sector, 0));
+
+	_headSector = sector;
+	_headSequence++;
+	_headFirstKey = FLASH_NO_KEY;
+	_writeSlot = FLASH_FIRST_SLOT;
+
+	// Reusing a sector drops its hours off the tail
+	if (_headSequence - _tailSequence >= _sectorCount) _tailSequence = _headSequence - _sectorCount + 1;
+}
+
+uint8_t FLASH_LOG_class::getCRC(const FLASH_SLOT &record)
+{
+	const uint8_t *bytes = (const uint8_t *)&record;
+	uint8_t length = offsetof(FLASH_SLOT, payload) + (record.length <= FLASH_PAYLOAD_MAX ? record.length : 0);
+	uint8_t crc = 0;
+
+	for (uint8_t i = 0; i < length; i++)
+	{
+		crc ^= bytes[i];
+		for (uint8_t j = 0; j < 8; j++)
+		{
+			crc = crc & 0x80 ? (crc << 1) ^ FLASH_CRC_POLY : crc << 1;
+		}
+	}
+
+	return crc;
+}
@@ -0,0 +1,116 @@
+/*
+  ============================================================
+  Master's Thesis in Electrical and Computer Engineering
+  Faculty of Electrical and Computer Engineering
+  School of Engineering and Natural Sciences, University of Iceland
+
+  Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+		 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+  Researcher: Jezreel Tan
+  Email: jvt6@hi.is
+
+  Supervisors:
+  Helgi Þorbergsson
+  Email: thorberg@hi.is
+
+  Dórótea Höeg Sigurðardóttir
+  Email: dorotea@hi.is
+
+  ============================================================
+*/
+
+#ifndef flash_log_h
+#define flash_log_h
+
+// No Arduino headers here, tools/flash_bench builds this same engine on Linux
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// NOR Geometry (W25Q-style: 256 B pages, 4 KB erase sectors)
+#define FLASH_PAGE_BYTES		256
+#define FLASH_SECTOR_BYTES		4096UL
+#define FLASH_SLOT_BYTES		32			// Divides a page, so a slot never straddles two
+#define FLASH_SLOTS				(FLASH_SECTOR_BYTES / FLASH_SLOT_BYTES)
+#define FLASH_FIRST_SLOT		1			// Slot 0 holds the sector header
+#define FLASH_PAYLOAD_MAX		24
+
+#define FLASH_MAGIC				0x474F4C54UL	// "TLOG"
+#define FLASH_NO_KEY			0xFFFFFFFFUL	// What erased flash reads as
+#define FLASH_NO_SECTOR			0xFFFF
+#define FLASH_ERASED			0xFF
+#define FLASH_COMMITTED			0x00
+#define FLASH_CRC_POLY			0x07
+
+// Both slot types are programmed with commit left erased, then commit is programmed on its own.
+// Power lost in between leaves commit at 0xFF and the slot is skipped on the next mount.
+struct FLASH_HEADER
+{
+	uint32_t magic;
+	uint32_t sequence;			// +1 for every opened sector, orders the ring
+	uint32_t eraseCount;		// Wear of this sector
+	uint32_t firstHourKey;		// Hour index: programmed with the sector's first record
+	uint8_t firstSlot;
+	uint8_t reserved[FLASH_SLOT_BYTES - 18];
+	uint8_t commit;
+};
+
+struct FLASH_SLOT
+{
+	uint32_t hourKey;
+	uint8_t length;
+	uint8_t payload[FLASH_PAYLOAD_MAX];
+	uint8_t crc;
+	uint8_t reserved;
+	uint8_t commit;
+};
+
+static_assert(sizeof(FLASH_HEADER) == FLASH_SLOT_BYTES, "FLASH_HEADER must fill one slot");
+static_assert(sizeof(FLASH_SLOT) == FLASH_SLOT_BYTES, "FLASH_SLOT must fill one slot");
+static_assert(offsetof(FLASH_HEADER, commit) == FLASH_SLOT_BYTES - 1 && offsetof(FLASH_SLOT, commit) == FLASH_SLOT_BYTES - 1, "Commit marker must be the last byte of a slot");
+
+// Implemented by the SPI driver on the node and by the fake flash in tools/flash_bench
+class FLASH_DEVICE_class
+{
+	public:
+		virtual uint16_t getSectorCount() = 0;
+		virtual void read(uint32_t address, void *buffer, uint16_t length) = 0;
+		virtual void program(uint32_t address, const void *buffer, uint16_t length) = 0;
+		virtual void eraseSector(uint32_t address) = 0;
+};
+
+class FLASH_LOG_class
+{
+	private:
+		FLASH_DEVICE_class &_device;
+		uint16_t _sectorCount = 0;
+		uint16_t _headSector = FLASH_NO_SECTOR;
+		uint16_t _writeSlot;
+		uint32_t _headSequence;
+		uint32_t _tailSequence;
+		uint32_t _headFirstKey;
+		uint32_t _lastHourKey = FLASH_NO_KEY;
+
+		uint32_t getAddress(uint16_t sector, uint16_t slot);
+		uint16_t getSector(uint32_t sequence);
+		uint32_t getFirstKey(uint16_t sector, uint16_t &firstSlot);
+		uint32_t getLastKey(uint16_t sector);
+		bool readHeader(uint16_t sector, FLASH_HEADER &header);
+		bool readSlot(uint16_t sector, uint16_t slot, FLASH_SLOT &record);
+		void setFirstKey(uint16_t sector, uint32_t hourKey, uint8_t slot);
+		void commit(uint32_t address);
+		void openSector();
+		uint8_t getCRC(const FLASH_SLOT &record);
+
+	public:
+		FLASH_LOG_class(FLASH_DEVICE_class &device) : _device(device) {}
+
+		bool mount();
+		bool append(uint32_t hourKey, const void *data, uint8_t length);
+		bool find(uint32_t hourKey, void *data, uint8_t &length);
+		uint32_t getLastHourKey() { return _lastHourKey; }
+		uint32_t getSectorsUsed() { return _headSector == FLASH_NO_SECTOR ? 0 : _headSequence - _tailSequence + 1; }
+};
+
+#endif
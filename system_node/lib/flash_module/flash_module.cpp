@@ -0,0 +1,180 @@
+/*
+  ============================================================
+  Master's Thesis in Electrical and Computer Engineering
+  Faculty of Electrical and Computer Engineering
+  School of Engineering and Natural Sciences, University of Iceland
+
+  Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+		 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+  Researcher: Jezreel Tan
+  Email: jvt6@hi.is
+
+  Supervisors:
+  Helgi Þorbergsson
+  Email: thorberg@hi.is
+
+  Dórótea Höeg Sigurðardóttir
+  Email: dorotea@hi.is
+
+  ============================================================
+*/
+
+#include "../system_node.hpp"
+
+void FLASH_MODULE_class::Initialize()
+{
+	// CS stays driven high, also through sleep, so the chip never sees LoRa traffic
+	pinMode(FLASH_CS, OUTPUT);
+	deselect();
+	wake();
+
+	// Capacity byte of the JEDEC ID is log2 of the size in bytes
+	select();
+	SPI.transfer(FLASH_JEDEC_ID);
+	SPI.transfer(0);
+	SPI.transfer(0);
+	uint8_t capacity = SPI.transfer(0);
+	deselect();
+
+	if (capacity >= 16 && capacity <= 24)
+	{
+		_sectorCount = (1UL << capacity) / FLASH_SECTOR_BYTES;
+		if (_sectorCount > FLASH_MAX_SECTORS) _sectorCount = FLASH_MAX_SECTORS;
+	}
+
+	_mounted = _log.mount();
+
+	#ifdef DEBUGGING
+		Serial.print(F("Flash Sectors: "));
+		Serial.print(_sectorCount);
+		Serial.print(F(" | Mounted: "));
+		Serial.print(_mounted);
+		Serial.print(F(" | Sectors Used: "));
+		Serial.println(_log.getSectorsUsed());
+	#endif
+
+	powerDown();
+}
+
+bool FLASH_MODULE_class::append(uint32_t hourKey, const void *data, uint8_t length)
+{
+	if (!_mounted) return false;
+
+	wake();
+	bool stored = _log.append(hourKey, data, length);
+	powerDown();
+
+	return stored;
+}
+
+bool FLASH_MODULE_class::find(uint32_t hourKey, void *data, uint8_t &length)
+{
+	if (!_mounted) return false;
+
+	wake();
+	bool found = _log.find(hourKey, data, length);
+	powerDown();
+
+	return found;
+}
+
+uint16_t FLASH_MODULE_class::getSectorCount()
+{
+	return _sectorCount;
+}
+
+void FLASH_MODULE_class::read(uint32_t address, void *buffer, uint16_t length)
+{
+	select();
+	sendCommand(FLASH_READ_DATA, address);
+	memset(buffer, 0, length);
+	SPI.transfer(buffer, length);
+	deselect();
+}
+
+void FLASH_MODULE_class::program(uint32_t address, const void *buffer, uint16_t length)
+{
+	// The log never crosses a page, so one Page Program is enough
+	select();
+	SPI.transfer(FLASH_WRITE_ENABLE);
+	deselect();
+
+	select();
+	sendCommand(FLASH_PAGE_PROGRAM, address);
+	for (uint16_t i = 0; i < length; i++)
+	{
+		SPI.transfer(((const uint8_t *)buffer)[i]);
+	}
+	deselect();
+
+	waitUntilReady();
+}
+
+void FLASH_MODULE_class::eraseSector(uint32_t address)
+{
+	select();
+	SPI.transfer(FLASH_WRITE_ENABLE);
+	deselect();
+
+	select();
+	sendCommand(FLASH_SECTOR_ERASE, address);
+	deselect();
+
+	waitUntilReady();
+}
+
+void FLASH_MODULE_class::select()
+{
+	SPI.beginTransaction(SPISettings(FLASH_SPI_CLOCK, MSBFIRST, SPI_MODE0));
+	digitalWrite(FLASH_CS, LOW);
+}
+
+void FLASH_MODULE_class::deselect()
+{
+	digitalWrite(FLASH_CS, HIGH);
+	SPI.endTransaction();
+}
+
+void FLASH_MODULE_class::sendCommand(uint8_t command, uint32_t address)
+{
+	SPI.transfer(command);
+	SPI.transfer((address >> 16) & 0xFF);
+	SPI.transfer((address >> 8) & 0xFF);
+	SPI.transfer(address & 0xFF);
+}
+
+void FLASH_MODULE_class::waitUntilReady()
+{
+	// Sector erase is the slow one, tens of milliseconds
+	select();
+	SPI.transfer(FLASH_READ_STATUS);
+	while (SPI.transfer(0) & FLASH_STATUS_BUSY)
+	{
+		#ifdef WDT_ENABLE
+			wdt_reset();
+		#endif
+	}
+	deselect();
+}
+
+void FLASH_MODULE_class::wake()
+{
+	// Paired with SPI.end() in powerDown(), the SPI library counts begin/end calls
+	SPI.begin();
+
+	select();
+	SPI.transfer(FLASH_RELEASE);
+	deselect();
+	delayMicroseconds(FLASH_WAKE_US);
+}
+
+void FLASH_MODULE_class::powerDown()
+{
+	// Deep power-down draws about 1 uA
+	select();
+	SPI.transfer(FLASH_POWER_DOWN);
+	deselect();
+
+	SPI.end();
+}
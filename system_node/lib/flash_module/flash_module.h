@@ -0,0 +1,74 @@
+/*
+  ============================================================
+  Master's Thesis in Electrical and Computer Engineering
+  Faculty of Electrical and Computer Engineering
+  School of Engineering and Natural Sciences, University of Iceland
+
+  Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+		 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+  Researcher: Jezreel Tan
+  Email: jvt6@hi.is
+
+  Supervisors:
+  Helgi Þorbergsson
+  Email: thorberg@hi.is
+
+  Dórótea Höeg Sigurðardóttir
+  Email: dorotea@hi.is
+
+  ============================================================
+*/
+
+#ifndef flash_module_h
+#define flash_module_h
+
+#include "../system_node.hpp"
+
+// SPI NOR Flash Pins (shares the bus with the LoRa module)
+#define FLASH_CS				9
+
+#define FLASH_SPI_CLOCK			8000000
+#define FLASH_SECTORS			512			// W25Q16 fallback when the JEDEC ID can't be read
+#define FLASH_MAX_SECTORS		4096		// 16 MB, keeps sector numbers in 16 bits
+#define FLASH_WAKE_US			30			// tRES1 after release from power-down
+
+// W25Q-Series Commands
+#define FLASH_WRITE_ENABLE		0x06
+#define FLASH_READ_STATUS		0x05
+#define FLASH_READ_DATA			0x03
+#define FLASH_PAGE_PROGRAM		0x02
+#define FLASH_SECTOR_ERASE		0x20
+#define FLASH_JEDEC_ID			0x9F
+#define FLASH_POWER_DOWN		0xB9
+#define FLASH_RELEASE			0xAB
+#define FLASH_STATUS_BUSY		0x01
+
+class FLASH_MODULE_class : public FLASH_DEVICE_class
+{
+	private:
+		FLASH_LOG_class _log;
+		uint16_t _sectorCount = FLASH_SECTORS;
+		bool _mounted = false;
+
+		void select();
+		void deselect();
+		void sendCommand(uint8_t command, uint32_t address);
+		void waitUntilReady();
+		void wake();
+		void powerDown();
+
+	public:
+		FLASH_MODULE_class() : _log(*this) {}
+
+		void Initialize();
+		bool append(uint32_t hourKey, const void *data, uint8_t length);
+		bool find(uint32_t hourKey, void *data, uint8_t &length);
+
+		uint16_t getSectorCount();
+		void read(uint32_t address, void *buffer, uint16_t length);
+		void program(uint32_t address, const void *buffer, uint16_t length);
+		void eraseSector(uint32_t address);
+};
+
+#endif
@@ -0,0 +1,128 @@
+/*
+  ============================================================
+  Master's Thesis in Electrical and Computer Engineering
+  Faculty of Electrical and Computer Engineering
+  School of Engineering and Natural Sciences, University of Iceland
+
+  Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+		 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+  Researcher: Jezreel Tan
+  Email: jvt6@hi.is
+
+  Supervisors:
+  Helgi Þorbergsson
+  Email: thorberg@hi.is
+
+  Dórótea Höeg Sigurðardóttir
+  Email: dorotea@hi.is
+
+  ============================================================
+*/
+
+#include "../system_node.hpp"
+
+HEALTH_MODULE_class nodeHealth;
+
+// Optiboot clears MCUSR before starting the sketch and hands its copy over in r2, taken before the startup code runs
+uint8_t bootCause __attribute__ ((section (".noinit")));
+void saveBootCause() __attribute__ ((naked, used, section (".init0")));
+void saveBootCause()
+{
+	// Not on the host build in tools/energy_model, where there is no r2 and no bootloader
+	#ifdef __AVR__
+		__asm__ __volatile__ ("sts %0, r2\n" : "=m" (bootCause) :);
+	#endif
+}
+
+// The watchdog stays armed while WDRF is set, so MCUSR is read and cleared before the core starts (avr-libc FAQ).
+// Without a bootloader r2 is whatever it was, but MCUSR then still holds the cause
+uint8_t resetCause __attribute__ ((section (".noinit")));
+void saveResetCause() __attribute__ ((naked, used, section (".init3")));
+void saveResetCause()
+{
+	resetCause = MCUSR ? MCUSR : bootCause;
+	MCUSR = 0;
+	wdt_disable();
+}
+
+// Everything between the end of .noinit and the stack is painted before the constructors run, the
+// bytes still painted at the end of a window are what the deepest call of that window left over
+extern uint16_t __heap_start, *__brkval;
+void paintAtBoot() __attribute__ ((naked, used, section (".init3")));
+void paintAtBoot()
+{
+	for (uint8_t *p = (uint8_t*)&__heap_start; p < (uint8_t*)SP; p++) *p = STACK_PAINT;
+}
+
+void HEALTH_MODULE_class::Initialize()
+{
+	EEPROM.get(HEALTH_EEPROM_START, _record);
+
+	if (_record.magic != HEALTH_MAGIC)
+	{
+		memset(&_record, 0, sizeof(_record));
+		_record.magic = HEALTH_MAGIC;
+	}
+
+	_minFreeRam = stackHeadroom();
+
+	if (resetCause & bit(WDRF)) count(HEALTH_WATCHDOG);
+	store();
+}
+
+void HEALTH_MODULE_class::count(uint8_t counter)
+{
+	if (_record.counters[counter] < UINT16_MAX) _record.counters[counter]++;
+}
+
+uint16_t HEALTH_MODULE_class::stackHeadroom()
+{
+	// The stack grows down into the paint, count up from the heap until the first byte it touched
+	uint8_t *p = (uint8_t*)(__brkval == 0 ? &__heap_start : __brkval);
+	uint8_t *top = (uint8_t*)SP;
+	uint16_t headroom = 0;
+
+	while (p < top && *p++ == STACK_PAINT) headroom++;
+
+	return headroom;
+}
+
+void HEALTH_MODULE_class::paintStack()
+{
+	// Called from the shallow end of Run(), anything an interrupt leaves in the paint only makes the next figure lower
+	uint8_t *p = (uint8_t*)(__brkval == 0 ? &__heap_start : __brkval);
+	uintptr_t top = SP - STACK_GUARD;
+
+	while ((uintptr_t)p < top) *p++ = STACK_PAINT;
+}
+
+void HEALTH_MODULE_class::openRound(uint8_t hwid, time_t t)
+{
+	// Nodes report in different rounds, so the reports don't all land in one window
+	uint32_t hourKey = (t + SECS_PER_HOUR / 2) / SECS_PER_HOUR;
+	if ((hourKey + hwid) % HEALTH_ROUNDS == 0) _due = true;
+}
+
+void HEALTH_MODULE_class::closeRound()
+{
+	// High-water mark of this window, then a fresh coat for the next one
+	uint16_t headroom = stackHeadroom();
+
+	if (headroom < _minFreeRam) _minFreeRam = headroom;
+	paintStack();
+	store();
+}
+
+void HEALTH_MODULE_class::store()
+{
+	// Once per window, put() only rewrites the bytes that changed
+	EEPROM.put(HEALTH_EEPROM_START, _record);
+}
+
+void HEALTH_MODULE_class::sent()
+{
+	_due = false;
+	_seq++;
+	_minFreeRam = UINT16_MAX;
+}
@@ -0,0 +1,78 @@
+/*
+  ============================================================
+  Master's Thesis in Electrical and Computer Engineering
+  Faculty of Electrical and Computer Engineering
+  School of Engineering and Natural Sciences, University of Iceland
+
+  Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+		 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+  Researcher: Jezreel Tan
+  Email: jvt6@hi.is
+
+  Supervisors:
+  Helgi Þorbergsson
+  Email: thorberg@hi.is
+
+  Dórótea Höeg Sigurðardóttir
+  Email: dorotea@hi.is
+
+  ============================================================
+*/
+
+#ifndef health_module_h
+#define health_module_h
+
+#include "../system_node.hpp"
+
+// EEPROM Layout, clear of the history ring at 0
+#define HEALTH_EEPROM_START		0x300
+#define HEALTH_MAGIC			0x48	// Anything else there is a fresh or erased EEPROM
+
+// Counters, in the order they are sent in the HLTH frame (keep in sync with the basestation)
+#define HEALTH_SEND_LIMIT		0		// Frames heard after the reply already went out SEND_ATTEMPTS times
+#define HEALTH_BAD_HEADER		1
+#define HEALTH_BAD_FRAME		2		// Brackets, characters, numbers or field count
+#define HEALTH_BAD_CHECKSUM		3
+#define HEALTH_WATCHDOG			4		// Resets with WDRF set in MCUSR, or in r2 from Optiboot 4.6+ which clears MCUSR itself
+#define HEALTH_COUNTERS			5
+
+#define HEALTH_ROUNDS			6		// Windows between reports, staggered by hwid
+
+// Stack Painting, the same byte as tools/avr_bench
+#define STACK_PAINT				0xC5
+#define STACK_GUARD				32		// Left alone below SP when repainting, room for an interrupt's frame
+
+struct HEALTH_RECORD
+{
+	uint8_t magic;
+	uint16_t counters[HEALTH_COUNTERS];		// Since the EEPROM was last erased, saturating
+};
+
+class HEALTH_MODULE_class
+{
+	private:
+		HEALTH_RECORD _record;
+		uint16_t _minFreeRam;				// Fewest painted bytes left in any window since the last report
+		uint8_t _seq;
+		bool _due;
+
+	public:
+		void Initialize();
+		void count(uint8_t counter);
+		void openRound(uint8_t hwid, time_t t);
+		void closeRound();
+		void store();
+		uint16_t stackHeadroom();
+		void paintStack();
+		void sent();
+
+		bool due() const { return _due; }
+		uint8_t seq() const { return _seq; }
+		uint16_t counter(uint8_t counter) const { return _record.counters[counter]; }
+		uint16_t minFreeRam() const { return _minFreeRam; }
+};
+
+extern HEALTH_MODULE_class nodeHealth;
+
+#endif
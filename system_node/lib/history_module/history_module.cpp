@@ -0,0 +1,86 @@
+/*
+  ============================================================
+  Master's Thesis in Electrical and Computer Engineering
+  Faculty of Electrical and Computer Engineering
+  School of Engineering and Natural Sciences, University of Iceland
+
+  Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+		 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+  Researcher: Jezreel Tan
+  Email: jvt6@hi.is
+
+  Supervisors:
+  Helgi Þorbergsson
+  Email: thorberg@hi.is
+
+  Dórótea Höeg Sigurðardóttir
+  Email: dorotea@hi.is
+
+  ============================================================
+*/
+
+#include "../system_node.hpp"
+
+uint32_t HISTORY_MODULE_class::hourKey(time_t t)
+{
+	// Sampled at ALARM1 just before the hour and polled just after it, both round to the same hour
+	return (t + SECS_PER_HOUR / 2) / SECS_PER_HOUR;
+}
+
+void HISTORY_MODULE_class::storeData(IDATA IData, time_t t)
+{
+	HISTORY_RECORD record;
+
+	record.hourKey = hourKey(t);
+	record.temperature = (int16_t)lround(IData.SYSTEM_TEMPERATURE * HISTORY_CENTI);
+	record.humidity = (uint16_t)lround(IData.SYSTEM_HUMIDITY * HISTORY_CENTI);
+	record.soilTemperature = (int16_t)lround(IData.SOIL_TEMPERATURE * HISTORY_CENTI);
+	record.soilMoisture = IData.SOIL_MOISTURE;
+	record.battery = (uint16_t)lround(IData.BATTERY_VOLTAGE * HISTORY_MILLI);
+
+	#ifdef FLASH_LOGGING
+		if (!_flash_module.append(record.hourKey, &record, sizeof(record))) return;
+	#else
+		// Ring indexed by hour, put() only rewrites bytes that changed
+		EEPROM.put(getAddress(record.hourKey), record);
+	#endif
+
+	#ifdef DEBUGGING
+		Serial.print(F("Stored History for Hour: "));
+		Serial.println(record.hourKey);
+	#endif
+}
+
+bool HISTORY_MODULE_class::loadData(uint32_t roundHour, uint8_t hoursAgo, HISTORY_RECORD &record)
+{
+	// Counted back from the hour of the round asking, the same base the basestation uses
+	uint32_t key = roundHour - hoursAgo;
+
+	#ifdef FLASH_LOGGING
+		uint8_t length;
+
+		if (roundHour == 0) return false;
+
+		return _flash_module.find(key, &record, length) && length == sizeof(record);
+	#else
+		if (roundHour == 0 || hoursAgo >= HISTORY_DEPTH) return false;
+
+		// Slot may have been overwritten or never written, the stored key tells
+		EEPROM.get(getAddress(key), record);
+
+		return record.hourKey == key;
+	#endif
+}
+
+#ifdef FLASH_LOGGING
+	void HISTORY_MODULE_class::Initialize()
+	{
+		_flash_module.Initialize();
+	}
+#else
+	uint16_t HISTORY_MODULE_class::getAddress(uint32_t hourKey)
+	{
+		return HISTORY_EEPROM_START + (hourKey % HISTORY_DEPTH) * sizeof(HISTORY_RECORD);
+	}
+#endif
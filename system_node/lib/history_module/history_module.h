@@ -0,0 +1,65 @@
+/*
+  ============================================================
+  Master's Thesis in Electrical and Computer Engineering
+  Faculty of Electrical and Computer Engineering
+  School of Engineering and Natural Sciences, University of Iceland
+
+  Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+		 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+  Researcher: Jezreel Tan
+  Email: jvt6@hi.is
+
+  Supervisors:
+  Helgi Þorbergsson
+  Email: thorberg@hi.is
+
+  Dórótea Höeg Sigurðardóttir
+  Email: dorotea@hi.is
+
+  ============================================================
+*/
+
+#ifndef history_module_h
+#define history_module_h
+
+#include "../system_node.hpp"
+
+// EEPROM Layout (ATmega328: 1 KB, DS3231 has no SRAM)
+#define HISTORY_EEPROM_START	0
+#define HISTORY_DEPTH			24		// Last 24 hourly readings, 14 bytes each
+
+// Fixed-Point Scales
+#define HISTORY_CENTI			100		// Temperature and humidity in hundredths
+#define HISTORY_MILLI			1000	// Battery in millivolts
+
+struct HISTORY_RECORD
+{
+	uint32_t hourKey;			// Hours since epoch of the round this reading was taken for
+	int16_t temperature;
+	uint16_t humidity;
+	int16_t soilTemperature;
+	uint16_t soilMoisture;
+	uint16_t battery;
+};
+
+class HISTORY_MODULE_class
+{
+	private:
+		#ifdef FLASH_LOGGING
+			FLASH_MODULE_class _flash_module;		// Keeps every hour, not just the last day
+		#else
+			uint16_t getAddress(uint32_t hourKey);
+		#endif
+
+	public:
+		#ifdef FLASH_LOGGING
+			void Initialize();
+		#endif
+
+		static uint32_t hourKey(time_t t);
+		void storeData(IDATA IData, time_t t);
+		bool loadData(uint32_t roundHour, uint8_t hoursAgo, HISTORY_RECORD &record);
+};
+
+#endif
@@ -132,16 +132,21 @@ void HWIO_class::getBattery(float &battery)
 		delay(SAMPLE_DELAY);
 	}
 
-	float pinvoltage = ((totaldatasamples / DATA_SAMPLES) / ADC_RESO_MAX) * ADC_REF_VOL;
-	float batteryvoltage = pinvoltage * (((float)R1 + (float)R2) / (float)R2);
+	battery = toBatteryVoltage(totaldatasamples);
 
 	#ifdef DEBUGGING
 		Serial.print(F("Battery Voltage: "));
-		Serial.print(batteryvoltage);
+		Serial.print(battery);
 		Serial.println(F(" Volts"));
 	#endif
+}
+
+float HWIO_class::toBatteryVoltage(float totaldatasamples)
+{
+	float pinvoltage = ((totaldatasamples / DATA_SAMPLES) / ADC_RESO_MAX) * ADC_REF_VOL;
+	float batteryvoltage = pinvoltage * (((float)R1 + (float)R2) / (float)R2);
 
-	battery = constrain(batteryvoltage, MIN_VALUE, MAX_VALUE);
+	return constrain(batteryvoltage, MIN_VALUE, MAX_VALUE);
 }
 
 void HWIO_class::getAHT10(float &temperature, float &humidity)
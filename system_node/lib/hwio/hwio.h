@@ -76,10 +76,15 @@ class HWIO_class
 		void setGPIO();
 		void getHWID(uint8_t &hwid);
 		void getBattery(float &battery);
+		float toBatteryVoltage(float totaldatasamples);
 		void getAHT10(float &temperature, float &humidity);
 		void getSoilTemperature(float &temperature);
 		void getSoilMoisture(uint16_t &moisture);
 
+		#ifdef AVR_BENCH
+			friend class AVR_BENCH_class;
+		#endif
+
 	public:
 		HWIO_class() : oneWire(STEMP_IN), ds18b20(&oneWire) {}
 
@@ -22,6 +22,16 @@
 
 #include "../system_node.hpp"
 
+const char LORA_MODULE_class::_validHeaders[VALID_HEADERS][MAX_HEADER_LENGTH] PROGMEM =
+{
+	"TEMP:",
+	"HUMI:",
+	"STMP:",
+	"SMOI:",
+	"BATT:",
+	"BKFL:"
+};
+
 void LORA_MODULE_class::Initialize(IDATA IData)
 {
 	configureLoRa();
@@ -29,16 +39,18 @@ void LORA_MODULE_class::Initialize(IDATA IData)
 	// Set HW ID
 	_hwid = IData.HW_ID;
 
+	// No event relayed yet
+	for (uint8_t i = 0; i < MAX_DEVICES; i++) _lastEventSeq[i] = -1;
+
+	// Carry on from the last seq sent, the basestation drops a repeat of the one it has stored for us
+	_eventSeq = EEPROM.read(EVENT_SEQ_EEPROM);
+
 	// CSMA/CA (Carrier Sense Multiple Access with Collision Avoidance) Parameters
 	_backoffTime = BACKOFF_MUL + _hwid * BACKOFF_MUL;
 	_csmaTimeout = CSMA_TOUT_MIN + (CSMA_TOUT_MUL * _hwid);
 
 	#ifdef DEBUGGING
-		Serial.print(F("Backoff Time (ms): "));
-		Serial.println(_backoffTime);
-		Serial.print(F("CSMA Timeout (ms): "));
-		Serial.println(_csmaTimeout);
-		Serial.println(F("LoRa Setup Complete!"));
+		debugLog.log(LOG_LORA_SETUP, _backoffTime, _csmaTimeout);
 	#endif
 }
 
@@ -51,7 +63,7 @@ void LORA_MODULE_class::configureLoRa()
 	if (!LoRa.begin(FREQUENCY))
 	{
 		#ifdef DEBUGGING
-			Serial.println(F("X: ERROR: LoRa Initialization Failed!"));
+			debugLog.log(LOG_LORA_FAILED);
 		#endif
 	}
 
@@ -78,7 +90,7 @@ void LORA_MODULE_class::setPinsOff()
 	pinMode(PIN_SCK, INPUT);
 }
 
-void LORA_MODULE_class::loadSensorData(IDATA IData)
+void LORA_MODULE_class::loadSensorData(IDATA IData, PREDICTOR_class *predictor)
 {
 	_sensorData[TEMPERATURE] = IData.SYSTEM_TEMPERATURE;
 	_sensorData[HUMIDITY] = IData.SYSTEM_HUMIDITY;
@@ -86,25 +98,71 @@ void LORA_MODULE_class::loadSensorData(IDATA IData)
 	_sensorData[SOIL_MOISTURE] = IData.SOIL_MOISTURE;
 	_sensorData[BATT_VOLTAGE] = IData.BATTERY_VOLTAGE;
 
+	#ifdef PREDICTING
+		// Only contribute real values the basestation can't predict on its own
+		for (uint8_t i = TEMPERATURE; i < BACKFILL; i++)
+		{
+			if (predictor->isPredicted(i)) _sensorData[i] = PREDICTED_VALUE;
+		}
+	#endif
+
 	resetValues();
 }
 
-void LORA_MODULE_class::startLoRaMesh(IDATA IData, HWIO_class *hwio, RTC_MODULE_class *rtc)
+void LORA_MODULE_class::startLoRaMesh(IDATA IData, HWIO_class *hwio, RTC_MODULE_class *rtc, HISTORY_MODULE_class *history)
 {
 	while (millis() - _lastSystemUpdateTime <= LORA_WAKE_TIMEOUT)
 	{
 		if (LoRa.parsePacket() || _newpayloadAlert)
 		{
 			if (!_newpayloadAlert && !getLoRaPayload()) continue;
+
+			// The first network time heard this wake is checked against the RTC in whole seconds, a cheap read before anything is relayed
+			if (_timeHeard && !_timeChecked) checkRTC(hwio, rtc);
+
+			// Backfill replies and health reports are never merged, hold one and forward it when the channel goes quiet
+			if (isHistoryFrame() || isHealthFrame())
+			{
+				_newpayloadAlert = false;
+				queueHistoryRelay();
+				continue;
+			}
+
+			// Urgent events bypass the round, relay them and pick up where we left off
+			if (isEventFrame())
+			{
+				_newpayloadAlert = false;
+				relayEvent();
+				if (_loraprevHeader[0] != '\0' && _sendAttempts < SEND_ATTEMPTS) sendPayloadData();
+				continue;
+			}
+
 			preloadMessageData();
 			processPayloadData();
-			sendPayloadData(hwio, rtc);
+			sendPayloadData();
+
+			// Backfill hours are counted from the round asking, not from whatever was stored last
+			if (_backfillLoaded && _backfillHour == 0) _backfillHour = roundHour(hwio, rtc);
 		}
+		else if (millis() - _lastActivityTime >= _csmaTimeout && (sendHistoryData(history) || sendHealthData(rtc)))
+		{
+			// Stay awake while there is backfill left to move
+			_lastSystemUpdateTime = millis();
+		}
+		#ifdef DEBUGGING
+			else
+			{
+				debugLog.drain();
+			}
+		#endif
 
 		#ifdef WDT_ENABLE
 			wdt_reset();
 		#endif
 	}
+
+	// Measuring spins on the DS3231 for up to a second, so it waits until the window's relays are done
+	if (_syncPending) syncRTC(hwio, rtc);
 }
 
 void LORA_MODULE_class::resetValues()
@@ -112,9 +170,16 @@ void LORA_MODULE_class::resetValues()
 	// Reset values for fresh requests
 	_sendAttempts = 0;
 	_newpayloadAlert = false;
-	_syncRTCDone = false;
+	_timeHeard = false;
+	_timeChecked = false;
+	_syncPending = false;
+	_backfillLoaded = false;
+	_historyPending = false;
+	_backfillMask = 0;
+	_backfillHour = 0;
 	_lastSystemUpdateTime = millis();
-	memset(_loraPayload, 0, sizeof(_loraPayload));
+	_lastActivityTime = millis();
+	memset(_frames.rx, 0, sizeof(_frames.rx));
 	memset(_loraprevHeader, 0, sizeof(_loraprevHeader));
 	memset(_systemValues, 0, sizeof(_systemValues));
 }
@@ -122,55 +187,68 @@ void LORA_MODULE_class::resetValues()
 bool LORA_MODULE_class::getLoRaPayload()
 {
 	#ifdef DEBUGGING
-		//	Display Signal Strength (RSSI) of the Received Packet
-		Serial.println(F("Packet received!"));
-		Serial.print(F("Signal strength [RSSI] (dBm): "));
-		Serial.println(LoRa.packetRssi());
+		//	Signal Strength (RSSI) of the Received Packet
+		debugLog.log(LOG_PACKET, (int16_t)LoRa.packetRssi());
 	#endif
 
+	// RxDone was just polled, the frame ended about now
+	_rxTime = millis();
+
 	//	Get Payload content
 	uint8_t payloadIndex = 0;
-	memset(_loraPayload, 0, sizeof(_loraPayload));
-	while (LoRa.available() && payloadIndex < sizeof(_loraPayload) - 1)
+	memset(_frames.rx, 0, sizeof(_frames.rx));
+	while (LoRa.available() && payloadIndex < sizeof(_frames.rx) - 1)
 	{
-		_loraPayload[payloadIndex++] = (char)LoRa.read();
+		_frames.rx[payloadIndex++] = (char)LoRa.read();
 	}
 	payloadIndex++; // +1 as space for null terminator
 
 	// Flush remaining bytes (if any)
 	while (LoRa.available()) LoRa.read();
+	_lastActivityTime = millis();
+	_rxLength = payloadIndex - 1;
 
-	#ifdef ENCRYPTING
-		#ifdef DEBUGGING
-			Serial.print(F("Encrypted Payload: "));
-			for (uint8_t i = 0; i < payloadIndex - 1; i++)
-			{
-				Serial.print((uint8_t)_loraPayload[i], HEX);
-				Serial.print(' ');
-			}
-			Serial.println();
-		#endif
+	#ifdef EVENT_TRACE
+		uint16_t frameId = TRACE_MODULE_class::frameId(_frames.rx, payloadIndex - 1);
+		eventTrace.add(TRACE_RX, payloadIndex - 1, frameId);
+	#endif
 
-		char decryptedPayload[MAX_MESSAGE_LENGTH];
-		memcpy(decryptedPayload, _loraPayload, payloadIndex);
-		rc4EncryptDecrypt(decryptedPayload, payloadIndex);
-		memcpy(_loraPayload, decryptedPayload, payloadIndex);
+	#ifdef ENCRYPTING
+		rc4EncryptDecrypt(_frames.rx, payloadIndex);
 	#endif
 
 	#ifdef DEBUGGING
-		//	Print LoRa Payload
-		Serial.print(F("Payload: "));
-		Serial.println(_loraPayload);
+		debugLog.log(LOG_PAYLOAD, logText(_frames.rx));
+	#endif
+
+	// The network time rides behind the frame and is cut off before the frame is checked
+	uint32_t epoch;
+	uint16_t millisecond;
+	bool tagged = takeTimeTag(&epoch, &millisecond);
+
+	bool valid = checkMessageValidity();
+
+	// The first time heard this wake is kept, counted on from its last symbol
+	if (valid && tagged && !_timeHeard)
+	{
+		_timeEpoch = epoch;
+		_timeElapsed = millisecond + airtime(_rxLength);
+		_timeHeardAt = _rxTime;
+		_timeHeard = true;
+	}
+
+	#ifdef EVENT_TRACE
+		if (!valid) eventTrace.add(TRACE_INVALID, isEventFrame() ? TRACE_EVENT_FRAME : isHistoryFrame() ? TRACE_HISTORY_FRAME : isHealthFrame() ? TRACE_HEALTH_FRAME : TRACE_DATA_FRAME, frameId);
 	#endif
 
-	return checkMessageValidity();
+	return valid;
 }
 
 int8_t LORA_MODULE_class::getcharIndex(char c)
 {
-	for (uint8_t i = 0; i < sizeof(_loraPayload); i++)
+	for (uint8_t i = 0; i < sizeof(_frames.rx); i++)
 	{
-		if (_loraPayload[i] == c) return i;
+		if (_frames.rx[i] == c) return i;
 	}
 	return -1;
 }
@@ -180,19 +258,18 @@ float *LORA_MODULE_class::getpayloadValues()
 	static float tempValues[MAX_DEVICES];
 	memset(tempValues, 0, sizeof(tempValues));
 
-	uint8_t startIdx = getcharIndex('[');
-	uint8_t endIdx = getcharIndex(']');
-	uint8_t array_len = endIdx - (startIdx + 1);
-	char buffer[array_len + 1];
-	strncpy(buffer, &_loraPayload[startIdx + 1], array_len);
-	buffer[array_len] = '\0';
+	int8_t startIdx = getcharIndex('[');
+	if (startIdx == -1) return tempValues;
 
-	char* token = strtok(buffer, ",");
+	// Read straight out of the frame, a placeholder or anything else that isn't a number reads as 0
+	char *cursor = &_frames.rx[startIdx + 1];
 	uint8_t index = 0;
-	while (token != nullptr && index < MAX_DEVICES)
+	while (*cursor != ']' && *cursor != '\0' && index < MAX_DEVICES)
 	{
-		tempValues[index++] = atof(token);
-		token = strtok(nullptr, ",");
+		tempValues[index++] = *cursor == PREDICTED_PLACEHOLDER ? PREDICTED_VALUE : strtod(cursor, nullptr);
+
+		while (*cursor != ',' && *cursor != ']' && *cursor != '\0') cursor++;
+		if (*cursor == ',') cursor++;
 	}
 
 	return tempValues;
@@ -200,20 +277,29 @@ float *LORA_MODULE_class::getpayloadValues()
 
 bool LORA_MODULE_class::checkMessageValidity()
 {
-	uint8_t startIdx = getcharIndex('[');
-	uint8_t endIdx = getcharIndex(']');
-	uint8_t payloadLen = strlen(_loraPayload);
+	int8_t startIdx = getcharIndex('[');
+	int8_t endIdx = getcharIndex(']');
+	uint8_t payloadLen = strlen(_frames.rx);
 	bool checkforCharacters = true;
 
+	// Event, backfill and health frames have their own layouts
+	if (isEventFrame()) return checkEventValidity();
+	if (isHistoryFrame()) return checkHistoryValidity();
+	if (isHealthFrame()) return checkHealthValidity();
+
 	// Check header validity
 	for (uint8_t i = 0; i < VALID_HEADERS; i++)
 	{
-		if (strncmp(_loraPayload, _validHeaders[i], strlen(_validHeaders[i])) == 0) break;
+		if (strncmp_P(_frames.rx, _validHeaders[i], START_OF_BRACKET) == 0) break;
 
 		if(i == VALID_HEADERS - 1)
 		{
 			#ifdef DEBUGGING
-				Serial.println(F("X: Invalid Packet Header!"));
+				debugLog.log(LOG_BAD_HEADER);
+			#endif
+
+			#ifdef HEALTH_REPORTS
+				nodeHealth.count(HEALTH_BAD_HEADER);
 			#endif
 
 			return false;
@@ -224,7 +310,11 @@ bool LORA_MODULE_class::checkMessageValidity()
 	if (startIdx == -1 && endIdx == -1)
 	{
 		#ifdef DEBUGGING
-			Serial.println(F("X: Unable to Locate Data!"));
+			debugLog.log(LOG_NO_DATA);
+		#endif
+
+		#ifdef HEALTH_REPORTS
+			nodeHealth.count(HEALTH_BAD_FRAME);
 		#endif
 
 		return false;
@@ -233,27 +323,35 @@ bool LORA_MODULE_class::checkMessageValidity()
 	// Check Payload data strictly
 	for (size_t i = START_OF_BRACKET; i < payloadLen; i++)
 	{
-		char payloadChar = _loraPayload[i];
+		char payloadChar = _frames.rx[i];
 
 		if (checkforCharacters)
 		{
-			if (payloadChar == BLANK_PLACEHOLDER || (payloadChar == '[' && _loraPayload[i + 1] == ']')) continue;
+			if (payloadChar == BLANK_PLACEHOLDER || payloadChar == PREDICTED_PLACEHOLDER || (payloadChar == '[' && _frames.rx[i + 1] == ']')) continue;
 
 			if (payloadChar != '[' && payloadChar != ']' && payloadChar != ',')
 			{
 				#ifdef DEBUGGING
-					Serial.println(F("X: Invalid Character Found!"));
+					debugLog.log(LOG_BAD_CHARACTER);
+				#endif
+
+				#ifdef HEALTH_REPORTS
+					nodeHealth.count(HEALTH_BAD_FRAME);
 				#endif
 
 				return false;
 			}
 
-			if ((payloadChar == '[' && _loraPayload[i + 2] == ',') || (payloadChar == ',' && _loraPayload[i + 2] == ',') || (payloadChar == ',' && _loraPayload[i + 2] == ']'))
+			if ((payloadChar == '[' && _frames.rx[i + 2] == ',') || (payloadChar == ',' && _frames.rx[i + 2] == ',') || (payloadChar == ',' && _frames.rx[i + 2] == ']'))
 			{
-				if (_loraPayload[i + 1] != BLANK_PLACEHOLDER)
+				if (_frames.rx[i + 1] != BLANK_PLACEHOLDER && _frames.rx[i + 1] != PREDICTED_PLACEHOLDER)
 				{
 					#ifdef DEBUGGING
-						Serial.println(F("X: Invalid Data Found!"));
+						debugLog.log(LOG_BAD_DATA);
+					#endif
+
+					#ifdef HEALTH_REPORTS
+						nodeHealth.count(HEALTH_BAD_FRAME);
 					#endif
 
 					return false;
@@ -269,13 +367,17 @@ bool LORA_MODULE_class::checkMessageValidity()
 			if ((payloadChar < '0' || payloadChar > '9') && payloadChar != '.' && payloadChar != '-')
 			{
 				#ifdef DEBUGGING
-					Serial.println(F("Invalid Number Found!"));
+					debugLog.log(LOG_BAD_NUMBER);
+				#endif
+
+				#ifdef HEALTH_REPORTS
+					nodeHealth.count(HEALTH_BAD_FRAME);
 				#endif
 
 				return false;
 			}
 
-			if (_loraPayload[i + 1] == ',' || _loraPayload[i + 1] == ']')
+			if (_frames.rx[i + 1] == ',' || _frames.rx[i + 1] == ']')
 			{
 				checkforCharacters = true;
 			}
@@ -290,20 +392,21 @@ bool LORA_MODULE_class::checkMessageValidity()
 		float sum = 0;
 		for (uint8_t i = 0; i < CHECKSUM; i++)
 		{
-			sum += tempValues[i];
+			if (tempValues[i] != PREDICTED_VALUE) sum += tempValues[i];
 		}
 
 		#ifdef DEBUGGING
-			Serial.print(F("Calculating Checksum: "));
-			Serial.print(sum, DECIMAL_VALUES);
-			Serial.print(F(" vs "));
-			Serial.println(tempValues[CHECKSUM], DECIMAL_VALUES);
+			debugLog.log(LOG_CHECKSUM, sum, tempValues[CHECKSUM]);
 		#endif
 
 		if (fabs(sum - tempValues[CHECKSUM]) > EPSILON)
 		{
 			#ifdef DEBUGGING
-				Serial.println(F("Checksum is BAD!"));
+				debugLog.log(LOG_CHECKSUM_BAD);
+			#endif
+
+			#ifdef HEALTH_REPORTS
+				nodeHealth.count(HEALTH_BAD_CHECKSUM);
 			#endif
 
 			return false;
@@ -311,7 +414,7 @@ bool LORA_MODULE_class::checkMessageValidity()
 		#ifdef DEBUGGING
 			else
 			{
-				Serial.println(F("Checksum is GOOD!"));
+				debugLog.log(LOG_CHECKSUM_GOOD);
 			}
 		#endif
 	}
@@ -323,17 +426,17 @@ void LORA_MODULE_class::preloadMessageData()
 {
 	uint8_t startIdx = getcharIndex('[');
 	uint8_t endIdx = getcharIndex(']');
-	uint8_t payloadLen = strlen(_loraPayload);
+	uint8_t payloadLen = strlen(_frames.rx);
 
-	if ((startIdx == START_OF_BRACKET && endIdx == START_OF_BRACKET + 1 && payloadLen == START_OF_BRACKET + 2) || strncmp(_loraPayload, _loraprevHeader, START_OF_BRACKET) != 0)
+	if ((startIdx == START_OF_BRACKET && endIdx == START_OF_BRACKET + 1 && payloadLen == START_OF_BRACKET + 2) || strncmp(_frames.rx, _loraprevHeader, START_OF_BRACKET) != 0)
 	{
 		// Reset database
 		memset(_systemValues, 0, sizeof(_systemValues));
 
 		// Load values
-		for (uint8_t i = 0; i < VALID_HEADERS - 1; i++)
+		for (uint8_t i = 0; i < BACKFILL; i++)
 		{
-			if (strncmp(_loraPayload, _validHeaders[i], strlen(_validHeaders[i])) == 0)
+			if (strncmp_P(_frames.rx, _validHeaders[i], START_OF_BRACKET) == 0)
 			{
 				_systemValues[_hwid] = _sensorData[i];
 				break;
@@ -341,19 +444,13 @@ void LORA_MODULE_class::preloadMessageData()
 		}
 
 		// Get new header
-		strncpy(_loraprevHeader, _loraPayload, START_OF_BRACKET);
-		_loraprevHeader[MAX_HEADER_LENGTH - 1] = '\0';
+		memcpy(_loraprevHeader, _frames.rx, START_OF_BRACKET);
+		_loraprevHeader[START_OF_BRACKET] = '\0';
 	}
 
 	#ifdef DEBUGGING
-		//	Print Current Database
-		Serial.print(F("Current Data: ["));
-		for (uint8_t i = 0; i < MAX_DEVICES; i++)
-		{
-			Serial.print(strcmp(_loraprevHeader, _validHeaders[SOIL_MOISTURE]) == 0 ? (uint16_t)_systemValues[i] : _systemValues[i], DECIMAL_VALUES);
-			if (i < (MAX_DEVICES - 1)) Serial.print(',');
-		}
-		Serial.println(']');
+		//	Current Database
+		debugLog.log(strcmp_P(_loraprevHeader, _validHeaders[SOIL_MOISTURE]) == 0 ? LOG_CURRENT_RAW : LOG_CURRENT_DATA, logFloats(_systemValues, MAX_DEVICES));
 	#endif
 }
 
@@ -368,13 +465,14 @@ void LORA_MODULE_class::processPayloadData()
 		//	Merge current values with data from Payload only when new data is different
 		if (fabs(tempValues[i] - _systemValues[i]) > EPSILON)
 		{
-			bool isDate = strcmp(_loraprevHeader, _validHeaders[DATE]);
+			// Requests from the basestation are relayed verbatim
+			bool isRequest = strcmp_P(_loraprevHeader, _validHeaders[BACKFILL]) == 0;
 			_sendAttempts = 0;
 			_systemValues[CHECKSUM] = 0;
 
 			for (uint8_t i = 0; i < MAX_DEVICES - 1; i++)
 			{
-				if(isDate == 0)
+				if(isRequest)
 				{
 					_systemValues[i] = tempValues[i];
 				}
@@ -384,18 +482,21 @@ void LORA_MODULE_class::processPayloadData()
 				}
 
 				// Update Checksum
-				_systemValues[CHECKSUM] += _systemValues[i];
+				if (_systemValues[i] != PREDICTED_VALUE) _systemValues[CHECKSUM] += _systemValues[i];
 			}
 
 			#ifdef DEBUGGING
-				//	Print merged values
-				Serial.print(F("Merged Data: ["));
-				for (uint8_t i = 0; i < MAX_DEVICES; i++)
+				//	Merged values
+				debugLog.log(strcmp_P(_loraprevHeader, _validHeaders[SOIL_MOISTURE]) == 0 ? LOG_MERGED_RAW : LOG_MERGED_DATA, logFloats(_systemValues, MAX_DEVICES));
+			#endif
+
+			#ifdef EVENT_TRACE
+				uint16_t filled = 0;
+				for (uint8_t i = 0; i < MAX_DEVICES - 1; i++)
 				{
-					Serial.print(strcmp(_loraprevHeader, _validHeaders[SOIL_MOISTURE]) == 0 ? (uint16_t)_systemValues[i] : _systemValues[i], DECIMAL_VALUES);
-					if (i < (MAX_DEVICES - 1)) Serial.print(',');
+					if (_systemValues[i] != 0) filled |= bit(i);
 				}
-				Serial.println(']');
+				eventTrace.add(TRACE_MERGE, 0, filled);
 			#endif
 
 			break;
@@ -403,49 +504,28 @@ void LORA_MODULE_class::processPayloadData()
 	}
 }
 
-void LORA_MODULE_class::sendPayloadData(HWIO_class *hwio, RTC_MODULE_class *rtc)
+uint8_t LORA_MODULE_class::formatPayloadData(char *frame)
 {
-	// Reset new Payload alert and last update to prevent forever looping messages
-	_lastSystemUpdateTime = millis();
-	_newpayloadAlert = false;
-
-	// No need to send when reached send limit
-	if (_sendAttempts >= SEND_ATTEMPTS)
-	{
-		#ifdef DEBUGGING
-			Serial.println(F("Send Limit Reached!"));
-		#endif
+	// Written straight into the frame, a value that would not fit cuts it short rather than overrun it
+	bool isInteger = strcmp_P(_loraprevHeader, _validHeaders[SOIL_MOISTURE]) == 0 || strcmp_P(_loraprevHeader, _validHeaders[BACKFILL]) == 0;
+	uint8_t pos = strlen(_loraprevHeader);
 
-		return;
-	}
-	// Only sync rtc on the first attempt of sending the date & time
-	else if(strncmp(_loraprevHeader, _validHeaders[DATE], sizeof(_loraprevHeader)) == 0 && _syncRTCDone == false)
-	{
-		#ifdef DEBUGGING
-			Serial.println(F("Syncing RTC via LoRa"));
-		#endif
-
-		hwio->toggleModules(hwio->GPIO_WAKE);
-		delay(DELAY_SMALL);
-		rtc->reInit();
-		rtc->syncTime(_systemValues);
-		delay(DELAY_SMALL);
-		Wire.end();
-		hwio->toggleModules(hwio->GPIO_SLEEP);
-		_syncRTCDone = true;
-	}
+	memcpy(frame, _loraprevHeader, pos);
+	frame[pos++] = '[';
 
-	// Create new Payload
-	char relay_message[MAX_MESSAGE_LENGTH] = {0};
-	uint8_t pos = 0;
 	for (uint8_t i = 0; i < MAX_DEVICES; i++)
 	{
-		char numStr[MAX_NUMBER_LENGTH];
+		char numStr[MAX_NUMBER_LENGTH + 2];		// dtostrf of a sum past 1000 takes two more
 		if(_systemValues[i] == 0)
 		{
 			numStr[0] = BLANK_PLACEHOLDER;
     		numStr[1] = '\0';
 		}
+		else if (_systemValues[i] == PREDICTED_VALUE)
+		{
+			numStr[0] = PREDICTED_PLACEHOLDER;
+			numStr[1] = '\0';
+		}
 		else
 		{
 			uint8_t width = MAX_NUMBER_LENGTH;
@@ -464,9 +544,9 @@ void LORA_MODULE_class::sendPayloadData(HWIO_class *hwio, RTC_MODULE_class *rtc)
 				width -= 3;
 			}
 
-			if (strcmp(_loraprevHeader, _validHeaders[SOIL_MOISTURE]) == 0)
+			if (isInteger)
 			{
-				snprintf(numStr, sizeof(numStr), "%u", (uint16_t)_systemValues[i]);
+				snprintf_P(numStr, sizeof(numStr), PSTR("%02lu"), (unsigned long)_systemValues[i]);
 			}
 			else
 			{
@@ -474,38 +554,63 @@ void LORA_MODULE_class::sendPayloadData(HWIO_class *hwio, RTC_MODULE_class *rtc)
 			}
 		}
 
-		strcpy(&relay_message[pos], numStr);
-		pos += strlen(numStr);
+		// Room for the value, its separator and the terminator
+		uint8_t len = strlen(numStr);
+		if (pos + len + 2 > MAX_MESSAGE_LENGTH) break;
+
+		memcpy(&frame[pos], numStr, len);
+		pos += len;
+		frame[pos++] = ',';
+	}
+
+	frame[pos - 1] = ']';
+	frame[pos++] = '\0';
+
+	return pos;
+}
+
+void LORA_MODULE_class::sendPayloadData()
+{
+	// Reset new Payload alert and last update to prevent forever looping messages
+	_lastSystemUpdateTime = millis();
+	_newpayloadAlert = false;
+
+	// No need to send when reached send limit
+	if (_sendAttempts >= SEND_ATTEMPTS)
+	{
+		#ifdef DEBUGGING
+			debugLog.log(LOG_SEND_LIMIT);
+		#endif
+
+		#ifdef HEALTH_REPORTS
+			nodeHealth.count(HEALTH_SEND_LIMIT);
+		#endif
 
-		if (i < MAX_DEVICES - 1) relay_message[pos++] = ',';
+		return;
+	}
+	// Pick up our slot of the backfill request once, replies go out in quiet windows
+	else if (strncmp_P(_loraprevHeader, _validHeaders[BACKFILL], sizeof(_loraprevHeader)) == 0 && _backfillLoaded == false)
+	{
+		_backfillMask = (uint16_t)_systemValues[_hwid];
+		_backfillLoaded = true;
 	}
 
-	char sendPayload[MAX_MESSAGE_LENGTH];
-	snprintf(sendPayload, sizeof(sendPayload), "%s[%s]", _loraprevHeader, relay_message);
-	uint8_t payloadLen = strlen(sendPayload) + 1;
+	// Create new Payload, the first request of the round also carries the time on to nodes out of the basestation's reach
+	bool isTagged = _timeHeard && strcmp_P(_loraprevHeader, _validHeaders[TEMPERATURE]) == 0;
+	uint8_t payloadLen = formatPayloadData(_frames.tx);
+	if (isTagged) payloadLen = appendTimeTag(_frames.tx, payloadLen);
 
 	#ifdef DEBUGGING
-		Serial.print(F("Payload to Send: "));
-		Serial.println(sendPayload);
+		debugLog.log(LOG_SEND_PAYLOAD, logText(_frames.tx));
 	#endif
 
-	// Encryption
+	// Encrypt in place, the frame is rebuilt from _systemValues for the next send
 	#ifdef ENCRYPTING
-		char encryptedPayload[payloadLen] = {0};
-		strncpy(encryptedPayload, sendPayload, payloadLen);
-
-		// Encrypt Data
-		rc4EncryptDecrypt(encryptedPayload, payloadLen);
+		rc4EncryptDecrypt(_frames.tx, payloadLen);
+	#endif
 
-		#ifdef DEBUGGING
-			Serial.print(F("Encrypted Message: "));
-			for (uint8_t i = 0; i < payloadLen; i++)
-			{
-				Serial.print((uint8_t)encryptedPayload[i], HEX);
-				Serial.print(' ');
-			}
-			Serial.println();
-		#endif
+	#ifdef EVENT_TRACE
+		uint16_t frameId = TRACE_MODULE_class::frameId(_frames.tx, payloadLen - 1);
 	#endif
 
 	// CSMA/CA (Carrier Sense Multiple Access with Collision Avoidance)
@@ -514,11 +619,23 @@ void LORA_MODULE_class::sendPayloadData(HWIO_class *hwio, RTC_MODULE_class *rtc)
 		unsigned long startTime = millis();
 		unsigned long lastCheckTime = millis();
 
+		#ifdef DEBUGGING
+			uint16_t backoffSlots = 0;
+		#endif
+
+		#ifdef EVENT_TRACE
+			eventTrace.add(TRACE_BACKOFF, _sendAttempts, _csmaTimeout);
+		#endif
+
 		while (millis() - startTime < _csmaTimeout)
 		{
 			// Check for incoming messages
 			if (LoRa.parsePacket() && getLoRaPayload())
 			{
+				#ifdef EVENT_TRACE
+					eventTrace.add(TRACE_CSMA_INTERRUPT, _sendAttempts, 0);
+				#endif
+
 				_newpayloadAlert = true;
 				return;
 			}
@@ -527,34 +644,51 @@ void LORA_MODULE_class::sendPayloadData(HWIO_class *hwio, RTC_MODULE_class *rtc)
 				lastCheckTime = millis();
 
 				#ifdef DEBUGGING
-					Serial.print('.');
+					backoffSlots++;
 				#endif
 
 				// Perform backoff without blocking execution
 				// if (LoRa.packetRssi() < CSMA_NOISE_LIM) break; Note: Removed since looked like useless and only makes issues
 			}
 
+			// Nothing to do but wait, so this is when the debug log goes out
+			#ifdef DEBUGGING
+				debugLog.drain();
+			#endif
+
 			#ifdef WDT_ENABLE
 				wdt_reset();
 			#endif
 		}
 
+		// The time is stamped as this copy goes out, so the frame is rebuilt after the wait
+		if (isTagged)
+		{
+			payloadLen = appendTimeTag(_frames.tx, formatPayloadData(_frames.tx));
+
+			#ifdef ENCRYPTING
+				rc4EncryptDecrypt(_frames.tx, payloadLen);
+			#endif
+
+			#ifdef EVENT_TRACE
+				frameId = TRACE_MODULE_class::frameId(_frames.tx, payloadLen - 1);
+			#endif
+		}
+
 		// Send the payload over LoRa
-		LoRa.beginPacket();
-		#ifdef ENCRYPTING
-			LoRa.write((const uint8_t*)encryptedPayload, payloadLen - 1);	// -1 Don't send null terminator
-		#else
-			LoRa.write((const uint8_t*)sendPayload, payloadLen - 1);		// -1 Don't send null terminator
+		#ifdef EVENT_TRACE
+			eventTrace.add(TRACE_TX_START, payloadLen - 1, frameId);
 		#endif
+		LoRa.beginPacket();
+		LoRa.write((const uint8_t*)_frames.tx, payloadLen - 1);		// -1 Don't send null terminator
 		LoRa.endPacket();												// Set true for non blocking sending
+		#ifdef EVENT_TRACE
+			eventTrace.add(TRACE_TX_END, payloadLen - 1, frameId);
+		#endif
 
 		// Debugging output for the sent message
 		#ifdef DEBUGGING
-			Serial.print(F("\nPayload Sent Sucessfully! ("));
-			Serial.print(_sendAttempts + 1);
-			Serial.print('/');
-			Serial.print(SEND_ATTEMPTS);
-			Serial.println(')');
+			debugLog.log(LOG_SENT, (uint8_t)(_sendAttempts + 1), (uint8_t)SEND_ATTEMPTS, backoffSlots);
 		#endif
 
 		// Increment attempts
@@ -563,6 +697,475 @@ void LORA_MODULE_class::sendPayloadData(HWIO_class *hwio, RTC_MODULE_class *rtc)
 	}
 }
 
+bool LORA_MODULE_class::takeTimeTag(uint32_t *epoch, uint16_t *millisecond)
+{
+	char *tag = strchr(_frames.rx, TIME_TAG);
+	if (tag == nullptr) return false;
+
+	// "@epoch.ms", three digits of ms and nothing after them
+	char *end = tag + 1;
+	*epoch = strtoul(tag + 1, &end, 10);
+	bool valid = isdigit(tag[1]) && end[0] == '.' && isdigit(end[1]) && isdigit(end[2]) && isdigit(end[3]) && end[4] == '\0';
+	*millisecond = valid ? atoi(&end[1]) : 0;
+
+	// Cut off either way, what is left is checked like any other frame
+	memset(tag, 0, strlen(tag));
+
+	return valid;
+}
+
+uint8_t LORA_MODULE_class::appendTimeTag(char *frame, uint8_t length)
+{
+	// Our best guess of the network time right now, left off when the frame has no room for it
+	unsigned long elapsed = timeElapsed();
+	char tag[TIME_TAG_LENGTH];
+	uint8_t tagLength = snprintf_P(tag, sizeof(tag), PSTR("%c%lu.%03u"), TIME_TAG, (unsigned long)(_timeEpoch + elapsed / 1000), (uint16_t)(elapsed % 1000));
+
+	if (length + tagLength > MAX_MESSAGE_LENGTH) return length;
+
+	memcpy(&frame[length - 1], tag, tagLength + 1);
+	return length + tagLength;
+}
+
+unsigned long LORA_MODULE_class::timeElapsed()
+{
+	return _timeElapsed + (millis() - _timeHeardAt);
+}
+
+void LORA_MODULE_class::checkRTC(HWIO_class *hwio, RTC_MODULE_class *rtc)
+{
+	hwio->toggleModules(hwio->GPIO_WAKE);
+	delay(DELAY_SMALL);
+	rtc->reInit();
+	_syncPending = rtc->checkTime(_timeEpoch, timeElapsed());
+	Wire.end();
+	hwio->toggleModules(hwio->GPIO_SLEEP);
+	_timeChecked = true;
+}
+
+void LORA_MODULE_class::syncRTC(HWIO_class *hwio, RTC_MODULE_class *rtc)
+{
+	#ifdef DEBUGGING
+		debugLog.log(LOG_RTC_SYNC_LORA);
+	#endif
+
+	hwio->toggleModules(hwio->GPIO_WAKE);
+	delay(DELAY_SMALL);
+	rtc->reInit();
+	rtc->syncTime(_timeEpoch, timeElapsed());
+	delay(DELAY_SMALL);
+	Wire.end();
+	hwio->toggleModules(hwio->GPIO_SLEEP);
+	_syncPending = false;
+}
+
+uint32_t LORA_MODULE_class::roundHour(HWIO_class *hwio, RTC_MODULE_class *rtc)
+{
+	if (_timeHeard) return HISTORY_MODULE_class::hourKey(_timeEpoch + timeElapsed() / 1000);
+
+	// Only relays heard this wake, the RTC was set at an earlier one
+	hwio->toggleModules(hwio->GPIO_WAKE);
+	delay(DELAY_SMALL);
+	rtc->reInit();
+	time_t t = rtc->getTime();
+	Wire.end();
+	hwio->toggleModules(hwio->GPIO_SLEEP);
+
+	return HISTORY_MODULE_class::hourKey(t);
+}
+
+uint16_t LORA_MODULE_class::airtime(uint8_t length)
+{
+	// Semtech AN1200.13, explicit header with CRC, counted in quarter symbols to stay in integers
+	const uint32_t symbolUs = (1UL << SPREAD_FACTOR) * 1000UL / (uint32_t)(BANDWIDTH / 1000);
+	const uint8_t perBlock = 4 * (SPREAD_FACTOR - (symbolUs > 16000 ? 2 : 0));
+	int16_t bits = 8 * length - 4 * SPREAD_FACTOR + 28 + 16;
+	uint16_t blocks = bits > 0 ? (bits + perBlock - 1) / perBlock : 0;
+	uint32_t quarters = 4 * PREAMBLE + 17 + 4 * (8 + blocks * CODING_RATE);
+
+	return quarters * symbolUs / 4000;
+}
+
+bool LORA_MODULE_class::isEventFrame()
+{
+	return strncmp_P(_frames.rx, PSTR(EVENT_HEADER), START_OF_BRACKET) == 0;
+}
+
+bool LORA_MODULE_class::checkEventValidity()
+{
+	uint8_t fields = 1;
+	int8_t endIdx = getcharIndex(']');
+
+	if (_frames.rx[START_OF_BRACKET] != '[' || endIdx == -1)
+	{
+		#ifdef DEBUGGING
+			debugLog.log(LOG_NO_EVENT_DATA);
+		#endif
+
+		#ifdef HEALTH_REPORTS
+			nodeHealth.count(HEALTH_BAD_FRAME);
+		#endif
+
+		return false;
+	}
+
+	// Strictly numbers, no placeholders in events
+	for (uint8_t i = START_OF_BRACKET + 1; i < endIdx; i++)
+	{
+		char payloadChar = _frames.rx[i];
+
+		if (payloadChar == ',')
+		{
+			if (_frames.rx[i - 1] == ',' || _frames.rx[i - 1] == '[') return false;
+			fields++;
+		}
+		else if ((payloadChar < '0' || payloadChar > '9') && payloadChar != '.' && payloadChar != '-')
+		{
+			#ifdef DEBUGGING
+				debugLog.log(LOG_BAD_EVENT_CHARACTER);
+			#endif
+
+			#ifdef HEALTH_REPORTS
+				nodeHealth.count(HEALTH_BAD_FRAME);
+			#endif
+
+			return false;
+		}
+	}
+
+	if (fields != EVENT_FIELDS) return false;
+
+	// Last field is the checksum of the others
+	float* tempValues = getpayloadValues();
+	float sum = 0;
+	for (uint8_t i = 0; i < EVENT_FIELDS - 1; i++)
+	{
+		sum += tempValues[i];
+	}
+
+	// The hwid indexes the dedupe table and the seq is kept as a byte
+	if (fabs(sum - tempValues[EVENT_FIELDS - 1]) > EPSILON || tempValues[0] < 0 || tempValues[0] >= MAX_DEVICES - 1 || tempValues[3] < 0 || tempValues[3] > UINT8_MAX)
+	{
+		#ifdef DEBUGGING
+			debugLog.log(LOG_EVENT_CHECKSUM_BAD);
+		#endif
+
+		#ifdef HEALTH_REPORTS
+			nodeHealth.count(HEALTH_BAD_CHECKSUM);
+		#endif
+
+		return false;
+	}
+
+	return true;
+}
+
+void LORA_MODULE_class::sendEvent(uint8_t rule, float value)
+{
+	char valueStr[EVENT_NUMBER_LENGTH];
+	char checksumStr[EVENT_NUMBER_LENGTH];
+
+	_eventSeq++;
+	EEPROM.update(EVENT_SEQ_EEPROM, _eventSeq);
+
+	// Don't relay our own event when it bounces back
+	_lastEventSeq[_hwid] = _eventSeq;
+
+	dtostrf(value, 1, DECIMAL_VALUES, valueStr);
+	dtostrf(_hwid + rule + value + _eventSeq, 1, DECIMAL_VALUES, checksumStr);
+	snprintf_P(_frames.tx, EVENT_MESSAGE_LENGTH, PSTR(EVENT_HEADER "[%u,%u,%s,%u,%s]"), _hwid, rule, valueStr, _eventSeq, checksumStr);
+
+	#ifdef DEBUGGING
+		debugLog.log(LOG_SEND_EVENT, logText(_frames.tx));
+	#endif
+
+	sendDirectPayload(_frames.tx, EVENT_SEND_ATTEMPTS);
+}
+
+void LORA_MODULE_class::relayEvent()
+{
+	float* tempValues = getpayloadValues();
+	uint8_t eventHwid = (uint8_t)tempValues[0];
+	uint8_t eventSeq = (uint8_t)tempValues[3];
+
+	// Each event only gets relayed once per node
+	if (_lastEventSeq[eventHwid] == eventSeq) return;
+	_lastEventSeq[eventHwid] = eventSeq;
+
+	#ifdef DEBUGGING
+		debugLog.log(LOG_RELAY_EVENT);
+	#endif
+
+	// The receive buffer stays as it is, the round carries on from it
+	strncpy(_frames.tx, _frames.rx, EVENT_MESSAGE_LENGTH - 1);
+	_frames.tx[EVENT_MESSAGE_LENGTH - 1] = '\0';
+
+	sendDirectPayload(_frames.tx, 1);
+}
+
+bool LORA_MODULE_class::isHistoryFrame()
+{
+	return strncmp_P(_frames.rx, PSTR(HISTORY_HEADER), START_OF_BRACKET) == 0;
+}
+
+bool LORA_MODULE_class::checkHistoryValidity()
+{
+	// HIST:[hwid,(ago,temp,humi,stmp,smoi,batt)...,checksum], integers only
+	if (_frames.rx[START_OF_BRACKET] != '[' || getcharIndex(']') == -1) return false;
+
+	char *cursor = &_frames.rx[START_OF_BRACKET + 1];
+	long values[2] = { 0, 0 };
+	long sum = 0;
+	uint8_t fields = 0;
+
+	while (*cursor != ']')
+	{
+		char *end;
+		long value = strtol(cursor, &end, 10);
+
+		if (end == cursor || (*end != ',' && *end != ']'))
+		{
+			#ifdef DEBUGGING
+				debugLog.log(LOG_BAD_HISTORY);
+			#endif
+
+			#ifdef HEALTH_REPORTS
+				nodeHealth.count(HEALTH_BAD_FRAME);
+			#endif
+
+			return false;
+		}
+
+		// Keep a running sum that always excludes the latest field, which is the checksum at the end
+		sum += values[1];
+		values[1] = value;
+		if (fields++ == 0) values[0] = value;
+
+		cursor = *end == ',' ? end + 1 : end;
+	}
+
+	if (fields < HISTORY_FIELDS + 2 || (fields - 2) % HISTORY_FIELDS != 0 || values[0] < 0 || values[0] >= MAX_DEVICES - 1 || sum != values[1])
+	{
+		#ifdef DEBUGGING
+			debugLog.log(LOG_HISTORY_CHECKSUM_BAD);
+		#endif
+
+		#ifdef HEALTH_REPORTS
+			nodeHealth.count(HEALTH_BAD_CHECKSUM);
+		#endif
+
+		return false;
+	}
+
+	return true;
+}
+
+void LORA_MODULE_class::queueHistoryRelay()
+{
+	// Same node and first hour identify a frame, the data never changes
+	uint8_t fromHwid = atoi(&_frames.rx[START_OF_BRACKET + 1]);
+	uint8_t firstAgo = atoi(strchr(_frames.rx, ',') + 1);
+	uint16_t key = (fromHwid << 8) | firstAgo;
+	if (isHealthFrame()) key |= HEALTH_RELAY_KEY;
+
+	if (fromHwid == _hwid || _historyPending) return;
+
+	for (uint8_t i = 0; i < HISTORY_SEEN; i++)
+	{
+		if (_historySeen[i] == key) return;
+	}
+
+	_historySeen[_historySeenIdx] = key;
+	_historySeenIdx = (_historySeenIdx + 1) % HISTORY_SEEN;
+
+	strncpy(_frames.held, _frames.rx, sizeof(_frames.held) - 1);
+	_frames.held[sizeof(_frames.held) - 1] = '\0';
+	_historyPending = true;
+}
+
+bool LORA_MODULE_class::sendHistoryData(HISTORY_MODULE_class *history)
+{
+	// Relays first, they have been waiting longer
+	if (_historyPending)
+	{
+		#ifdef DEBUGGING
+			debugLog.log(LOG_RELAY_HISTORY, logText(_frames.held));
+		#endif
+
+		_historyPending = false;
+		sendDirectPayload(_frames.held, 1);
+		_lastActivityTime = millis();
+
+		return true;
+	}
+
+	if (_backfillMask == 0) return false;
+
+	// Pack as many requested hours as fit, each record delta-encoded against the previous one
+	char *frame = _frames.tx;
+	uint8_t pos = snprintf_P(frame, MAX_MESSAGE_LENGTH, PSTR(HISTORY_HEADER "[%u"), _hwid);
+	long previous[HISTORY_FIELDS] = { 0 };
+	long checksum = _hwid;
+	uint8_t records = 0;
+
+	for (uint8_t ago = 0; ago < BACKFILL_HOURS; ago++)
+	{
+		HISTORY_RECORD record;
+
+		if (!(_backfillMask & bit(ago))) continue;
+
+		// Hours we never stored can't be sent, drop them from the request
+		if (!history->loadData(_backfillHour, ago, record))
+		{
+			_backfillMask &= ~bit(ago);
+			continue;
+		}
+
+		long current[HISTORY_FIELDS] = { ago, record.temperature, record.humidity, record.soilTemperature, record.soilMoisture, record.battery };
+		uint8_t start = pos;
+		long recordSum = 0;
+
+		// ",-65535" per field at worst, the record is taken back off if it leaves no room for the checksum
+		for (uint8_t i = 0; i < HISTORY_FIELDS && pos < MAX_MESSAGE_LENGTH; i++)
+		{
+			pos += snprintf_P(&frame[pos], MAX_MESSAGE_LENGTH - pos, PSTR(",%ld"), current[i] - previous[i]);
+			recordSum += current[i] - previous[i];
+		}
+
+		if (pos + HISTORY_NUMBER_LENGTH + 2 > MAX_MESSAGE_LENGTH)
+		{
+			pos = start;
+			break;
+		}
+
+		checksum += recordSum;
+		memcpy(previous, current, sizeof(previous));
+		_backfillMask &= ~bit(ago);
+		records++;
+	}
+
+	if (records == 0) return false;
+
+	snprintf_P(&frame[pos], MAX_MESSAGE_LENGTH - pos, PSTR(",%ld]"), checksum);
+
+	#ifdef DEBUGGING
+		debugLog.log(LOG_SEND_HISTORY, logText(frame));
+	#endif
+
+	sendDirectPayload(frame, 1);
+	_lastActivityTime = millis();
+
+	return true;
+}
+
+bool LORA_MODULE_class::isHealthFrame()
+{
+	return strncmp_P(_frames.rx, PSTR(HEALTH_HEADER), START_OF_BRACKET) == 0;
+}
+
+bool LORA_MODULE_class::checkHealthValidity()
+{
+	// HLTH:[hwid,seq,counters...,min free RAM,RTC drift,checksum], integers only, only relayed here
+	if (_frames.rx[START_OF_BRACKET] != '[' || getcharIndex(']') == -1) return false;
+
+	char *cursor = &_frames.rx[START_OF_BRACKET + 1];
+	long values[HEALTH_FIELDS];
+	long sum = 0;
+	uint8_t fields = 0;
+
+	while (*cursor != ']' && fields < HEALTH_FIELDS)
+	{
+		char *end;
+		values[fields] = strtol(cursor, &end, 10);
+
+		if (end == cursor || (*end != ',' && *end != ']')) break;
+		if (fields < HEALTH_FIELDS - 1) sum += values[fields];
+
+		fields++;
+		cursor = *end == ',' ? end + 1 : end;
+	}
+
+	if (fields != HEALTH_FIELDS || *cursor != ']' || values[0] < 0 || values[0] >= MAX_DEVICES - 1 || sum != values[HEALTH_FIELDS - 1])
+	{
+		#ifdef DEBUGGING
+			debugLog.log(LOG_BAD_HEALTH);
+		#endif
+
+		#ifdef HEALTH_REPORTS
+			nodeHealth.count(fields == HEALTH_FIELDS && *cursor == ']' ? HEALTH_BAD_CHECKSUM : HEALTH_BAD_FRAME);
+		#endif
+
+		return false;
+	}
+
+	return true;
+}
+
+bool LORA_MODULE_class::sendHealthData(RTC_MODULE_class *rtc)
+{
+	#ifdef HEALTH_REPORTS
+		if (!nodeHealth.due()) return false;
+
+		char *frame = _frames.tx;
+		long checksum = (long)_hwid + nodeHealth.seq() + nodeHealth.minFreeRam() + rtc->drift();
+		uint8_t pos = snprintf_P(frame, HEALTH_MESSAGE_LENGTH, PSTR(HEALTH_HEADER "[%u,%u"), _hwid, nodeHealth.seq());
+
+		for (uint8_t i = 0; i < HEALTH_COUNTERS; i++)
+		{
+			pos += snprintf_P(&frame[pos], HEALTH_MESSAGE_LENGTH - pos, PSTR(",%u"), nodeHealth.counter(i));
+			checksum += nodeHealth.counter(i);
+		}
+
+		snprintf_P(&frame[pos], HEALTH_MESSAGE_LENGTH - pos, PSTR(",%u,%d,%ld]"), nodeHealth.minFreeRam(), rtc->drift(), checksum);
+
+		#ifdef DEBUGGING
+			debugLog.log(LOG_SEND_HEALTH, logText(frame));
+		#endif
+
+		// One copy, the counters only grow so a lost report is caught up by the next
+		sendDirectPayload(frame, 1);
+		nodeHealth.sent();
+		_lastActivityTime = millis();
+
+		return true;
+	#else
+		return false;
+	#endif
+}
+
+void LORA_MODULE_class::sendDirectPayload(char *payload, uint8_t attempts)
+{
+	uint8_t payloadLen = strlen(payload) + 1;
+
+	#ifdef ENCRYPTING
+		rc4EncryptDecrypt(payload, payloadLen);
+	#endif
+
+	#ifdef EVENT_TRACE
+		uint16_t frameId = TRACE_MODULE_class::frameId(payload, payloadLen - 1);
+	#endif
+
+	for (uint8_t i = 0; i < attempts; i++)
+	{
+		// Minimal staggered backoff so neighbours relaying the same event don't collide
+		delay(EVENT_BACKOFF_MUL + _hwid * EVENT_BACKOFF_MUL);
+
+		#ifdef EVENT_TRACE
+			eventTrace.add(TRACE_TX_START, payloadLen - 1, frameId);
+		#endif
+		LoRa.beginPacket();
+		LoRa.write((const uint8_t*)payload, payloadLen - 1);	// -1 Don't send null terminator
+		LoRa.endPacket();
+		#ifdef EVENT_TRACE
+			eventTrace.add(TRACE_TX_END, payloadLen - 1, frameId);
+		#endif
+
+		#ifdef WDT_ENABLE
+			wdt_reset();
+		#endif
+	}
+}
+
 #ifdef ENCRYPTING
 	void LORA_MODULE_class::rc4EncryptDecrypt(char *data, uint8_t len)
 	{
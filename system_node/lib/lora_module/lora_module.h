@@ -47,6 +47,32 @@
 #define CSMA_TOUT_MUL		250
 #define CSMA_TOUT_MIN		1500
 
+// Event Frame Settings
+#define EVENT_HEADER		"EVNT:"
+#define EVENT_FIELDS		5		// [hwid,rule,value,seq,checksum]
+#define EVENT_SEND_ATTEMPTS	2
+#define EVENT_BACKOFF_MUL	15		// Much shorter than BACKOFF_MUL, events jump the queue
+#define EVENT_NUMBER_LENGTH	12		// Raw soil moisture checksum "1287.00000" is 10, +1 for sign, +1 for null terminator
+#define EVENT_MESSAGE_LENGTH	48
+#define EVENT_SEQ_EEPROM	0x3F0	// Last seq sent, clear of the history ring and the health record, so a reset doesn't repeat one
+
+// Store-and-Forward Settings
+#define HISTORY_HEADER		"HIST:"
+#define HISTORY_FIELDS		6		// Per record: hours ago, temp, humi, stmp, smoi, batt (deltas after the first)
+#define BACKFILL_HOURS		16		// Bits in the basestation's per-node request mask
+#define HISTORY_SEEN		4		// Recently relayed frames remembered to stop ping-pong
+#define HISTORY_NUMBER_LENGTH	12
+
+// Health Frame Settings
+#define HEALTH_HEADER		"HLTH:"
+#define HEALTH_FIELDS		10		// [hwid,seq,send limits,bad headers,bad frames,bad checksums,watchdog resets,min free RAM,RTC drift,checksum]
+#define HEALTH_MESSAGE_LENGTH	64
+#define HEALTH_RELAY_KEY	0x8000	// Keeps relayed health reports apart from history frames in _historySeen
+
+// Time Sync Settings
+#define TIME_TAG			'@'		// Requests end in "@epoch.ms", the network time as the copy went on air
+#define TIME_TAG_LENGTH		16		// "@4294967295.999" is 15, +1 for null terminator
+
 // Algorithm Settings
 #define CHECKSUM			8
 #define START_OF_BRACKET	5
@@ -58,6 +84,14 @@
 #define BLANK_PLACEHOLDER	'*'
 #define DELAY_SMALL 		50
 
+// Every payload-sized buffer the node has, each with one owner, so a relay never copies a frame around
+struct FRAME_POOL
+{
+	char rx[MAX_MESSAGE_LENGTH];		// Filled by getLoRaPayload() and decrypted in place, good until the next frame is read
+	char tx[MAX_MESSAGE_LENGTH];		// Formatted and encrypted in place by whoever sends, free again once it is on air
+	char held[MAX_MESSAGE_LENGTH];		// Backfill or health frame queueHistoryRelay() keeps for a quiet slot
+};
+
 class LORA_MODULE_class
 {
 	private:
@@ -68,30 +102,38 @@ class LORA_MODULE_class
 			SOIL_TEMPERATURE,
 			SOIL_MOISTURE,
 			BATT_VOLTAGE,
-			DATE,
+			BACKFILL,
 			VALID_HEADERS
 		};
-		const char* _validHeaders[VALID_HEADERS] =
-		{
-			"TEMP:",
-			"HUMI:",
-			"STMP:",
-			"SMOI:",
-			"BATT:",
-			"DATE:"
-		};
+		static const char _validHeaders[VALID_HEADERS][MAX_HEADER_LENGTH];		// In flash, compare with the _P functions
 
 		bool _newpayloadAlert;
-		bool _syncRTCDone;
+		bool _timeHeard;
+		bool _timeChecked;
+		bool _syncPending;
+		bool _backfillLoaded;
+		bool _historyPending;
 		uint8_t _hwid;
+		uint8_t _eventSeq;
+		uint8_t _historySeenIdx;
+		uint16_t _backfillMask;
+		uint32_t _backfillHour;
+		uint16_t _historySeen[HISTORY_SEEN];
+		int16_t _lastEventSeq[MAX_DEVICES];		// Per origin, several events can be in flight at once
 		uint8_t _sendAttempts;
 		uint16_t _backoffTime;
 		uint16_t _csmaTimeout;
 		unsigned long _lastSystemUpdateTime;
+		unsigned long _lastActivityTime;
+		unsigned long _rxTime;
+		uint8_t _rxLength;
+		uint32_t _timeEpoch;
+		unsigned long _timeElapsed;
+		unsigned long _timeHeardAt;
 		float _sensorData[VALID_HEADERS];
 		float _systemValues[MAX_DEVICES];
-		char _loraPayload[MAX_MESSAGE_LENGTH];
 		char _loraprevHeader[MAX_HEADER_LENGTH];
+		FRAME_POOL _frames;
 
 		int8_t getcharIndex(char c);
 		float *getpayloadValues();
@@ -100,17 +142,41 @@ class LORA_MODULE_class
 		bool checkMessageValidity();
 		void preloadMessageData();
 		void processPayloadData();
-		void sendPayloadData(HWIO_class *hwio, RTC_MODULE_class *rtc);
+		uint8_t formatPayloadData(char *frame);
+		void sendPayloadData();
+		bool takeTimeTag(uint32_t *epoch, uint16_t *millisecond);
+		uint8_t appendTimeTag(char *frame, uint8_t length);
+		unsigned long timeElapsed();
+		void checkRTC(HWIO_class *hwio, RTC_MODULE_class *rtc);
+		void syncRTC(HWIO_class *hwio, RTC_MODULE_class *rtc);
+		uint32_t roundHour(HWIO_class *hwio, RTC_MODULE_class *rtc);
+		uint16_t airtime(uint8_t length);
+		bool isEventFrame();
+		bool checkEventValidity();
+		void relayEvent();
+		bool isHistoryFrame();
+		bool checkHistoryValidity();
+		void queueHistoryRelay();
+		bool sendHistoryData(HISTORY_MODULE_class *history);
+		bool isHealthFrame();
+		bool checkHealthValidity();
+		bool sendHealthData(RTC_MODULE_class *rtc);
+		void sendDirectPayload(char *payload, uint8_t attempts);
 
 		#ifdef ENCRYPTING
 			void rc4EncryptDecrypt(char *data, uint8_t len);
 		#endif
 
+		#ifdef AVR_BENCH
+			friend class AVR_BENCH_class;
+		#endif
+
 	public:
 		void Initialize(IDATA IData);
 		void configureLoRa();
-		void loadSensorData(IDATA IData);
-		void startLoRaMesh(IDATA IData, HWIO_class *hwio, RTC_MODULE_class *rtc);
+		void loadSensorData(IDATA IData, PREDICTOR_class *predictor);
+		void startLoRaMesh(IDATA IData, HWIO_class *hwio, RTC_MODULE_class *rtc, HISTORY_MODULE_class *history);
+		void sendEvent(uint8_t rule, float value);
 		void setPinsOff();
 };
 
@@ -0,0 +1,73 @@
+/*
+  ============================================================
+  Master's Thesis in Electrical and Computer Engineering
+  Faculty of Electrical and Computer Engineering
+  School of Engineering and Natural Sciences, University of Iceland
+
+  Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+		 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+  Researcher: Jezreel Tan
+  Email: jvt6@hi.is
+
+  Supervisors:
+  Helgi Þorbergsson
+  Email: thorberg@hi.is
+
+  Dórótea Höeg Sigurðardóttir
+  Email: dorotea@hi.is
+
+  ============================================================
+*/
+
+#include "../system_node.hpp"
+
+void PREDICTOR_class::Update(IDATA IData)
+{
+	float values[METRICS] =
+	{
+		IData.SYSTEM_TEMPERATURE,
+		IData.SYSTEM_HUMIDITY,
+		IData.SOIL_TEMPERATURE,
+		(float)IData.SOIL_MOISTURE,
+		IData.BATTERY_VOLTAGE
+	};
+
+	_predictedMask = 0;
+
+	// Step the model once per hourly sample, the basestation steps its copy once per round
+	for (uint8_t i = 0; i < METRICS; i++)
+	{
+		float prediction = _level[i] + _slope[i];
+
+		if ((_primedMask & bit(i)) && _staleRounds[i] < PREDICT_REFRESH_ROUNDS && fabs(values[i] - prediction) <= _residualBounds[i])
+		{
+			// Close enough, the basestation will fill in the same prediction
+			_level[i] = prediction;
+			_staleRounds[i]++;
+			_predictedMask |= bit(i);
+		}
+		else
+		{
+			#if PREDICT_MODE == PREDICT_LINEAR_TREND
+				_slope[i] = (_primedMask & bit(i)) ? TREND_GAIN * (values[i] - _level[i]) : 0;
+			#else
+				_slope[i] = 0;
+			#endif
+
+			_level[i] = values[i];
+			_staleRounds[i] = 0;
+			_primedMask |= bit(i);
+		}
+	}
+
+	#ifdef DEBUGGING
+		Serial.print(F("Predicted Metrics Mask: "));
+		Serial.println(_predictedMask, BIN);
+	#endif
+}
+
+bool PREDICTOR_class::isPredicted(uint8_t metric)
+{
+	return metric < METRICS && (_predictedMask & bit(metric));
+}
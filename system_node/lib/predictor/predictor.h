@@ -0,0 +1,81 @@
+/*
+  ============================================================
+  Master's Thesis in Electrical and Computer Engineering
+  Faculty of Electrical and Computer Engineering
+  School of Engineering and Natural Sciences, University of Iceland
+
+  Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+		 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+  Researcher: Jezreel Tan
+  Email: jvt6@hi.is
+
+  Supervisors:
+  Helgi Þorbergsson
+  Email: thorberg@hi.is
+
+  Dórótea Höeg Sigurðardóttir
+  Email: dorotea@hi.is
+
+  ============================================================
+*/
+
+#ifndef predictor_h
+#define predictor_h
+
+#include "../system_node.hpp"
+
+// Payload Markers
+#define PREDICTED_PLACEHOLDER	'~'		// Slot is alive and within the shared prediction
+#define PREDICTED_VALUE			-1000	// Outside every sensor range, never summed into the checksum
+
+// Predictor Modes
+#define PREDICT_LAST_VALUE		0
+#define PREDICT_LINEAR_TREND	1
+
+// Predictor Settings (Must match the basestation!)
+#define PREDICT_MODE			PREDICT_LINEAR_TREND
+#define PREDICT_REFRESH_ROUNDS	6		// Force a real value every 6 hours to bound drift
+#define TREND_GAIN				0.5		// Damping on the per-round slope, raw differences are noisy
+
+// Residual Bounds: Only send a real value when the prediction is off by more than this
+#define RESIDUAL_TEMP			0.25	// C
+#define RESIDUAL_HUMI			1.0		// %rH
+#define RESIDUAL_STMP			0.10	// C
+#define RESIDUAL_SMOI			5		// Raw ADC
+#define RESIDUAL_BATT			0.02	// V
+
+class PREDICTOR_class
+{
+	private:
+		// Metric order follows the LoRa headers: TEMP, HUMI, STMP, SMOI, BATT
+		enum _metrics : uint8_t
+		{
+			TEMP,
+			HUMI,
+			STMP,
+			SMOI,
+			BATT,
+			METRICS
+		};
+		const float _residualBounds[METRICS] =
+		{
+			RESIDUAL_TEMP,
+			RESIDUAL_HUMI,
+			RESIDUAL_STMP,
+			RESIDUAL_SMOI,
+			RESIDUAL_BATT
+		};
+
+		uint8_t _primedMask;
+		uint8_t _predictedMask;
+		uint8_t _staleRounds[METRICS];
+		float _level[METRICS];
+		float _slope[METRICS];
+
+	public:
+		void Update(IDATA IData);
+		bool isPredicted(uint8_t metric);
+};
+
+#endif
@@ -46,8 +46,8 @@ void RTC_MODULE_class::Initialize()
 	_rtc.alarm(DS3232RTC::ALARM_1);
 	_rtc.alarmInterrupt(DS3232RTC::ALARM_1, true);
 
-	// Set Alarm 2 to trigger at ALARM2_MIN every hour
-	_rtc.setAlarm(DS3232RTC::ALM2_MATCH_MINUTES, 0, ALARM2_MIN, 0, 1);
+	// Set Alarm 2 to trigger at ALARM2_MIN every hour, with event checks in between
+	setCheckAlarm();
 	_rtc.alarm(DS3232RTC::ALARM_2);
 	_rtc.alarmInterrupt(DS3232RTC::ALARM_2, true);
 
@@ -68,10 +68,9 @@ void RTC_MODULE_class::Sync()
 	#ifdef DEBUGGING
 		if (timeStatus() != timeSet)
 		{
-			Serial.print(F("X: ERROR: Failed to Sync RTC! "));
+			debugLog.log(LOG_RTC_SYNC_FAILED);
 		}
-		Serial.print(F("RTC Sync: "));
-		printtimedate(_rtc.get());
+		debugLog.log(LOG_RTC_SYNC, (uint32_t)_rtc.get());
 	#endif
 }
 
@@ -93,54 +92,164 @@ uint8_t RTC_MODULE_class::checkAlarm()
 			printtimedate(_rtc.get());
 		#endif
 
-		return ALARM2_TRIGGER;
+		// Only ALARM2_MIN closes the LoRa window, the rest are event checks
+		bool windowClose = minute(_rtc.get()) == ALARM2_MIN;
+		setCheckAlarm();
+
+		return windowClose ? ALARM2_TRIGGER : CHECK_TRIGGER;
 	}
 
 	return NO_TRIGGER;
 }
 
+void RTC_MODULE_class::setCheckAlarm()
+{
+	uint8_t nextMinute = ALARM2_MIN;
+
+	#if EVENT_CHECK_MIN > 0
+		// Walk ALARM2_MIN + n * EVENT_CHECK_MIN, wrapping back onto ALARM2_MIN every hour
+		uint8_t offset = (minute(_rtc.get()) + 60 - ALARM2_MIN) % 60;
+		nextMinute = (ALARM2_MIN + (offset / EVENT_CHECK_MIN + 1) * EVENT_CHECK_MIN) % 60;
+	#endif
+
+	_rtc.setAlarm(DS3232RTC::ALM2_MATCH_MINUTES, 0, nextMinute, 0, 1);
+}
+
 time_t RTC_MODULE_class::getTime()
 {
 	return _rtc.get();
 }
 
-void RTC_MODULE_class::syncTime(const float *rtctime)
+bool RTC_MODULE_class::checkTime(time_t epoch, unsigned long elapsed)
+{
+	// One register read, a second either way is only where in the second each clock is
+	long seconds = (long)(_rtc.get() - epoch) - (long)(elapsed / 1000);
+
+	// The first network time since boot is always measured, the drift fit counts from that write
+	if (_lastSet == 0 || labs(seconds) > SYNC_COARSE_LIMIT) return true;
+
+	// The fit still needs offsets while the clock reads in step, one rollover poll every few checks
+	#ifdef DRIFT_TRIMMING
+		if (++_checks >= DRIFT_SAMPLE_EVERY) return true;
+	#endif
+
+	return false;
+}
+
+void RTC_MODULE_class::syncTime(time_t epoch, unsigned long elapsed)
 {
-	uint8_t hr = (uint8_t)rtctime[HOUR];
-	uint8_t min = (uint8_t)rtctime[MINUTE];
-	uint8_t sec = (uint8_t)rtctime[SECOND];
-	uint8_t dy = (uint8_t)rtctime[DAY];
-	uint8_t mnth = (uint8_t)rtctime[MONTH];
-	uint8_t yr = (uint8_t)rtctime[YEAR];
-
-	// Check data validity if it's in range
-	if(hr > 23 || min > 59 || sec > 59 || dy < 1 || dy > 31 || mnth < 1 || mnth > 12 || yr > 99)
+	unsigned long calledAt = millis();
+	tmElements_t tm;
+	breakTime(epoch, tm);
+
+	// The DS3231 counts 2000 to 2099, anything else came from a basestation without a time yet
+	if (tm.Year < y2kYearToTm(0) || tm.Year > y2kYearToTm(99))
 	{
 		#ifdef DEBUGGING
-			Serial.println(F("X: Invalid datettime Data Found!"));
+			debugLog.log(LOG_BAD_DATETIME);
 		#endif
 
 		return;
 	}
 
-	// Set the RTC module time
-	setTime(hr, min, sec, dy, mnth, yr);
-	_rtc.set(now());
+	_checks = 0;
+
+	// The network time is elapsed ms past epoch. Writing the seconds register restarts the
+	// DS3231's 1 Hz countdown, so it is left alone when close enough, or written on the next whole second
+	if (!measureOffset(epoch, elapsed, calledAt))
+	{
+		elapsed += millis() - calledAt;
+		time_t target = epoch + elapsed / 1000 + 1;
+		delay(1000 - elapsed % 1000);
+		_rtc.set(target);
+		_lastSet = target;
+	}
 
 	#ifdef DEBUGGING
-		Serial.print(F("Datetime from LoRa: "));
-		Serial.print(hr);Serial.print(':');
-		Serial.print(min);Serial.print(':');
-		Serial.print(sec);Serial.print(' ');
-		Serial.print(dy);Serial.print('-');
-		Serial.print(mnth);Serial.print('-');
-		Serial.println(yr + 2000);
+		debugLog.log(LOG_DATETIME_LORA, tm.Hour, tm.Minute, tm.Second, tm.Day, tm.Month, (uint8_t)tmYearToY2k(tm.Year));
+		debugLog.log(LOG_DATETIME_DELAY, (uint32_t)elapsed);
 	#endif
 
 	// Sync for good measure
 	Sync();
 }
 
+bool RTC_MODULE_class::measureOffset(time_t base, unsigned long elapsed, unsigned long calledAt)
+{
+	// The edge where the DS3231's seconds roll over, against the network time at that moment
+	time_t before = _rtc.get();
+	time_t rolled = before;
+	unsigned long start = millis();
+	while (rolled == before && millis() - start < SYNC_ROLL_TIMEOUT) rolled = _rtc.get();
+	unsigned long rolledAt = millis();
+	elapsed += rolledAt - calledAt;
+
+	// Whole seconds first, a clock that is days out would overflow the ms
+	long seconds = (long)(rolled - base) - (long)(elapsed / 1000);
+	if (rolled == before || labs(seconds) > SYNC_MAX_OFFSET / 1000 + 1) return false;
+
+	long offset = (long)(rolled - base) * 1000 - (long)elapsed;
+	if (labs(offset) > SYNC_MAX_OFFSET) return false;
+
+	#ifdef DRIFT_TRIMMING
+		// A new rate starts a new offset, so the clock is written after a trim
+		if (fitDrift(offset, rolled)) return false;
+	#endif
+
+	// Within the sync error, leave the countdown alone and keep counting from the last write
+	return labs(offset) <= SYNC_THRESHOLD;
+}
+
+#ifdef DRIFT_TRIMMING
+	bool RTC_MODULE_class::fitDrift(long offset, time_t rolled)
+	{
+		long interval = (long)(rolled - _lastSet);
+		if (_lastSet == 0 || interval < DRIFT_MIN_INTERVAL) return false;
+
+		// Least squares through the origin, the offset has grown from zero since the last write
+		_sumOT += (float)offset * interval;
+		_sumTT += (float)interval * interval;
+		_drift = lroundf(10000.0f * _sumOT / _sumTT);
+
+		#ifdef DEBUGGING
+			debugLog.log(LOG_RTC_DRIFT, (int32_t)offset, (int32_t)interval, _drift);
+		#endif
+
+		if (++_samples < DRIFT_SAMPLES) return false;
+
+		if (abs(_drift) >= DRIFT_DEADBAND)
+		{
+			trimAging();
+			return true;
+		}
+
+		// Close enough, keep fitting but let older syncs fade as the crystal ages
+		_sumOT /= 2;
+		_sumTT /= 2;
+		_samples = DRIFT_SAMPLES / 2;
+		return false;
+	}
+
+	void RTC_MODULE_class::trimAging()
+	{
+		// What is left of the drift goes into the aging offset, one LSB per tenth of a ppm, and the fit starts over on the new rate
+		int16_t aging = (int8_t)_rtc.readRTC(DS3232RTC::DS32_AGING) + _drift;
+		aging = constrain(aging, -AGING_LIMIT, AGING_LIMIT);
+		_rtc.writeRTC(DS3232RTC::DS32_AGING, (uint8_t)(int8_t)aging);
+
+		// A forced conversion applies it now rather than at the next one in up to 64 s
+		_rtc.writeRTC(DS3232RTC::DS32_CONTROL, _rtc.readRTC(DS3232RTC::DS32_CONTROL) | bit(DS3232RTC::DS32_CONV));
+
+		#ifdef DEBUGGING
+			debugLog.log(LOG_RTC_AGING, aging, _drift);
+		#endif
+
+		_sumOT = 0;
+		_sumTT = 0;
+		_samples = 0;
+	}
+#endif
+
 #ifdef DEBUGGING
 	void RTC_MODULE_class::settimefromPC()
 	{
@@ -31,24 +31,45 @@
 #define ALARM1_MIN		59
 #define ALARM1_SEC		30
 #define ALARM2_MIN		5
+#define EVENT_CHECK_MIN	10		// Minutes between event rule checks, 0 to only check at the hourly sample
+
+#if EVENT_CHECK_MIN > 0 && 60 % EVENT_CHECK_MIN != 0
+	#error "EVENT_CHECK_MIN must divide an hour so Alarm 2 still lands on ALARM2_MIN"
+#endif
+
+// Time Sync
+#define SYNC_THRESHOLD		5		// ms the DS3231 may be off and still be left running, about the sync error
+#define SYNC_MAX_OFFSET		2000	// ms, further off than this was a fresh clock, not drift
+#define SYNC_ROLL_TIMEOUT	1100	// ms to wait for the DS3231's seconds to roll over
+#define SYNC_COARSE_LIMIT	1		// s the whole-second check may read off before the clock is measured and set
+
+// Drift Trimming
+#define DRIFT_SAMPLES		4		// Syncs fitted before the aging offset is trimmed
+#define DRIFT_SAMPLE_EVERY	6		// Time checks between measured syncs when the clock reads in step
+#define DRIFT_MIN_INTERVAL	600		// s, shorter gaps are mostly sync error
+#define DRIFT_DEADBAND		2		// Tenths of a ppm left alone, 1 ms over an hour is already 0.28 ppm
+#define AGING_LIMIT			127		// One aging LSB moves the oscillator about a tenth of a ppm at 25 C, positive slows it
 
 #define NO_TRIGGER		0
 #define ALARM1_TRIGGER	1
 #define ALARM2_TRIGGER	2
+#define CHECK_TRIGGER	3
 
 class RTC_MODULE_class
 {
 	private:
-		enum _timeFormat : uint8_t
-		{
-			HOUR,
-			MINUTE,
-			SECOND,
-			DAY,
-			MONTH,
-			YEAR
-		};
 		DS3232RTC _rtc;
+		time_t _lastSet = 0;				// What we last wrote, 0 until the first sync since boot
+		float _sumOT = 0;					// Offset (ms) times interval (s), and interval squared, since the last trim
+		float _sumTT = 0;
+		uint8_t _samples = 0;
+		uint8_t _checks = 0;				// Time checks since the clock was last measured
+		int16_t _drift = 0;					// Tenths of a ppm, positive when the DS3231 runs fast
+
+		void setCheckAlarm();
+		bool measureOffset(time_t base, unsigned long elapsed, unsigned long calledAt);
+		bool fitDrift(long offset, time_t rolled);
+		void trimAging();
 
 		#ifdef DEBUGGING
 			void printtimedate(time_t t);
@@ -61,7 +82,10 @@ class RTC_MODULE_class
 		void Sync();
 		uint8_t checkAlarm();
 		time_t getTime();
-    	void syncTime(const float* rtctime);
+		bool checkTime(time_t epoch, unsigned long elapsed);
+    	void syncTime(time_t epoch, unsigned long elapsed);
+
+		int16_t drift() const { return _drift; }
 };
 
 #endif
@@ -24,10 +24,10 @@
 
 void SD_CARD_MODULE_class::logData(IDATA IData, time_t t)
 {
-	char datetime[20];
-	snprintf(datetime, sizeof(datetime), "%04d-%02d-%02d %02d:%02d:%02d", year(t), month(t), day(t), hour(t), minute(t), second(t));
-
 	#ifdef DEBUGGING
+		char datetime[26];		// 19 and the terminator, sized for the widest the casts allow so no build warns
+		snprintf(datetime, sizeof(datetime), "%04u-%02u-%02u %02u:%02u:%02u", (uint16_t)year(t), (uint8_t)month(t), (uint8_t)day(t), (uint8_t)hour(t), (uint8_t)minute(t), (uint8_t)second(t));
+
 		Serial.print(F("Writing to SD Card: "));
 		Serial.print(IData.HW_ID);Serial.print(F(", "));
 		Serial.print(datetime);Serial.print(F(" | "));
@@ -37,16 +37,135 @@ void SD_CARD_MODULE_class::logData(IDATA IData, time_t t)
 		Serial.print(IData.SOIL_MOISTURE);Serial.print(F("RAW, "));
 		Serial.print(IData.BATTERY_VOLTAGE, DECIMAL_VALUES);Serial.println('v');
 	#else
-		Serial.begin(LOGGING_BAUD);
-		delay(LOGGING_DELAY);
-		Serial.print(IData.HW_ID);Serial.print(',');
-		Serial.print(datetime);Serial.print(',');
-		Serial.print(IData.SYSTEM_TEMPERATURE, DECIMAL_VALUES);Serial.print(',');
-		Serial.print(IData.SYSTEM_HUMIDITY, DECIMAL_VALUES);Serial.print(',');
-		Serial.print(IData.SOIL_TEMPERATURE, DECIMAL_VALUES);Serial.print(',');
-		Serial.print(IData.SOIL_MOISTURE);Serial.print(',');
-		Serial.println(IData.BATTERY_VOLTAGE, DECIMAL_VALUES);
-		delay(LOGGING_DELAY);
-		Serial.end();
+		// Start a new batch if the gap no longer fits a delta, e.g. after a long low battery sleep
+		if (_batchCount > 0 && (t < _lastTime || t - _lastTime > UINT16_MAX)) flushBatch();
+
+		if (_batchCount == 0)
+		{
+			_hwid = IData.HW_ID;
+			_batchStart = t;
+			_lastTime = t;
+		}
+
+		LOG_RECORD &record = _batch[_batchCount++];
+		record.timeDelta = t - _lastTime;
+		record.temperature = (int16_t)lround(IData.SYSTEM_TEMPERATURE * LOG_CENTI);
+		record.humidity = (uint16_t)lround(IData.SYSTEM_HUMIDITY * LOG_CENTI);
+		record.soilTemperature = (int16_t)lround(IData.SOIL_TEMPERATURE * LOG_CENTI);
+		record.soilMoisture = IData.SOIL_MOISTURE;
+		record.battery = (uint16_t)lround(IData.BATTERY_VOLTAGE * LOG_MILLI);
+		_lastTime = t;
+
+		if (_batchCount >= LOG_BATCH_HOURS) flushBatch();
 	#endif
 }
+
+void SD_CARD_MODULE_class::flushBatch()
+{
+	// One short burst every few hours instead of a slow CSV line every hour
+	Serial.begin(LOGGING_BAUD);
+	delay(LOGGING_SETTLE);
+
+	_checkSum = 0;
+	Serial.write(LOG_END);
+	writeByte(LOG_MAGIC);
+	writeByte(_hwid);
+	writeByte(_batchCount);
+	writeLong((uint32_t)_batchStart);
+
+	for (uint8_t i = 0; i < _batchCount; i++)
+	{
+		writeWord(_batch[i].timeDelta);
+		writeWord((uint16_t)_batch[i].temperature);
+		writeWord(_batch[i].humidity);
+		writeWord((uint16_t)_batch[i].soilTemperature);
+		writeWord(_batch[i].soilMoisture);
+		writeWord(_batch[i].battery);
+	}
+
+	writeByte(_checkSum);
+	Serial.write(LOG_END);
+
+	// Wait for the last byte to leave, OpenLog commits it while the LoRa window is open
+	Serial.flush();
+	Serial.end();
+
+	_batchCount = 0;
+}
+
+#ifdef EVENT_TRACE
+	void SD_CARD_MODULE_class::logTrace(uint8_t hwid, const TRACE_MODULE_class *trace)
+	{
+		// The debug console already has the UART open, empty its ring first so nothing lands inside the frame
+		#ifdef DEBUGGING
+			debugLog.flush();
+		#else
+			Serial.begin(LOGGING_BAUD);
+			delay(LOGGING_SETTLE);
+		#endif
+
+		_checkSum = 0;
+		Serial.write(LOG_END);
+		writeByte(TRACE_MAGIC);
+		writeByte(hwid);
+		writeWord(trace->count());
+		writeWord(trace->dropped());
+		writeLong(trace->openEpoch());
+		writeLong(trace->openMillis());
+		writeLong(trace->closeEpoch());
+		writeLong(trace->closeMillis());
+
+		for (uint8_t i = 0; i < trace->count(); i++)
+		{
+			const TRACE_RECORD &record = trace->get(i);
+			writeLong(record.time);
+			writeByte(record.event);
+			writeByte(record.length);
+			writeWord(record.arg);
+		}
+
+		writeByte(_checkSum);
+		Serial.write(LOG_END);
+		Serial.flush();
+
+		#ifndef DEBUGGING
+			Serial.end();
+		#endif
+	}
+#endif
+
+void SD_CARD_MODULE_class::writeByte(uint8_t value)
+{
+	_checkSum += value;
+
+	switch (value)
+	{
+		case LOG_END:
+			Serial.write(LOG_ESC);
+			Serial.write(LOG_ESC_END);
+			break;
+		case LOG_ESC:
+			Serial.write(LOG_ESC);
+			Serial.write(LOG_ESC_ESC);
+			break;
+		case LOG_OPENLOG_ESC:
+			Serial.write(LOG_ESC);
+			Serial.write(LOG_ESC_SUB);
+			break;
+		default:
+			Serial.write(value);
+			break;
+	}
+}
+
+void SD_CARD_MODULE_class::writeWord(uint16_t value)
+{
+	writeByte(value & 0xFF);
+	writeByte(value >> 8);
+}
+
+void SD_CARD_MODULE_class::writeLong(uint32_t value)
+{
+	writeWord(value & 0xFFFF);
+	writeWord(value >> 16);
+}
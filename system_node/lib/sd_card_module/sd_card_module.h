@@ -25,17 +25,61 @@
 
 #include "../system_node.hpp"
 
-#define LOGGING_BAUD  9600
-#define LOGGING_DELAY 1500
+#define LOGGING_BAUD		115200
+#define LOGGING_SETTLE		50			// OpenLog has been up since the wake, only let the UART settle
+#define LOG_BATCH_HOURS		6			// Records held in RAM before one write to the card
+
+// Fixed-point scales, same as the history ring
+#define LOG_CENTI			100			// Temperature and humidity in hundredths
+#define LOG_MILLI			1000		// Battery in millivolts
+
+// Binary Frame (decoded by tools/openlog_decode)
+// END, [magic, hwid, count, start time u32, count x record, sum8] escaped, END
+// Event trace frame (tools/trace_view), same framing and checksum
+// END, [TRACE_MAGIC, hwid, count u16, dropped u16, open epoch u32, open millis u32, close epoch u32, close millis u32, count x TRACE_RECORD, sum8] escaped, END
+// Multi-byte fields are little endian
+#define LOG_MAGIC			0x4C
+#define LOG_END				0xC0		// SLIP framing
+#define LOG_ESC				0xDB
+#define LOG_ESC_END			0xDC
+#define LOG_ESC_ESC			0xDD
+#define LOG_ESC_SUB			0xDE
+#define LOG_OPENLOG_ESC		0x1A		// Three in a row would drop OpenLog into command mode
 
 // OpenLog Config Settings
-// 9600,26,3,1,1,1,0
+// 115200,26,3,1,1,1,0
 // baud,escape,esc#,mode,verb,echo,ignoreRX
 
+struct LOG_RECORD
+{
+	uint16_t timeDelta;					// Seconds since the previous record, 0 for the first
+	int16_t temperature;
+	uint16_t humidity;
+	int16_t soilTemperature;
+	uint16_t soilMoisture;
+	uint16_t battery;
+};
+
 class SD_CARD_MODULE_class
 {
+	private:
+		LOG_RECORD _batch[LOG_BATCH_HOURS];
+		uint8_t _batchCount = 0;
+		uint8_t _hwid;
+		uint8_t _checkSum;
+		time_t _batchStart;
+		time_t _lastTime;
+
+		void flushBatch();
+		void writeByte(uint8_t value);
+		void writeWord(uint16_t value);
+		void writeLong(uint32_t value);
+
 	public:
 		void logData(IDATA IData, time_t t);
+		#ifdef EVENT_TRACE
+			void logTrace(uint8_t hwid, const TRACE_MODULE_class *trace);
+		#endif
 
 };
 
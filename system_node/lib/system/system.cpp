@@ -40,6 +40,16 @@ void SYSTEM_class::Initialize()
 	// Initialize Lora Module
 	_lora_module.Initialize(_IData);
 
+	#ifdef HEALTH_REPORTS
+		// Counters survive resets, this one counts them
+		nodeHealth.Initialize();
+	#endif
+
+	#ifdef FLASH_LOGGING
+		// Mount the flash log
+		_history_module.Initialize();
+	#endif
+
 	#ifdef DEBUGGING
 		Serial.print(F("System Version: v"));
 		Serial.println(SYSTEM_VER);
@@ -62,25 +72,80 @@ void SYSTEM_class::Run()
 		uint8_t alarm_trigger = _rtc_module.checkAlarm();
 		_interruptbyRTC = false;
 
+		// Last window's events go out first, then a fresh trace for this one. Later RTC wakes carry
+		// their second of the hour, which places the stretch of millis() that follows
+		#ifdef EVENT_TRACE
+			time_t now = _rtc_module.getTime();
+			if (alarm_trigger == ALARM1_TRIGGER)
+			{
+				if (eventTrace.closed() && eventTrace.count() > 0) _sd_card_module.logTrace(_IData.HW_ID, &eventTrace);
+				eventTrace.open(now);
+			}
+			else
+			{
+				eventTrace.add(TRACE_WAKE, TRACE_BY_RTC, now % SECS_PER_HOUR);
+			}
+		#endif
+
 		if (alarm_trigger == ALARM1_TRIGGER)
 		{
 			_hwio.loadSensorData(&_IData);
-			_sd_card_module.logData(_IData, _rtc_module.getTime());
+			time_t t = _rtc_module.getTime();
+			#ifndef FLASH_LOGGING
+				_sd_card_module.logData(_IData, t);
+			#endif
+
+			#ifdef STORE_AND_FORWARD
+				_history_module.storeData(_IData, t);
+			#endif
+
+			#ifdef PREDICTING
+				_predictor.Update(_IData);
+			#endif
+
+			#ifdef EVENT_ALERTS
+				checkEvents(_IData);
+			#endif
+
+			#ifdef HEALTH_REPORTS
+				nodeHealth.openRound(_IData.HW_ID, t);
+			#endif
+
+			_windowOpen = true;
 		}
-		if (alarm_trigger == ALARM2_TRIGGER || !isBatteryLevelSufficient())
+		else if (alarm_trigger == CHECK_TRIGGER)
+		{
+			// Sample into a copy so the round's data and predictions stay untouched
+			IDATA checkData = _IData;
+			_hwio.loadSensorData(&checkData);
+
+			#ifdef EVENT_ALERTS
+				checkEvents(checkData);
+			#endif
+		}
+		if (alarm_trigger == ALARM2_TRIGGER || (alarm_trigger == CHECK_TRIGGER && !_windowOpen) || !isBatteryLevelSufficient())
 		{
 			#ifdef DEBUGGING
 				displayfreeRAM();
 			#endif
 
+			#ifdef EVENT_TRACE
+				if (_windowOpen) eventTrace.close(_rtc_module.getTime());
+			#endif
+
+			#ifdef HEALTH_REPORTS
+				if (_windowOpen) nodeHealth.closeRound();
+			#endif
+
+			_windowOpen = false;
 			entersleepMode();
 		}
 	}
 	else if (_interruptbyLoRa)
 	{
 		_interruptbyLoRa = false;
-		_lora_module.loadSensorData(_IData);
-		_lora_module.startLoRaMesh(_IData, &_hwio, &_rtc_module);
+		_lora_module.loadSensorData(_IData, &_predictor);
+		_lora_module.startLoRaMesh(_IData, &_hwio, &_rtc_module, &_history_module);
 	}
 	else
 	{
@@ -95,8 +160,8 @@ void SYSTEM_class::Run()
 void SYSTEM_class::entersleepMode()
 {
 	#ifdef DEBUGGING
-		Serial.println(F("Entering Sleep Mode..."));
-		delay(DELAY_SMALL);
+		debugLog.log(LOG_SLEEP);
+		debugLog.flush();
 	#endif
 
 	// Turn off LoRa and Modules
@@ -128,8 +193,8 @@ void SYSTEM_class::entersleepMode()
 void SYSTEM_class::enterlightsleepMode()
 {
 	#ifdef DEBUGGING
-		Serial.println(F("Entering Light Sleep Mode..."));
-		delay(DELAY_SMALL);
+		debugLog.log(LOG_LIGHT_SLEEP);
+		debugLog.flush();
 	#endif
 
 	// Turn off other devices
@@ -140,12 +205,21 @@ void SYSTEM_class::enterlightsleepMode()
 	Wire.end();
 	_hwio.setPinsOff();
 
+	#ifdef EVENT_TRACE
+		eventTrace.add(TRACE_SLEEP, TRACE_LIGHT, 0);
+	#endif
+
 	// Set Interrupts and Sleep
 	noInterrupts();
 	attachInterrupt(digitalPinToInterrupt(LORA_DI0), wakeonLoRa, RISING);
 	EIFR = bit(INTF0);
 	gotosleep();
 
+	// RTC wakes are traced in Run, once the RTC is back up
+	#ifdef EVENT_TRACE
+		if (_interruptbyLoRa) eventTrace.add(TRACE_WAKE, TRACE_BY_LORA, TRACE_NO_TIME);
+	#endif
+
 	// Remove LoRa Interrupt
 	detachInterrupt(digitalPinToInterrupt(LORA_DI0));
 }
@@ -197,6 +271,17 @@ inline void SYSTEM_class::gotosleep()
 	#endif
 }
 
+void SYSTEM_class::checkEvents(IDATA IData)
+{
+	uint8_t tripped = _event_module.checkRules(IData);
+
+	// LoRa is already up after every RTC wake, send straight away
+	for (uint8_t rule = EVENT_FROST; rule < EVENT_RULES; rule++)
+	{
+		if (tripped & bit(rule)) _lora_module.sendEvent(rule, _event_module.getRuleValue(rule, IData));
+	}
+}
+
 inline bool SYSTEM_class::isBatteryLevelSufficient()
 {
 	return _IData.BATTERY_VOLTAGE > BATTERY_LEVEL_CUTOFF ? true : false;
@@ -215,9 +300,9 @@ inline void SYSTEM_class::wakeonRTC()
 #ifdef DEBUGGING
 	uint16_t SYSTEM_class::freeRAM() 
 	{
+		// Stack pointer down to the heap's end, SP rather than a local's address so the host build has a stand-in
 		extern uint16_t __heap_start,*__brkval;
-		uint16_t v;
-		return (uint16_t)&v - (__brkval == 0 ? (uint16_t)&__heap_start : (uint16_t) __brkval);  
+		return SP - (uintptr_t)(__brkval == 0 ? &__heap_start : __brkval);
 	}
 
 	void SYSTEM_class::displayfreeRAM()
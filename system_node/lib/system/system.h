@@ -34,16 +34,21 @@ class SYSTEM_class
 		IDATA&                  _IData;
 		HWIO_class&             _hwio;
 		RTC_MODULE_class&       _rtc_module;
+		PREDICTOR_class&        _predictor;
+		EVENT_MODULE_class&     _event_module;
+		HISTORY_MODULE_class&   _history_module;
 		LORA_MODULE_class&      _lora_module;
 		SD_CARD_MODULE_class&   _sd_card_module;
 
 		static volatile bool _interruptbyLoRa;
 		static volatile bool _interruptbyRTC;
+		bool _windowOpen;
 
 		static inline void wakeonRTC();
 		static inline void wakeonLoRa();
 		inline void gotosleep();
 		inline bool isBatteryLevelSufficient();
+		void checkEvents(IDATA IData);
 		void entersleepMode();
 		void enterlightsleepMode();
 
@@ -53,7 +58,7 @@ class SYSTEM_class
 		#endif
 
 	public:
-		SYSTEM_class(SystemComponents& class_lib) : _IData(class_lib._IData), _hwio(class_lib._hwio), _rtc_module(class_lib._rtc_module), _lora_module(class_lib._lora_module) , _sd_card_module(class_lib._sd_card_module){}
+		SYSTEM_class(SystemComponents& class_lib) : _IData(class_lib._IData), _hwio(class_lib._hwio), _rtc_module(class_lib._rtc_module), _predictor(class_lib._predictor), _event_module(class_lib._event_module), _history_module(class_lib._history_module), _lora_module(class_lib._lora_module) , _sd_card_module(class_lib._sd_card_module){}
 		
 		void Initialize();
 		void Run();
@@ -27,9 +27,20 @@
 #define SERIAL_BAUD     115200
 
 // Toggles: Comment or Uncomment to Disable or Enable
-// #define DEBUGGING
+// #define DEBUGGING			// Radio and mesh messages are tokenized, read them with tools/log_decode
 #define ENCRYPTING
 #define WDT_ENABLE
+#define PREDICTING				// Must match the basestation
+#define EVENT_ALERTS
+#define STORE_AND_FORWARD
+#define HEALTH_REPORTS			// Retry and failure counters sent as HLTH frames, must match the basestation
+#define DRIFT_TRIMMING			// Offsets seen at each time sync fitted into the DS3231 aging offset
+// #define FLASH_LOGGING			// SPI NOR flash instead of OpenLog, also backs the history
+// #define EVENT_TRACE			// Radio events of each LoRa window dumped to the UART, view with tools/trace_view
+
+#if defined(FLASH_LOGGING) && !defined(STORE_AND_FORWARD)
+	#error "FLASH_LOGGING stores through the history module, enable STORE_AND_FORWARD"
+#endif
 
 // Encryption Settings
 #ifdef DEBUGGING
@@ -47,16 +58,41 @@
 #include <OneWire.h>
 #include <DS3232RTC.h>
 #include <DallasTemperature.h>
+#include <EEPROM.h>
 #include <Adafruit_AHTX0.h>
 #include <avr/sleep.h>
 #include <avr/power.h>
 #include <avr/wdt.h>
 
 #include "IDevice.h"
+#ifdef DEBUGGING
+	#include "debug_log/debug_log.h"
+	#include "debug_log/debug_log.cpp"
+#endif
+#ifdef EVENT_TRACE
+	#include "trace_module/trace_module.h"
+	#include "trace_module/trace_module.cpp"
+#endif
 #include "hwio/hwio.h"
 #include "hwio/hwio.cpp"
 #include "rtc_module/rtc_module.h"
 #include "rtc_module/rtc_module.cpp"
+#include "predictor/predictor.h"
+#include "predictor/predictor.cpp"
+#include "event_module/event_module.h"
+#include "event_module/event_module.cpp"
+#ifdef FLASH_LOGGING
+	#include "flash_module/flash_log.h"
+	#include "flash_module/flash_log.cpp"
+	#include "flash_module/flash_module.h"
+	#include "flash_module/flash_module.cpp"
+#endif
+#include "history_module/history_module.h"
+#include "history_module/history_module.cpp"
+#ifdef HEALTH_REPORTS
+	#include "health_module/health_module.h"
+	#include "health_module/health_module.cpp"
+#endif
 #include "lora_module/lora_module.h"
 #include "lora_module/lora_module.cpp"
 #include "sd_card_module/sd_card_module.h"
@@ -70,6 +106,9 @@ struct SystemComponents
 	// Hardware Classes
 	HWIO_class            _hwio;
 	RTC_MODULE_class      _rtc_module;
+	PREDICTOR_class       _predictor;
+	EVENT_MODULE_class    _event_module;
+	HISTORY_MODULE_class  _history_module;
 	LORA_MODULE_class     _lora_module;
 	SD_CARD_MODULE_class  _sd_card_module;
 };
@@ -0,0 +1,81 @@
+/*
+  ============================================================
+  Master's Thesis in Electrical and Computer Engineering
+  Faculty of Electrical and Computer Engineering
+  School of Engineering and Natural Sciences, University of Iceland
+
+  Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+		 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+  Researcher: Jezreel Tan
+  Email: jvt6@hi.is
+
+  Supervisors:
+  Helgi Þorbergsson
+  Email: thorberg@hi.is
+
+  Dórótea Höeg Sigurðardóttir
+  Email: dorotea@hi.is
+
+  ============================================================
+*/
+
+#include "../system_node.hpp"
+
+TRACE_MODULE_class eventTrace;
+
+void TRACE_MODULE_class::add(uint8_t event, uint8_t length, uint16_t arg)
+{
+	// Event checks between windows stay out of the dump
+	if (_closed) return;
+
+	TRACE_RECORD &record = _records[_head];
+	record.time = millis();
+	record.event = event;
+	record.length = length;
+	record.arg = arg;
+
+	_head = (_head + 1) % TRACE_RECORDS;
+	if (_count < TRACE_RECORDS) _count++;
+	else if (_dropped < UINT16_MAX) _dropped++;
+}
+
+void TRACE_MODULE_class::open(time_t t)
+{
+	clear();
+
+	_openEpoch = (uint32_t)t;
+	_openMillis = millis();
+}
+
+void TRACE_MODULE_class::close(time_t t)
+{
+	add(TRACE_SLEEP, TRACE_DEEP, 0);
+
+	_closed = true;
+	_closeEpoch = (uint32_t)t;
+	_closeMillis = millis();
+}
+
+void TRACE_MODULE_class::clear()
+{
+	_head = 0;
+	_count = 0;
+	_dropped = 0;
+	_closed = false;
+}
+
+const TRACE_RECORD &TRACE_MODULE_class::get(uint8_t index) const
+{
+	// Oldest first
+	return _records[(_head + TRACE_RECORDS - _count + index) % TRACE_RECORDS];
+}
+
+uint16_t TRACE_MODULE_class::frameId(const char *data, uint8_t length)
+{
+	// Hash of the bytes on air, a sender's TX and every receiver's RX of the same frame carry the same ID
+	uint16_t id = 0;
+	for (uint8_t i = 0; i < length; i++) id = id * 33 + (uint8_t)data[i];
+
+	return id;
+}
@@ -0,0 +1,99 @@
+/*
+  ============================================================
+  Master's Thesis in Electrical and Computer Engineering
+  Faculty of Electrical and Computer Engineering
+  School of Engineering and Natural Sciences, University of Iceland
+
+  Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+		 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+  Researcher: Jezreel Tan
+  Email: jvt6@hi.is
+
+  Supervisors:
+  Helgi Þorbergsson
+  Email: thorberg@hi.is
+
+  Dórótea Höeg Sigurðardóttir
+  Email: dorotea@hi.is
+
+  ============================================================
+*/
+
+#ifndef trace_module_h
+#define trace_module_h
+
+#include "../system_node.hpp"
+
+// One LoRa window of events. Opened at ALARM1, closed with the window and dumped through the OpenLog
+// framing at the next ALARM1, when OpenLog has been powered long enough to commit it (tools/trace_view)
+#define TRACE_RECORDS		40		// 8 bytes each, the oldest are overwritten
+#define TRACE_MAGIC			0x54
+
+// Events, same numbers on the basestation
+#define TRACE_RX			1		// Frame read after RxDone, length = bytes on air, arg = frame ID
+#define TRACE_INVALID		2		// Frame rejected, length = frame kind below, arg = frame ID
+#define TRACE_MERGE			3		// Merged data changed, arg = mask of the filled slots
+#define TRACE_BACKOFF		4		// CSMA wait starts, length = attempt, arg = timeout in ms
+#define TRACE_CSMA_INTERRUPT	5	// A frame arrived during the wait, length = attempt
+#define TRACE_TX_START		6		// length = bytes on air, arg = frame ID
+#define TRACE_TX_END		7		// length = bytes on air, arg = frame ID
+#define TRACE_SLEEP			8		// length = TRACE_DEEP (the window closed) or TRACE_LIGHT
+#define TRACE_WAKE			9		// length = TRACE_BY_RTC or TRACE_BY_LORA, arg = RTC second of the hour or TRACE_NO_TIME
+#define TRACE_REQUEST		10		// Basestation only
+#define TRACE_CLOSE			11		// Basestation only
+
+// Frame kinds for TRACE_INVALID
+#define TRACE_DATA_FRAME	0
+#define TRACE_EVENT_FRAME	1
+#define TRACE_HISTORY_FRAME	2
+#define TRACE_HEALTH_FRAME	3
+
+#define TRACE_DEEP			0
+#define TRACE_LIGHT			1
+#define TRACE_BY_RTC		0
+#define TRACE_BY_LORA		1
+#define TRACE_NO_TIME		0xFFFF
+
+struct TRACE_RECORD
+{
+	uint32_t time;						// millis(), stands still while the node sleeps
+	uint8_t event;
+	uint8_t length;
+	uint16_t arg;
+};
+
+class TRACE_MODULE_class
+{
+	private:
+		TRACE_RECORD _records[TRACE_RECORDS];
+		uint8_t _head;
+		uint8_t _count;
+		uint16_t _dropped;
+		bool _closed;
+		uint32_t _openEpoch;			// RTC and millis() at both ends, how tools/trace_view places the window
+		uint32_t _openMillis;
+		uint32_t _closeEpoch;
+		uint32_t _closeMillis;
+
+	public:
+		void add(uint8_t event, uint8_t length, uint16_t arg);
+		void open(time_t t);
+		void close(time_t t);
+		void clear();
+
+		bool closed() const { return _closed; }
+		uint8_t count() const { return _count; }
+		uint16_t dropped() const { return _dropped; }
+		uint32_t openEpoch() const { return _openEpoch; }
+		uint32_t openMillis() const { return _openMillis; }
+		uint32_t closeEpoch() const { return _closeEpoch; }
+		uint32_t closeMillis() const { return _closeMillis; }
+		const TRACE_RECORD &get(uint8_t index) const;
+
+		static uint16_t frameId(const char *data, uint8_t length);
+};
+
+extern TRACE_MODULE_class eventTrace;
+
+#endif
@@ -0,0 +1,171 @@
+/*
+  ============================================================
+  Master's Thesis in Electrical and Computer Engineering
+  Faculty of Electrical and Computer Engineering
+  School of Engineering and Natural Sciences, University of Iceland
+
+  Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+		 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+  Researcher: Jezreel Tan
+  Email: jvt6@hi.is
+
+  Supervisors:
+  Helgi Þorbergsson
+  Email: thorberg@hi.is
+
+  Dórótea Höeg Sigurðardóttir
+  Email: dorotea@hi.is
+
+  ============================================================
+*/
+
+// Cycle counts and stack depth of the system node's hot functions, for simavr or a real board
+//
+// avr_bench.py next to this sketch builds it with arduino-cli against system_node/lib, runs it under
+// simavr and adds flash and RAM figures from the ELF. Results leave through simavr's console
+// register, one line each:
+//
+//	BENCH <name> <cycles> <stack bytes> <result>
+//
+// Timer1 counts every CPU cycle, its overflow interrupt carries the count past 16 bits, and Timer0
+// is stopped while a function runs so millis() does not land in the numbers. The cost of an empty
+// measurement is taken off. The stack below the caller is painted before each call, the lowest
+// byte that changed is the high-water mark.
+
+#define AVR_BENCH
+
+#include "system_node.hpp"
+#include <avr/avr_mcu_section.h>
+
+#define STACK_PAINT			0xC5
+#define STACK_MARGIN		16			// Left alone below SP for measure()'s own frame
+#define CONSOLE_LENGTH		64
+
+AVR_MCU(F_CPU, "atmega328p");
+AVR_MCU_SIMAVR_CONSOLE(&GPIOR0);
+
+extern uint8_t __heap_start;
+extern void *__brkval;
+
+static volatile uint16_t overflows;
+static uint32_t overhead;
+
+ISR(TIMER1_OVF_vect)
+{
+	overflows++;
+}
+
+// Full frame, eight readings and the checksum, the longest a node relays
+static const char fullFrame[] = "TEMP:[12.34000,-3.21000,21.50000,9.87000,100.25000,-15.50000,7.00000,55.55000,187.80000]";
+static const char typicalFrame[] = "TEMP:[12.34000,*,-3.21000,~,21.50000,*,9.87000,*,40.50000]";
+
+class AVR_BENCH_class
+{
+	private:
+		LORA_MODULE_class &_lora = class_lib._lora_module;
+		HWIO_class &_hwio = class_lib._hwio;
+
+		static void console(const char *text)
+		{
+			while (*text) GPIOR0 = *text++;
+		}
+
+		template <typename F>
+		static uint32_t __attribute__((noinline)) measure(const char *name, F body)
+		{
+			uint8_t *bottom = __brkval ? (uint8_t*)__brkval : &__heap_start;
+			uint8_t *top = (uint8_t*)SP - STACK_MARGIN;
+			uint8_t *lowest = bottom;
+			uint8_t timerMask = TIMSK0;
+			char line[CONSOLE_LENGTH];
+
+			// Timer0 off first, its interrupt would leave a frame in the paint
+			TIMSK0 = 0;
+			for (uint8_t *p = bottom; p < top; p++) *p = STACK_PAINT;
+
+			overflows = 0;
+			TCNT1 = 0;
+			TIFR1 = _BV(TOV1);
+
+			long result = body();
+
+			uint16_t count = TCNT1;
+			uint32_t cycles = ((uint32_t)overflows << 16) + count;
+
+			// Overflowed after the last interrupt could be taken
+			if ((TIFR1 & _BV(TOV1)) && count < 0x8000) cycles += 0x10000;
+			TIMSK0 = timerMask;
+
+			while (lowest < top && *lowest == STACK_PAINT) lowest++;
+
+			cycles = cycles > overhead ? cycles - overhead : 0;
+			if (name != nullptr)
+			{
+				snprintf(line, sizeof(line), "BENCH %s %lu %u %ld\n", name, (unsigned long)cycles, (unsigned)(top - lowest), result);
+				console(line);
+			}
+
+			return cycles;
+		}
+
+	public:
+		void run()
+		{
+			char line[CONSOLE_LENGTH];
+			char payload[MAX_MESSAGE_LENGTH];
+
+			// Timer1 free running at the CPU clock
+			TCCR1A = 0;
+			TCCR1B = _BV(CS10);
+			TIMSK1 = _BV(TOIE1);
+			sei();
+
+			overhead = measure(nullptr, []() -> long { return 0; });
+			snprintf(line, sizeof(line), "F_CPU %lu\n", (unsigned long)F_CPU);
+			console(line);
+
+			strcpy(payload, fullFrame);
+			measure("rc4EncryptDecrypt", [&]() -> long { _lora.rc4EncryptDecrypt(payload, sizeof(fullFrame)); return payload[0]; });
+
+			strcpy(_lora._frames.rx, fullFrame);
+			measure("checkMessageValidity", [&]() -> long { return _lora.checkMessageValidity(); });
+
+			strcpy(_lora._frames.rx, typicalFrame);
+			measure("checkMessageValidity_typical", [&]() -> long { return _lora.checkMessageValidity(); });
+
+			strcpy(_lora._frames.rx, fullFrame);
+			measure("getpayloadValues", [&]() -> long { return _lora.getpayloadValues()[CHECKSUM]; });
+
+			// What sendPayloadData puts on the air, dtostrf for every reading
+			memcpy(_lora._systemValues, _lora.getpayloadValues(), sizeof(_lora._systemValues));
+			strcpy(_lora._loraprevHeader, "TEMP:");
+			measure("formatPayloadData", [&]() -> long { return _lora.formatPayloadData(payload); });
+
+			for (uint8_t i = 0; i < CHECKSUM; i++) _lora._systemValues[i] = 100 + i * 37;
+			_lora._systemValues[CHECKSUM] = 1836;
+			strcpy(_lora._loraprevHeader, "SMOI:");
+			measure("formatPayloadData_smoi", [&]() -> long { return _lora.formatPayloadData(payload); });
+
+			measure("toBatteryVoltage", [&]() -> long { return _hwio.toBatteryVoltage(7800) * 1000; });
+
+			console("DONE\n");
+		}
+};
+
+AVR_BENCH_class bench;
+
+void setup()
+{
+	bench.run();
+
+	// simavr ends the run when the CPU sleeps with interrupts off
+	cli();
+	set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+	sleep_enable();
+	sleep_cpu();
+}
+
+void loop()
+{
+}
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""
+Builds avr_bench.ino for the system node's ATmega328, runs it under simavr and writes the results as JSON.
+
+    python3 avr_bench.py                                      # writes avr_bench.json
+    python3 avr_bench.py --baseline main.json --threshold 2   # exit 1 if anything grew more than 2 %
+
+Needs arduino-cli with the arduino:avr core and the node's libraries (LoRa, DS3232RTC, OneWire,
+DallasTemperature, Adafruit AHTX0), simavr, and avr-size/avr-nm from the same toolchain.
+The sketch includes system_node.hpp, so what is measured is the node's own code with its own
+toggles, built by the same compiler and flags as the firmware.
+
+Per function: cycles and microseconds at the board's clock, stack high-water mark in bytes,
+and flash bytes of its symbol (null when the compiler inlined it). Whole image: flash (.text
++ .data) and static RAM (.data + .bss). Commit the JSON from main, run with --baseline on a
+branch, and every optimisation comes with its numbers.
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+REPO = os.path.normpath(os.path.join(HERE, "..", ".."))
+
+# Bench name to the symbol whose size is reported, see avr_bench.ino
+SYMBOLS = {
+    "rc4EncryptDecrypt": "LORA_MODULE_class::rc4EncryptDecrypt",
+    "checkMessageValidity": "LORA_MODULE_class::checkMessageValidity",
+    "checkMessageValidity_typical": "LORA_MODULE_class::checkMessageValidity",
+    "getpayloadValues": "LORA_MODULE_class::getpayloadValues",
+    "formatPayloadData": "LORA_MODULE_class::formatPayloadData",
+    "formatPayloadData_smoi": "LORA_MODULE_class::formatPayloadData",
+    "toBatteryVoltage": "HWIO_class::toBatteryVoltage",
+}
+
+BENCH_LINE = re.compile(r"BENCH (\S+) (\d+) (\d+) (-?\d+)")
+CLOCK_LINE = re.compile(r"F_CPU (\d+)")
+
+
+def build(fqbn, simavr_include, output):
+    flags = "-I{} -I{}".format(os.path.join(REPO, "system_node", "lib"), simavr_include)
+    subprocess.run(["arduino-cli", "compile", "--fqbn", fqbn,
+                    "--build-property", "compiler.cpp.extra_flags=" + flags,
+                    "--output-dir", output, HERE], check=True)
+    return os.path.join(output, "avr_bench.ino.elf")
+
+
+def simulate(elf, timeout):
+    # The .mmcu section in the ELF tells simavr the part, the clock and where the console is
+    run = subprocess.run(["simavr", elf], capture_output=True, text=True, timeout=timeout)
+    output = run.stdout + run.stderr
+    clock = CLOCK_LINE.search(output)
+    results = {}
+
+    for name, cycles, stack, result in BENCH_LINE.findall(output):
+        results[name] = {"cycles": int(cycles), "stack": int(stack), "result": int(result)}
+
+    if clock is None or "DONE" not in output:
+        sys.exit("simavr did not finish the run:\n" + output[-2000:])
+
+    return int(clock.group(1)), results
+
+
+def sizes(elf):
+    sections = {}
+    for line in subprocess.run(["avr-size", "-A", elf], capture_output=True, text=True, check=True).stdout.splitlines():
+        fields = line.split()
+        if len(fields) >= 2 and fields[0].startswith(".") and fields[1].isdigit():
+            sections[fields[0]] = int(fields[1])
+
+    symbols = {}
+    for line in subprocess.run(["avr-nm", "-C", "-S", "--size-sort", elf], capture_output=True, text=True, check=True).stdout.splitlines():
+        fields = line.split(None, 3)
+        if len(fields) == 4 and fields[2] in "tTwW":
+            symbols[fields[3].split("(")[0]] = int(fields[1], 16)
+
+    flash = sections.get(".text", 0) + sections.get(".data", 0)
+    ram = sections.get(".data", 0) + sections.get(".bss", 0)
+    return flash, ram, symbols
+
+
+def commit():
+    try:
+        return subprocess.run(["git", "-C", REPO, "rev-parse", "--short", "HEAD"], capture_output=True, text=True, check=True).stdout.strip()
+    except (OSError, subprocess.CalledProcessError):
+        return None
+
+
+def compare(report, baseline, threshold):
+    worse = []
+
+    def check(label, now, before):
+        if now is None or before is None or before == 0:
+            return ""
+        change = 100.0 * (now - before) / before
+        if change > threshold:
+            worse.append("{} {} -> {} ({:+.1f} %)".format(label, before, now, change))
+        return " ({:+.1f} %)".format(change)
+
+    print("{:<30} {:>16} {:>14} {:>14}".format("function", "cycles", "stack", "flash"))
+    for name, now in report["functions"].items():
+        before = baseline.get("functions", {}).get(name, {})
+        print("{:<30} {:>8}{:<8} {:>6}{:<8} {:>6}{:<8}".format(name,
+              now["cycles"], check(name + " cycles", now["cycles"], before.get("cycles")),
+              now["stack"], check(name + " stack", now["stack"], before.get("stack")),
+              str(now["flash"]), check(name + " flash", now["flash"], before.get("flash"))))
+    print("image: flash {}{} ram {}{}".format(report["flash"], check("image flash", report["flash"], baseline.get("flash")),
+                                              report["ram"], check("image ram", report["ram"], baseline.get("ram"))))
+
+    return worse
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--fqbn", default="arduino:avr:nano:cpu=atmega328", help="Board the node is built for")
+    parser.add_argument("--simavr-include", default="/usr/include/simavr", help="Directory holding avr/avr_mcu_section.h")
+    parser.add_argument("--output", "-o", default="avr_bench.json")
+    parser.add_argument("--baseline", help="Earlier JSON to compare against")
+    parser.add_argument("--threshold", type=float, default=1.0, help="Percent growth that fails the run")
+    parser.add_argument("--timeout", type=float, default=120)
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as output:
+        elf = build(args.fqbn, args.simavr_include, output)
+        clock, results = simulate(elf, args.timeout)
+        flash, ram, symbols = sizes(elf)
+
+    functions = {}
+    for name, result in results.items():
+        result["us"] = round(result["cycles"] * 1e6 / clock, 1)
+        result["flash"] = symbols.get(SYMBOLS.get(name, name))
+        functions[name] = result
+
+    report = {"commit": commit(), "fqbn": args.fqbn, "f_cpu": clock, "flash": flash, "ram": ram, "functions": functions}
+    with open(args.output, "w") as file:
+        json.dump(report, file, indent=2)
+
+    baseline = {}
+    if args.baseline:
+        with open(args.baseline) as file:
+            baseline = json.load(file)
+
+    worse = compare(report, baseline, args.threshold)
+    for line in worse:
+        print("worse: " + line)
+    sys.exit(1 if worse else 0)
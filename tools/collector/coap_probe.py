@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+"""
+Sends one synthetic round the way the basestation does and reports bytes and round-trip time.
+
+    python3 coap_probe.py --coap 127.0.0.1:5683                 # against ./collector
+    python3 coap_probe.py --coap 127.0.0.1:5683 --http 127.0.0.1:8080 --devices 4
+
+--http replays the old per-device upload against tools/thingspeak_standin for comparison:
+one fresh TCP connection and one GET /update per device, with the headers ESP8266HTTPClient sends.
+Wire bytes add 28 bytes of IP/UDP header per datagram for CoAP, and 40 bytes of IP/TCP header
+for each of the at least 9 packets (handshake, request, response, ACKs, close) a GET needs.
+"""
+
+import argparse
+import random
+import socket
+import struct
+import time
+
+COAP_ACK_TIMEOUT = 2.0
+COAP_MAX_RETRANSMIT = 4
+UDP_HEADERS = 28
+TCP_HEADERS = 40
+TCP_PACKETS = 9
+
+
+def round_packet(message_id, devices):
+    # Same layout as COAP_UPLOADER_class::sendRound()
+    header = bytes([0x40 | 2, 0x02]) + struct.pack(">HH", message_id, message_id)
+    options = bytes([(11 << 4) | 1]) + b"r" + b"\xff"
+    payload = struct.pack("<BBI", 1, len(devices), int(time.time()))
+    for hwid in devices:
+        payload += struct.pack("<BBhHhHH", hwid, 0, 1234, 8150, 612, 1532, 3912)
+    return header + options + payload
+
+
+def probe_coap(host, port, devices):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    message_id = random.randrange(0x10000)
+    packet = round_packet(message_id, devices)
+    sent = received = datagrams = 0
+    timeout = COAP_ACK_TIMEOUT * random.uniform(1, 1.5)
+    start = time.perf_counter()
+
+    for attempt in range(COAP_MAX_RETRANSMIT + 1):
+        sock.sendto(packet, (host, port))
+        sent += len(packet)
+        datagrams += 1
+        sock.settimeout(timeout)
+        try:
+            while True:
+                reply, _ = sock.recvfrom(64)
+                if len(reply) >= 4 and struct.unpack(">H", reply[2:4])[0] == message_id:
+                    received += len(reply)
+                    datagrams += 1
+                    rtt = time.perf_counter() - start
+                    return sent + received, sent + received + datagrams * UDP_HEADERS, rtt, reply[1]
+        except socket.timeout:
+            timeout *= 2
+    return sent, sent + datagrams * UDP_HEADERS, None, None
+
+
+def probe_http(host, port, devices):
+    total = 0
+    start = time.perf_counter()
+    for hwid in devices:
+        url = (f"/update?api_key=KEY{hwid:012d}&field1={12.34:.5f}&field2={81.5:.5f}"
+               f"&field3={6.12:.5f}&field4=1532&field5={3.912:.5f}")
+        request = (f"GET {url} HTTP/1.1\r\nHost: {host}\r\nUser-Agent: ESP8266HTTPClient\r\n"
+                   "Accept-Encoding: identity;q=1,chunked;q=0.1,*;q=0\r\nConnection: close\r\n\r\n").encode()
+        with socket.create_connection((host, port)) as sock:
+            sock.sendall(request)
+            total += len(request)
+            while chunk := sock.recv(4096):
+                total += len(chunk)
+    rtt = time.perf_counter() - start
+    return total, total + len(devices) * TCP_PACKETS * TCP_HEADERS, rtt
+
+
+def endpoint(text):
+    host, port = text.rsplit(":", 1)
+    return host, int(port)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--coap", type=endpoint, required=True, help="collector host:port")
+    parser.add_argument("--http", type=endpoint, help="thingspeak_standin host:port")
+    parser.add_argument("--devices", type=int, default=4)
+    args = parser.parse_args()
+    devices = [1, 3, 5, 7, 0, 2, 4, 6][:args.devices]
+
+    payload, wire, rtt, code = probe_coap(*args.coap, devices)
+    if rtt is None:
+        print(f"coap: no ACK after {COAP_MAX_RETRANSMIT} retransmissions, {wire} bytes sent")
+    else:
+        print(f"coap: {payload} bytes payload, {wire} bytes on the wire, rtt {rtt * 1000:.2f} ms, "
+              f"code {code >> 5}.{code & 0x1f:02d}")
+
+    if args.http:
+        http_payload, http_wire, http_rtt = probe_http(*args.http, devices)
+        print(f"http: {http_payload} bytes payload, {http_wire} bytes on the wire, rtt {http_rtt * 1000:.2f} ms")
+        if rtt is not None:
+            print(f"ratio: {http_wire / wire:.1f}x bytes, {http_rtt / rtt:.1f}x time")
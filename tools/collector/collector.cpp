@@ -0,0 +1,287 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// Receives the basestation's CoAP round records (COAP_UPLOADS) and writes them out as CSV
+//
+// Build:	g++ -std=c++17 -O2 -Wall -o collector collector.cpp
+// Usage:	./collector [-p 5683] [-o rounds.csv]
+//
+// Record layout is documented in basestation_node/lib/coap_uploader.h. Confirmable requests are
+// acknowledged with 2.04, retransmissions of a request already stored are only acknowledged again.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#define COAP_VERSION			1
+#define COAP_TYPE_CON			0
+#define COAP_TYPE_NON			1
+#define COAP_TYPE_ACK			2
+#define COAP_POST				0x02
+#define COAP_CHANGED			0x44		// 2.04
+#define COAP_BAD_REQUEST		0x80		// 4.00
+#define COAP_NOT_FOUND			0x84		// 4.04
+#define COAP_METHOD_NOT_ALLOWED	0x85		// 4.05
+#define COAP_OPTION_URI_PATH	11
+#define COAP_PAYLOAD_MARKER		0xFF
+#define COAP_URI_PATH			"r"
+
+#define ROUND_RECORD_VERSION	1
+#define ROUND_HEADER_LEN		6
+#define ROUND_ENTRY_LEN			12
+#define DEFAULT_PORT			5683
+#define PACKET_LEN				1152
+#define RECENT_EXCHANGES		64			// Remembered for deduplication, well past EXCHANGE_LIFETIME at one round an hour
+
+struct EXCHANGE
+{
+	uint32_t address;
+	uint16_t port;
+	uint16_t messageId;
+	uint8_t code;
+};
+
+static volatile sig_atomic_t running = 1;
+static EXCHANGE recent[RECENT_EXCHANGES];
+static unsigned recentCount = 0;
+static unsigned long rounds = 0, duplicates = 0, rejected = 0, bytesIn = 0, bytesOut = 0;
+
+static void stop(int)
+{
+	running = 0;
+}
+
+static uint16_t get16(const uint8_t *data)
+{
+	return data[0] | data[1] << 8;
+}
+
+static uint32_t get32(const uint8_t *data)
+{
+	return get16(data) | (uint32_t)get16(data + 2) << 16;
+}
+
+// Option delta or length nibble, 13 and 14 pull in one or two extension bytes
+static bool optionValue(unsigned nibble, const uint8_t *&at, const uint8_t *end, unsigned &value)
+{
+	if (nibble < 13)
+	{
+		value = nibble;
+	}
+	else if (nibble == 13 && at < end)
+	{
+		value = 13 + *at++;
+	}
+	else if (nibble == 14 && at + 1 < end)
+	{
+		value = 269 + (at[0] << 8 | at[1]);
+		at += 2;
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+static uint8_t storeRound(const uint8_t *payload, size_t length, FILE *out)
+{
+	if (length < ROUND_HEADER_LEN || payload[0] != ROUND_RECORD_VERSION) return COAP_BAD_REQUEST;
+
+	uint8_t count = payload[1];
+	time_t timestamp = get32(payload + 2);
+	if (length != ROUND_HEADER_LEN + (size_t)count * ROUND_ENTRY_LEN) return COAP_BAD_REQUEST;
+
+	char when[21];
+	struct tm timeInfo;
+	gmtime_r(&timestamp, &timeInfo);
+	strftime(when, sizeof(when), "%Y-%m-%dT%H:%M:%SZ", &timeInfo);
+
+	for (uint8_t i = 0; i < count; i++)
+	{
+		const uint8_t *entry = payload + ROUND_HEADER_LEN + i * ROUND_ENTRY_LEN;
+
+		fprintf(out, "%s,%u,%.2f,%.2f,%.2f,%u,%.3f,%u\n",
+			when,
+			entry[0],
+			(int16_t)get16(entry + 2) / 100.0,
+			get16(entry + 4) / 100.0,
+			(int16_t)get16(entry + 6) / 100.0,
+			get16(entry + 8),
+			get16(entry + 10) / 1000.0,
+			entry[1]);
+	}
+	fflush(out);
+
+	return COAP_CHANGED;
+}
+
+static uint8_t handleRequest(const uint8_t *packet, size_t length, FILE *out)
+{
+	const uint8_t *at = packet + 4 + (packet[0] & 0x0F);
+	const uint8_t *end = packet + length;
+	unsigned option = 0;
+	char path[32] = "";
+	size_t pathLength = 0;
+
+	if (packet[1] != COAP_POST) return COAP_METHOD_NOT_ALLOWED;
+
+	// Options up to the payload marker, only Uri-Path matters here
+	while (at < end && *at != COAP_PAYLOAD_MARKER)
+	{
+		unsigned delta, size;
+		uint8_t nibbles = *at++;
+
+		if (!optionValue(nibbles >> 4, at, end, delta) || !optionValue(nibbles & 0x0F, at, end, size) || at + size > end) return COAP_BAD_REQUEST;
+		option += delta;
+
+		if (option == COAP_OPTION_URI_PATH && pathLength + size + 1 < sizeof(path))
+		{
+			if (pathLength > 0) path[pathLength++] = '/';
+			memcpy(&path[pathLength], at, size);
+			pathLength += size;
+			path[pathLength] = '\0';
+		}
+		at += size;
+	}
+
+	if (strcmp(path, COAP_URI_PATH) != 0) return COAP_NOT_FOUND;
+	if (at >= end) return COAP_BAD_REQUEST;
+
+	return storeRound(at + 1, end - at - 1, out);
+}
+
+int main(int argc, char **argv)
+{
+	uint16_t port = DEFAULT_PORT;
+	FILE *out = stdout;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "p:o:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'p':
+				port = atoi(optarg);
+				break;
+
+			case 'o':
+				if (!(out = fopen(optarg, "a")))
+				{
+					perror(optarg);
+					return 1;
+				}
+				break;
+
+			default:
+				fprintf(stderr, "Usage: %s [-p port] [-o rounds.csv]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	int sock = socket(AF_INET, SOCK_DGRAM, 0);
+	sockaddr_in local = {};
+	local.sin_family = AF_INET;
+	local.sin_addr.s_addr = htonl(INADDR_ANY);
+	local.sin_port = htons(port);
+
+	if (sock < 0 || bind(sock, (sockaddr*)&local, sizeof(local)) < 0)
+	{
+		perror("bind");
+		return 1;
+	}
+
+	// No SA_RESTART, so recvfrom() returns on Ctrl-C and the totals get printed
+	struct sigaction action = {};
+	action.sa_handler = stop;
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+
+	fprintf(stderr, "Collector listening on UDP %u\n", port);
+	if (ftell(out) == 0) fprintf(out, "time,hwid,temperature,humidity,soil_temperature,soil_moisture,battery,predicted\n");
+
+	while (running)
+	{
+		uint8_t packet[PACKET_LEN];
+		sockaddr_in peer;
+		socklen_t peerLength = sizeof(peer);
+
+		ssize_t length = recvfrom(sock, packet, sizeof(packet), 0, (sockaddr*)&peer, &peerLength);
+		if (length < 4) continue;
+		bytesIn += length;
+
+		uint8_t type = (packet[0] >> 4) & 0x03;
+		uint8_t tokenLength = packet[0] & 0x0F;
+		uint16_t messageId = packet[2] << 8 | packet[3];
+
+		// Not a request we can answer, RFC 7252 says drop it silently
+		if (packet[0] >> 6 != COAP_VERSION || tokenLength > 8 || length < 4 + tokenLength || (type != COAP_TYPE_CON && type != COAP_TYPE_NON)) continue;
+
+		// A retransmission gets the answer the first copy got, without storing the round twice
+		uint8_t code = 0;
+		for (unsigned i = 0; i < recentCount && i < RECENT_EXCHANGES; i++)
+		{
+			if (recent[i].address == peer.sin_addr.s_addr && recent[i].port == peer.sin_port && recent[i].messageId == messageId)
+			{
+				code = recent[i].code;
+				duplicates++;
+				break;
+			}
+		}
+
+		if (code == 0)
+		{
+			code = handleRequest(packet, length, out);
+			recent[recentCount++ % RECENT_EXCHANGES] = { peer.sin_addr.s_addr, peer.sin_port, messageId, code };
+
+			if (code == COAP_CHANGED) rounds++;
+			else rejected++;
+		}
+
+		// Piggybacked response, same message ID and token
+		if (type != COAP_TYPE_CON) continue;
+
+		uint8_t reply[4 + 8];
+		reply[0] = (COAP_VERSION << 6) | (COAP_TYPE_ACK << 4) | tokenLength;
+		reply[1] = code;
+		reply[2] = packet[2];
+		reply[3] = packet[3];
+		memcpy(&reply[4], &packet[4], tokenLength);
+
+		if (sendto(sock, reply, 4 + tokenLength, 0, (sockaddr*)&peer, peerLength) > 0) bytesOut += 4 + tokenLength;
+	}
+
+	fprintf(stderr, "rounds=%lu duplicates=%lu rejected=%lu bytes_in=%lu bytes_out=%lu\n", rounds, duplicates, rejected, bytesIn, bytesOut);
+	close(sock);
+	if (out != stdout) fclose(out);
+
+	return 0;
+}
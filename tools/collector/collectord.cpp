@@ -0,0 +1,1128 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// Collector for many basestations: UDP (CoAP), TCP and MQTT ingest, decoded on a worker per core
+//
+// Build:	g++ -std=c++17 -O2 -Wall -pthread -o collectord collectord.cpp
+// Usage:	./collectord [-p 5683] [-t 5684] [-m broker:1883] [-r collector] [-u 2] [-w cores]
+//			             [-k keys.txt] [-o rounds] [-d] [-a alerts.rules] [-s] [-i 1]
+//
+//	-p	UDP port for CoAP, 0 turns it off			-u	UDP receiver threads on one SO_REUSEPORT port
+//	-t	TCP port, 0 turns it off					-w	Decode workers, pinned one per core
+//	-m	MQTT broker to subscribe to				-r	MQTT topic root
+//	-k	Keys file, one "<network> <key>" per line, networks not in it use the nodes' default key
+//	-o	Output prefix, each worker appends to <prefix>.<worker>.csv
+//	-d	Also keep each worker's rows in <prefix>.<worker>.tsdb, see ../tsdb/tsdb.h
+//	-a	Alert rules, see rules.h, each worker appends what fires and clears to <prefix>.<worker>.alerts
+//	-s	fdatasync every batch before it is acknowledged
+//	-i	Seconds between throughput lines on stderr, 0 for totals only
+//
+// Wire formats are in ingest.h. Ingest threads only read the envelope, and the network ID picks
+// the worker, so everything about one network (its key, its recent rounds, its output file) is
+// only ever touched by one thread and nothing is locked. Each ingest thread has its own lock-free
+// ring into each worker. A worker decodes a batch, writes it with one write(), and only then
+// acknowledges it. loadgen.cpp next to this file drives it with synthetic basestations.
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "ingest.h"
+#include "rules.h"
+#include "../tsdb/tsdb.h"
+
+#define DEFAULT_UDP_PORT		5683
+#define DEFAULT_TCP_PORT		5684
+#define DEFAULT_MQTT_ROOT		"collector"
+#define RING_LEN				512			// Items per ingest thread and worker pair, power of two
+#define BATCH_MAX				64			// recvmmsg() batch, and items per ring per worker pass
+#define RECENT_ROUNDS			8			// Per network, catches a round arriving twice over any path
+#define CACHE_LINE				64
+#define WORKER_POLL_MS			200
+#define FULL_WAIT_US			100			// TCP and MQTT wait for room instead of dropping
+#define MQTT_KEEP_ALIVE			60
+#define MQTT_RETRY_MS			2000
+#define TCP_BUFFER_LEN			(64 * 1024)
+#define MAX_EVENTS				64
+#define OUTPUT_HEADER			"time,network,hwid,temperature,humidity,soil_temperature,soil_moisture,battery,predicted\n"
+#define ALERTS_HEADER			"time,network,hwid,rule,event,value\n"
+
+enum SOURCE : uint8_t
+{
+	SOURCE_UDP,
+	SOURCE_TCP,
+	SOURCE_MQTT
+};
+
+// The CoAP exchange to answer once the round is stored
+struct EXCHANGE
+{
+	int socket;
+	bool confirmable;
+	uint8_t tokenLength;
+	uint8_t token[8];
+	uint16_t messageId;
+	sockaddr_in peer;
+};
+
+struct ITEM
+{
+	uint8_t source;
+	uint8_t kind;
+	uint16_t network;
+	uint16_t length;
+	EXCHANGE exchange;
+	uint8_t data[PACKET_LEN];
+};
+
+// Single producer, single consumer, head and tail on their own cache lines. Slots are filled and
+// read in place so a whole ITEM never goes through the stack.
+template <typename T, size_t N>
+class RING
+{
+	static_assert((N & (N - 1)) == 0, "RING size must be a power of two");
+
+	private:
+		alignas(CACHE_LINE) std::atomic<size_t> _head{0};
+		alignas(CACHE_LINE) std::atomic<size_t> _tail{0};
+		alignas(CACHE_LINE) T _items[N];
+
+	public:
+		T *claim()
+		{
+			size_t tail = _tail.load(std::memory_order_relaxed);
+			return tail - _head.load(std::memory_order_acquire) == N ? nullptr : &_items[tail & (N - 1)];
+		}
+
+		void publish()
+		{
+			_tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
+		T *peek()
+		{
+			size_t head = _head.load(std::memory_order_relaxed);
+			return head == _tail.load(std::memory_order_acquire) ? nullptr : &_items[head & (N - 1)];
+		}
+
+		void release()
+		{
+			_head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+};
+
+struct alignas(CACHE_LINE) COUNTERS
+{
+	std::atomic<unsigned long> items{0};
+	std::atomic<unsigned long> rounds{0};
+	std::atomic<unsigned long> rows{0};
+	std::atomic<unsigned long> duplicates{0};
+	std::atomic<unsigned long> rejected{0};
+	std::atomic<unsigned long> dropped{0};		// Ingest side, worker ring full
+	std::atomic<unsigned long> alerts{0};
+};
+
+struct NETWORK
+{
+	uint32_t recent[RECENT_ROUNDS] = {};
+	uint8_t recentCount = 0;
+	const std::string *key = nullptr;
+	std::vector<NODE_ALERTS> nodes;
+};
+
+struct WORKER
+{
+	int wake = -1;
+	int output = -1;
+	int alerts = -1;
+	std::vector<RING<ITEM, RING_LEN>*> rings;	// One per ingest thread
+	std::unordered_map<uint16_t, NETWORK> networks;
+	std::string buffer;
+	std::string alertBuffer;
+	TSDB_class *store = nullptr;
+	std::vector<ROUND_ROW> rows;				// The item's rows, stored once it is known not to be a duplicate
+	std::vector<std::pair<EXCHANGE, uint8_t>> replies;
+	COUNTERS counters;
+};
+
+// Producer side of one ingest thread, a ring into every worker
+struct INGEST
+{
+	unsigned index;
+	std::vector<bool> woken;
+};
+
+static std::atomic<bool> running{true};
+static std::vector<WORKER*> workers;
+static std::unordered_map<uint16_t, std::string> keys;
+static std::string defaultKey = DEFAULT_KEY;
+static RULES_class rules;
+static bool syncWrites = false;
+static COUNTERS ingestCounters;
+
+static void stop(int)
+{
+	running = false;
+}
+
+static unsigned long nowMs()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ---- Worker side ----
+
+static void formatTime(uint32_t timestamp, char *when)
+{
+	time_t t = timestamp;
+	struct tm timeInfo;
+
+	gmtime_r(&t, &timeInfo);
+	strftime(when, 21, "%Y-%m-%dT%H:%M:%SZ", &timeInfo);
+}
+
+static void appendRow(WORKER &worker, const char *when, uint16_t network, const ROUND_ROW &row)
+{
+	char line[160];
+
+	snprintf(line, sizeof(line), "%s,%u,%u,%.2f,%.2f,%.2f,%u,%.3f,%u\n",
+		when, network, row.hwid, row.values[0], row.values[1], row.values[2], (unsigned)row.values[3], row.values[4], row.flags);
+	worker.buffer += line;
+	if (worker.store != nullptr || rules.count > 0) worker.rows.push_back(row);
+}
+
+// Predicted values stay in the CSV with their flag, the store only keeps what was measured
+static void storeRows(WORKER &worker, uint16_t network, uint32_t timestamp)
+{
+	for (const ROUND_ROW &row : worker.rows)
+	{
+		for (uint8_t metric = 0; metric < METRICS; metric++)
+		{
+			if (row.flags & (1 << metric)) continue;
+			worker.store->append(seriesId(network, row.hwid, metric), timestamp, row.values[metric], metricDecimals[metric]);
+		}
+	}
+}
+
+static uint8_t decodeRecord(WORKER &worker, const ITEM &item, uint32_t &timestamp)
+{
+	const uint8_t *payload = item.data;
+	char when[21];
+
+	if (item.length < ROUND_HEADER_LEN || payload[0] != ROUND_RECORD_VERSION) return COAP_BAD_REQUEST;
+
+	uint8_t count = payload[1];
+	timestamp = get32(payload + 2);
+	if (item.length != ROUND_HEADER_LEN + (size_t)count * ROUND_ENTRY_LEN) return COAP_BAD_REQUEST;
+
+	formatTime(timestamp, when);
+
+	for (uint8_t i = 0; i < count; i++)
+	{
+		const uint8_t *entry = payload + ROUND_HEADER_LEN + i * ROUND_ENTRY_LEN;
+		ROUND_ROW row;
+
+		row.hwid = entry[0];
+		row.flags = entry[1];
+		row.values[0] = (int16_t)get16(entry + 2) / 100.0;
+		row.values[1] = get16(entry + 4) / 100.0;
+		row.values[2] = (int16_t)get16(entry + 6) / 100.0;
+		row.values[3] = get16(entry + 8);
+		row.values[4] = get16(entry + 10) / 1000.0;
+		appendRow(worker, when, item.network, row);
+	}
+	worker.counters.rows += count;
+
+	return COAP_CHANGED;
+}
+
+static uint8_t decodeText(WORKER &worker, const ITEM &item, const std::string &key, uint32_t &timestamp)
+{
+	ROUND_ROW rows[CHECKSUM] = {};
+	uint8_t seen = 0;
+	size_t at = 4;
+	char when[21];
+
+	if (item.length < 4) return COAP_BAD_REQUEST;
+	timestamp = get32(item.data);
+
+	// Any frame that fails its checksum rejects the round, as a bad frame over the air would be
+	while (at < item.length)
+	{
+		uint8_t length = item.data[at++];
+		char frame[MAX_MESSAGE_LENGTH];
+		double values[MAX_DEVICES];
+		uint8_t predicted;
+		uint8_t metric = 0;
+
+		if (length == 0 || length >= MAX_MESSAGE_LENGTH || at + length > item.length) return COAP_BAD_REQUEST;
+
+		memcpy(frame, &item.data[at], length);
+		frame[length] = '\0';
+		rc4(key, (uint8_t*)frame, length);
+		at += length;
+
+		while (metric < TEXT_METRICS && strncmp(frame, textHeaders[metric], 5) != 0) metric++;
+		if (metric == TEXT_METRICS || !parseFrame(frame, metric, values, &predicted)) return COAP_BAD_REQUEST;
+
+		for (uint8_t slot = 0; slot < CHECKSUM; slot++)
+		{
+			rows[slot].values[metric] = values[slot];
+			if (predicted & (1 << slot)) rows[slot].flags |= 1 << metric;
+		}
+		seen |= 1 << metric;
+	}
+
+	if (seen == 0) return COAP_BAD_REQUEST;
+
+	formatTime(timestamp, when);
+
+	// A device is in the round if anything came in for it, real or predicted
+	for (uint8_t slot = 0; slot < CHECKSUM; slot++)
+	{
+		bool present = rows[slot].flags != 0;
+		for (uint8_t metric = 0; metric < TEXT_METRICS; metric++) present |= rows[slot].values[metric] != 0;
+		if (!present) continue;
+
+		rows[slot].hwid = slot;
+		appendRow(worker, when, item.network, rows[slot]);
+		worker.counters.rows++;
+	}
+
+	return COAP_CHANGED;
+}
+
+static uint8_t decode(WORKER &worker, const ITEM &item)
+{
+	NETWORK &network = worker.networks[item.network];
+	size_t mark = worker.buffer.size();
+	uint32_t timestamp = 0;
+	uint8_t code;
+
+	worker.rows.clear();
+	if (network.key == nullptr)
+	{
+		auto found = keys.find(item.network);
+		network.key = found != keys.end() ? &found->second : &defaultKey;
+	}
+
+	if (item.kind == KIND_RECORD) code = decodeRecord(worker, item, timestamp);
+	else if (item.kind == KIND_TEXT) code = network.key->empty() ? COAP_UNAUTHORIZED : decodeText(worker, item, *network.key, timestamp);
+	else code = COAP_NOT_FOUND;
+
+	if (code != COAP_CHANGED)
+	{
+		worker.buffer.resize(mark);
+		worker.counters.rejected++;
+		return code;
+	}
+
+	// Same round again, a retransmission or the same basestation on two paths, answered but not stored
+	for (uint8_t i = 0; i < RECENT_ROUNDS; i++)
+	{
+		if (network.recent[i] == timestamp && timestamp != 0)
+		{
+			worker.buffer.resize(mark);
+			worker.counters.duplicates++;
+			return COAP_CHANGED;
+		}
+	}
+
+	network.recent[network.recentCount++ % RECENT_ROUNDS] = timestamp;
+	worker.counters.rounds++;
+	if (worker.store != nullptr) storeRows(worker, item.network, timestamp);
+	if (rules.count > 0) worker.counters.alerts += rules.round(network.nodes, item.network, timestamp, worker.rows.data(), worker.rows.size(), worker.alertBuffer);
+
+	return COAP_CHANGED;
+}
+
+static void acknowledge(const EXCHANGE &exchange, uint8_t code)
+{
+	uint8_t reply[4 + 8];
+
+	// Piggybacked response, same message ID and token
+	reply[0] = (COAP_VERSION << 6) | (COAP_TYPE_ACK << 4) | exchange.tokenLength;
+	reply[1] = code;
+	reply[2] = exchange.messageId >> 8;
+	reply[3] = exchange.messageId;
+	memcpy(&reply[4], exchange.token, exchange.tokenLength);
+
+	sendto(exchange.socket, reply, 4 + exchange.tokenLength, MSG_DONTWAIT, (const sockaddr*)&exchange.peer, sizeof(exchange.peer));
+}
+
+static void writeAll(int fd, std::string &buffer)
+{
+	size_t written = 0;
+
+	while (written < buffer.size())
+	{
+		ssize_t result = write(fd, buffer.data() + written, buffer.size() - written);
+		if (result < 0 && errno != EINTR) break;
+		if (result > 0) written += result;
+	}
+	if (syncWrites && !buffer.empty()) fdatasync(fd);
+	buffer.clear();
+}
+
+static void flushBatch(WORKER &worker)
+{
+	// Write through, the batch is on its way to storage before anyone hears it was taken
+	writeAll(worker.output, worker.buffer);
+	if (!worker.alertBuffer.empty()) writeAll(worker.alerts, worker.alertBuffer);
+
+	for (auto &reply : worker.replies)
+	{
+		acknowledge(reply.first, reply.second);
+	}
+	worker.replies.clear();
+}
+
+static void runWorker(WORKER *worker, unsigned core)
+{
+	// Thread per core, a worker's networks stay in one core's cache
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	CPU_SET(core % std::thread::hardware_concurrency(), &cpus);
+	pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+
+	while (true)
+	{
+		bool stopping = !running;
+		size_t taken;
+
+		do
+		{
+			taken = 0;
+
+			for (auto ring : worker->rings)
+			{
+				ITEM *item;
+
+				for (size_t count = 0; count < BATCH_MAX && (item = ring->peek()) != nullptr; count++)
+				{
+					uint8_t code = decode(*worker, *item);
+
+					if (item->source == SOURCE_UDP && item->exchange.confirmable) worker->replies.emplace_back(item->exchange, code);
+					ring->release();
+					taken++;
+				}
+			}
+
+			worker->counters.items += taken;
+			flushBatch(*worker);
+		} while (taken > 0);
+
+		// Rings were empty, so everything queued before stop() was seen is stored
+		if (stopping) break;
+
+		// Ingest threads bump the eventfd after each batch they hand over
+		pollfd wake = { worker->wake, POLLIN, 0 };
+		uint64_t value;
+		if (poll(&wake, 1, WORKER_POLL_MS) > 0 && read(worker->wake, &value, sizeof(value)) < 0) continue;
+	}
+}
+
+// ---- Ingest side ----
+
+static ITEM *claimItem(INGEST &ingest, uint16_t network, bool wait)
+{
+	RING<ITEM, RING_LEN> *ring = workers[network % workers.size()]->rings[ingest.index];
+	ITEM *item;
+
+	// UDP drops and answers 5.03, the stream paths hold back and let TCP flow control push back
+	while ((item = ring->claim()) == nullptr)
+	{
+		if (!wait || !running) return nullptr;
+		std::this_thread::sleep_for(std::chrono::microseconds(FULL_WAIT_US));
+	}
+
+	return item;
+}
+
+static void publishItem(INGEST &ingest, uint16_t network)
+{
+	size_t index = network % workers.size();
+
+	workers[index]->rings[ingest.index]->publish();
+	ingest.woken[index] = true;
+}
+
+static void wakeWorkers(INGEST &ingest)
+{
+	uint64_t one = 1;
+
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		if (!ingest.woken[i]) continue;
+
+		if (write(workers[i]->wake, &one, sizeof(one)) < 0) continue;
+		ingest.woken[i] = false;
+	}
+}
+
+// Option delta or length nibble, 13 and 14 pull in one or two extension bytes
+static bool optionValue(unsigned nibble, const uint8_t *&at, const uint8_t *end, unsigned &value)
+{
+	if (nibble < 13)
+	{
+		value = nibble;
+	}
+	else if (nibble == 13 && at < end)
+	{
+		value = 13 + *at++;
+	}
+	else if (nibble == 14 && at + 1 < end)
+	{
+		value = 269 + (at[0] << 8 | at[1]);
+		at += 2;
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+// Envelope only, /r or /t then an optional network. Returns 0 and the payload when it is a round.
+static uint8_t parseCoap(const uint8_t *packet, size_t length, uint8_t &kind, uint16_t &network, const uint8_t *&payload)
+{
+	const uint8_t *at = packet + 4 + (packet[0] & 0x0F);
+	const uint8_t *end = packet + length;
+	unsigned option = 0;
+	unsigned segment = 0;
+	kind = 0;
+	network = 0;
+
+	if (packet[1] != COAP_POST) return COAP_METHOD_NOT_ALLOWED;
+
+	while (at < end && *at != COAP_PAYLOAD_MARKER)
+	{
+		unsigned delta, size;
+		uint8_t nibbles = *at++;
+
+		if (!optionValue(nibbles >> 4, at, end, delta) || !optionValue(nibbles & 0x0F, at, end, size) || at + size > end) return COAP_BAD_REQUEST;
+		option += delta;
+
+		if (option == COAP_OPTION_URI_PATH)
+		{
+			if (segment == 0 && size == 1 && (*at == KIND_RECORD || *at == KIND_TEXT)) kind = *at;
+			else if (segment == 1 && size > 0 && size <= 5) network = (uint16_t)atoi(std::string((const char*)at, size).c_str());
+			else return COAP_NOT_FOUND;
+			segment++;
+		}
+		at += size;
+	}
+
+	if (kind == 0) return COAP_NOT_FOUND;
+	if (at >= end) return COAP_BAD_REQUEST;
+
+	payload = at + 1;
+	return 0;
+}
+
+static void runUdp(INGEST ingest, int sock)
+{
+	mmsghdr messages[BATCH_MAX];
+	iovec vectors[BATCH_MAX];
+	sockaddr_in peers[BATCH_MAX];
+	static thread_local uint8_t packets[BATCH_MAX][PACKET_LEN];
+
+	for (unsigned i = 0; i < BATCH_MAX; i++)
+	{
+		vectors[i] = { packets[i], PACKET_LEN };
+		messages[i].msg_hdr = {};
+		messages[i].msg_hdr.msg_iov = &vectors[i];
+		messages[i].msg_hdr.msg_iovlen = 1;
+		messages[i].msg_hdr.msg_name = &peers[i];
+	}
+
+	while (running)
+	{
+		for (unsigned i = 0; i < BATCH_MAX; i++) messages[i].msg_hdr.msg_namelen = sizeof(peers[i]);
+
+		// As many datagrams as are waiting in one call, MSG_WAITFORONE returns as soon as there is one
+		int count = recvmmsg(sock, messages, BATCH_MAX, MSG_WAITFORONE, NULL);
+		if (count <= 0) continue;
+
+		for (int i = 0; i < count; i++)
+		{
+			const uint8_t *packet = packets[i];
+			size_t length = messages[i].msg_len;
+			uint8_t type = (packet[0] >> 4) & 0x03;
+			uint8_t tokenLength = packet[0] & 0x0F;
+
+			// Not a request we can answer, RFC 7252 says drop it silently
+			if (length < 4 || packet[0] >> 6 != COAP_VERSION || tokenLength > 8 || length < 4U + tokenLength || (type != COAP_TYPE_CON && type != COAP_TYPE_NON)) continue;
+
+			EXCHANGE exchange;
+			exchange.socket = sock;
+			exchange.confirmable = type == COAP_TYPE_CON;
+			exchange.tokenLength = tokenLength;
+			exchange.messageId = packet[2] << 8 | packet[3];
+			exchange.peer = peers[i];
+			memcpy(exchange.token, &packet[4], tokenLength);
+
+			uint8_t kind;
+			uint16_t network;
+			const uint8_t *payload;
+			uint8_t code = parseCoap(packet, length, kind, network, payload);
+			ITEM *item = code == 0 ? claimItem(ingest, network, false) : nullptr;
+
+			if (code == 0 && item == nullptr)
+			{
+				code = COAP_UNAVAILABLE;
+				ingestCounters.dropped++;
+			}
+
+			if (code != 0)
+			{
+				if (exchange.confirmable) acknowledge(exchange, code);
+				continue;
+			}
+
+			item->source = SOURCE_UDP;
+			item->kind = kind;
+			item->network = network;
+			item->length = packet + length - payload;
+			item->exchange = exchange;
+			memcpy(item->data, payload, item->length);
+			publishItem(ingest, network);
+		}
+
+		wakeWorkers(ingest);
+	}
+}
+
+struct TCP_CONNECTION
+{
+	int fd;
+	std::vector<uint8_t> buffer;
+};
+
+static void runTcp(INGEST ingest, int listener)
+{
+	int epoll = epoll_create1(0);
+	epoll_event event = {};
+	std::unordered_map<int, TCP_CONNECTION> connections;
+	static thread_local uint8_t chunk[TCP_BUFFER_LEN];
+
+	event.events = EPOLLIN;
+	event.data.fd = listener;
+	epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &event);
+
+	while (running)
+	{
+		epoll_event events[MAX_EVENTS];
+		int count = epoll_wait(epoll, events, MAX_EVENTS, WORKER_POLL_MS);
+
+		for (int i = 0; i < count; i++)
+		{
+			int fd = events[i].data.fd;
+
+			if (fd == listener)
+			{
+				int client = accept4(listener, NULL, NULL, SOCK_NONBLOCK);
+				if (client < 0) continue;
+
+				event.data.fd = client;
+				epoll_ctl(epoll, EPOLL_CTL_ADD, client, &event);
+				connections[client].fd = client;
+				continue;
+			}
+
+			TCP_CONNECTION &connection = connections[fd];
+			ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+
+			if (received <= 0)
+			{
+				if (received < 0 && errno == EAGAIN) continue;
+				epoll_ctl(epoll, EPOLL_CTL_DEL, fd, NULL);
+				close(fd);
+				connections.erase(fd);
+				continue;
+			}
+
+			connection.buffer.insert(connection.buffer.end(), chunk, chunk + received);
+
+			// Every whole frame in the buffer, a partial one waits for the next read
+			size_t at = 0;
+			while (connection.buffer.size() - at >= TCP_HEADER_LEN)
+			{
+				const uint8_t *frame = &connection.buffer[at];
+				uint16_t network = get16(frame + 1);
+				uint16_t length = get16(frame + 3);
+
+				if (length > PACKET_LEN)
+				{
+					// Lost framing, nothing after this can be trusted
+					ingestCounters.rejected++;
+					at = connection.buffer.size();
+					shutdown(fd, SHUT_RDWR);
+					break;
+				}
+				if (connection.buffer.size() - at < TCP_HEADER_LEN + (size_t)length) break;
+
+				ITEM *item = claimItem(ingest, network, true);
+				if (item == nullptr) break;
+
+				item->source = SOURCE_TCP;
+				item->kind = frame[0];
+				item->network = network;
+				item->length = length;
+				memcpy(item->data, frame + TCP_HEADER_LEN, length);
+				publishItem(ingest, network);
+
+				at += TCP_HEADER_LEN + length;
+			}
+			connection.buffer.erase(connection.buffer.begin(), connection.buffer.begin() + at);
+		}
+
+		wakeWorkers(ingest);
+	}
+
+	for (auto &connection : connections) close(connection.first);
+	close(epoll);
+}
+
+// ---- MQTT, a subscriber to the broker the basestations publish to ----
+
+static bool sendAll(int fd, const uint8_t *data, size_t length)
+{
+	while (length > 0)
+	{
+		ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+		if (sent <= 0) return false;
+		data += sent;
+		length -= sent;
+	}
+
+	return true;
+}
+
+static bool recvAll(int fd, uint8_t *data, size_t length)
+{
+	while (length > 0)
+	{
+		ssize_t received = recv(fd, data, length, 0);
+		if (received <= 0) return false;
+		data += received;
+		length -= received;
+	}
+
+	return true;
+}
+
+static int connectTo(const std::string &host, const std::string &port)
+{
+	addrinfo hints = {}, *result;
+	int fd = -1;
+
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	if (getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0) return -1;
+
+	for (addrinfo *at = result; at != NULL && fd < 0; at = at->ai_next)
+	{
+		fd = socket(at->ai_family, at->ai_socktype, at->ai_protocol);
+		if (fd >= 0 && connect(fd, at->ai_addr, at->ai_addrlen) < 0)
+		{
+			close(fd);
+			fd = -1;
+		}
+	}
+	freeaddrinfo(result);
+
+	return fd;
+}
+
+static void appendString(std::vector<uint8_t> &packet, const std::string &text)
+{
+	packet.push_back(text.size() >> 8);
+	packet.push_back(text.size());
+	packet.insert(packet.end(), text.begin(), text.end());
+}
+
+static void appendRemaining(std::vector<uint8_t> &packet, size_t remaining)
+{
+	do
+	{
+		uint8_t digit = remaining % 128;
+		remaining /= 128;
+		packet.push_back(remaining > 0 ? digit | 0x80 : digit);
+	} while (remaining > 0);
+}
+
+static int mqttSession(INGEST &ingest, const std::string &host, const std::string &port, const std::string &root)
+{
+	int fd = connectTo(host, port);
+	if (fd < 0) return -1;
+
+	// CONNECT, clean session, then SUBSCRIBE <root>/+/+ at QoS 1
+	std::vector<uint8_t> body, packet;
+	appendString(body, "MQTT");
+	body.push_back(4);
+	body.push_back(0x02);
+	body.push_back(MQTT_KEEP_ALIVE >> 8);
+	body.push_back(MQTT_KEEP_ALIVE & 0xFF);
+	appendString(body, "collectord-" + std::to_string(getpid()));
+	packet.push_back(0x10);
+	appendRemaining(packet, body.size());
+	packet.insert(packet.end(), body.begin(), body.end());
+
+	body.clear();
+	body.push_back(0);
+	body.push_back(1);
+	appendString(body, root + "/+/+");
+	body.push_back(1);
+	packet.push_back(0x82);
+	appendRemaining(packet, body.size());
+	packet.insert(packet.end(), body.begin(), body.end());
+
+	if (!sendAll(fd, packet.data(), packet.size()))
+	{
+		close(fd);
+		return -1;
+	}
+
+	fprintf(stderr, "MQTT subscribed to %s/+/+ on %s:%s\n", root.c_str(), host.c_str(), port.c_str());
+
+	std::vector<uint8_t> message;
+	unsigned long lastSent = nowMs();
+
+	while (running)
+	{
+		pollfd readable = { fd, POLLIN, 0 };
+		uint8_t header;
+
+		if (poll(&readable, 1, WORKER_POLL_MS) == 0)
+		{
+			// Quiet for half the keep-alive, ping so the broker keeps us
+			static const uint8_t ping[2] = { 0xC0, 0x00 };
+
+			if (nowMs() - lastSent < MQTT_KEEP_ALIVE * 500UL) continue;
+			if (!sendAll(fd, ping, sizeof(ping))) break;
+			lastSent = nowMs();
+			continue;
+		}
+		if (recv(fd, &header, 1, 0) <= 0) break;
+
+		size_t remaining = 0;
+		uint8_t digit = 0x80;
+		unsigned shift = 0;
+		bool complete = true;
+
+		while ((digit & 0x80) && shift < 28 && (complete = recvAll(fd, &digit, 1)))
+		{
+			remaining |= (size_t)(digit & 0x7F) << shift;
+			shift += 7;
+		}
+
+		message.resize(remaining);
+		if (!complete || (remaining > 0 && !recvAll(fd, message.data(), remaining))) break;
+		if ((header >> 4) != 3 || remaining < 2) continue;
+
+		// PUBLISH, topic <root>/<network>/<kind>
+		uint8_t qos = (header >> 1) & 0x03;
+		size_t topicLength = message[0] << 8 | message[1];
+		size_t at = 2 + topicLength + (qos > 0 ? 2 : 0);
+		if (at > remaining) continue;
+
+		std::string topic((const char*)&message[2], topicLength);
+		size_t last = topic.rfind('/');
+		size_t middle = last == std::string::npos || last == 0 ? std::string::npos : topic.rfind('/', last - 1);
+
+		if (qos > 0)
+		{
+			uint8_t ack[4] = { 0x40, 0x02, message[2 + topicLength], message[3 + topicLength] };
+			if (!sendAll(fd, ack, sizeof(ack))) break;
+			lastSent = nowMs();
+		}
+
+		if (middle == std::string::npos || topic.size() != last + 2 || remaining - at > PACKET_LEN)
+		{
+			ingestCounters.rejected++;
+			continue;
+		}
+
+		uint16_t network = (uint16_t)atoi(topic.c_str() + middle + 1);
+		ITEM *item = claimItem(ingest, network, true);
+		if (item == nullptr) break;
+
+		item->source = SOURCE_MQTT;
+		item->kind = topic[last + 1];
+		item->network = network;
+		item->length = remaining - at;
+		memcpy(item->data, &message[at], item->length);
+		publishItem(ingest, network);
+		wakeWorkers(ingest);
+	}
+
+	close(fd);
+	return 0;
+}
+
+static void runMqtt(INGEST ingest, std::string broker, std::string root)
+{
+	size_t colon = broker.rfind(':');
+	std::string host = broker.substr(0, colon);
+	std::string port = colon == std::string::npos ? "1883" : broker.substr(colon + 1);
+
+	while (running)
+	{
+		if (mqttSession(ingest, host, port, root) < 0) fprintf(stderr, "MQTT broker %s unreachable\n", broker.c_str());
+		if (running) std::this_thread::sleep_for(std::chrono::milliseconds(MQTT_RETRY_MS));
+	}
+}
+
+// ---- Setup ----
+
+static int bindSocket(int type, uint16_t port)
+{
+	int sock = socket(AF_INET, type, 0);
+	int one = 1;
+	sockaddr_in local = {};
+
+	local.sin_family = AF_INET;
+	local.sin_addr.s_addr = htonl(INADDR_ANY);
+	local.sin_port = htons(port);
+
+	setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	if (type == SOCK_DGRAM) setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+
+	if (sock < 0 || bind(sock, (sockaddr*)&local, sizeof(local)) < 0 || (type == SOCK_STREAM && listen(sock, SOMAXCONN) < 0))
+	{
+		perror("bind");
+		exit(1);
+	}
+
+	// Receive calls time out so the threads notice a stop
+	timeval timeout = { 0, WORKER_POLL_MS * 1000 };
+	setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	return sock;
+}
+
+static bool loadKeys(const char *path)
+{
+	std::ifstream file(path);
+	std::string line;
+
+	if (!file) return false;
+
+	while (std::getline(file, line))
+	{
+		std::istringstream fields(line);
+		unsigned network;
+		std::string key;
+
+		if (line.empty() || line[0] == '#') continue;
+		if (fields >> network >> key) keys[network] = key;
+	}
+
+	return true;
+}
+
+static void totals(unsigned long *values)
+{
+	memset(values, 0, 7 * sizeof(unsigned long));
+
+	for (auto worker : workers)
+	{
+		values[0] += worker->counters.items;
+		values[1] += worker->counters.rounds;
+		values[2] += worker->counters.rows;
+		values[3] += worker->counters.duplicates;
+		values[4] += worker->counters.rejected;
+		values[6] += worker->counters.alerts;
+	}
+	values[4] += ingestCounters.rejected;
+	values[5] = ingestCounters.dropped;
+}
+
+int main(int argc, char **argv)
+{
+	uint16_t udpPort = DEFAULT_UDP_PORT;
+	uint16_t tcpPort = DEFAULT_TCP_PORT;
+	unsigned udpThreads = 1;
+	unsigned workerCount = std::max(1U, std::thread::hardware_concurrency());
+	unsigned interval = 1;
+	std::string broker;
+	std::string root = DEFAULT_MQTT_ROOT;
+	std::string prefix = "rounds";
+	bool store = false;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "p:t:m:r:u:w:k:o:da:si:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'p': udpPort = atoi(optarg); break;
+			case 't': tcpPort = atoi(optarg); break;
+			case 'm': broker = optarg; break;
+			case 'r': root = optarg; break;
+			case 'u': udpThreads = std::max(1, atoi(optarg)); break;
+			case 'w': workerCount = std::max(1, atoi(optarg)); break;
+			case 'o': prefix = optarg; break;
+			case 'd': store = true; break;
+			case 's': syncWrites = true; break;
+			case 'i': interval = atoi(optarg); break;
+
+			case 'a':
+				if (!rules.load(optarg)) return 1;
+				break;
+
+			case 'k':
+				if (!loadKeys(optarg))
+				{
+					perror(optarg);
+					return 1;
+				}
+				break;
+
+			default:
+				fprintf(stderr, "Usage: %s [-p udp] [-t tcp] [-m broker:port] [-r root] [-u udp threads] [-w workers] [-k keys] [-o prefix] [-d] [-a rules] [-s] [-i seconds]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	unsigned ingestCount = (udpPort ? udpThreads : 0) + (tcpPort ? 1 : 0) + (broker.empty() ? 0 : 1);
+	if (ingestCount == 0)
+	{
+		fprintf(stderr, "Nothing to listen on\n");
+		return 1;
+	}
+
+	for (unsigned i = 0; i < workerCount; i++)
+	{
+		WORKER *worker = new WORKER();
+		std::string path = prefix + "." + std::to_string(i) + ".csv";
+
+		worker->wake = eventfd(0, EFD_NONBLOCK);
+		worker->output = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+		if (worker->output < 0)
+		{
+			perror(path.c_str());
+			return 1;
+		}
+		if (lseek(worker->output, 0, SEEK_END) == 0 && write(worker->output, OUTPUT_HEADER, strlen(OUTPUT_HEADER)) < 0) return 1;
+
+		if (rules.count > 0)
+		{
+			path = prefix + "." + std::to_string(i) + ".alerts";
+			worker->alerts = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+			if (worker->alerts < 0)
+			{
+				perror(path.c_str());
+				return 1;
+			}
+			if (lseek(worker->alerts, 0, SEEK_END) == 0 && write(worker->alerts, ALERTS_HEADER, strlen(ALERTS_HEADER)) < 0) return 1;
+		}
+
+		if (store)
+		{
+			path = prefix + "." + std::to_string(i) + ".tsdb";
+			worker->store = new TSDB_class();
+			if (!worker->store->open(path))
+			{
+				perror(path.c_str());
+				return 1;
+			}
+		}
+
+		for (unsigned j = 0; j < ingestCount; j++) worker->rings.push_back(new RING<ITEM, RING_LEN>());
+		workers.push_back(worker);
+	}
+
+	// Whichever thread takes the signal, they all watch running and time out of their waits
+	struct sigaction action = {};
+	action.sa_handler = stop;
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+
+	std::vector<std::thread> ingestThreads, workerThreads;
+	unsigned index = 0;
+
+	for (unsigned i = 0; i < workerCount; i++) workerThreads.emplace_back(runWorker, workers[i], i);
+
+	for (unsigned i = 0; udpPort && i < udpThreads; i++)
+	{
+		ingestThreads.emplace_back(runUdp, INGEST{ index++, std::vector<bool>(workerCount) }, bindSocket(SOCK_DGRAM, udpPort));
+	}
+	if (tcpPort) ingestThreads.emplace_back(runTcp, INGEST{ index++, std::vector<bool>(workerCount) }, bindSocket(SOCK_STREAM, tcpPort));
+	if (!broker.empty()) ingestThreads.emplace_back(runMqtt, INGEST{ index++, std::vector<bool>(workerCount) }, broker, root);
+
+	fprintf(stderr, "Collector on UDP %u (%u threads), TCP %u, %u workers\n", udpPort, udpThreads, tcpPort, workerCount);
+
+	unsigned long last[7] = {}, now[7];
+	unsigned long started = nowMs(), lastAt = started;
+
+	while (running)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		if (interval == 0 || nowMs() - lastAt < interval * 1000UL) continue;
+
+		totals(now);
+		double seconds = (nowMs() - lastAt) / 1000.0;
+		fprintf(stderr, "%.0f rounds/s %.0f rows/s | rounds=%lu duplicates=%lu rejected=%lu dropped=%lu alerts=%lu\n",
+			(now[1] - last[1]) / seconds, (now[2] - last[2]) / seconds, now[1], now[3], now[4], now[5], now[6]);
+		memcpy(last, now, sizeof(last));
+		lastAt = nowMs();
+	}
+
+	// Ingest first, then the workers drain what was handed over
+	for (auto &thread : ingestThreads) thread.join();
+	for (auto &thread : workerThreads) thread.join();
+
+	totals(now);
+	double seconds = (nowMs() - started) / 1000.0;
+	fprintf(stderr, "items=%lu rounds=%lu rows=%lu duplicates=%lu rejected=%lu dropped=%lu alerts=%lu in %.1f s (%.0f rounds/s)\n",
+		now[0], now[1], now[2], now[3], now[4], now[5], now[6], seconds, now[1] / seconds);
+
+	for (auto worker : workers)
+	{
+		close(worker->output);
+		if (worker->alerts >= 0) close(worker->alerts);
+		delete worker->store;
+	}
+
+	return 0;
+}
@@ -0,0 +1,203 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// Wire formats shared by collectord and loadgen
+//
+// Every ingest path carries the same two payloads, keyed by a network ID (one per basestation):
+//
+//	'r'	Binary round record, exactly what COAP_UPLOADER_class sends (basestation_node/lib/coap_uploader.h)
+//	't'	The round's LoRa frames as they went over the air, RC4 with the network's key:
+//		u32 timestamp, then per frame a length byte and the frame ("TEMP:[*,12.34000,...,12.34000]")
+//
+//	UDP		CoAP POST to /r or /t, followed by /<network> (a bare /r is network 0, the basestation as it is)
+//	TCP		Stream of [u8 kind][u16 network][u16 length][payload], little endian
+//	MQTT	Topic <root>/<network>/<kind>, payload as above
+
+#ifndef ingest_h
+#define ingest_h
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#define KIND_RECORD				'r'
+#define KIND_TEXT				't'
+
+#define COAP_VERSION			1
+#define COAP_TYPE_CON			0
+#define COAP_TYPE_NON			1
+#define COAP_TYPE_ACK			2
+#define COAP_POST				0x02
+#define COAP_CHANGED			0x44		// 2.04
+#define COAP_BAD_REQUEST		0x80		// 4.00
+#define COAP_UNAUTHORIZED		0x81		// 4.01, no key for the network
+#define COAP_NOT_FOUND			0x84		// 4.04
+#define COAP_METHOD_NOT_ALLOWED	0x85		// 4.05
+#define COAP_UNAVAILABLE		0xA3		// 5.03, worker queue full
+#define COAP_OPTION_URI_PATH	11
+#define COAP_PAYLOAD_MARKER		0xFF
+
+#define ROUND_RECORD_VERSION	1
+#define ROUND_HEADER_LEN		6
+#define ROUND_ENTRY_LEN			12
+#define TCP_HEADER_LEN			5
+#define PACKET_LEN				1152
+
+// Round frames, as in basestation_node/lib/lora_module.h
+#define MAX_DEVICES				9
+#define CHECKSUM				8
+#define TEXT_METRICS			5			// TEMP, HUMI, STMP, SMOI, BATT
+#define MAX_MESSAGE_LENGTH		97
+#define BLANK_PLACEHOLDER		'*'
+#define PREDICTED_PLACEHOLDER	'~'
+#define CHECKSUM_EPSILON		0.001		// Looser than the basestation's 0.0001, the sender summed in float
+#define RC4_BYTES				255
+#define DEFAULT_KEY				"G7v!Xz@a?>Qp!d$1"
+
+static const char *textHeaders[TEXT_METRICS] = { "TEMP:", "HUMI:", "STMP:", "SMOI:", "BATT:" };
+
+struct ROUND_ROW
+{
+	uint8_t hwid;
+	uint8_t flags;				// Predicted metrics, bit per metric
+	double values[TEXT_METRICS];
+};
+
+static inline uint16_t get16(const uint8_t *data)
+{
+	return data[0] | data[1] << 8;
+}
+
+static inline uint32_t get32(const uint8_t *data)
+{
+	return get16(data) | (uint32_t)get16(data + 2) << 16;
+}
+
+static inline void put16(uint8_t *data, uint16_t value)
+{
+	data[0] = value;
+	data[1] = value >> 8;
+}
+
+static inline void put32(uint8_t *data, uint32_t value)
+{
+	put16(data, value);
+	put16(data + 2, value >> 16);
+}
+
+// The nodes' RC4 with its 255 byte state, not interchangeable with standard RC4
+static inline void rc4(const std::string &key, uint8_t *data, size_t length)
+{
+	uint8_t S[RC4_BYTES];
+	for (unsigned i = 0; i < RC4_BYTES; i++)
+	{
+		S[i] = i;
+	}
+
+	uint8_t j = 0, temp;
+	for (unsigned i = 0; i < RC4_BYTES; i++)
+	{
+		j = (j + S[i] + key[i % key.size()]) % RC4_BYTES;
+		temp = S[i];
+		S[i] = S[j];
+		S[j] = temp;
+	}
+
+	uint8_t i = 0; j = 0;
+	for (size_t n = 0; n < length; n++)
+	{
+		i = (i + 1) % RC4_BYTES;
+		j = (j + S[i]) % RC4_BYTES;
+		temp = S[i];
+		S[i] = S[j];
+		S[j] = temp;
+		data[n] ^= S[(S[i] + S[j]) % RC4_BYTES];
+	}
+}
+
+// One decrypted frame into its 9 slots, same rules as the basestation's checkMessageValidity():
+// '*' blank, '~' predicted, numbers at least two characters, last slot the sum of the others
+static inline bool parseFrame(const char *frame, uint8_t metric, double *values, uint8_t *predicted)
+{
+	const char *at = frame + 5;
+	double sum = 0;
+
+	if (strncmp(frame, textHeaders[metric], 5) != 0 || *at++ != '[') return false;
+	*predicted = 0;
+
+	for (uint8_t slot = 0; slot < MAX_DEVICES; slot++)
+	{
+		const char *end = at;
+		while (*end && *end != ',' && *end != ']') end++;
+
+		if (end - at == 1 && *at == BLANK_PLACEHOLDER)
+		{
+			values[slot] = 0;
+		}
+		else if (end - at == 1 && *at == PREDICTED_PLACEHOLDER)
+		{
+			values[slot] = 0;
+			*predicted |= 1 << slot;
+		}
+		else
+		{
+			char *parsed;
+
+			if (end - at < 2) return false;
+			values[slot] = strtod(at, &parsed);
+			if (parsed != end) return false;
+		}
+
+		if (slot < CHECKSUM) sum += values[slot];
+		if (*end != (slot == CHECKSUM ? ']' : ',')) return false;
+		at = end + 1;
+	}
+
+	return *at == '\0' && fabs(sum - values[CHECKSUM]) <= CHECKSUM_EPSILON;
+}
+
+// Writes one frame the way a basestation relays it, returns its length
+static inline size_t buildFrame(char *frame, uint8_t metric, const double *values, uint8_t predicted)
+{
+	size_t pos = snprintf(frame, MAX_MESSAGE_LENGTH, "%s[", textHeaders[metric]);
+	double sum = 0;
+
+	for (uint8_t slot = 0; slot < CHECKSUM; slot++)
+	{
+		if (predicted & (1 << slot)) pos += snprintf(&frame[pos], MAX_MESSAGE_LENGTH - pos, "%c,", PREDICTED_PLACEHOLDER);
+		else if (values[slot] == 0) pos += snprintf(&frame[pos], MAX_MESSAGE_LENGTH - pos, "%c,", BLANK_PLACEHOLDER);
+		else if (metric == 3) pos += snprintf(&frame[pos], MAX_MESSAGE_LENGTH - pos, "%02lu,", (unsigned long)values[slot]);
+		else pos += snprintf(&frame[pos], MAX_MESSAGE_LENGTH - pos, "%.5f,", values[slot]);
+
+		if (!(predicted & (1 << slot))) sum += values[slot];
+	}
+
+	if (metric == 3) pos += snprintf(&frame[pos], MAX_MESSAGE_LENGTH - pos, "%02lu]", (unsigned long)sum);
+	else pos += snprintf(&frame[pos], MAX_MESSAGE_LENGTH - pos, "%.5f]", sum);
+
+	return pos;
+}
+
+#endif
@@ -0,0 +1,561 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// Load generator for collectord, synthetic basestations sending a round every hour, sped up
+//
+// Build:	g++ -std=c++17 -O2 -Wall -pthread -o loadgen loadgen.cpp
+// Usage:	./loadgen [-T udp|tcp|mqtt] [-f r|t] [-H 127.0.0.1] [-p port] [-b 1000] [-x 100] [-d 4]
+//			          [-s 10] [-t 4] [-n 1] [-w 256] [-k keys.txt] [-r collector]
+//
+//	-T	Transport, the collector's own ports by default (5683, 5684), or a broker on 1883 for mqtt
+//	-f	'r' binary round records, 't' encrypted LoRa frames
+//	-b	Basestations, network IDs -n onwards		-x	Times real rate, 0 sends as fast as it can
+//	-d	Devices per basestation					-s	Seconds to run
+//	-t	Sending threads, basestations split between them
+//	-w	Unacknowledged CoAP requests per thread with -x 0
+//
+// Each round has its own timestamp, an hour after the basestation's previous one, so none of them
+// are taken for duplicates. Raise -b or set -x 0 until acked/s stops following sent/s, that is
+// the ceiling. Over UDP every request is confirmable and its ACK timed; TCP and MQTT have no
+// acknowledgement from the collector, compare with its own rounds/s there.
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <ctime>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "ingest.h"
+
+#define ROUND_INTERVAL_S		3600
+#define DEFAULT_WINDOW			256
+#define ACK_TIMEOUT_US			2000000		// An unanswered request counts as lost after this
+#define MAX_SAMPLES				200000		// RTT samples kept per thread
+#define MQTT_KEEP_ALIVE			60
+
+struct alignas(64) THREAD_STATS
+{
+	std::atomic<unsigned long> sent{0};
+	std::atomic<unsigned long> acked{0};
+	std::atomic<unsigned long> refused{0};		// Answered, but not 2.04
+	std::atomic<unsigned long> lost{0};
+	std::atomic<unsigned long> bytes{0};
+	std::vector<uint32_t> rtt;					// Microseconds
+};
+
+struct SETTINGS
+{
+	std::string transport = "udp";
+	char format = KIND_RECORD;
+	std::string host = "127.0.0.1";
+	std::string port;
+	std::string root = "collector";
+	unsigned basestations = 1000;
+	double speed = 100;
+	unsigned devices = 4;
+	unsigned seconds = 10;
+	unsigned threads = 4;
+	unsigned firstNetwork = 1;
+	unsigned window = DEFAULT_WINDOW;
+};
+
+static SETTINGS settings;
+static std::unordered_map<uint16_t, std::string> keys;
+static std::atomic<bool> running{true};
+static uint32_t startEpoch;
+
+static void stop(int)
+{
+	running = false;
+}
+
+static uint64_t nowUs()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// One round's payload, binary record or the five frames a basestation relays
+static size_t buildRound(uint8_t *out, uint16_t network, uint32_t timestamp, std::mt19937 &random)
+{
+	std::uniform_real_distribution<double> temperature(-5, 15), humidity(40, 99), soil(0, 12), battery(3.5, 4.2);
+	std::uniform_int_distribution<int> moisture(10, 80), predict(0, 9);
+	double values[TEXT_METRICS][CHECKSUM] = {};
+	uint8_t predicted[TEXT_METRICS] = {};
+
+	// Odd HW IDs like the field deployment, the odd predicted slot like nodes inside their bounds
+	for (unsigned i = 0; i < settings.devices && i < CHECKSUM / 2; i++)
+	{
+		uint8_t slot = 2 * i + 1;
+
+		values[0][slot] = round(temperature(random) * 100) / 100;
+		values[1][slot] = round(humidity(random) * 100) / 100;
+		values[2][slot] = round(soil(random) * 100) / 100;
+		values[3][slot] = moisture(random);
+		values[4][slot] = round(battery(random) * 1000) / 1000;
+
+		for (uint8_t metric = 0; metric < TEXT_METRICS; metric++)
+		{
+			if (values[metric][slot] == 0) values[metric][slot] = 1;
+			if (predict(random) == 0) predicted[metric] |= 1 << slot;
+		}
+	}
+
+	if (settings.format == KIND_RECORD)
+	{
+		uint8_t count = 0;
+
+		for (uint8_t slot = 0; slot < CHECKSUM; slot++)
+		{
+			if (values[0][slot] == 0) continue;
+
+			uint8_t *entry = out + ROUND_HEADER_LEN + count++ * ROUND_ENTRY_LEN;
+			uint8_t flags = 0;
+			for (uint8_t metric = 0; metric < TEXT_METRICS; metric++) flags |= (predicted[metric] >> slot & 1) << metric;
+
+			entry[0] = slot;
+			entry[1] = flags;
+			put16(entry + 2, (int16_t)lround(values[0][slot] * 100));
+			put16(entry + 4, (uint16_t)lround(values[1][slot] * 100));
+			put16(entry + 6, (int16_t)lround(values[2][slot] * 100));
+			put16(entry + 8, (uint16_t)values[3][slot]);
+			put16(entry + 10, (uint16_t)lround(values[4][slot] * 1000));
+		}
+
+		out[0] = ROUND_RECORD_VERSION;
+		out[1] = count;
+		put32(out + 2, timestamp);
+
+		return ROUND_HEADER_LEN + count * ROUND_ENTRY_LEN;
+	}
+
+	auto found = keys.find(network);
+	const std::string key = found != keys.end() ? found->second : DEFAULT_KEY;
+	size_t length = 4;
+
+	put32(out, timestamp);
+	for (uint8_t metric = 0; metric < TEXT_METRICS; metric++)
+	{
+		char frame[MAX_MESSAGE_LENGTH];
+		size_t frameLength = buildFrame(frame, metric, values[metric], predicted[metric]);
+
+		rc4(key, (uint8_t*)frame, frameLength);
+		out[length++] = frameLength;
+		memcpy(&out[length], frame, frameLength);
+		length += frameLength;
+	}
+
+	return length;
+}
+
+// CoAP POST /<format>/<network>, token is the message ID
+static size_t buildCoap(uint8_t *packet, uint16_t messageId, uint16_t network, const uint8_t *payload, size_t length)
+{
+	std::string segment = std::to_string(network);
+	size_t at = 0;
+
+	packet[at++] = (COAP_VERSION << 6) | (COAP_TYPE_CON << 4) | 2;
+	packet[at++] = COAP_POST;
+	packet[at++] = messageId >> 8;
+	packet[at++] = messageId;
+	packet[at++] = messageId >> 8;
+	packet[at++] = messageId;
+	packet[at++] = (COAP_OPTION_URI_PATH << 4) | 1;
+	packet[at++] = settings.format;
+	packet[at++] = segment.size();
+	memcpy(&packet[at], segment.data(), segment.size());
+	at += segment.size();
+	packet[at++] = COAP_PAYLOAD_MARKER;
+	memcpy(&packet[at], payload, length);
+
+	return at + length;
+}
+
+static int connectTo(int type)
+{
+	addrinfo hints = {}, *result;
+	int fd = -1;
+
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = type;
+	if (getaddrinfo(settings.host.c_str(), settings.port.c_str(), &hints, &result) != 0) return -1;
+
+	for (addrinfo *at = result; at != NULL && fd < 0; at = at->ai_next)
+	{
+		fd = socket(at->ai_family, at->ai_socktype, at->ai_protocol);
+		if (fd >= 0 && connect(fd, at->ai_addr, at->ai_addrlen) < 0)
+		{
+			close(fd);
+			fd = -1;
+		}
+	}
+	freeaddrinfo(result);
+
+	int one = 1;
+	if (fd >= 0 && type == SOCK_STREAM) setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+	return fd;
+}
+
+static bool sendAll(int fd, const uint8_t *data, size_t length)
+{
+	while (length > 0)
+	{
+		ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+		if (sent <= 0) return false;
+		data += sent;
+		length -= sent;
+	}
+
+	return true;
+}
+
+static void appendRemaining(std::vector<uint8_t> &packet, size_t remaining)
+{
+	do
+	{
+		uint8_t digit = remaining % 128;
+		remaining /= 128;
+		packet.push_back(remaining > 0 ? digit | 0x80 : digit);
+	} while (remaining > 0);
+}
+
+static bool mqttConnect(int fd, unsigned index)
+{
+	std::string clientId = "loadgen-" + std::to_string(getpid()) + "-" + std::to_string(index);
+	std::vector<uint8_t> packet = { 0x10 };
+	std::vector<uint8_t> body = { 0, 4, 'M', 'Q', 'T', 'T', 4, 0x02, 0, MQTT_KEEP_ALIVE };
+	uint8_t reply[4];
+
+	body.push_back(clientId.size() >> 8);
+	body.push_back(clientId.size());
+	body.insert(body.end(), clientId.begin(), clientId.end());
+	appendRemaining(packet, body.size());
+	packet.insert(packet.end(), body.begin(), body.end());
+
+	return sendAll(fd, packet.data(), packet.size()) && recv(fd, reply, sizeof(reply), MSG_WAITALL) == 4 && reply[0] == 0x20 && reply[3] == 0;
+}
+
+// Takes every ACK waiting on the socket
+static void collectAcks(int fd, THREAD_STATS &stats, std::vector<uint64_t> &sentAt, unsigned &outstanding)
+{
+	uint8_t reply[64];
+	ssize_t length;
+
+	while ((length = recv(fd, reply, sizeof(reply), MSG_DONTWAIT)) >= 4)
+	{
+		uint16_t messageId = reply[2] << 8 | reply[3];
+		if (sentAt[messageId] == 0) continue;
+
+		uint64_t rtt = nowUs() - sentAt[messageId];
+		sentAt[messageId] = 0;
+		outstanding--;
+
+		if (reply[1] == COAP_CHANGED) stats.acked++;
+		else stats.refused++;
+		if (stats.rtt.size() < MAX_SAMPLES) stats.rtt.push_back(rtt);
+	}
+}
+
+// Outstanding requests past ACK_TIMEOUT_US are written off
+static void expireAcks(THREAD_STATS &stats, std::vector<uint64_t> &sentAt, unsigned &outstanding)
+{
+	uint64_t now = nowUs();
+
+	for (auto &at : sentAt)
+	{
+		if (at != 0 && now - at > ACK_TIMEOUT_US)
+		{
+			at = 0;
+			outstanding--;
+			stats.lost++;
+		}
+	}
+}
+
+static void runThread(unsigned index, THREAD_STATS *stats)
+{
+	std::mt19937 random(index * 7919 + 1);
+	std::vector<uint16_t> networks;
+	std::vector<uint32_t> roundsSent;
+	std::vector<uint64_t> sentAt(0x10000, 0);
+	unsigned outstanding = 0;
+	uint16_t messageId = random();
+	uint8_t payload[PACKET_LEN], packet[PACKET_LEN + 64];
+	bool udp = settings.transport == "udp";
+	bool mqtt = settings.transport == "mqtt";
+
+	for (unsigned b = index; b < settings.basestations; b += settings.threads) networks.push_back(settings.firstNetwork + b);
+	roundsSent.assign(networks.size(), 0);
+	if (networks.empty()) return;
+
+	int fd = connectTo(udp ? SOCK_DGRAM : SOCK_STREAM);
+	if (fd < 0 || (mqtt && !mqttConnect(fd, index)))
+	{
+		fprintf(stderr, "Thread %u cannot reach %s:%s\n", index, settings.host.c_str(), settings.port.c_str());
+		return;
+	}
+
+	// This thread's basestations take turns, evenly spread over the round interval
+	double perRoundUs = settings.speed > 0 ? ROUND_INTERVAL_S * 1e6 / settings.speed / networks.size() : 0;
+	uint64_t start = nowUs() + (uint64_t)(perRoundUs * index / settings.threads);
+	uint64_t lastExpire = start;
+	size_t turn = 0;
+
+	while (running)
+	{
+		uint64_t now = nowUs();
+
+		if (udp)
+		{
+			collectAcks(fd, *stats, sentAt, outstanding);
+			if (now - lastExpire > ACK_TIMEOUT_US / 4)
+			{
+				expireAcks(*stats, sentAt, outstanding);
+				lastExpire = now;
+			}
+		}
+
+		// Paced, or with -x 0 held to the window of requests waiting on their ACK
+		if (perRoundUs > 0 && now < start + (uint64_t)(perRoundUs * stats->sent))
+		{
+			pollfd wait = { fd, POLLIN, 0 };
+			poll(&wait, 1, 1);
+			continue;
+		}
+		if (perRoundUs == 0 && udp && outstanding >= settings.window)
+		{
+			pollfd wait = { fd, POLLIN, 0 };
+			poll(&wait, 1, 1);
+			continue;
+		}
+
+		uint16_t network = networks[turn];
+		uint32_t timestamp = startEpoch + roundsSent[turn]++ * ROUND_INTERVAL_S;
+		size_t length = buildRound(payload, network, timestamp, random);
+		size_t size;
+		bool sent;
+		turn = (turn + 1) % networks.size();
+
+		if (udp)
+		{
+			messageId++;
+			if (sentAt[messageId] != 0)
+			{
+				outstanding--;
+				stats->lost++;
+			}
+			size = buildCoap(packet, messageId, network, payload, length);
+			sent = send(fd, packet, size, 0) == (ssize_t)size;
+			if (sent)
+			{
+				sentAt[messageId] = nowUs();
+				outstanding++;
+			}
+		}
+		else if (mqtt)
+		{
+			// QoS 0 PUBLISH to <root>/<network>/<format>
+			std::string topic = settings.root + "/" + std::to_string(network) + "/" + settings.format;
+			std::vector<uint8_t> message = { 0x30 };
+
+			appendRemaining(message, 2 + topic.size() + length);
+			message.push_back(topic.size() >> 8);
+			message.push_back(topic.size());
+			message.insert(message.end(), topic.begin(), topic.end());
+			message.insert(message.end(), payload, payload + length);
+			size = message.size();
+			sent = sendAll(fd, message.data(), size);
+		}
+		else
+		{
+			packet[0] = settings.format;
+			put16(packet + 1, network);
+			put16(packet + 3, length);
+			memcpy(packet + TCP_HEADER_LEN, payload, length);
+			size = TCP_HEADER_LEN + length;
+			sent = sendAll(fd, packet, size);
+		}
+
+		if (!sent)
+		{
+			fprintf(stderr, "Thread %u: send failed: %s\n", index, strerror(errno));
+			break;
+		}
+
+		stats->sent++;
+		stats->bytes += size;
+	}
+
+	// Stragglers get their chance to be acknowledged
+	uint64_t drainUntil = nowUs() + ACK_TIMEOUT_US;
+	while (udp && outstanding > 0 && nowUs() < drainUntil)
+	{
+		pollfd wait = { fd, POLLIN, 0 };
+		poll(&wait, 1, 10);
+		collectAcks(fd, *stats, sentAt, outstanding);
+	}
+	if (udp) stats->lost += outstanding;
+
+	close(fd);
+}
+
+static bool loadKeys(const char *path)
+{
+	std::ifstream file(path);
+	std::string line;
+
+	if (!file) return false;
+
+	while (std::getline(file, line))
+	{
+		std::istringstream fields(line);
+		unsigned network;
+		std::string key;
+
+		if (line.empty() || line[0] == '#') continue;
+		if (fields >> network >> key) keys[network] = key;
+	}
+
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	int opt;
+
+	while ((opt = getopt(argc, argv, "T:f:H:p:b:x:d:s:t:n:w:k:r:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'T': settings.transport = optarg; break;
+			case 'f': settings.format = optarg[0]; break;
+			case 'H': settings.host = optarg; break;
+			case 'p': settings.port = optarg; break;
+			case 'b': settings.basestations = std::max(1, atoi(optarg)); break;
+			case 'x': settings.speed = atof(optarg); break;
+			case 'd': settings.devices = std::min(std::max(1, atoi(optarg)), CHECKSUM / 2); break;
+			case 's': settings.seconds = atoi(optarg); break;
+			case 't': settings.threads = std::max(1, atoi(optarg)); break;
+			case 'n': settings.firstNetwork = atoi(optarg); break;
+			case 'w': settings.window = std::max(1, atoi(optarg)); break;
+			case 'r': settings.root = optarg; break;
+
+			case 'k':
+				if (!loadKeys(optarg))
+				{
+					perror(optarg);
+					return 1;
+				}
+				break;
+
+			default:
+				fprintf(stderr, "Usage: %s [-T udp|tcp|mqtt] [-f r|t] [-H host] [-p port] [-b basestations] [-x speed] [-d devices] [-s seconds] [-t threads] [-n first network] [-w window] [-k keys] [-r root]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	if ((settings.transport != "udp" && settings.transport != "tcp" && settings.transport != "mqtt") || (settings.format != KIND_RECORD && settings.format != KIND_TEXT))
+	{
+		fprintf(stderr, "Unknown transport or format\n");
+		return 1;
+	}
+	if (settings.port.empty()) settings.port = settings.transport == "udp" ? "5683" : settings.transport == "tcp" ? "5684" : "1883";
+
+	struct sigaction action = {};
+	action.sa_handler = stop;
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+
+	// Rounds start on the hour, a year back, so they never collide with real ones
+	startEpoch = (time(NULL) - 365 * 24 * 3600UL) / ROUND_INTERVAL_S * ROUND_INTERVAL_S;
+
+	double offered = settings.basestations * settings.speed / ROUND_INTERVAL_S;
+	if (settings.speed > 0) fprintf(stderr, "%u basestations at %gx: %.1f rounds/s offered over %s\n", settings.basestations, settings.speed, offered, settings.transport.c_str());
+	else fprintf(stderr, "%u basestations as fast as possible over %s\n", settings.basestations, settings.transport.c_str());
+
+	std::vector<THREAD_STATS> stats(settings.threads);
+	std::vector<std::thread> threads;
+	for (unsigned i = 0; i < settings.threads; i++) threads.emplace_back(runThread, i, &stats[i]);
+
+	uint64_t started = nowUs(), lastAt = started;
+	unsigned long lastSent = 0, lastAcked = 0;
+
+	while (running && nowUs() - started < settings.seconds * 1000000ULL)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+
+		unsigned long sent = 0, acked = 0;
+		for (auto &s : stats)
+		{
+			sent += s.sent;
+			acked += s.acked;
+		}
+
+		double seconds = (nowUs() - lastAt) / 1e6;
+		if (settings.transport == "udp") fprintf(stderr, "sent %.0f/s acked %.0f/s\n", (sent - lastSent) / seconds, (acked - lastAcked) / seconds);
+		else fprintf(stderr, "sent %.0f/s\n", (sent - lastSent) / seconds);
+
+		lastSent = sent;
+		lastAcked = acked;
+		lastAt = nowUs();
+	}
+
+	double seconds = (nowUs() - started) / 1e6;
+	running = false;
+	for (auto &thread : threads) thread.join();
+
+	unsigned long sent = 0, acked = 0, refused = 0, lost = 0, bytes = 0;
+	std::vector<uint32_t> rtt;
+	for (auto &s : stats)
+	{
+		sent += s.sent;
+		acked += s.acked;
+		refused += s.refused;
+		lost += s.lost;
+		bytes += s.bytes;
+		rtt.insert(rtt.end(), s.rtt.begin(), s.rtt.end());
+	}
+
+	printf("transport=%s format=%c sent=%lu rounds (%.0f/s, %.2f MB/s)", settings.transport.c_str(), settings.format, sent, sent / seconds, bytes / seconds / 1e6);
+	if (settings.transport == "udp")
+	{
+		std::sort(rtt.begin(), rtt.end());
+		printf(" acked=%lu (%.0f/s) refused=%lu lost=%lu", acked, acked / seconds, refused, lost);
+		if (!rtt.empty()) printf(" rtt_p50=%.2fms rtt_p99=%.2fms", rtt[rtt.size() / 2] / 1000.0, rtt[rtt.size() * 99 / 100] / 1000.0);
+	}
+	printf("\n");
+
+	return 0;
+}
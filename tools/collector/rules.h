@@ -0,0 +1,284 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// Alert rules evaluated on each round as collectord takes it in
+//
+// A rules file has one rule per line, '#' starts a comment:
+//
+//	<name> <metric> <test> [value] [x<rounds>]
+//
+//	metric		temp, humi, stmp, smoi, batt, or node for missed
+//	above v		Reading over v						below v		Reading under v
+//	rise v		Climbing faster than v per hour		fall v		Dropping faster than v per hour
+//	flat v		Within v of the node's last reading, a stuck sensor
+//	missed		The node was heard before but is not in this round
+//	x<rounds>	Rounds in a row the test has to hold before the rule fires, 1 by default
+//
+// A rule fires once when its run reaches the count and clears the first round the test fails
+// again, so a battery sitting under its threshold is one alert and not one an hour.
+//
+// load() compiles the rules to a flat plan: steps grouped by metric, each step only the test,
+// its value, its count and the rule's bit. A round walks the steps for the metrics it carries and
+// touches nothing but each node's small state, a last reading per metric and a run counter per
+// rule, so it costs the same in the first hour as after years and never looks at history.
+// Predicted readings are not tested, a node whose readings are all predicted was not heard.
+
+#ifndef rules_h
+#define rules_h
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "ingest.h"
+
+#define MAX_RULES				64			// A bit each in NODE_ALERTS::active
+#define RULE_NAME_LENGTH		24
+#define ALL_PREDICTED			((1 << TEXT_METRICS) - 1)
+#define RULE_NODE				TEXT_METRICS	// Metric slot of the per node tests
+
+#define TEST_ABOVE				0
+#define TEST_BELOW				1
+#define TEST_RISE				2
+#define TEST_FALL				3
+#define TEST_FLAT				4
+#define TEST_MISSED				5
+
+static const char *const ruleMetrics[TEXT_METRICS + 1] = { "temp", "humi", "stmp", "smoi", "batt", "node" };
+static const char *const ruleTests[] = { "above", "below", "rise", "fall", "flat", "missed" };
+static const uint8_t ruleDecimals[TEXT_METRICS + 1] = { 2, 2, 2, 0, 3, 0 };
+
+struct PLAN_STEP
+{
+	uint8_t test;
+	uint8_t rule;
+	uint16_t rounds;
+	float value;
+};
+
+struct NODE_ALERTS
+{
+	uint8_t hwid;
+	uint8_t known = 0;							// Metrics with a last reading
+	uint32_t lastRound = 0;
+	uint32_t lastAt[TEXT_METRICS] = {};
+	float last[TEXT_METRICS] = {};
+	uint64_t active = 0;						// Rules firing, by bit
+	uint16_t runs[MAX_RULES] = {};
+};
+
+class RULES_class
+{
+	private:
+		char _names[MAX_RULES][RULE_NAME_LENGTH];
+		uint8_t _metrics[MAX_RULES];
+		std::vector<PLAN_STEP> _plan;
+		uint16_t _start[RULE_NODE + 2] = {};		// Steps of metric m are _plan[_start[m], _start[m + 1])
+
+		void emit(std::string &alerts, uint32_t timestamp, uint16_t network, uint8_t hwid, uint8_t rule, bool firing, double value)
+		{
+			char line[384];
+			char when[21];
+			time_t t = timestamp;
+			struct tm timeInfo;
+
+			gmtime_r(&t, &timeInfo);
+			strftime(when, sizeof(when), "%Y-%m-%dT%H:%M:%SZ", &timeInfo);
+
+			snprintf(line, sizeof(line), "%s,%u,%u,%s,%s,%.*f\n", when, network, hwid, _names[rule], firing ? "fire" : "clear", ruleDecimals[_metrics[rule]], value);
+			alerts += line;
+		}
+
+		// Counts the run and reports the edges, nothing while a rule stays where it was
+		bool step(NODE_ALERTS &node, const PLAN_STEP &step, bool holds, std::string &alerts, uint32_t timestamp, uint16_t network, double value)
+		{
+			uint64_t bit = 1ULL << step.rule;
+
+			if (!holds)
+			{
+				node.runs[step.rule] = 0;
+				if (!(node.active & bit)) return false;
+
+				node.active &= ~bit;
+				emit(alerts, timestamp, network, node.hwid, step.rule, false, value);
+				return true;
+			}
+
+			if (node.runs[step.rule] < UINT16_MAX) node.runs[step.rule]++;
+			if (node.runs[step.rule] < step.rounds || (node.active & bit)) return false;
+
+			node.active |= bit;
+			emit(alerts, timestamp, network, node.hwid, step.rule, true, value);
+			return true;
+		}
+
+	public:
+		size_t count = 0;
+
+		// Parses and compiles, says what is wrong on stderr and returns false
+		bool load(const char *path)
+		{
+			std::ifstream file(path);
+			std::vector<PLAN_STEP> byMetric[RULE_NODE + 1];
+			std::string line;
+			unsigned number = 0;
+
+			if (!file)
+			{
+				perror(path);
+				return false;
+			}
+
+			while (std::getline(file, line))
+			{
+				std::stringstream fields(line.substr(0, line.find('#')));
+				std::string name, metric, test, token;
+				PLAN_STEP step = {};
+				uint8_t m = 0;
+
+				number++;
+				if (!(fields >> name)) continue;
+
+				step.rounds = 1;
+				fields >> metric >> test;
+				while (m <= RULE_NODE && metric != ruleMetrics[m]) m++;
+				while (step.test <= TEST_MISSED && test != ruleTests[step.test]) step.test++;
+
+				bool valid = m <= RULE_NODE && step.test <= TEST_MISSED && (m == RULE_NODE) == (step.test == TEST_MISSED);
+				bool hasValue = false;
+
+				while (valid && fields >> token)
+				{
+					char *end;
+
+					if (token[0] == 'x') step.rounds = strtoul(token.c_str() + 1, &end, 10);
+					else
+					{
+						step.value = strtof(token.c_str(), &end);
+						hasValue = true;
+					}
+					valid = *end == '\0' && step.rounds > 0;
+				}
+				if (step.test != TEST_MISSED && !hasValue) valid = false;
+
+				if (!valid || count == MAX_RULES || name.size() >= RULE_NAME_LENGTH)
+				{
+					fprintf(stderr, "%s:%u: %s\n", path, number, count == MAX_RULES ? "too many rules" : "not a rule");
+					return false;
+				}
+
+				step.rule = count;
+				strcpy(_names[count], name.c_str());
+				_metrics[count] = m;
+				byMetric[m].push_back(step);
+				count++;
+			}
+
+			for (uint8_t m = 0; m <= RULE_NODE; m++)
+			{
+				_start[m] = _plan.size();
+				_plan.insert(_plan.end(), byMetric[m].begin(), byMetric[m].end());
+			}
+			_start[RULE_NODE + 1] = _plan.size();
+
+			return true;
+		}
+
+		// One round of a network: its rows, and the state of every node the network has had.
+		// Returns the alerts raised, appended to alerts as time,network,hwid,rule,fire|clear,value lines.
+		size_t round(std::vector<NODE_ALERTS> &nodes, uint16_t network, uint32_t timestamp, const ROUND_ROW *rows, size_t rowCount, std::string &alerts)
+		{
+			size_t raised = 0;
+
+			// A late round is history by now, alerting on it would only undo the present
+			for (const NODE_ALERTS &node : nodes)
+			{
+				if (node.lastRound >= timestamp) return 0;
+			}
+
+			for (size_t r = 0; r < rowCount; r++)
+			{
+				const ROUND_ROW &row = rows[r];
+				NODE_ALERTS *node = nullptr;
+
+				if (row.flags == ALL_PREDICTED) continue;
+
+				for (NODE_ALERTS &candidate : nodes)
+				{
+					if (candidate.hwid == row.hwid) node = &candidate;
+				}
+				if (node == nullptr)
+				{
+					nodes.emplace_back();
+					node = &nodes.back();
+					node->hwid = row.hwid;
+				}
+
+				node->lastRound = timestamp;
+
+				for (uint8_t m = 0; m < TEXT_METRICS; m++)
+				{
+					if (row.flags & (1 << m)) continue;
+
+					double value = row.values[m];
+					bool known = node->known & (1 << m);
+					double change = value - node->last[m];
+					double rate = known ? change * 3600 / (timestamp - node->lastAt[m]) : 0;
+
+					for (uint16_t s = _start[m]; s < _start[m + 1]; s++)
+					{
+						const PLAN_STEP &plan = _plan[s];
+						bool holds = false;
+
+						switch (plan.test)
+						{
+							case TEST_ABOVE: holds = value > plan.value; break;
+							case TEST_BELOW: holds = value < plan.value; break;
+							case TEST_RISE: holds = known && rate > plan.value; break;
+							case TEST_FALL: holds = known && rate < -plan.value; break;
+							case TEST_FLAT: holds = known && fabs(change) <= plan.value; break;
+						}
+						raised += step(*node, plan, holds, alerts, timestamp, network, value);
+					}
+
+					node->last[m] = value;
+					node->lastAt[m] = timestamp;
+					node->known |= 1 << m;
+				}
+			}
+
+			// Whoever was not in the round, the value of a missed alert is the rounds missed so far
+			for (NODE_ALERTS &node : nodes)
+			{
+				bool missed = node.lastRound < timestamp;
+
+				for (uint16_t s = _start[RULE_NODE]; s < _start[RULE_NODE + 1]; s++)
+				{
+					raised += step(node, _plan[s], missed, alerts, timestamp, network, node.runs[_plan[s].rule] + missed);
+				}
+			}
+
+			return raised;
+		}
+};
+
+#endif
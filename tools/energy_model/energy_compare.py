@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+"""
+Runs energy_model.cpp against two or more versions of the node firmware and compares what they draw.
+
+    python3 energy_compare.py main .                        # main against the working tree
+    python3 energy_compare.py main.json . -H 336            # a saved report against the working tree
+    python3 energy_compare.py main HEAD --threshold 2       # exit 1 if HEAD draws 2 % more than main
+
+Each version is a git revision, "." for the working tree, or a JSON report from an earlier run
+(energy_model -j, or --output here). Revisions are checked out into a temporary worktree and the
+current tools/energy_model is built against their system_node/lib, so only the firmware differs
+between the builds. Every build runs with the same options and the same simulated weather.
+
+Percentages are against the first version. Needs g++ with C++17.
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+REPO = os.path.normpath(os.path.join(HERE, "..", ".."))
+
+COMPONENTS = ["mcu", "radio", "sensors", "openlog", "flash", "board", "total"]
+COUNTERS = ["rtc_wakes", "lora_wakes", "frames_sent", "frames_received", "frames_missed", "eeprom_writes", "uart_bytes"]
+
+
+def build(tree, defines, output):
+    command = [os.environ.get("CXX", "g++"), "-std=gnu++17", "-O2", "-Wall",
+               "-I" + os.path.join(HERE, "shim"), "-I" + os.path.join(tree, "system_node", "lib")]
+    command += ["-D" + define for define in defines]
+    command += ["-o", output, os.path.join(HERE, "energy_model.cpp")]
+    subprocess.run(command, check=True)
+    return output
+
+
+def simulate(binary, args, workdir):
+    report = os.path.join(workdir, "report.json")
+    subprocess.run([binary, "-H", str(args.hours), "-i", str(args.hwid), "-n", str(args.neighbours),
+                    "-c", args.currents, "-C", str(args.capacity), "-u", str(args.usable),
+                    "-b", str(args.battery), "-j", report], check=True, stdout=subprocess.DEVNULL)
+    with open(report) as file:
+        return json.load(file)
+
+
+def measure(version, args, workdir):
+    if version.endswith(".json"):
+        with open(version) as file:
+            return json.load(file)
+
+    binary = os.path.join(workdir, "energy_model")
+    if version == ".":
+        return simulate(build(REPO, args.define, binary), args, workdir)
+
+    # A detached worktree keeps the checkout out of the way of whatever is open here
+    tree = os.path.join(workdir, "tree")
+    subprocess.run(["git", "-C", REPO, "worktree", "add", "--detach", "--quiet", tree, version], check=True)
+    try:
+        return simulate(build(tree, args.define, binary), args, workdir)
+    finally:
+        subprocess.run(["git", "-C", REPO, "worktree", "remove", "--force", tree], check=True)
+
+
+def compare(versions, reports, threshold):
+    worse = []
+    first = reports[0]
+
+    def cell(now, before, label):
+        if before in (None, 0) or now is None:
+            return "{:>10.4f} {:>9}".format(now or 0, "")
+        change = 100.0 * (now - before) / before
+        if label and change > threshold:
+            worse.append("{} {:.4f} -> {:.4f} ({:+.1f} %)".format(label, before, now, change))
+        return "{:>10.4f} {:>+8.1f}%".format(now, change)
+
+    print("{:<16}".format("mAh/h") + "".join(" {:>20}".format(version[-20:]) for version in versions))
+    for component in COMPONENTS:
+        row = "{:<16}".format(component)
+        for version, report in zip(versions, reports):
+            label = "{} total".format(version) if component == "total" and report is not first else None
+            row += " " + cell(report["mah_per_hour"].get(component), first["mah_per_hour"].get(component), label)
+        print(row)
+
+    row = "{:<16}".format("lifetime days")
+    for report in reports:
+        row += " " + cell(report["lifetime_days"], first["lifetime_days"], None)
+    print(row)
+
+    for counter in COUNTERS:
+        row = "{:<16}".format(counter)
+        for report in reports:
+            row += " {:>20}".format(report["counters"].get(counter, "-"))
+        print(row)
+
+    return worse
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("versions", nargs="+", help="Git revision, '.' for the working tree, or a report JSON")
+    parser.add_argument("-H", "--hours", type=float, default=168, help="Simulated hours")
+    parser.add_argument("-i", "--hwid", type=int, default=1)
+    parser.add_argument("-n", "--neighbours", type=int, default=3)
+    parser.add_argument("-c", "--currents", default=os.path.join(HERE, "currents.txt"))
+    parser.add_argument("-C", "--capacity", type=float, default=3000, help="Battery capacity in mAh")
+    parser.add_argument("-u", "--usable", type=float, default=0.85, help="Share of the capacity above the cutoff")
+    parser.add_argument("-b", "--battery", type=float, default=3.9, help="Battery voltage the node reads")
+    parser.add_argument("-D", "--define", action="append", default=[], help="Extra firmware define, e.g. FLASH_LOGGING")
+    parser.add_argument("--output", "-o", help="Write the last version's report here")
+    parser.add_argument("--threshold", type=float, default=1.0, help="Percent growth in total mAh/h that fails the run")
+    args = parser.parse_args()
+    args.currents = os.path.abspath(args.currents)
+
+    reports = []
+    for version in args.versions:
+        with tempfile.TemporaryDirectory() as workdir:
+            report = measure(version, args, workdir)
+        report.setdefault("version", version)
+        reports.append(report)
+
+    if args.output:
+        with open(args.output, "w") as file:
+            json.dump(reports[-1], file, indent=2)
+
+    worse = compare(args.versions, reports, args.threshold)
+    for line in worse:
+        print("worse: " + line)
+    sys.exit(1 if worse else 0)
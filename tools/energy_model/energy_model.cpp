@@ -0,0 +1,293 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// Runs the node's firmware on a simulated board for days of simulated time and adds up where the
+// battery goes
+//
+// Build:	g++ -std=gnu++17 -O2 -Wall -Ishim -I../../system_node/lib -o energy_model energy_model.cpp
+// Usage:	./energy_model [-H hours] [-i hwid] [-n neighbours] [-c currents.txt] [-C capacity_mah]
+//			[-u usable] [-b battery_volts] [-d rtc_ppm] [-s start_epoch] [-t trace.csv] [-j report.json] [-v]
+//
+// The firmware is system_node.hpp exactly as the node builds it, toggles and all. shim/ stands in
+// for the Arduino core and the libraries, and every call that takes time or moves a part between
+// power states lands on the board in sim_board.h. Each state's time is multiplied by its current
+// from currents.txt, so a firmware change shows up as the mAh it costs or saves, not as a guess.
+//
+// -d runs the DS3231's crystal that many ppm fast (negative: slow), for the firmware to trim.
+// -t writes every state change as time,component,state. -v echoes the node's Serial output,
+// which is the DEBUGGING log in a DEBUGGING build.
+// Compare two firmware versions with energy_compare.py.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include <system_node.hpp>
+
+#include "sim_board.h"
+#include "sim_board.cpp"
+#include "sim_rtc.cpp"
+#include "sim_radio.cpp"
+#include "sim_flash.cpp"
+#include "sim_air.cpp"
+#include "sim_arduino.cpp"
+
+#define DEFAULT_HOURS		168
+#define DEFAULT_HWID		1
+#define DEFAULT_NEIGHBOURS	3
+#define DEFAULT_CAPACITY	3000.0		// mAh, one 18650
+#define DEFAULT_USABLE		0.85		// Share of it above BATTERY_LEVEL_CUTOFF
+#define DEFAULT_BATTERY		3.9
+#define DEFAULT_START		1767226200	// 2026-01-01 00:10:00 UTC
+#define CURRENT_LINE		128
+
+#if defined(DEBUGGING) || defined(HEALTH_REPORTS)
+	// freeRAM() and the health module's stack painting read the AVR heap symbols
+	uint16_t __heap_start, *__brkval;
+#endif
+
+SYSTEM_class system_node(class_lib);
+
+static double currents[SIM_COMPONENTS][SIM_MAX_STATES];
+static double boardCurrent = 0;
+
+static std::string defaultCurrents()
+{
+	std::string path = __FILE__;
+	size_t slash = path.rfind('/');
+
+	return (slash == std::string::npos ? std::string() : path.substr(0, slash + 1)) + "currents.txt";
+}
+
+static bool loadCurrents(const char *path)
+{
+	// component.state mA, and board for what is always on
+	FILE *file = fopen(path, "r");
+	bool seen[SIM_COMPONENTS][SIM_MAX_STATES] = {};
+	char line[CURRENT_LINE];
+
+	if (file == NULL)
+	{
+		fprintf(stderr, "Cannot open %s\n", path);
+		return false;
+	}
+
+	while (fgets(line, sizeof(line), file))
+	{
+		char key[CURRENT_LINE];
+		double milliamps;
+
+		*strchrnul(line, '#') = '\0';
+		if (sscanf(line, "%127s %lf", key, &milliamps) != 2) continue;
+
+		if (strcmp(key, "board") == 0)
+		{
+			boardCurrent = milliamps;
+			continue;
+		}
+
+		bool known = false;
+		for (uint8_t i = 0; i < SIM_COMPONENTS && !known; i++)
+		{
+			for (uint8_t j = 0; j < SIM_MAX_STATES && !known; j++)
+			{
+				if (simStateNames[i][j] == NULL || strcmp(key, (std::string(simComponentNames[i]) + "." + simStateNames[i][j]).c_str()) != 0) continue;
+
+				currents[i][j] = milliamps;
+				seen[i][j] = known = true;
+			}
+		}
+
+		if (!known)
+		{
+			fprintf(stderr, "%s: unknown state %s\n", path, key);
+			fclose(file);
+			return false;
+		}
+	}
+	fclose(file);
+
+	for (uint8_t i = 0; i < SIM_COMPONENTS; i++)
+	{
+		for (uint8_t j = 0; j < SIM_MAX_STATES; j++)
+		{
+			if (simStateNames[i][j] != NULL && !seen[i][j]) fprintf(stderr, "%s: no current for %s.%s, taking 0\n", path, simComponentNames[i], simStateNames[i][j]);
+		}
+	}
+
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	double hours = DEFAULT_HOURS;
+	int hwid = DEFAULT_HWID;
+	int neighbours = DEFAULT_NEIGHBOURS;
+	std::string currentsPath = defaultCurrents();
+	double capacity = DEFAULT_CAPACITY;
+	double usable = DEFAULT_USABLE;
+	double battery = DEFAULT_BATTERY;
+	double crystal = 0;
+	time_t start = DEFAULT_START;
+	const char *tracePath = NULL;
+	const char *jsonPath = NULL;
+	bool echo = false;
+	int option;
+
+	while ((option = getopt(argc, argv, "H:i:n:c:C:u:b:d:s:t:j:v")) != -1)
+	{
+		switch (option)
+		{
+			case 'H': hours = atof(optarg); break;
+			case 'i': hwid = atoi(optarg); break;
+			case 'n': neighbours = atoi(optarg); break;
+			case 'c': currentsPath = optarg; break;
+			case 'C': capacity = atof(optarg); break;
+			case 'u': usable = atof(optarg); break;
+			case 'b': battery = atof(optarg); break;
+			case 'd': crystal = atof(optarg); break;
+			case 's': start = atol(optarg); break;
+			case 't': tracePath = optarg; break;
+			case 'j': jsonPath = optarg; break;
+			case 'v': echo = true; break;
+			default:
+				fprintf(stderr, "Usage: %s [-H hours] [-i hwid] [-n neighbours] [-c currents.txt] [-C capacity_mah] [-u usable] [-b battery_volts] [-d rtc_ppm] [-s start_epoch] [-t trace.csv] [-j report.json] [-v]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	if (hours <= 0 || hwid < 0 || hwid >= SIM_NODE_SLOTS || neighbours < 0 || neighbours >= SIM_NODE_SLOTS)
+	{
+		fprintf(stderr, "hours must be positive, hwid and neighbours 0 to %d\n", SIM_NODE_SLOTS - 1);
+		return 1;
+	}
+	if (!loadCurrents(currentsPath.c_str())) return 1;
+
+	FILE *trace = NULL;
+	if (tracePath != NULL && (trace = fopen(tracePath, "w")) == NULL)
+	{
+		fprintf(stderr, "Cannot write %s\n", tracePath);
+		return 1;
+	}
+
+	// The firmware never returns, the board ends the run from inside it
+	board.begin(start, (uint64_t)(hours * 3600 * SIM_SECOND), hwid, neighbours, battery, trace, echo);
+	board.rtc.setCrystal(crystal);
+	try
+	{
+		system_node.Initialize();
+		for (;;) system_node.Run();
+	}
+	catch (const SIM_END_OF_RUN &)
+	{
+	}
+	board.finish();
+	if (trace != NULL) fclose(trace);
+
+	// Per state and per component, all in mAh
+	double seconds = board.now() / (double)SIM_SECOND;
+	double componentCharge[SIM_COMPONENTS] = {};
+	double boardCharge = boardCurrent * seconds / 3600;
+	double total = boardCharge;
+
+	printf("Simulated %.1f h of node %d with %d neighbours at %.2f V\n\n", seconds / 3600, hwid, neighbours, battery);
+	printf("%-18s %12s %8s %10s %10s\n", "state", "seconds", "share", "mA", "mAh");
+	for (uint8_t i = 0; i < SIM_COMPONENTS; i++)
+	{
+		for (uint8_t j = 0; j < SIM_MAX_STATES && simStateNames[i][j] != NULL; j++)
+		{
+			double time = board.stateTime(i, j) / (double)SIM_SECOND;
+			double charge = currents[i][j] * time / 3600;
+			if (time == 0) continue;
+
+			componentCharge[i] += charge;
+			total += charge;
+			printf("%-18s %12.3f %7.3f%% %10.4f %10.4f\n", (std::string(simComponentNames[i]) + "." + simStateNames[i][j]).c_str(),
+				time, 100 * time / seconds, currents[i][j], charge);
+		}
+	}
+	printf("%-18s %12.3f %7.3f%% %10.4f %10.4f\n\n", "board", seconds, 100.0, boardCurrent, boardCharge);
+
+	double perHour = total / (seconds / 3600);
+	double lifetime = capacity * usable / perHour / 24;
+
+	for (uint8_t i = 0; i < SIM_COMPONENTS; i++)
+	{
+		printf("%-8s %10.4f mAh/h %6.1f%%\n", simComponentNames[i], componentCharge[i] / (seconds / 3600), 100 * componentCharge[i] / total);
+	}
+	printf("%-8s %10.4f mAh/h %6.1f%%\n\n", "board", boardCharge / (seconds / 3600), 100 * boardCharge / total);
+	printf("Average %.4f mA | %.4f mAh/day | lifetime %.1f days on %.0f mAh x %.2f\n", perHour, perHour * 24, lifetime, capacity, usable);
+
+	printf("Counters:");
+	for (uint8_t i = 0; i < SIM_COUNTERS; i++)
+	{
+		printf(" %s %llu", simCounterNames[i], (unsigned long long)board.getCounter(i));
+	}
+	printf("\n");
+	printf("RTC offset from true time at the end: %+.1f ms\n", board.rtc.offset() / 1000.0);
+
+	if (jsonPath != NULL)
+	{
+		FILE *json = fopen(jsonPath, "w");
+		if (json == NULL)
+		{
+			fprintf(stderr, "Cannot write %s\n", jsonPath);
+			return 1;
+		}
+
+		fprintf(json, "{\n  \"hours\": %.3f,\n  \"hwid\": %d,\n  \"neighbours\": %d,\n  \"battery\": %.3f,\n", seconds / 3600, hwid, neighbours, battery);
+		fprintf(json, "  \"states\": {");
+		const char *separator = "\n";
+		for (uint8_t i = 0; i < SIM_COMPONENTS; i++)
+		{
+			for (uint8_t j = 0; j < SIM_MAX_STATES && simStateNames[i][j] != NULL; j++)
+			{
+				double time = board.stateTime(i, j) / (double)SIM_SECOND;
+				fprintf(json, "%s    \"%s.%s\": {\"seconds\": %.6f, \"ma\": %g, \"mah\": %.6f}", separator,
+					simComponentNames[i], simStateNames[i][j], time, currents[i][j], currents[i][j] * time / 3600);
+				separator = ",\n";
+			}
+		}
+		fprintf(json, "\n  },\n  \"mah_per_hour\": {");
+		for (uint8_t i = 0; i < SIM_COMPONENTS; i++)
+		{
+			fprintf(json, "\"%s\": %.6f, ", simComponentNames[i], componentCharge[i] / (seconds / 3600));
+		}
+		fprintf(json, "\"board\": %.6f, \"total\": %.6f},\n", boardCharge / (seconds / 3600), perHour);
+		fprintf(json, "  \"mah_per_day\": %.6f,\n  \"lifetime_days\": %.3f,\n  \"capacity_mah\": %.1f,\n  \"usable\": %.3f,\n  \"counters\": {",
+			perHour * 24, lifetime, capacity, usable);
+		for (uint8_t i = 0; i < SIM_COUNTERS; i++)
+		{
+			fprintf(json, "%s\"%s\": %llu", i ? ", " : "", simCounterNames[i], (unsigned long long)board.getCounter(i));
+		}
+		fprintf(json, "},\n  \"rtc_offset_ms\": %.3f\n}\n", board.rtc.offset() / 1000.0);
+		fclose(json);
+	}
+
+	return 0;
+}
@@ -0,0 +1,43 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// Host stand-in for the Adafruit AHTX0 driver, with the driver's own start-up and conversion waits
+
+#ifndef sim_adafruit_ahtx0_h
+#define sim_adafruit_ahtx0_h
+
+#include "Arduino.h"
+
+struct sensors_event_t
+{
+	float temperature;
+	float relative_humidity;
+};
+
+class Adafruit_AHTX0
+{
+	public:
+		bool begin();
+		bool getEvent(sensors_event_t *humidity, sensors_event_t *temperature);
+};
+
+#endif
@@ -0,0 +1,164 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// Host stand-in for the Arduino core, only what system_node uses. Declarations only, the
+// definitions are in ../sim_arduino.cpp and run against the simulated board in ../sim_board.h.
+
+#ifndef sim_arduino_core_h
+#define sim_arduino_core_h
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <type_traits>
+
+#include "avr/pgmspace.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH				1
+#define LOW					0
+
+#define INPUT				0
+#define OUTPUT				1
+#define INPUT_PULLUP		2
+
+#define CHANGE				1
+#define FALLING				2
+#define RISING				3
+
+#define DEC					10
+#define HEX					16
+#define BIN					2
+
+// Nano pin numbers
+#define A0					14
+#define A1					15
+#define A2					16
+#define A3					17
+#define A4					18
+#define A5					19
+#define A6					20
+#define A7					21
+
+#define NOT_AN_INTERRUPT	-1
+#define digitalPinToInterrupt(p)	((p) == 2 ? 0 : ((p) == 3 ? 1 : NOT_AN_INTERRUPT))
+
+#define F(text)				(text)
+#define bit(b)				(1UL << (b))
+#define constrain(amt, low, high)	((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// Registers the firmware writes directly, only EIFR does anything
+#define INTF0				0
+#define INTF1				1
+#define BODSE				5
+#define BODS				6
+#define ADEN				7
+#define WDRF				3
+
+struct SIM_EIFR_class
+{
+	void operator=(uint8_t value);		// Write one to clear, like the real flags
+};
+
+extern SIM_EIFR_class EIFR;
+extern volatile uint8_t ADCSRA;
+extern volatile uint8_t WDTCSR;
+extern volatile uint8_t MCUCR;
+extern volatile uint8_t MCUSR;
+
+// No AVR stack here, SP sits at the heap start so the painted gap is empty and freeRAM() reads 0
+#define SP					((uintptr_t)&__heap_start)
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void noInterrupts();
+void interrupts();
+void attachInterrupt(int8_t interrupt, void (*isr)(), int mode);
+void detachInterrupt(int8_t interrupt);
+
+char *dtostrf(double value, signed char width, unsigned char precision, char *buffer);
+
+// UART, every byte costs its time on the wire and reaches OpenLog when it is powered
+class HardwareSerial
+{
+	private:
+		void printNumber(unsigned long value, bool negative, int base);
+
+	public:
+		void begin(unsigned long baud);
+		void end();
+		void flush();
+		size_t write(uint8_t value);
+		size_t write(const uint8_t *buffer, size_t size);
+		int availableForWrite() { return 63; }		// Empty 64 byte TX buffer, the wire time is charged per byte
+
+		void print(const char *text) { write((const uint8_t *)text, strlen(text)); }
+		void print(char c) { write((uint8_t)c); }
+		void print(double value, int digits = 2);
+		void println() { print("\r\n"); }
+
+		template <typename T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+		void print(T value, int base = DEC)
+		{
+			if constexpr (std::is_signed<T>::value)
+			{
+				if (value < 0)
+				{
+					printNumber(-(long)value, true, base);
+					return;
+				}
+			}
+			printNumber(value, false, base);
+		}
+
+		template <typename T>
+		void println(T value)
+		{
+			print(value);
+			println();
+		}
+
+		template <typename T>
+		void println(T value, int format)
+		{
+			print(value, format);
+			println();
+		}
+};
+
+extern HardwareSerial Serial;
+
+#endif
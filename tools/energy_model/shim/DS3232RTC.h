@@ -0,0 +1,84 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// Host stand-in for JChristensen's DS3232RTC, driving the simulated DS3231 in ../sim_rtc.h
+
+#ifndef sim_ds3232rtc_h
+#define sim_ds3232rtc_h
+
+#include "Arduino.h"
+#include "TimeLib.h"
+
+class DS3232RTC
+{
+	public:
+		enum ALARM_TYPES_t : uint8_t
+		{
+			ALM1_EVERY_SECOND,
+			ALM1_MATCH_SECONDS,
+			ALM1_MATCH_MINUTES,
+			ALM1_MATCH_HOURS,
+			ALM1_MATCH_DATE,
+			ALM1_MATCH_DAY,
+			ALM2_EVERY_MINUTE,
+			ALM2_MATCH_MINUTES,
+			ALM2_MATCH_HOURS,
+			ALM2_MATCH_DATE,
+			ALM2_MATCH_DAY
+		};
+
+		enum SQWAVE_FREQS_t : uint8_t
+		{
+			SQWAVE_1_HZ,
+			SQWAVE_1024_HZ,
+			SQWAVE_4096_HZ,
+			SQWAVE_8192_HZ,
+			SQWAVE_NONE
+		};
+
+		static const uint8_t ALARM_1 = 1;
+		static const uint8_t ALARM_2 = 2;
+
+		static const uint8_t DS32_CONTROL = 0x0E;
+		static const uint8_t DS32_STATUS = 0x0F;
+		static const uint8_t DS32_AGING = 0x10;
+		static const uint8_t DS32_EN32KHZ = 3;
+		static const uint8_t DS32_CONV = 5;
+		static const uint8_t DS32_BBSQW = 6;
+
+		void begin() {}
+		static time_t get();
+		uint8_t set(time_t t);
+		uint8_t read(tmElements_t &tm);
+		uint8_t write(tmElements_t &tm);
+
+		void setAlarm(ALARM_TYPES_t alarmType, uint8_t seconds, uint8_t minutes, uint8_t hours, uint8_t daydate);
+		bool alarm(uint8_t alarmNumber);
+		void alarmInterrupt(uint8_t alarmNumber, bool alarmEnabled);
+		void squareWave(SQWAVE_FREQS_t freq);
+
+		uint8_t readRTC(uint8_t addr);
+		uint8_t writeRTC(uint8_t addr, uint8_t value);
+		int16_t temperature();
+};
+
+#endif
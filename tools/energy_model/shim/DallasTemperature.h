@@ -0,0 +1,47 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// Host stand-in for DallasTemperature with one DS18B20 on the bus. Conversions block for the
+// 12-bit 750 ms by default, like the real library.
+
+#ifndef sim_dallastemperature_h
+#define sim_dallastemperature_h
+
+#include "OneWire.h"
+
+#define DEVICE_DISCONNECTED_C	-127
+
+class DallasTemperature
+{
+	private:
+		bool _waitForConversion = true;
+
+	public:
+		DallasTemperature(OneWire *oneWire) {}
+
+		void begin();
+		void setWaitForConversion(bool wait) { _waitForConversion = wait; }
+		void requestTemperatures();
+		float getTempCByIndex(uint8_t index);
+};
+
+#endif
@@ -0,0 +1,60 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// Host stand-in for the AVR EEPROM library. put() only writes bytes that changed, and each
+// write holds the CPU for the 3.4 ms the cell takes.
+
+#ifndef sim_eeprom_h
+#define sim_eeprom_h
+
+#include "Arduino.h"
+
+#define E2END				0x3FF
+
+class EEPROMClass
+{
+	public:
+		uint8_t read(int address);
+		void write(int address, uint8_t value);
+		void update(int address, uint8_t value);
+		uint16_t length() { return E2END + 1; }
+
+		template <typename T>
+		T &get(int address, T &value)
+		{
+			uint8_t *bytes = (uint8_t *)&value;
+			for (size_t i = 0; i < sizeof(T); i++) bytes[i] = read(address + i);
+			return value;
+		}
+
+		template <typename T>
+		const T &put(int address, const T &value)
+		{
+			const uint8_t *bytes = (const uint8_t *)&value;
+			for (size_t i = 0; i < sizeof(T); i++) update(address + i, bytes[i]);
+			return value;
+		}
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
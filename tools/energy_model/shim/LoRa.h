@@ -0,0 +1,65 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// Host stand-in for the sandeepmistry LoRa library, driving the simulated SX1278 in ../sim_radio.h
+
+#ifndef sim_lora_h
+#define sim_lora_h
+
+#include "Arduino.h"
+
+class LoRaClass
+{
+	public:
+		void setPins(int ss, int reset, int dio0) {}
+		int begin(long frequency);
+		void end();
+
+		void setTxPower(int level, int outputPin = 1) {}
+		void setSignalBandwidth(long bandwidth);
+		void setSyncWord(int syncWord) {}
+		void setSpreadingFactor(int spreadingFactor);
+		void setCodingRate4(int denominator);
+		void setPreambleLength(long length);
+		void enableCrc() {}
+		void disableCrc() {}
+
+		int beginPacket(int implicitHeader = false);
+		size_t write(uint8_t value);
+		size_t write(const uint8_t *buffer, size_t size);
+		int endPacket(bool async = false);
+
+		int parsePacket(int size = 0);
+		int available();
+		int read();
+		int peek();
+		int packetRssi();
+		float packetSnr();
+
+		void receive(int size = 0);
+		void idle();
+		void sleep();
+};
+
+extern LoRaClass LoRa;
+
+#endif
@@ -0,0 +1,36 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// Host stand-in for OneWire, the DS18B20 stand-in does the bus work
+
+#ifndef sim_onewire_h
+#define sim_onewire_h
+
+#include "Arduino.h"
+
+class OneWire
+{
+	public:
+		OneWire(uint8_t pin) {}
+};
+
+#endif
@@ -0,0 +1,54 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// Host stand-in for the SPI library, bytes go to whichever simulated chip has its select low
+
+#ifndef sim_spi_h
+#define sim_spi_h
+
+#include "Arduino.h"
+
+#define MSBFIRST			1
+#define LSBFIRST			0
+#define SPI_MODE0			0
+
+class SPISettings
+{
+	public:
+		SPISettings() {}
+		SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) {}
+};
+
+class SPIClass
+{
+	public:
+		void begin() {}
+		void end() {}
+		void beginTransaction(SPISettings settings) {}
+		void endTransaction() {}
+		uint8_t transfer(uint8_t data);
+		void transfer(void *buffer, size_t count);
+};
+
+extern SPIClass SPI;
+
+#endif
@@ -0,0 +1,84 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// Host stand-in for TimeLib, UTC only. Like the real library its clock runs on millis(), which
+// stops in power-down, and it re-reads the sync provider every five minutes.
+
+#ifndef sim_timelib_h
+#define sim_timelib_h
+
+#include "Arduino.h"
+
+#define SECS_PER_MIN		((time_t)(60UL))
+#define SECS_PER_HOUR		((time_t)(3600UL))
+#define SECS_PER_DAY		((time_t)(SECS_PER_HOUR * 24UL))
+
+#define CalendarYrToTm(Y)	((Y) - 1970)
+#define tmYearToCalendar(Y)	((Y) + 1970)
+#define y2kYearToTm(Y)		((Y) + 30)
+#define tmYearToY2k(Y)		((Y) - 30)
+
+typedef time_t (*getExternalTime)();
+
+enum timeStatus_t
+{
+	timeNotSet,
+	timeNeedsSync,
+	timeSet
+};
+
+struct tmElements_t
+{
+	uint8_t Second;
+	uint8_t Minute;
+	uint8_t Hour;
+	uint8_t Wday;			// Sunday is 1
+	uint8_t Day;
+	uint8_t Month;
+	uint8_t Year;			// Offset from 1970
+};
+
+time_t now();
+void setTime(time_t t);
+void setTime(int hr, int min, int sec, int dy, int mnth, int yr);
+void setSyncProvider(getExternalTime provider);
+timeStatus_t timeStatus();
+
+time_t makeTime(const tmElements_t &tm);
+void breakTime(time_t t, tmElements_t &tm);
+
+int hour(time_t t);
+int minute(time_t t);
+int second(time_t t);
+int day(time_t t);
+int weekday(time_t t);
+int month(time_t t);
+int year(time_t t);
+
+int hour();
+int minute();
+int second();
+int day();
+int month();
+int year();
+
+#endif
@@ -0,0 +1,40 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// Host stand-in for the Wire library, the RTC stand-in charges its own bus time
+
+#ifndef sim_wire_h
+#define sim_wire_h
+
+#include "Arduino.h"
+
+class TwoWire
+{
+	public:
+		void begin() {}
+		void end() {}
+		void setClock(uint32_t clock) {}
+};
+
+extern TwoWire Wire;
+
+#endif
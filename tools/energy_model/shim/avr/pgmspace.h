@@ -0,0 +1,42 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// Host stand-in for avr/pgmspace.h, flash and RAM are one address space here
+
+#ifndef sim_avr_pgmspace_h
+#define sim_avr_pgmspace_h
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(text)				(text)
+
+#define pgm_read_byte(address)	(*(const uint8_t*)(address))
+#define memcpy_P				memcpy
+#define strcmp_P				strcmp
+#define strncmp_P				strncmp
+#define strlen_P				strlen
+#define snprintf_P				snprintf
+
+#endif
@@ -0,0 +1,52 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// Host stand-in for avr/power.h, the clock and peripheral gates only change what the board
+// draws while awake, which the current table already folds into mcu.active
+
+#ifndef sim_avr_power_h
+#define sim_avr_power_h
+
+typedef enum
+{
+	clock_div_1,
+	clock_div_2,
+	clock_div_4,
+	clock_div_8,
+	clock_div_16,
+	clock_div_32,
+	clock_div_64,
+	clock_div_128,
+	clock_div_256
+} clock_div_t;
+
+inline void power_adc_disable() {}
+inline void power_spi_disable() {}
+inline void power_timer0_disable() {}
+inline void power_timer1_disable() {}
+inline void power_timer2_disable() {}
+inline void power_twi_disable() {}
+inline void power_usart0_disable() {}
+inline void power_all_enable() {}
+inline void clock_prescale_set(clock_div_t divider) {}
+
+#endif
@@ -0,0 +1,40 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// Host stand-in for avr/sleep.h, sleep_cpu() hands the time over to the simulated board
+
+#ifndef sim_avr_sleep_h
+#define sim_avr_sleep_h
+
+#include <stdint.h>
+
+#define SLEEP_MODE_IDLE			0
+#define SLEEP_MODE_PWR_DOWN		2
+
+void set_sleep_mode(uint8_t mode);
+void sleep_enable();
+void sleep_disable();
+void sleep_cpu();
+
+#define sleep_mode()	do { sleep_enable(); sleep_cpu(); sleep_disable(); } while (0)
+
+#endif
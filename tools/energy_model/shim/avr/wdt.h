@@ -0,0 +1,45 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// Host stand-in for avr/wdt.h, the board counts every time the watchdog would have fired
+
+#ifndef sim_avr_wdt_h
+#define sim_avr_wdt_h
+
+#include <stdint.h>
+
+#define WDTO_15MS		0
+#define WDTO_30MS		1
+#define WDTO_60MS		2
+#define WDTO_120MS		3
+#define WDTO_250MS		4
+#define WDTO_500MS		5
+#define WDTO_1S			6
+#define WDTO_2S			7
+#define WDTO_4S			8
+#define WDTO_8S			9
+
+void wdt_enable(uint8_t timeout);
+void wdt_disable();
+void wdt_reset();
+
+#endif
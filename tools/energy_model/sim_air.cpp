@@ -0,0 +1,429 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#include "sim_board.h"
+
+void SIM_AIR_class::begin(uint8_t nodeHwid, uint8_t neighbours)
+{
+	SIM_PEER basestation;
+	basestation.hwid = -1;
+	basestation.csma = CSMA_TOUT_MIN * 1000ULL;
+	_peers.push_back(basestation);
+	_activeMask = bit(nodeHwid);
+
+	// Neighbours take the lowest free slots
+	for (uint8_t hwid = 0; hwid < SIM_NODE_SLOTS && _peers.size() <= neighbours; hwid++)
+	{
+		if (hwid == nodeHwid) continue;
+
+		SIM_PEER peer;
+		peer.hwid = hwid;
+		peer.csma = (CSMA_TOUT_MIN + CSMA_TOUT_MUL * hwid) * 1000ULL;
+		_peers.push_back(peer);
+		_activeMask |= bit(hwid);
+	}
+
+	_roundAt = nextRound(board.now());
+}
+
+uint64_t SIM_AIR_class::nextRound(uint64_t now)
+{
+	time_t t = board.trueTime();
+	time_t next = t - t % SECS_PER_HOUR + SIM_ROUND_START;
+
+	if (next <= t) next += SECS_PER_HOUR;
+	return now - now % SIM_SECOND + (uint64_t)(next - t) * SIM_SECOND;
+}
+
+bool SIM_AIR_class::awake(const SIM_PEER &peer)
+{
+	if (peer.hwid < 0) return true;
+
+	time_t second = board.trueTime() % SECS_PER_HOUR;
+	return second >= SIM_WINDOW_OPENS || second < SIM_WINDOW_CLOSES;
+}
+
+uint64_t SIM_AIR_class::transmit(int8_t sender, const std::string &text, uint64_t at)
+{
+	// No carrier sense, like the firmware: the CSMA timeout is only a wait after the last frame heard
+	SIM_FRAME frame = { at, at + board.radio.airtime(text.size()), sender, text };
+
+	queue(frame);
+	return frame.end;
+}
+
+void SIM_AIR_class::queue(const SIM_FRAME &frame)
+{
+	auto position = _onAir.begin();
+	while (position != _onAir.end() && position->end <= frame.end) position++;
+	_onAir.insert(position, frame);
+}
+
+void SIM_AIR_class::nodeTransmit(const uint8_t *data, uint8_t length, uint64_t start, uint64_t end)
+{
+	std::string text((const char *)data, length);
+
+	#ifdef ENCRYPTING
+		rc4((uint8_t *)&text[0], text.size());
+	#endif
+
+	SIM_FRAME frame = { start, end, SIM_NODE, text };
+	queue(frame);
+}
+
+static void simValues(const std::string &text, double *values)
+{
+	// Same reading as getpayloadValues(): blanks parse as 0, '~' is a predicted slot
+	char buffer[MAX_MESSAGE_LENGTH];
+	size_t open = text.find('['), close = text.find(']');
+
+	memset(values, 0, sizeof(double) * (SIM_NODE_SLOTS + 1));
+	if (open == std::string::npos || close == std::string::npos || close <= open) return;
+
+	std::string inner = text.substr(open + 1, close - open - 1);
+	snprintf(buffer, sizeof(buffer), "%s", inner.c_str());
+
+	uint8_t index = 0;
+	for (char *token = strtok(buffer, ","); token != NULL && index <= SIM_NODE_SLOTS; token = strtok(NULL, ","))
+	{
+		values[index++] = *token == PREDICTED_PLACEHOLDER ? PREDICTED_VALUE : atof(token);
+	}
+}
+
+void SIM_AIR_class::hear(SIM_PEER &peer, const SIM_FRAME &frame)
+{
+	uint64_t now = frame.end;
+	double values[SIM_NODE_SLOTS + 1];
+
+	// The time rides behind requests and TEMP relays, what is in front of it reads like any other frame
+	std::string text = frame.text;
+	size_t tag = text.find(SIM_TIME_TAG);
+	unsigned long epoch = 0, millisecond = 0;
+	bool tagged = tag != std::string::npos && sscanf(text.c_str() + tag, "@%lu.%lu", &epoch, &millisecond) == 2;
+	if (tag != std::string::npos) text.erase(tag);
+
+	if (text.compare(0, START_OF_BRACKET, EVENT_HEADER) == 0)
+	{
+		// Neighbours relay each event once, the basestation only uploads it
+		simValues(text, values);
+		int key = ((int)values[0] << 8) | (int)values[3];
+
+		if (peer.hwid < 0 || (int)values[0] == peer.hwid || key == peer.lastEvent) return;
+
+		peer.lastEvent = key;
+		peer.event = text;
+		peer.eventAt = now + (EVENT_BACKOFF_MUL + peer.hwid * EVENT_BACKOFF_MUL) * 1000ULL;
+		return;
+	}
+
+	uint8_t header = 0;
+	while (header < SIM_HEADERS && text.compare(0, START_OF_BRACKET, simHeaders[header]) != 0) header++;
+
+	// Backfill (BKFL, HIST) is not scripted
+	if (header == SIM_HEADERS) return;
+	if (peer.hwid < 0 && header != _round) return;
+
+	// getLoRaPayload(): the first time heard in a window is kept, counted on from the frame's end
+	if (tagged && peer.hwid >= 0 && peer.timeHour != window())
+	{
+		peer.timeHour = window();
+		peer.timeEpoch = epoch;
+		peer.timeElapsed = millisecond + (double)(frame.end - frame.start) / 1000;
+		peer.timeHeardAt = frame.end;
+	}
+
+	bool request = text.compare(START_OF_BRACKET, std::string::npos, "[]") == 0;
+	simValues(text, values);
+
+	// preloadMessageData(): a new header, or a fresh request, starts over from our own reading
+	if (peer.hwid >= 0 && (request || header != peer.header))
+	{
+		memset(peer.slots, 0, sizeof(peer.slots));
+		peer.slots[peer.hwid] = ownValue(peer, header);
+		peer.header = header;
+	}
+	if (peer.hwid < 0) _resendAt = SIM_NEVER;
+
+	// processPayloadData(): merge into the blanks
+	for (uint8_t i = 0; i < SIM_NODE_SLOTS; i++)
+	{
+		if (fabs(values[i] - peer.slots[i]) <= EPSILON) continue;
+
+		peer.attempts = 0;
+		for (uint8_t j = 0; j < SIM_NODE_SLOTS; j++)
+		{
+			if (peer.slots[j] == 0) peer.slots[j] = values[j];
+		}
+		break;
+	}
+
+	// sendPayloadData() restarts the CSMA wait after every frame it hears
+	peer.sendAt = peer.attempts < SEND_ATTEMPTS ? now + peer.csma : SIM_NEVER;
+
+	if (peer.hwid < 0 && peer.sendAt == SIM_NEVER && complete()) _closeAt = now;
+}
+
+void SIM_AIR_class::relay(SIM_PEER &peer, uint64_t now)
+{
+	uint64_t end = transmit(&peer - &_peers[0], payload(peer, now), now);
+
+	peer.attempts++;
+	peer.sendAt = peer.attempts < SEND_ATTEMPTS ? end + peer.csma : SIM_NEVER;
+
+	// The basestation checks the request once its send loop is done
+	if (peer.hwid < 0)
+	{
+		_timeoutAt = end + SIM_REQ_TIMEOUT_US;
+		if (peer.sendAt == SIM_NEVER && complete()) _closeAt = end;
+	}
+}
+
+bool SIM_AIR_class::complete()
+{
+	for (uint8_t i = 0; i < SIM_NODE_SLOTS; i++)
+	{
+		if ((_activeMask & bit(i)) && _peers[0].slots[i] == 0) return false;
+	}
+
+	return true;
+}
+
+void SIM_AIR_class::openRequest(uint8_t header, uint64_t now)
+{
+	SIM_PEER &basestation = _peers[0];
+
+	_round = header;
+	memset(basestation.slots, 0, sizeof(basestation.slots));
+	basestation.header = header;
+	basestation.attempts = 0;
+	basestation.sendAt = SIM_NEVER;
+
+	transmit(0, request(header, now), now);
+	_resendAt = now + SIM_REQ_TIMEOUT_US / SIM_REQ_RESEND_DIV;
+	_timeoutAt = now + SIM_REQ_TIMEOUT_US;
+	_closeAt = SIM_NEVER;
+}
+
+void SIM_AIR_class::closeRequest(uint64_t now)
+{
+	_resendAt = SIM_NEVER;
+	_timeoutAt = SIM_NEVER;
+	_closeAt = SIM_NEVER;
+	_peers[0].sendAt = SIM_NEVER;
+
+	if (_round + 1 < SIM_HEADERS)
+	{
+		openRequest(_round + 1, now);
+		return;
+	}
+
+	_round = SIM_HEADERS;
+	_roundAt = nextRound(now);
+}
+
+std::string SIM_AIR_class::request(uint8_t header, uint64_t now)
+{
+	// Stamped with the true time as it goes out, the basestation's clock is taken as right
+	std::string text = simHeaders[header];
+
+	text += "[]";
+	text += timeTag(board.trueTime(now), (double)(now % SIM_SECOND) / 1000);
+	return text;
+}
+
+std::string SIM_AIR_class::timeTag(unsigned long epoch, double elapsed)
+{
+	char tag[MAX_NUMBER_LENGTH + 8];
+	unsigned long milliseconds = (unsigned long)elapsed;
+
+	snprintf(tag, sizeof(tag), "%c%lu.%03lu", SIM_TIME_TAG, epoch + milliseconds / 1000, milliseconds % 1000);
+	return tag;
+}
+
+std::string SIM_AIR_class::payload(const SIM_PEER &peer, uint64_t now)
+{
+	// formatPayloadData(), checksum in the last slot
+	std::string text = simHeaders[peer.header];
+	double checksum = 0;
+	char number[MAX_NUMBER_LENGTH + 8];
+
+	text += '[';
+	for (uint8_t i = 0; i <= SIM_NODE_SLOTS; i++)
+	{
+		double value = i < SIM_NODE_SLOTS ? peer.slots[i] : checksum;
+
+		if (value == 0) snprintf(number, sizeof(number), "%c", BLANK_PLACEHOLDER);
+		else if (value == PREDICTED_VALUE) snprintf(number, sizeof(number), "%c", PREDICTED_PLACEHOLDER);
+		else if (peer.header == SIM_SMOI) snprintf(number, sizeof(number), "%02lu", (unsigned long)value);
+		else snprintf(number, sizeof(number), "%.*f", DECIMAL_VALUES, value);
+
+		if (i < SIM_NODE_SLOTS && value != PREDICTED_VALUE) checksum += value;
+
+		text += number;
+		text += i < SIM_NODE_SLOTS ? ',' : ']';
+	}
+
+	// sendPayloadData(): TEMP relays carry the time on, stamped as they go out, when there is room
+	if (peer.hwid >= 0 && peer.header == SIM_TEMP && peer.timeHour == window())
+	{
+		std::string tag = timeTag(peer.timeEpoch, peer.timeElapsed + (double)(now - peer.timeHeardAt) / 1000);
+		if (text.size() + tag.size() < MAX_MESSAGE_LENGTH) text += tag;
+	}
+
+	return text;
+}
+
+double SIM_AIR_class::ownValue(SIM_PEER &peer, uint8_t header)
+{
+	// Sampled at ALARM1, once per window
+	time_t hour = window();
+
+	if (peer.sampledHour != hour)
+	{
+		peer.sampledHour = hour;
+		for (uint8_t i = 0; i < SIM_HEADERS; i++)
+		{
+			double value = board.environment(i, peer.hwid);
+			peer.readings[i] = i == SIM_SMOI ? floor(value) : value;
+
+			#ifdef PREDICTING
+				// Roughly half the neighbours' readings stay inside the shared prediction
+				if (simMix(((uint64_t)hour << 16) | (i << 8) | peer.hwid) % 100 < SIM_PREDICTED_SHARE) peer.readings[i] = PREDICTED_VALUE;
+			#endif
+		}
+	}
+
+	return peer.readings[header];
+}
+
+time_t SIM_AIR_class::window()
+{
+	// The window straddles the hour, so it belongs to the one it closes in
+	return (board.trueTime() + SECS_PER_HOUR - SIM_WINDOW_OPENS) / SECS_PER_HOUR;
+}
+
+uint64_t SIM_AIR_class::nextEvent()
+{
+	uint64_t next = std::min(std::min(_roundAt, _resendAt), std::min(_timeoutAt, _closeAt));
+
+	if (!_onAir.empty()) next = std::min(next, _onAir.front().end);
+	for (const SIM_PEER &peer : _peers)
+	{
+		next = std::min(next, std::min(peer.sendAt, peer.eventAt));
+	}
+
+	return next;
+}
+
+void SIM_AIR_class::runEvents(uint64_t now)
+{
+	for (uint64_t next = nextEvent(); next <= now; next = nextEvent())
+	{
+		if (!_onAir.empty() && _onAir.front().end == next)
+		{
+			SIM_FRAME frame = _onAir.front();
+			_onAir.pop_front();
+
+			if (frame.sender != SIM_NODE)
+			{
+				std::string bytes = frame.text;
+				#ifdef ENCRYPTING
+					rc4((uint8_t *)&bytes[0], bytes.size());
+				#endif
+				board.radio.deliver((const uint8_t *)bytes.data(), bytes.size(), frame.start);
+			}
+
+			for (size_t i = 0; i < _peers.size(); i++)
+			{
+				if ((int8_t)i != frame.sender && awake(_peers[i])) hear(_peers[i], frame);
+			}
+		}
+		else if (_roundAt == next)
+		{
+			_roundAt = SIM_NEVER;
+			openRequest(0, next);
+		}
+		else if (_closeAt == next || _timeoutAt == next)
+		{
+			closeRequest(next);
+		}
+		else if (_resendAt == next)
+		{
+			_resendAt = SIM_NEVER;
+			_timeoutAt = transmit(0, request(_round, next), next) + SIM_REQ_TIMEOUT_US;
+		}
+		else
+		{
+			for (SIM_PEER &peer : _peers)
+			{
+				if (peer.sendAt == next && awake(peer))
+				{
+					relay(peer, next);
+				}
+				else if (peer.sendAt == next)
+				{
+					peer.sendAt = SIM_NEVER;
+				}
+				else if (peer.eventAt == next)
+				{
+					peer.eventAt = SIM_NEVER;
+					transmit(&peer - &_peers[0], peer.event, next);
+				}
+				else continue;
+				break;
+			}
+		}
+	}
+}
+
+#ifdef ENCRYPTING
+	void SIM_AIR_class::rc4(uint8_t *data, size_t length)
+	{
+		// Copy of the node's cipher, 255 byte state and all
+		uint8_t S[RC4_BYTES];
+		for (uint16_t i = 0; i < RC4_BYTES; i++)
+		{
+			S[i] = i;
+		}
+
+		uint8_t j = 0, temp;
+		uint8_t enc_len = strlen(ENCRYPTION_KEY);
+		for (uint16_t i = 0; i < RC4_BYTES; i++)
+		{
+			j = (j + S[i] + ENCRYPTION_KEY[i % enc_len]) % RC4_BYTES;
+			temp = S[i];
+			S[i] = S[j];
+			S[j] = temp;
+		}
+
+		uint8_t i = 0; j = 0;
+		for (size_t n = 0; n < length; n++)
+		{
+			i = (i + 1) % RC4_BYTES;
+			j = (j + S[i]) % RC4_BYTES;
+			temp = S[i];
+			S[i] = S[j];
+			S[j] = temp;
+			data[n] ^= S[(S[i] + S[j]) % RC4_BYTES];
+		}
+	}
+#endif
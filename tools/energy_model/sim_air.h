@@ -0,0 +1,117 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// The air around the node for the energy model: the basestation's hourly round and a few
+// neighbours running the same flood as the firmware. Everyone hears everyone and frames take their
+// real airtime. Nobody senses the channel, and frames that overlap are not lost to each other,
+// only a radio that was transmitting or not yet listening misses one. The peers are a
+// sketch of lora_module.cpp, enough to make the node relay, merge and back off the way it does
+// in the field, not a second copy of it.
+//
+//	Round:		TEMP, HUMI, STMP, SMOI, BATT with data, each request stamped with the true time and
+//				closed once every active slot is in or after LORA_REQ_TIMEOUT, resent once if nobody answers
+//	Neighbours:	awake from ALARM1 to ALARM2 like the node, merge, relay twice per change after
+//				their CSMA timeout, carry the time on in their TEMP relays, relay each event once
+
+#ifndef sim_air_h
+#define sim_air_h
+
+#define SIM_ROUND_START			30				// Seconds into the hour, MINUTE_BREAK and SECOND_BREAK
+#define SIM_REQ_TIMEOUT_US		50000000ULL		// LORA_REQ_TIMEOUT
+#define SIM_REQ_RESEND_DIV		3
+#define SIM_WINDOW_OPENS		(59 * 60 + 30)	// Neighbours wake on ALARM1 ...
+#define SIM_WINDOW_CLOSES		(5 * 60)		// ... and go back to sleep on ALARM2
+#define SIM_PREDICTED_SHARE		50				// Percent of neighbour slots sent as '~' in PREDICTING builds
+#define SIM_HEADERS				5				// TEMP to BATT
+#define SIM_TIME_TAG			'@'				// TIME_TAG, "@epoch.ms" behind requests and TEMP relays
+#define SIM_NODE_SLOTS			8
+#define SIM_NODE				-1				// Sender of the node under test's frames
+
+static const char *const simHeaders[SIM_HEADERS] = { "TEMP:", "HUMI:", "STMP:", "SMOI:", "BATT:" };
+
+struct SIM_FRAME
+{
+	uint64_t start;
+	uint64_t end;
+	int8_t sender;							// Peer index, or SIM_NODE
+	std::string text;
+};
+
+struct SIM_PEER
+{
+	int8_t hwid;							// Slot, -1 for the basestation
+	uint64_t csma;							// CSMA timeout before each relay
+	uint8_t header = SIM_HEADERS;			// Request being merged, SIM_HEADERS for none
+	double slots[SIM_NODE_SLOTS] = {};		// 0 is blank, PREDICTED_VALUE is '~'
+	uint8_t attempts = 0;
+	uint64_t sendAt = SIM_NEVER;
+	std::string event;						// Event waiting to be relayed
+	uint64_t eventAt = SIM_NEVER;
+	int lastEvent = -1;						// hwid << 8 | seq of the last event relayed
+	time_t sampledHour = -1;				// Readings are taken once per window, like loadSensorData()
+	double readings[SIM_HEADERS];
+	time_t timeHour = -1;					// Window the time below was heard in, the first tag of each is kept
+	double timeElapsed = 0;					// ms past timeEpoch as the tagged frame ended
+	unsigned long timeEpoch = 0;
+	uint64_t timeHeardAt = 0;
+};
+
+class SIM_AIR_class
+{
+	private:
+		std::vector<SIM_PEER> _peers;		// [0] is the basestation
+		std::deque<SIM_FRAME> _onAir;		// Ordered by end
+		uint16_t _activeMask = 0;
+		uint8_t _round = SIM_HEADERS;		// Basestation's open request, SIM_HEADERS between rounds
+		uint64_t _roundAt = SIM_NEVER;
+		uint64_t _resendAt = SIM_NEVER;
+		uint64_t _timeoutAt = SIM_NEVER;
+		uint64_t _closeAt = SIM_NEVER;
+
+		bool awake(const SIM_PEER &peer);
+		uint64_t transmit(int8_t sender, const std::string &text, uint64_t at);
+		void queue(const SIM_FRAME &frame);
+		void hear(SIM_PEER &peer, const SIM_FRAME &frame);
+		void relay(SIM_PEER &peer, uint64_t now);
+		void openRequest(uint8_t header, uint64_t now);
+		void closeRequest(uint64_t now);
+		bool complete();
+		std::string request(uint8_t header, uint64_t now);
+		std::string payload(const SIM_PEER &peer, uint64_t now);
+		std::string timeTag(unsigned long epoch, double elapsed);
+		double ownValue(SIM_PEER &peer, uint8_t header);
+		time_t window();
+		uint64_t nextRound(uint64_t now);
+
+		#ifdef ENCRYPTING
+			void rc4(uint8_t *data, size_t length);
+		#endif
+
+	public:
+		void begin(uint8_t nodeHwid, uint8_t neighbours);
+		void nodeTransmit(const uint8_t *data, uint8_t length, uint64_t start, uint64_t end);
+
+		uint64_t nextEvent();
+		void runEvents(uint64_t now);
+};
+
+#endif
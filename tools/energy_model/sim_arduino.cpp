@@ -0,0 +1,545 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#include "sim_board.h"
+
+// Definitions for everything declared in shim/, each one a call into the simulated board
+
+LoRaClass LoRa;
+HardwareSerial Serial;
+TwoWire Wire;
+SPIClass SPI;
+EEPROMClass EEPROM;
+SIM_EIFR_class EIFR;
+volatile uint8_t ADCSRA;
+volatile uint8_t WDTCSR;
+volatile uint8_t MCUCR;
+volatile uint8_t MCUSR;
+
+static bool simSleepEnabled = false;
+
+void SIM_EIFR_class::operator=(uint8_t value)
+{
+	board.clearFlags(value & (bit(INTF0) | bit(INTF1)));
+}
+
+// Arduino core
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+	board.pinWrite(pin, value);
+}
+
+int digitalRead(uint8_t pin)
+{
+	return board.pinRead(pin);
+}
+
+int analogRead(uint8_t pin)
+{
+	return board.adcRead(pin);
+}
+
+unsigned long millis()
+{
+	board.busy(SIM_MILLIS_US);
+	return (unsigned long)(board.awake() / 1000);
+}
+
+unsigned long micros()
+{
+	board.busy(SIM_MILLIS_US);
+	return (unsigned long)board.awake();
+}
+
+void delay(unsigned long ms)
+{
+	board.busy(ms * 1000ULL);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+	board.busy(us);
+}
+
+void noInterrupts()
+{
+	board.setInterrupts(false);
+}
+
+void interrupts()
+{
+	board.setInterrupts(true);
+}
+
+void attachInterrupt(int8_t interrupt, void (*isr)(), int mode)
+{
+	board.attachInterrupt(interrupt, isr, mode);
+}
+
+void detachInterrupt(int8_t interrupt)
+{
+	board.detachInterrupt(interrupt);
+}
+
+char *dtostrf(double value, signed char width, unsigned char precision, char *buffer)
+{
+	sprintf(buffer, "%*.*f", width, precision, value);
+	return buffer;
+}
+
+void HardwareSerial::begin(unsigned long baud)
+{
+	board.uartBegin(baud);
+}
+
+void HardwareSerial::end()
+{
+	board.uartEnd();
+}
+
+void HardwareSerial::flush()
+{
+}
+
+size_t HardwareSerial::write(uint8_t value)
+{
+	board.uartWrite(&value, 1);
+	return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+	board.uartWrite(buffer, size);
+	return size;
+}
+
+void HardwareSerial::print(double value, int digits)
+{
+	char text[48];
+	snprintf(text, sizeof(text), "%.*f", digits, value);
+	print(text);
+}
+
+void HardwareSerial::printNumber(unsigned long value, bool negative, int base)
+{
+	char text[40];
+	char *cursor = &text[sizeof(text) - 1];
+
+	*cursor = '\0';
+	do
+	{
+		uint8_t digit = value % base;
+		*--cursor = digit < 10 ? '0' + digit : 'A' + digit - 10;
+		value /= base;
+	} while (value);
+
+	if (negative) *--cursor = '-';
+	print(cursor);
+}
+
+// avr-libc
+
+void set_sleep_mode(uint8_t mode)
+{
+}
+
+void sleep_enable()
+{
+	simSleepEnabled = true;
+}
+
+void sleep_disable()
+{
+	simSleepEnabled = false;
+}
+
+void sleep_cpu()
+{
+	if (simSleepEnabled) board.sleep();
+}
+
+void wdt_enable(uint8_t timeout)
+{
+	board.watchdogEnable(timeout);
+}
+
+void wdt_disable()
+{
+	board.watchdogDisable();
+}
+
+void wdt_reset()
+{
+	board.watchdogReset();
+}
+
+// TimeLib, counting whole seconds of millis() like the real one
+
+static time_t simSysTime = 0;
+static unsigned long simPrevMillis = 0;
+static time_t simNextSync = 0;
+static getExternalTime simSyncProvider = NULL;
+static timeStatus_t simStatus = timeNotSet;
+
+time_t now()
+{
+	unsigned long elapsed = (millis() - simPrevMillis) / 1000;
+
+	simSysTime += elapsed;
+	simPrevMillis += elapsed * 1000;
+
+	if (simSyncProvider != NULL && simNextSync <= simSysTime)
+	{
+		time_t t = simSyncProvider();
+		if (t != 0)
+		{
+			setTime(t);
+		}
+		else
+		{
+			simNextSync = simSysTime + 5 * SECS_PER_MIN;
+			simStatus = simStatus == timeNotSet ? timeNotSet : timeNeedsSync;
+		}
+	}
+
+	return simSysTime;
+}
+
+void setTime(time_t t)
+{
+	simSysTime = t;
+	simNextSync = t + 5 * SECS_PER_MIN;
+	simStatus = timeSet;
+	simPrevMillis = millis();
+}
+
+void setTime(int hr, int min, int sec, int dy, int mnth, int yr)
+{
+	tmElements_t tm;
+
+	// Two digit years are from 2000, like the real one
+	tm.Year = yr > 99 ? CalendarYrToTm(yr) : y2kYearToTm(yr);
+	tm.Month = mnth;
+	tm.Day = dy;
+	tm.Hour = hr;
+	tm.Minute = min;
+	tm.Second = sec;
+	setTime(makeTime(tm));
+}
+
+void setSyncProvider(getExternalTime provider)
+{
+	simSyncProvider = provider;
+	simNextSync = simSysTime;
+	now();
+}
+
+timeStatus_t timeStatus()
+{
+	now();
+	return simStatus;
+}
+
+time_t makeTime(const tmElements_t &tm)
+{
+	struct tm calendar = {};
+
+	calendar.tm_year = tmYearToCalendar(tm.Year) - 1900;
+	calendar.tm_mon = tm.Month - 1;
+	calendar.tm_mday = tm.Day;
+	calendar.tm_hour = tm.Hour;
+	calendar.tm_min = tm.Minute;
+	calendar.tm_sec = tm.Second;
+	return timegm(&calendar);
+}
+
+void breakTime(time_t t, tmElements_t &tm)
+{
+	struct tm calendar;
+	gmtime_r(&t, &calendar);
+
+	tm.Second = calendar.tm_sec;
+	tm.Minute = calendar.tm_min;
+	tm.Hour = calendar.tm_hour;
+	tm.Wday = calendar.tm_wday + 1;
+	tm.Day = calendar.tm_mday;
+	tm.Month = calendar.tm_mon + 1;
+	tm.Year = CalendarYrToTm(calendar.tm_year + 1900);
+}
+
+int hour(time_t t) { tmElements_t tm; breakTime(t, tm); return tm.Hour; }
+int minute(time_t t) { tmElements_t tm; breakTime(t, tm); return tm.Minute; }
+int second(time_t t) { tmElements_t tm; breakTime(t, tm); return tm.Second; }
+int day(time_t t) { tmElements_t tm; breakTime(t, tm); return tm.Day; }
+int weekday(time_t t) { tmElements_t tm; breakTime(t, tm); return tm.Wday; }
+int month(time_t t) { tmElements_t tm; breakTime(t, tm); return tm.Month; }
+int year(time_t t) { tmElements_t tm; breakTime(t, tm); return tmYearToCalendar(tm.Year); }
+
+int hour() { return hour(now()); }
+int minute() { return minute(now()); }
+int second() { return second(now()); }
+int day() { return day(now()); }
+int month() { return month(now()); }
+int year() { return year(now()); }
+
+// DS3232RTC, every register access is one I2C transaction
+
+time_t DS3232RTC::get()
+{
+	board.busy(SIM_I2C_US);
+	return board.rtc.get();
+}
+
+uint8_t DS3232RTC::set(time_t t)
+{
+	board.busy(SIM_I2C_US);
+	board.rtc.set(t);
+	return 0;
+}
+
+uint8_t DS3232RTC::read(tmElements_t &tm)
+{
+	breakTime(get(), tm);
+	return 0;
+}
+
+uint8_t DS3232RTC::write(tmElements_t &tm)
+{
+	return set(makeTime(tm));
+}
+
+void DS3232RTC::setAlarm(ALARM_TYPES_t alarmType, uint8_t seconds, uint8_t minutes, uint8_t hours, uint8_t daydate)
+{
+	board.busy(SIM_I2C_US);
+	board.rtc.setAlarm(alarmType, seconds, minutes, hours, daydate);
+}
+
+bool DS3232RTC::alarm(uint8_t alarmNumber)
+{
+	board.busy(SIM_I2C_US);
+	return board.rtc.alarm(alarmNumber);
+}
+
+void DS3232RTC::alarmInterrupt(uint8_t alarmNumber, bool alarmEnabled)
+{
+	board.busy(SIM_I2C_US);
+	board.rtc.alarmInterrupt(alarmNumber, alarmEnabled);
+}
+
+void DS3232RTC::squareWave(SQWAVE_FREQS_t freq)
+{
+	uint8_t control = readRTC(DS32_CONTROL);
+
+	// SQWAVE_NONE hands the pin to the alarms, anything else turns them off it
+	if (freq == SQWAVE_NONE) control |= bit(SIM_RTC_INTCN);
+	else control = (control & ~(bit(SIM_RTC_INTCN) | 0x18)) | (freq << 3);
+	writeRTC(DS32_CONTROL, control);
+}
+
+uint8_t DS3232RTC::readRTC(uint8_t addr)
+{
+	board.busy(SIM_I2C_US);
+	return board.rtc.readRegister(addr);
+}
+
+uint8_t DS3232RTC::writeRTC(uint8_t addr, uint8_t value)
+{
+	board.busy(SIM_I2C_US);
+	board.rtc.writeRegister(addr, value);
+	return 0;
+}
+
+int16_t DS3232RTC::temperature()
+{
+	board.busy(SIM_I2C_US);
+	return (int16_t)lround(board.environment(SIM_TEMP, board.hwid()) * 4);
+}
+
+// LoRa
+
+int LoRaClass::begin(long frequency)
+{
+	return board.radio.begin();
+}
+
+void LoRaClass::end()
+{
+	board.radio.sleep();
+}
+
+void LoRaClass::setSignalBandwidth(long bandwidth)
+{
+	board.radio.setSignalBandwidth(bandwidth);
+}
+
+void LoRaClass::setSpreadingFactor(int spreadingFactor)
+{
+	board.radio.setSpreadingFactor(spreadingFactor);
+}
+
+void LoRaClass::setCodingRate4(int denominator)
+{
+	board.radio.setCodingRate4(denominator);
+}
+
+void LoRaClass::setPreambleLength(long length)
+{
+	board.radio.setPreambleLength(length);
+}
+
+int LoRaClass::beginPacket(int implicitHeader)
+{
+	return board.radio.beginPacket();
+}
+
+size_t LoRaClass::write(uint8_t value)
+{
+	return board.radio.write(&value, 1);
+}
+
+size_t LoRaClass::write(const uint8_t *buffer, size_t size)
+{
+	return board.radio.write(buffer, size);
+}
+
+int LoRaClass::endPacket(bool async)
+{
+	return board.radio.endPacket();
+}
+
+int LoRaClass::parsePacket(int size)
+{
+	return board.radio.parsePacket();
+}
+
+int LoRaClass::available()
+{
+	return board.radio.available();
+}
+
+int LoRaClass::read()
+{
+	return board.radio.read();
+}
+
+int LoRaClass::peek()
+{
+	return board.radio.peek();
+}
+
+int LoRaClass::packetRssi()
+{
+	return SIM_RADIO_RSSI;
+}
+
+float LoRaClass::packetSnr()
+{
+	return 9.5;
+}
+
+void LoRaClass::receive(int size)
+{
+	board.radio.receive();
+}
+
+void LoRaClass::idle()
+{
+	board.radio.idle();
+}
+
+void LoRaClass::sleep()
+{
+	board.radio.sleep();
+}
+
+// SPI
+
+uint8_t SPIClass::transfer(uint8_t data)
+{
+	return board.spiTransfer(data);
+}
+
+void SPIClass::transfer(void *buffer, size_t count)
+{
+	uint8_t *bytes = (uint8_t *)buffer;
+
+	for (size_t i = 0; i < count; i++) bytes[i] = board.spiTransfer(bytes[i]);
+}
+
+// EEPROM
+
+uint8_t EEPROMClass::read(int address)
+{
+	return board.eepromRead(address);
+}
+
+void EEPROMClass::write(int address, uint8_t value)
+{
+	board.eepromUpdate(address, value);
+}
+
+void EEPROMClass::update(int address, uint8_t value)
+{
+	board.eepromUpdate(address, value);
+}
+
+// Sensors, both on the SENS_TOGGLE rail
+
+bool Adafruit_AHTX0::begin()
+{
+	board.busy(SIM_AHT_BEGIN_US);
+	return board.sensorRail();
+}
+
+bool Adafruit_AHTX0::getEvent(sensors_event_t *humidity, sensors_event_t *temperature)
+{
+	board.busy(SIM_AHT_MEASURE_US);
+	if (!board.sensorRail()) return false;
+
+	temperature->temperature = board.environment(SIM_TEMP, board.hwid());
+	humidity->relative_humidity = board.environment(SIM_HUMI, board.hwid());
+	return true;
+}
+
+void DallasTemperature::begin()
+{
+	board.busy(SIM_DS18B20_BEGIN_US);
+}
+
+void DallasTemperature::requestTemperatures()
+{
+	if (_waitForConversion) board.busy(SIM_DS18B20_CONVERT_US);
+}
+
+float DallasTemperature::getTempCByIndex(uint8_t index)
+{
+	board.busy(SIM_DS18B20_READ_US);
+	if (!board.sensorRail()) return DEVICE_DISCONNECTED_C;
+
+	// 12-bit resolution, sixteenths of a degree
+	return round(board.environment(SIM_STMP, board.hwid()) * 16) / 16;
+}
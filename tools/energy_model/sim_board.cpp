@@ -0,0 +1,354 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#include "sim_board.h"
+
+SIM_BOARD_class board;
+
+void SIM_BOARD_class::begin(time_t epoch, uint64_t length, uint8_t hwid, uint8_t neighbours, float battery, FILE *trace, bool echo)
+{
+	_epoch = epoch;
+	_end = length;
+	_hwid = hwid;
+	_battery = battery;
+	_trace = trace;
+	_echo = echo;
+
+	rtc.begin(epoch);
+	air.begin(hwid, neighbours);
+
+	if (_trace)
+	{
+		fprintf(_trace, "time,component,state\n");
+		for (uint8_t i = 0; i < SIM_COMPONENTS; i++)
+		{
+			fprintf(_trace, "0.000000,%s,%s\n", simComponentNames[i], simStateNames[i][_state[i]]);
+		}
+	}
+
+	#ifdef FLASH_LOGGING
+		flash.fit();
+		setState(SIM_FLASH, SIM_FLASH_STANDBY);
+	#endif
+}
+
+void SIM_BOARD_class::finish()
+{
+	for (uint8_t i = 0; i < SIM_COMPONENTS; i++)
+	{
+		_time[i][_state[i]] += _now - _since[i];
+		_since[i] = _now;
+	}
+}
+
+void SIM_BOARD_class::setState(uint8_t component, uint8_t state)
+{
+	if (_state[component] == state) return;
+
+	_time[component][_state[component]] += _now - _since[component];
+	_since[component] = _now;
+	_state[component] = state;
+
+	if (_trace)
+	{
+		fprintf(_trace, "%llu.%06llu,%s,%s\n", (unsigned long long)(_now / SIM_SECOND), (unsigned long long)(_now % SIM_SECOND),
+			simComponentNames[component], simStateNames[component][state]);
+	}
+}
+
+uint64_t SIM_BOARD_class::nextEvent()
+{
+	uint64_t next = std::min(rtc.nextEvent(), air.nextEvent());
+
+	next = std::min(next, flash.nextEvent());
+	return std::min(next, _openlogDone);
+}
+
+void SIM_BOARD_class::runEvents()
+{
+	rtc.runEvents(_now);
+	air.runEvents(_now);
+	flash.runEvents(_now);
+
+	if (_openlogDone <= _now)
+	{
+		_openlogDone = SIM_NEVER;
+		setState(SIM_OPENLOG, SIM_OPENLOG_IDLE);
+	}
+}
+
+void SIM_BOARD_class::moveTo(uint64_t time)
+{
+	if (_state[SIM_MCU] == SIM_MCU_ACTIVE)
+	{
+		_awake += time - _now;
+
+		// A real reset would start the firmware over, here it is only counted
+		if (_watchdogMs != 0 && _awake - _watchdogAt > _watchdogMs * 1000ULL)
+		{
+			count(SIM_WATCHDOG_FIRES);
+			_watchdogAt = _awake;
+		}
+	}
+
+	_now = time;
+}
+
+void SIM_BOARD_class::busy(uint64_t us)
+{
+	uint64_t target = _now + us;
+
+	// Interrupts that come due on the way still run, in the middle of a delay() like on the chip
+	for (;;)
+	{
+		uint64_t next = nextEvent();
+		if (next > target || next >= _end) break;
+
+		if (next > _now) moveTo(next);
+		runEvents();
+	}
+
+	if (target >= _end)
+	{
+		moveTo(_end);
+		throw SIM_END_OF_RUN();
+	}
+
+	moveTo(target);
+}
+
+void SIM_BOARD_class::sleep()
+{
+	setState(SIM_MCU, SIM_MCU_SLEEP);
+	_woken = false;
+
+	// Power-down: only an external interrupt brings the part back, with interrupts off it sleeps to the end
+	while (!_woken)
+	{
+		uint64_t next = nextEvent();
+		if (next >= _end)
+		{
+			moveTo(_end);
+			throw SIM_END_OF_RUN();
+		}
+
+		if (next > _now) moveTo(next);
+		runEvents();
+	}
+
+	setState(SIM_MCU, SIM_MCU_ACTIVE);
+	busy(SIM_WAKE_US);
+}
+
+void SIM_BOARD_class::attachInterrupt(int8_t interrupt, void (*isr)(), int mode)
+{
+	if (interrupt < 0 || interrupt > 1) return;
+
+	// A flag latched before this still fires as soon as interrupts are on, the firmware clears EIFR for that
+	_isr[interrupt] = isr;
+	_mode[interrupt] = mode;
+	dispatch();
+}
+
+void SIM_BOARD_class::detachInterrupt(int8_t interrupt)
+{
+	if (interrupt < 0 || interrupt > 1) return;
+
+	_isr[interrupt] = NULL;
+}
+
+void SIM_BOARD_class::setInterrupts(bool on)
+{
+	_interruptsOn = on;
+	dispatch();
+}
+
+void SIM_BOARD_class::setLine(uint8_t interrupt, bool level)
+{
+	if (_level[interrupt] == level) return;
+	_level[interrupt] = level;
+
+	// The sense control stays set after detachInterrupt(), so edges keep latching the flag
+	if (_mode[interrupt] == CHANGE || (_mode[interrupt] == RISING && level) || (_mode[interrupt] == FALLING && !level))
+	{
+		_flags |= bit(interrupt);
+		dispatch();
+	}
+}
+
+void SIM_BOARD_class::dispatch()
+{
+	if (!_interruptsOn) return;
+
+	for (uint8_t i = 0; i < 2; i++)
+	{
+		if (!(_flags & bit(i)) || _isr[i] == NULL) continue;
+
+		_flags &= ~bit(i);
+		if (_state[SIM_MCU] == SIM_MCU_SLEEP) count(i == 0 ? SIM_LORA_WAKES : SIM_RTC_WAKES);
+		_woken = true;
+		_isr[i]();
+	}
+}
+
+void SIM_BOARD_class::pinWrite(uint8_t pin, uint8_t value)
+{
+	if (pin == SENS_TOGGLE)
+	{
+		_sensorRail = value != LOW;
+		setState(SIM_SENSORS, _sensorRail ? SIM_RAIL_ON : SIM_RAIL_OFF);
+	}
+	else if (pin == LORA_TOGGLE)
+	{
+		setLoRaRail(value != LOW);
+	}
+	#ifdef FLASH_LOGGING
+		else if (pin == FLASH_CS)
+		{
+			flash.select(value == LOW);
+		}
+	#endif
+}
+
+void SIM_BOARD_class::setLoRaRail(bool on)
+{
+	if (_loraRail == on) return;
+	_loraRail = on;
+
+	radio.power(on);
+
+	// FLASH_LOGGING boards have the flash instead of OpenLog
+	#ifndef FLASH_LOGGING
+		if (!on && _openlogDone != SIM_NEVER)
+		{
+			count(SIM_OPENLOG_CUTS);
+			_openlogDone = SIM_NEVER;
+		}
+		setState(SIM_OPENLOG, on ? SIM_OPENLOG_IDLE : SIM_OPENLOG_OFF);
+	#endif
+}
+
+int SIM_BOARD_class::pinRead(uint8_t pin)
+{
+	// HW ID jumpers pull their pin to ground
+	if (pin == HWID_A) return _hwid & 1 ? LOW : HIGH;
+	if (pin == HWID_B) return _hwid & 2 ? LOW : HIGH;
+	if (pin == HWID_C) return _hwid & 4 ? LOW : HIGH;
+
+	return HIGH;
+}
+
+int SIM_BOARD_class::adcRead(uint8_t pin)
+{
+	busy(SIM_ADC_US);
+
+	if (pin == BATT_IN) return (int)lround(environment(SIM_BATT, _hwid) / SIM_DIVIDER / SIM_ADC_VOLTS * 1023);
+	if (pin == SMOIS_IN && _sensorRail) return (int)lround(environment(SIM_SMOI, _hwid));
+
+	return 0;
+}
+
+uint8_t SIM_BOARD_class::spiTransfer(uint8_t value)
+{
+	busy(SIM_SPI_BYTE_US);
+
+	return flash.transfer(value);
+}
+
+void SIM_BOARD_class::watchdogEnable(uint8_t timeout)
+{
+	_watchdogMs = 15UL << timeout;
+	_watchdogAt = _awake;
+}
+
+void SIM_BOARD_class::uartBegin(unsigned long baud)
+{
+	_uartOpen = true;
+	_baud = baud;
+}
+
+void SIM_BOARD_class::uartEnd()
+{
+	_uartOpen = false;
+}
+
+void SIM_BOARD_class::uartWrite(const uint8_t *data, size_t length)
+{
+	if (!_uartOpen || length == 0) return;
+
+	count(SIM_UART_BYTES, length);
+	if (_echo) fwrite(data, 1, length, stderr);
+
+	// Start bit, eight data bits, stop bit. OpenLog writes the card a little after the last byte.
+	bool openlog = _loraRail && _state[SIM_OPENLOG] != SIM_OPENLOG_OFF;
+	if (openlog)
+	{
+		_openlogDone = SIM_NEVER;
+		setState(SIM_OPENLOG, SIM_OPENLOG_WRITE);
+	}
+
+	busy(length * 10 * SIM_SECOND / _baud);
+
+	if (openlog) _openlogDone = _now + SIM_OPENLOG_COMMIT_US;
+}
+
+uint8_t SIM_BOARD_class::eepromRead(int address)
+{
+	return _eeprom[address & E2END];
+}
+
+void SIM_BOARD_class::eepromUpdate(int address, uint8_t value)
+{
+	if (_eeprom[address & E2END] == value) return;
+
+	_eeprom[address & E2END] = value;
+	count(SIM_EEPROM_WRITES);
+	busy(SIM_EEPROM_WRITE_US);
+}
+
+double SIM_BOARD_class::noise(uint8_t channel, uint8_t hwid)
+{
+	uint64_t key = ((uint64_t)trueTime() << 8) | (channel << 4) | hwid;
+
+	return (double)(simMix(key) >> 11) / (double)(1ULL << 53) * 2 - 1;
+}
+
+double SIM_BOARD_class::environment(uint8_t metric, uint8_t hwid)
+{
+	// A mild day on the roof, warmest mid-afternoon UTC, the soil lagging behind and drying slowly
+	double seconds = (double)trueTime();
+	double day = 2 * M_PI * fmod(seconds, SECS_PER_DAY) / SECS_PER_DAY;
+
+	switch (metric)
+	{
+		case SIM_TEMP:
+			return 9 + 4 * sin(day - 2.4) + 0.3 * hwid + 0.05 * noise(metric, hwid);
+		case SIM_HUMI:
+			return 82 - 10 * sin(day - 2.4) + 0.3 * noise(metric, hwid);
+		case SIM_STMP:
+			return 6 + sin(day - 3.1) + 0.2 * hwid + 0.02 * noise(metric, hwid);
+		case SIM_SMOI:
+			return 450 + 25 * sin(2 * M_PI * seconds / (5 * SECS_PER_DAY)) + 5 * hwid + 2 * noise(metric, hwid);
+		default:
+			return _battery + 0.02 * hwid + 0.003 * noise(metric, hwid);
+	}
+}
@@ -0,0 +1,246 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// The node's board for energy_model.cpp: a virtual clock, the power state of every part, the two
+// external interrupt lines and the weather the sensors read. The stand-in libraries in shim/ are
+// the only way the firmware reaches it, the same calls it makes on the real board.
+//
+// Time only moves when the firmware does something that takes time on the ATmega: delay(), a
+// radio poll, an ADC read, a bus transaction, a byte on the UART. sleep_cpu() jumps straight to
+// whatever wakes the part next, an RTC alarm or a frame arriving on the air.
+
+#ifndef sim_board_h
+#define sim_board_h
+
+#define SIM_NEVER				UINT64_MAX
+#define SIM_SECOND				1000000ULL
+
+// What the model charges for work it does not run cycle by cycle, in microseconds
+#define SIM_POLL_US				200			// One LoRa.parsePacket(), an SPI register read and the loop around it
+#define SIM_MILLIS_US			1
+#define SIM_ADC_US				112			// 13 ADC clocks at 125 kHz plus the call
+#define SIM_I2C_US				700			// One short DS3231 transaction at 100 kHz
+#define SIM_SPI_BYTE_US			1
+#define SIM_EEPROM_WRITE_US		3400
+#define SIM_WAKE_US				1000		// 16K CK crystal start-up out of power-down
+#define SIM_LORA_RESET_US		20000		// LoRa.begin() holds RESET for 10 ms, then waits 10 ms
+#define SIM_AHT_BEGIN_US		60000		// Adafruit driver: power-up wait, soft reset, calibration
+#define SIM_AHT_MEASURE_US		80000
+#define SIM_DS18B20_BEGIN_US	20000		// Bus reset and search
+#define SIM_DS18B20_CONVERT_US	750000		// 12-bit conversion, blocking by default
+#define SIM_DS18B20_READ_US		30000
+#define SIM_OPENLOG_COMMIT_US	100000		// OpenLog writing its buffer to the card after the last byte
+
+// Battery divider on BATT_IN, see hwio.h
+#define SIM_DIVIDER				((10000.0 + 33000.0) / 33000.0)
+#define SIM_ADC_VOLTS			3.3
+
+enum SIM_COMPONENTS : uint8_t
+{
+	SIM_MCU,
+	SIM_RADIO,
+	SIM_SENSORS,			// SENS_TOGGLE rail: AHT10, DS18B20, soil probe
+	SIM_OPENLOG,			// On the LORA_TOGGLE rail with the radio
+	SIM_FLASH,				// SPI NOR, only fitted in FLASH_LOGGING builds
+	SIM_COMPONENTS
+};
+
+enum SIM_STATES : uint8_t
+{
+	SIM_MCU_ACTIVE = 0,
+	SIM_MCU_SLEEP,
+
+	SIM_RADIO_OFF = 0,
+	SIM_RADIO_SLEEP,
+	SIM_RADIO_STANDBY,
+	SIM_RADIO_RX,
+	SIM_RADIO_TX,
+
+	SIM_RAIL_OFF = 0,
+	SIM_RAIL_ON,
+
+	SIM_OPENLOG_OFF = 0,
+	SIM_OPENLOG_IDLE,
+	SIM_OPENLOG_WRITE,
+
+	SIM_FLASH_ABSENT = 0,
+	SIM_FLASH_POWERDOWN,
+	SIM_FLASH_STANDBY,
+	SIM_FLASH_BUSY,
+
+	SIM_MAX_STATES = 5
+};
+
+static const char *const simComponentNames[SIM_COMPONENTS] = { "mcu", "radio", "sensors", "openlog", "flash" };
+static const char *const simStateNames[SIM_COMPONENTS][SIM_MAX_STATES] =
+{
+	{ "active", "sleep" },
+	{ "off", "sleep", "standby", "rx", "tx" },
+	{ "off", "on" },
+	{ "off", "idle", "write" },
+	{ "absent", "powerdown", "standby", "busy" }
+};
+
+enum SIM_COUNTERS : uint8_t
+{
+	SIM_RTC_WAKES,
+	SIM_LORA_WAKES,
+	SIM_FRAMES_SENT,
+	SIM_FRAMES_RECEIVED,
+	SIM_FRAMES_MISSED,		// Reached a powered radio that wasn't listening
+	SIM_EEPROM_WRITES,
+	SIM_UART_BYTES,
+	SIM_WATCHDOG_FIRES,		// Times the 8 s watchdog would have reset the node
+	SIM_OPENLOG_CUTS,		// Rail switched off while OpenLog was still writing
+	SIM_COUNTERS
+};
+
+static const char *const simCounterNames[SIM_COUNTERS] =
+{
+	"rtc_wakes", "lora_wakes", "frames_sent", "frames_received", "frames_missed",
+	"eeprom_writes", "uart_bytes", "watchdog_fires", "openlog_cuts"
+};
+
+// Sensor channels, same order as the LoRa headers
+enum SIM_METRICS : uint8_t
+{
+	SIM_TEMP,
+	SIM_HUMI,
+	SIM_STMP,
+	SIM_SMOI,
+	SIM_BATT,
+	SIM_METRICS
+};
+
+struct SIM_END_OF_RUN {};				// Thrown when the clock reaches the end of the run
+
+// splitmix64, noise keyed on time and channel so every build sees the same weather
+static inline uint64_t simMix(uint64_t x)
+{
+	x += 0x9E3779B97F4A7C15ULL;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+	return x ^ (x >> 31);
+}
+
+#include "sim_rtc.h"
+#include "sim_radio.h"
+#include "sim_air.h"
+#include "sim_flash.h"
+
+class SIM_BOARD_class
+{
+	private:
+		uint64_t _now = 0;
+		uint64_t _end = SIM_NEVER;
+		uint64_t _awake = 0;					// Microseconds out of power-down, what millis() counts
+		time_t _epoch = 0;						// True UTC at _now == 0
+		uint8_t _hwid = 0;
+		float _battery = 3.9;
+
+		uint8_t _state[SIM_COMPONENTS] = {};
+		uint64_t _since[SIM_COMPONENTS] = {};
+		uint64_t _time[SIM_COMPONENTS][SIM_MAX_STATES] = {};
+		uint64_t _counters[SIM_COUNTERS] = {};
+		FILE *_trace = NULL;
+		bool _echo = false;
+
+		// INT0 is LoRa DIO0 (active high), INT1 the DS3231's INT/SQW (open drain, active low)
+		void (*_isr[2])() = { NULL, NULL };
+		int _mode[2] = { 0, 0 };
+		bool _level[2] = { false, true };
+		uint8_t _flags = 0;
+		bool _interruptsOn = true;
+		bool _woken = false;
+
+		bool _sensorRail = false;
+		bool _loraRail = false;
+		uint32_t _watchdogMs = 0;
+		uint64_t _watchdogAt = 0;
+		bool _uartOpen = false;
+		unsigned long _baud = 0;
+		uint64_t _openlogDone = SIM_NEVER;
+		uint8_t _eeprom[E2END + 1];
+
+		uint64_t nextEvent();
+		void runEvents();
+		void moveTo(uint64_t time);
+		void dispatch();
+		void setLoRaRail(bool on);
+		double noise(uint8_t channel, uint8_t hwid);
+
+	public:
+		SIM_RTC_class rtc;
+		SIM_RADIO_class radio;
+		SIM_AIR_class air;
+		SIM_FLASH_class flash;
+
+		SIM_BOARD_class() { memset(_eeprom, 0xFF, sizeof(_eeprom)); }
+
+		void begin(time_t epoch, uint64_t length, uint8_t hwid, uint8_t neighbours, float battery, FILE *trace, bool echo);
+		void finish();
+
+		// Clock
+		uint64_t now() { return _now; }
+		uint64_t awake() { return _awake; }
+		time_t trueTime() { return _epoch + _now / SIM_SECOND; }
+		time_t trueTime(uint64_t at) { return _epoch + at / SIM_SECOND; }
+		uint8_t hwid() { return _hwid; }
+		void busy(uint64_t us);
+		void sleep();
+
+		// Accounting
+		void setState(uint8_t component, uint8_t state);
+		uint8_t getState(uint8_t component) { return _state[component]; }
+		uint64_t stateTime(uint8_t component, uint8_t state) { return _time[component][state]; }
+		void count(uint8_t counter, uint64_t amount = 1) { _counters[counter] += amount; }
+		uint64_t getCounter(uint8_t counter) { return _counters[counter]; }
+
+		// External interrupts
+		void attachInterrupt(int8_t interrupt, void (*isr)(), int mode);
+		void detachInterrupt(int8_t interrupt);
+		void setInterrupts(bool on);
+		void clearFlags(uint8_t mask) { _flags &= ~mask; }
+		void setLine(uint8_t interrupt, bool level);
+
+		// Pins and peripherals
+		void pinWrite(uint8_t pin, uint8_t value);
+		int pinRead(uint8_t pin);
+		int adcRead(uint8_t pin);
+		bool sensorRail() { return _sensorRail; }
+		uint8_t spiTransfer(uint8_t value);
+		void watchdogEnable(uint8_t timeout);
+		void watchdogDisable() { _watchdogMs = 0; }
+		void watchdogReset() { _watchdogAt = _awake; }
+		void uartBegin(unsigned long baud);
+		void uartEnd();
+		void uartWrite(const uint8_t *data, size_t length);
+		uint8_t eepromRead(int address);
+		void eepromUpdate(int address, uint8_t value);
+
+		// What the sensors of node hwid would read right now
+		double environment(uint8_t metric, uint8_t hwid);
+};
+
+extern SIM_BOARD_class board;
+
+#endif
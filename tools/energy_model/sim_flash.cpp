@@ -0,0 +1,136 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#include "sim_board.h"
+
+void SIM_FLASH_class::fit()
+{
+	_data.assign(SIM_FLASH_BYTES, 0xFF);
+}
+
+bool SIM_FLASH_class::busyNow()
+{
+	return _busyUntil != SIM_NEVER;
+}
+
+void SIM_FLASH_class::select(bool selected)
+{
+	if (!fitted()) return;
+
+	if (selected)
+	{
+		_selected = true;
+		_command = 0;
+		_count = 0;
+		_pageLength = 0;
+		return;
+	}
+	if (!_selected) return;
+	_selected = false;
+
+	uint8_t state = board.getState(SIM_FLASH);
+
+	// Commands take effect on the rising edge of CS, nothing but Release wakes a powered down chip
+	if (state == SIM_FLASH_POWERDOWN)
+	{
+		if (_command == SIM_FLASH_RELEASE) board.setState(SIM_FLASH, SIM_FLASH_STANDBY);
+		return;
+	}
+	if (busyNow()) return;
+
+	if (_command == SIM_FLASH_WRITE_ENABLE)
+	{
+		_writeEnabled = true;
+	}
+	else if (_command == SIM_FLASH_POWER_DOWN)
+	{
+		board.setState(SIM_FLASH, SIM_FLASH_POWERDOWN);
+	}
+	else if (_command == SIM_FLASH_PAGE_PROGRAM && _writeEnabled && _count >= 4)
+	{
+		// Programming only clears bits, and the address wraps inside the page
+		for (uint16_t i = 0; i < _pageLength; i++)
+		{
+			uint32_t address = (_address & ~(uint32_t)(SIM_FLASH_PAGE - 1)) | ((_address + i) & (SIM_FLASH_PAGE - 1));
+			_data[address % SIM_FLASH_BYTES] &= _page[i];
+		}
+
+		_writeEnabled = false;
+		_busyUntil = board.now() + SIM_FLASH_PROGRAM_US;
+		board.setState(SIM_FLASH, SIM_FLASH_BUSY);
+	}
+	else if (_command == SIM_FLASH_SECTOR_ERASE && _writeEnabled && _count >= 4)
+	{
+		uint32_t sector = (_address % SIM_FLASH_BYTES) & ~(uint32_t)(SIM_FLASH_SECTOR - 1);
+		memset(&_data[sector], 0xFF, SIM_FLASH_SECTOR);
+
+		_writeEnabled = false;
+		_busyUntil = board.now() + SIM_FLASH_ERASE_US;
+		board.setState(SIM_FLASH, SIM_FLASH_BUSY);
+	}
+}
+
+uint8_t SIM_FLASH_class::transfer(uint8_t value)
+{
+	if (!fitted() || !_selected) return 0xFF;
+
+	uint16_t index = _count++;
+	if (index == 0)
+	{
+		_command = value;
+		_address = 0;
+		return 0xFF;
+	}
+	if (board.getState(SIM_FLASH) == SIM_FLASH_POWERDOWN) return 0xFF;
+
+	switch (_command)
+	{
+		case SIM_FLASH_READ_STATUS:
+			return (busyNow() ? SIM_FLASH_STATUS_BUSY : 0) | (_writeEnabled ? SIM_FLASH_STATUS_WEL : 0);
+
+		case SIM_FLASH_JEDEC_ID:
+			return index <= 3 ? (SIM_FLASH_JEDEC >> (8 * (3 - index))) & 0xFF : 0xFF;
+
+		case SIM_FLASH_READ_DATA:
+		case SIM_FLASH_PAGE_PROGRAM:
+		case SIM_FLASH_SECTOR_ERASE:
+			if (index <= 3)
+			{
+				_address = (_address << 8) | value;
+				return 0xFF;
+			}
+			if (_command == SIM_FLASH_READ_DATA && !busyNow()) return _data[(_address + index - 4) % SIM_FLASH_BYTES];
+			if (_command == SIM_FLASH_PAGE_PROGRAM && _pageLength < SIM_FLASH_PAGE) _page[_pageLength++] = value;
+			return 0xFF;
+
+		default:
+			return 0xFF;
+	}
+}
+
+void SIM_FLASH_class::runEvents(uint64_t now)
+{
+	if (_busyUntil > now) return;
+
+	_busyUntil = SIM_NEVER;
+	board.setState(SIM_FLASH, SIM_FLASH_STANDBY);
+}
@@ -0,0 +1,73 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// W25Q16 on the SPI bus for FLASH_LOGGING builds, the commands flash_module.cpp uses with the
+// same typical program and erase times as tools/flash_bench
+
+#ifndef sim_flash_h
+#define sim_flash_h
+
+#define SIM_FLASH_BYTES			(2UL * 1024 * 1024)
+#define SIM_FLASH_PAGE			256
+#define SIM_FLASH_SECTOR		4096
+#define SIM_FLASH_PROGRAM_US	700			// tPP
+#define SIM_FLASH_ERASE_US		45000		// tSE
+#define SIM_FLASH_JEDEC			0xEF4015UL	// Winbond, SPI, 2^21 bytes
+
+// Commands, the same codes as flash_module.h
+#define SIM_FLASH_WRITE_ENABLE	0x06
+#define SIM_FLASH_READ_STATUS	0x05
+#define SIM_FLASH_READ_DATA		0x03
+#define SIM_FLASH_PAGE_PROGRAM	0x02
+#define SIM_FLASH_SECTOR_ERASE	0x20
+#define SIM_FLASH_JEDEC_ID		0x9F
+#define SIM_FLASH_POWER_DOWN	0xB9
+#define SIM_FLASH_RELEASE		0xAB
+#define SIM_FLASH_STATUS_BUSY	0x01
+#define SIM_FLASH_STATUS_WEL	0x02
+
+class SIM_FLASH_class
+{
+	private:
+		std::vector<uint8_t> _data;
+		bool _selected = false;
+		bool _writeEnabled = false;
+		uint8_t _command = 0;
+		uint16_t _count = 0;					// Bytes clocked since select
+		uint32_t _address = 0;
+		uint8_t _page[SIM_FLASH_PAGE];
+		uint16_t _pageLength = 0;
+		uint64_t _busyUntil = SIM_NEVER;
+
+		bool fitted() { return !_data.empty(); }
+		bool busyNow();
+
+	public:
+		void fit();
+		void select(bool selected);
+		uint8_t transfer(uint8_t value);
+
+		uint64_t nextEvent() { return _busyUntil; }
+		void runEvents(uint64_t now);
+};
+
+#endif
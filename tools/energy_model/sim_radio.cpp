@@ -0,0 +1,172 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#include "sim_board.h"
+
+void SIM_RADIO_class::enter(uint8_t state)
+{
+	board.setState(SIM_RADIO, state);
+}
+
+void SIM_RADIO_class::power(bool on)
+{
+	// Power-on reset puts every register back, the firmware configures it again after each wake
+	_continuous = false;
+	_rxDone = false;
+	_length = 0;
+	_index = 0;
+	_spreadingFactor = 7;
+	_bandwidth = 125000;
+	_codingRate = 5;
+	_preamble = 8;
+
+	board.setLine(0, false);
+	enter(on ? SIM_RADIO_STANDBY : SIM_RADIO_OFF);
+}
+
+bool SIM_RADIO_class::begin()
+{
+	if (board.getState(SIM_RADIO) == SIM_RADIO_OFF) return false;
+
+	board.busy(SIM_LORA_RESET_US);
+	enter(SIM_RADIO_STANDBY);
+	return true;
+}
+
+void SIM_RADIO_class::idle()
+{
+	if (board.getState(SIM_RADIO) == SIM_RADIO_OFF) return;
+
+	enter(SIM_RADIO_STANDBY);
+}
+
+void SIM_RADIO_class::sleep()
+{
+	if (board.getState(SIM_RADIO) == SIM_RADIO_OFF) return;
+
+	enter(SIM_RADIO_SLEEP);
+}
+
+void SIM_RADIO_class::receive()
+{
+	if (board.getState(SIM_RADIO) == SIM_RADIO_OFF) return;
+
+	_continuous = true;
+	if (board.getState(SIM_RADIO) != SIM_RADIO_RX) _rxSince = board.now();
+	enter(SIM_RADIO_RX);
+}
+
+int SIM_RADIO_class::parsePacket()
+{
+	board.busy(SIM_POLL_US);
+
+	if (board.getState(SIM_RADIO) == SIM_RADIO_OFF) return 0;
+
+	// Reading and clearing the IRQ flags drops DIO0
+	if (_rxDone)
+	{
+		_rxDone = false;
+		board.setLine(0, false);
+		_index = 0;
+		enter(SIM_RADIO_STANDBY);
+		return _length;
+	}
+
+	// Anything but RXSINGLE, RXCONTINUOUS included, is switched to RXSINGLE
+	if (board.getState(SIM_RADIO) != SIM_RADIO_RX || _continuous)
+	{
+		_continuous = false;
+		_rxSince = board.now();
+		enter(SIM_RADIO_RX);
+	}
+
+	return 0;
+}
+
+int SIM_RADIO_class::beginPacket()
+{
+	if (board.getState(SIM_RADIO) == SIM_RADIO_OFF) return 0;
+
+	enter(SIM_RADIO_STANDBY);
+	_txLength = 0;
+	return 1;
+}
+
+size_t SIM_RADIO_class::write(const uint8_t *data, size_t length)
+{
+	size_t room = SIM_RADIO_FIFO - _txLength;
+	if (length > room) length = room;
+
+	memcpy(_tx + _txLength, data, length);
+	_txLength += length;
+	board.busy(length * SIM_SPI_BYTE_US);
+	return length;
+}
+
+int SIM_RADIO_class::endPacket()
+{
+	if (board.getState(SIM_RADIO) == SIM_RADIO_OFF) return 0;
+
+	uint64_t start = board.now();
+	uint64_t duration = airtime(_txLength);
+
+	enter(SIM_RADIO_TX);
+	board.air.nodeTransmit(_tx, _txLength, start, start + duration);
+	board.busy(duration);
+
+	// TxDone on DIO0, then the library clears it and the chip drops to standby
+	board.setLine(0, true);
+	board.setLine(0, false);
+	enter(SIM_RADIO_STANDBY);
+	board.count(SIM_FRAMES_SENT);
+	return 1;
+}
+
+void SIM_RADIO_class::deliver(const uint8_t *data, uint8_t length, uint64_t start)
+{
+	uint8_t state = board.getState(SIM_RADIO);
+
+	if (state != SIM_RADIO_RX || _rxSince > start)
+	{
+		if (state != SIM_RADIO_OFF) board.count(SIM_FRAMES_MISSED);
+		return;
+	}
+
+	memcpy(_fifo, data, length);
+	_length = length;
+	_index = 0;
+	_rxDone = true;
+	board.count(SIM_FRAMES_RECEIVED);
+
+	if (!_continuous) enter(SIM_RADIO_STANDBY);
+	board.setLine(0, true);
+}
+
+uint64_t SIM_RADIO_class::airtime(uint8_t length)
+{
+	// Semtech AN1200.13, explicit header with CRC, same as gateway_node/lib/fake_radio.cpp
+	double symbol = (double)(1L << _spreadingFactor) / _bandwidth * 1000000;
+	int lowRate = symbol > 16000 ? 1 : 0;
+	double payload = ceil((8.0 * length - 4 * _spreadingFactor + 28 + 16) / (4 * (_spreadingFactor - 2 * lowRate)));
+
+	return (uint64_t)((_preamble + 4.25) * symbol + (8 + std::max(payload, 0.0) * _codingRate) * symbol);
+}
@@ -0,0 +1,80 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// SX1278 for the energy model: operating modes, the FIFO and DIO0. Frames reach it from the
+// simulated air at the moment their last symbol arrives, and only count when the radio has been
+// receiving since their first one.
+//
+// DIO0 keeps its reset mapping, RxDone while receiving and TxDone while transmitting. The LoRa
+// library's blocking endPacket() clears TxDone itself, but the edge still reaches INT0.
+
+#ifndef sim_radio_h
+#define sim_radio_h
+
+#define SIM_RADIO_FIFO			256
+#define SIM_RADIO_RSSI			-70
+
+class SIM_RADIO_class
+{
+	private:
+		bool _continuous = false;				// RXCONTINUOUS, otherwise RXSINGLE when receiving
+		bool _rxDone = false;
+		uint64_t _rxSince = 0;
+		uint8_t _fifo[SIM_RADIO_FIFO];
+		int _length = 0;
+		int _index = 0;
+		uint8_t _tx[SIM_RADIO_FIFO];
+		int _txLength = 0;
+
+		// Register defaults after power-up, LoRa.begin() leaves them alone
+		int _spreadingFactor = 7;
+		long _bandwidth = 125000;
+		int _codingRate = 5;
+		long _preamble = 8;
+
+		void enter(uint8_t state);
+
+	public:
+		void power(bool on);
+		bool begin();
+		void setSpreadingFactor(int spreadingFactor) { _spreadingFactor = spreadingFactor; }
+		void setSignalBandwidth(long bandwidth) { _bandwidth = bandwidth; }
+		void setCodingRate4(int denominator) { _codingRate = denominator; }
+		void setPreambleLength(long length) { _preamble = length; }
+
+		void idle();
+		void sleep();
+		void receive();
+		int parsePacket();
+		int available() { return _length - _index; }
+		int read() { return _index < _length ? _fifo[_index++] : -1; }
+		int peek() { return _index < _length ? _fifo[_index] : -1; }
+
+		int beginPacket();
+		size_t write(const uint8_t *data, size_t length);
+		int endPacket();
+
+		void deliver(const uint8_t *data, uint8_t length, uint64_t start);
+		uint64_t airtime(uint8_t length);
+};
+
+#endif
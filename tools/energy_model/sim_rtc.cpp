@@ -0,0 +1,187 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+#include "sim_board.h"
+
+void SIM_RTC_class::begin(time_t t)
+{
+	_base = t;
+	_baseAt = board.now();
+}
+
+double SIM_RTC_class::rate()
+{
+	return 1 + (_ppm - _aging * SIM_RTC_AGING_PPM) * 1e-6;
+}
+
+void SIM_RTC_class::rebase()
+{
+	// Move the base up to the last rollover, so a new rate only applies from here on
+	uint64_t now = board.now();
+	time_t seconds = (time_t)((now - _baseAt) * rate() / SIM_SECOND);
+
+	_baseAt += (uint64_t)llround(seconds * SIM_SECOND / rate());
+	_base += seconds;
+}
+
+time_t SIM_RTC_class::get()
+{
+	return _base + (time_t)((board.now() - _baseAt) * rate() / SIM_SECOND);
+}
+
+void SIM_RTC_class::set(time_t t)
+{
+	// Writing the seconds register restarts the 1 Hz countdown
+	begin(t);
+	schedule(0);
+	schedule(1);
+}
+
+int64_t SIM_RTC_class::offset()
+{
+	// Microseconds the RTC is ahead of true UTC right now
+	uint64_t now = board.now();
+	double ahead = (now - _baseAt) * (rate() - 1);
+
+	return ((int64_t)_base - (int64_t)board.trueTime(_baseAt)) * (int64_t)SIM_SECOND - (int64_t)(_baseAt % SIM_SECOND) + llround(ahead);
+}
+
+void SIM_RTC_class::setAlarm(uint8_t type, uint8_t seconds, uint8_t minutes, uint8_t hours, uint8_t daydate)
+{
+	uint8_t alarm = type < DS3232RTC::ALM2_EVERY_MINUTE ? 0 : 1;
+
+	_type[alarm] = type;
+	_seconds[alarm] = alarm == 0 ? seconds : 0;
+	_minutes[alarm] = minutes;
+	_hours[alarm] = hours;
+	_daydate[alarm] = daydate;
+	schedule(alarm);
+}
+
+bool SIM_RTC_class::matches(uint8_t alarm, time_t t)
+{
+	tmElements_t tm;
+	breakTime(t, tm);
+
+	bool second = tm.Second == _seconds[alarm];
+	bool minute = second && tm.Minute == _minutes[alarm];
+	bool hour = minute && tm.Hour == _hours[alarm];
+
+	switch (_type[alarm])
+	{
+		case DS3232RTC::ALM1_EVERY_SECOND:	return true;
+		case DS3232RTC::ALM1_MATCH_SECONDS:
+		case DS3232RTC::ALM2_EVERY_MINUTE:	return second;
+		case DS3232RTC::ALM1_MATCH_MINUTES:
+		case DS3232RTC::ALM2_MATCH_MINUTES:	return minute;
+		case DS3232RTC::ALM1_MATCH_HOURS:
+		case DS3232RTC::ALM2_MATCH_HOURS:	return hour;
+		case DS3232RTC::ALM1_MATCH_DATE:
+		case DS3232RTC::ALM2_MATCH_DATE:	return hour && tm.Day == _daydate[alarm];
+		default:							return hour && tm.Wday == _daydate[alarm];
+	}
+}
+
+void SIM_RTC_class::schedule(uint8_t alarm)
+{
+	time_t t = get() + 1;
+
+	// Find the next matching second, then walk whole minutes from there
+	for (uint8_t i = 0; i < 60 && !matches(alarm, t) && (t % 60) != _seconds[alarm]; i++) t++;
+	for (uint32_t i = 0; i < SIM_RTC_SEARCH_MINUTES && !matches(alarm, t); i++) t += 60;
+
+	_nextAt[alarm] = matches(alarm, t) ? _baseAt + (uint64_t)ceil((t - _base) * SIM_SECOND / rate()) : SIM_NEVER;
+}
+
+bool SIM_RTC_class::alarm(uint8_t alarmNumber)
+{
+	uint8_t alarm = alarmNumber - 1;
+	bool flag = _flag[alarm];
+
+	_flag[alarm] = false;
+	updateLine();
+	return flag;
+}
+
+void SIM_RTC_class::alarmInterrupt(uint8_t alarmNumber, bool enabled)
+{
+	_enabled[alarmNumber - 1] = enabled;
+	updateLine();
+}
+
+uint8_t SIM_RTC_class::readRegister(uint8_t address)
+{
+	if (address == SIM_RTC_CONTROL) return (_control & ~0x03) | _enabled[0] | (_enabled[1] << 1);
+	if (address == SIM_RTC_STATUS) return _flag[0] | (_flag[1] << 1);
+	if (address == SIM_RTC_AGING) return (uint8_t)_aging;
+
+	return 0;
+}
+
+void SIM_RTC_class::writeRegister(uint8_t address, uint8_t value)
+{
+	if (address == SIM_RTC_CONTROL)
+	{
+		// A conversion is over before the next access, CONV never reads back set
+		_control = value & ~(0x03 | bit(SIM_RTC_CONV));
+		_enabled[0] = value & 0x01;
+		_enabled[1] = value & 0x02;
+	}
+	else if (address == SIM_RTC_STATUS)
+	{
+		// Alarm flags can only be cleared from the bus
+		_flag[0] = _flag[0] && (value & 0x01);
+		_flag[1] = _flag[1] && (value & 0x02);
+	}
+	else if (address == SIM_RTC_AGING)
+	{
+		rebase();
+		_aging = (int8_t)value;
+		schedule(0);
+		schedule(1);
+	}
+
+	updateLine();
+}
+
+void SIM_RTC_class::updateLine()
+{
+	bool pending = (_flag[0] && _enabled[0]) || (_flag[1] && _enabled[1]);
+
+	board.setLine(1, !((_control & bit(SIM_RTC_INTCN)) && pending));
+}
+
+void SIM_RTC_class::runEvents(uint64_t now)
+{
+	bool changed = false;
+
+	for (uint8_t i = 0; i < 2; i++)
+	{
+		if (_nextAt[i] > now) continue;
+
+		_flag[i] = true;
+		schedule(i);
+		changed = true;
+	}
+
+	if (changed) updateLine();
+}
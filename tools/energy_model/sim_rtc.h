@@ -0,0 +1,80 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// DS3231 for the energy model: the time of day, both alarms and the INT pin they pull low.
+// Alarm flags set on the matching second whether or not their interrupt is enabled, and INT
+// stays low until the firmware clears every enabled flag that is set, like the real part.
+// The crystal can be set off by some ppm, and the aging register pulls it back a tenth of a
+// ppm per step, at once rather than at the next temperature conversion.
+
+#ifndef sim_rtc_h
+#define sim_rtc_h
+
+#define SIM_RTC_CONTROL			0x0E
+#define SIM_RTC_STATUS			0x0F
+#define SIM_RTC_INTCN			2
+#define SIM_RTC_CONV			5
+#define SIM_RTC_AGING			0x10
+#define SIM_RTC_AGING_PPM		0.1
+#define SIM_RTC_SEARCH_MINUTES	(32 * 24 * 60)		// Longest an alarm can be away, one date match
+
+class SIM_RTC_class
+{
+	private:
+		time_t _base = 0;						// RTC time at _baseAt, seconds roll over in step with it
+		uint64_t _baseAt = 0;
+		double _ppm = 0;						// Crystal error, positive runs fast
+		int8_t _aging = 0;
+		uint8_t _type[2] = {};					// DS3232RTC::ALARM_TYPES_t
+		uint8_t _seconds[2] = {};
+		uint8_t _minutes[2] = {};
+		uint8_t _hours[2] = {};
+		uint8_t _daydate[2] = {};
+		bool _flag[2] = {};
+		bool _enabled[2] = {};
+		uint64_t _nextAt[2] = { SIM_NEVER, SIM_NEVER };
+		uint8_t _control = bit(SIM_RTC_INTCN) | 0x18;
+
+		double rate();
+		void rebase();
+		void schedule(uint8_t alarm);
+		bool matches(uint8_t alarm, time_t t);
+		void updateLine();
+
+	public:
+		void begin(time_t t);
+		time_t get();
+		void set(time_t t);
+		int64_t offset();
+		void setCrystal(double ppm) { rebase(); _ppm = ppm; schedule(0); schedule(1); }
+
+		void setAlarm(uint8_t type, uint8_t seconds, uint8_t minutes, uint8_t hours, uint8_t daydate);
+		bool alarm(uint8_t alarmNumber);
+		void alarmInterrupt(uint8_t alarmNumber, bool enabled);
+		uint8_t readRegister(uint8_t address);
+		void writeRegister(uint8_t address, uint8_t value);
+
+		uint64_t nextEvent() { return _nextAt[0] < _nextAt[1] ? _nextAt[0] : _nextAt[1]; }
+		void runEvents(uint64_t now);
+};
+
+#endif
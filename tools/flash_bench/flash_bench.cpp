@@ -0,0 +1,341 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// Runs the node's flash log engine against a fake NOR chip on Linux
+//
+// Build:	g++ -std=c++17 -O2 -Wall -o flash_bench flash_bench.cpp
+// Usage:	./flash_bench [-s sectors] [-n hours] [-p power_cut_trials] [-f image_file]
+//
+// With -f the chip lives in a file, so the log survives between runs like the real part.
+// Device times use W25Q16 typical figures and an 8 MHz SPI clock.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <unistd.h>
+
+#include "../../system_node/lib/flash_module/flash_log.h"
+#include "../../system_node/lib/flash_module/flash_log.cpp"
+
+#define DEFAULT_SECTORS		512
+#define DEFAULT_HOURS		100000
+#define DEFAULT_TRIALS		2000
+#define PAYLOAD_BYTES		14			// HISTORY_RECORD
+#define BACKFILL_HOURS		16
+
+#define PROGRAM_US			700.0		// tPP
+#define ERASE_US			45000.0		// tSE
+#define SPI_BYTE_US			1.0			// 8 bits at 8 MHz
+#define COMMAND_BYTES		4
+
+struct POWER_CUT {};
+
+class FAKE_FLASH_class : public FLASH_DEVICE_class
+{
+	private:
+		std::vector<uint8_t> _data;
+		uint16_t _sectorCount;
+		long _cutAfter = -1;			// Bytes programmed before the power goes, -1 for never
+
+	public:
+		std::vector<uint32_t> eraseCounts;
+		unsigned long reads = 0;
+		unsigned long programs = 0;
+		unsigned long erases = 0;
+		double deviceMicros = 0;
+
+		FAKE_FLASH_class(uint16_t sectorCount) : _data(sectorCount * FLASH_SECTOR_BYTES, FLASH_ERASED), _sectorCount(sectorCount), eraseCounts(sectorCount, 0) {}
+
+		std::vector<uint8_t> &image() { return _data; }
+		void cutPowerAfter(long bytes) { _cutAfter = bytes; }
+		void resetCounters() { reads = programs = erases = 0; deviceMicros = 0; }
+
+		uint16_t getSectorCount() { return _sectorCount; }
+
+		void read(uint32_t address, void *buffer, uint16_t length)
+		{
+			memcpy(buffer, &_data[address], length);
+			reads++;
+			deviceMicros += (COMMAND_BYTES + length) * SPI_BYTE_US;
+		}
+
+		void program(uint32_t address, const void *buffer, uint16_t length)
+		{
+			if ((address % FLASH_PAGE_BYTES) + length > FLASH_PAGE_BYTES)
+			{
+				fprintf(stderr, "program crosses a page at 0x%06x\n", address);
+				exit(3);
+			}
+
+			// NOR can only clear bits, an interrupted program stops part way
+			for (uint16_t i = 0; i < length; i++)
+			{
+				if (_cutAfter == 0) throw POWER_CUT();
+				if (_cutAfter > 0) _cutAfter--;
+				_data[address + i] &= ((const uint8_t *)buffer)[i];
+			}
+
+			programs++;
+			deviceMicros += (COMMAND_BYTES + length) * SPI_BYTE_US + PROGRAM_US;
+		}
+
+		void eraseSector(uint32_t address)
+		{
+			uint32_t start = address - address % FLASH_SECTOR_BYTES;
+
+			// An interrupted erase leaves the sector half done
+			if (_cutAfter == 0)
+			{
+				memset(&_data[start], FLASH_ERASED, FLASH_SECTOR_BYTES / 2);
+				throw POWER_CUT();
+			}
+
+			memset(&_data[start], FLASH_ERASED, FLASH_SECTOR_BYTES);
+			eraseCounts[start / FLASH_SECTOR_BYTES]++;
+			erases++;
+			deviceMicros += COMMAND_BYTES * SPI_BYTE_US + ERASE_US;
+		}
+};
+
+static void makePayload(uint32_t hourKey, uint8_t *payload)
+{
+	for (uint8_t i = 0; i < PAYLOAD_BYTES; i++) payload[i] = (uint8_t)(hourKey * 31 + i * 7);
+}
+
+static bool checkHour(FLASH_LOG_class &log, uint32_t hourKey)
+{
+	uint8_t expected[PAYLOAD_BYTES];
+	uint8_t payload[FLASH_PAYLOAD_MAX];
+	uint8_t length = 0;
+
+	makePayload(hourKey, expected);
+
+	return log.find(hourKey, payload, length) && length == PAYLOAD_BYTES && memcmp(payload, expected, PAYLOAD_BYTES) == 0;
+}
+
+static double elapsedMicros(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+static int runThroughput(uint16_t sectors, uint32_t hours, const char *imageFile)
+{
+	FAKE_FLASH_class flash(sectors);
+	FLASH_LOG_class log(flash);
+	uint8_t payload[PAYLOAD_BYTES];
+	FILE *file = imageFile ? fopen(imageFile, "rb") : nullptr;
+
+	if (file)
+	{
+		if (fread(flash.image().data(), 1, flash.image().size(), file) != flash.image().size()) fprintf(stderr, "%s: short image, rest stays erased\n", imageFile);
+		fclose(file);
+	}
+
+	if (!log.mount())
+	{
+		fprintf(stderr, "mount failed\n");
+		return 1;
+	}
+
+	uint32_t firstHour = log.getLastHourKey() == FLASH_NO_KEY ? 1 : log.getLastHourKey() + 1;
+	printf("Mounted %u sectors, %u in use, resuming at hour %u\n", sectors, log.getSectorsUsed(), firstHour);
+
+	// Appends
+	flash.resetCounters();
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t hour = firstHour; hour < firstHour + hours; hour++)
+	{
+		makePayload(hour, payload);
+		if (!log.append(hour, payload, PAYLOAD_BYTES))
+		{
+			fprintf(stderr, "append failed at hour %u\n", hour);
+			return 1;
+		}
+	}
+	double hostMicros = elapsedMicros(start);
+
+	printf("Append:   %u hours | host %.3f us/op | device %.3f ms/op | %lu programs, %lu erases\n",
+		hours, hostMicros / hours, flash.deviceMicros / hours / 1000, flash.programs, flash.erases);
+
+	// Backfill-style lookups of the most recent hours, then random ones across the whole log
+	uint32_t lastHour = log.getLastHourKey();
+	uint32_t keptHours = log.getSectorsUsed() == 1 ? hours : (log.getSectorsUsed() - 1) * (FLASH_SLOTS - FLASH_FIRST_SLOT) + 1;
+	uint32_t oldestHour = lastHour - (keptHours < lastHour ? keptHours : lastHour) + 1;
+	uint32_t recentHours = lastHour - oldestHour + 1 < BACKFILL_HOURS ? lastHour - oldestHour + 1 : BACKFILL_HOURS;
+	unsigned long misses = 0;
+	std::mt19937 rng(1);
+
+	flash.resetCounters();
+	start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < recentHours; i++)
+	{
+		if (!checkHour(log, lastHour - i)) misses++;
+	}
+	printf("Recent:   %u finds | host %.3f us/op | %.1f reads/op | %lu misses\n",
+		recentHours, elapsedMicros(start) / recentHours, (double)flash.reads / recentHours, misses);
+
+	const uint32_t randomFinds = 10000;
+	std::uniform_int_distribution<uint32_t> pick(oldestHour, lastHour);
+	misses = 0;
+	flash.resetCounters();
+	start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < randomFinds; i++)
+	{
+		if (!checkHour(log, pick(rng))) misses++;
+	}
+	printf("Random:   %u finds | host %.3f us/op | %.1f reads/op | device %.3f ms/op | %lu misses\n",
+		randomFinds, elapsedMicros(start) / randomFinds, (double)flash.reads / randomFinds, flash.deviceMicros / randomFinds / 1000, misses);
+
+	uint32_t minErase = flash.eraseCounts[0];
+	uint32_t maxErase = flash.eraseCounts[0];
+	for (uint32_t count : flash.eraseCounts)
+	{
+		if (count < minErase) minErase = count;
+		if (count > maxErase) maxErase = count;
+	}
+	printf("Wear:     erases per sector min %u, max %u (this run)\n", minErase, maxErase);
+
+	if (imageFile)
+	{
+		file = fopen(imageFile, "wb");
+		if (!file || fwrite(flash.image().data(), 1, flash.image().size(), file) != flash.image().size())
+		{
+			perror(imageFile);
+			return 1;
+		}
+		fclose(file);
+	}
+
+	return misses ? 2 : 0;
+}
+
+static int runPowerCuts(uint16_t sectors, uint32_t trials)
+{
+	std::mt19937 rng(2);
+	unsigned long failures = 0;
+	unsigned long tornKept = 0;
+
+	// Small chip so the ring wraps and sector opens get cut too
+	for (uint32_t trial = 0; trial < trials; trial++)
+	{
+		FAKE_FLASH_class flash(sectors);
+		FLASH_LOG_class log(flash);
+		uint8_t payload[PAYLOAD_BYTES];
+		uint32_t committed = 0;
+
+		log.mount();
+
+		uint32_t warmup = std::uniform_int_distribution<uint32_t>(0, sectors * FLASH_SLOTS * 2)(rng);
+		for (uint32_t hour = 1; hour <= warmup; hour++)
+		{
+			makePayload(hour, payload);
+			log.append(hour, payload, PAYLOAD_BYTES);
+		}
+		committed = warmup;
+
+		flash.cutPowerAfter(std::uniform_int_distribution<long>(0, 2000)(rng));
+		try
+		{
+			for (uint32_t hour = warmup + 1; ; hour++)
+			{
+				makePayload(hour, payload);
+				log.append(hour, payload, PAYLOAD_BYTES);
+				committed = hour;
+			}
+		}
+		catch (POWER_CUT &) {}
+		flash.cutPowerAfter(-1);
+
+		// Reboot: everything acknowledged must still be there, the torn hour may or may not be
+		FLASH_LOG_class rebooted(flash);
+		rebooted.mount();
+
+		uint32_t lastHour = rebooted.getLastHourKey();
+		if (lastHour != committed && lastHour != committed + 1 && committed != 0)
+		{
+			fprintf(stderr, "trial %u: last hour %u, expected %u\n", trial, lastHour, committed);
+			failures++;
+			continue;
+		}
+		if (lastHour == committed + 1) tornKept++;
+
+		uint32_t keep = (rebooted.getSectorsUsed() - 1) * (FLASH_SLOTS - FLASH_FIRST_SLOT);
+		for (uint32_t hour = committed > keep ? committed - keep + 1 : 1; hour <= committed; hour++)
+		{
+			if (!checkHour(rebooted, hour))
+			{
+				fprintf(stderr, "trial %u: hour %u lost\n", trial, hour);
+				failures++;
+				break;
+			}
+		}
+
+		// And the log keeps going
+		uint32_t next = (lastHour == FLASH_NO_KEY ? committed : lastHour) + 1;
+		makePayload(next, payload);
+		if (!rebooted.append(next, payload, PAYLOAD_BYTES) || !checkHour(rebooted, next))
+		{
+			fprintf(stderr, "trial %u: append after reboot failed\n", trial);
+			failures++;
+		}
+	}
+
+	printf("Power:    %u cut trials | %lu failures | %lu cut in the commit window and kept\n", trials, failures, tornKept);
+
+	return failures ? 2 : 0;
+}
+
+int main(int argc, char **argv)
+{
+	uint16_t sectors = DEFAULT_SECTORS;
+	uint32_t hours = DEFAULT_HOURS;
+	uint32_t trials = DEFAULT_TRIALS;
+	const char *imageFile = nullptr;
+	int option;
+
+	while ((option = getopt(argc, argv, "s:n:p:f:")) != -1)
+	{
+		switch (option)
+		{
+			case 's': sectors = atoi(optarg); break;
+			case 'n': hours = atoi(optarg); break;
+			case 'p': trials = atoi(optarg); break;
+			case 'f': imageFile = optarg; break;
+			default:
+				fprintf(stderr, "Usage: %s [-s sectors] [-n hours] [-p power_cut_trials] [-f image_file]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	if (sectors < 2 || sectors > 4096)
+	{
+		fprintf(stderr, "sectors must be 2 to 4096\n");
+		return 1;
+	}
+
+	int result = runThroughput(sectors, hours, imageFile);
+	if (result == 0 && trials > 0) result = runPowerCuts(4, trials);
+
+	return result;
+}
@@ -0,0 +1,145 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// Expands the tokenized debug log of the system node or the basestation back into text
+//
+// Build:	g++ -std=c++17 -O2 -Wall -I../../system_node/lib/debug_log -o log_decode log_decode.cpp
+//			g++ -std=c++17 -O2 -Wall -I../../basestation_node/lib -o log_decode_base log_decode.cpp
+// Usage:	stty -F /dev/ttyUSB0 115200 raw && ./log_decode < /dev/ttyUSB0
+//			./log_decode [-n] capture.bin [more captures...]
+//
+// The message table is log_messages.h from the include path, so build the decoder from the same
+// commit as the firmware. Plain prints are passed through untouched, -n drops the timestamps.
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <unistd.h>
+
+#include "log_messages.h"
+#include "log_format.h"
+
+static const char *const formats[] =
+{
+	#define LOG_FORMAT_ENTRY(id, format) format,
+	LOG_MESSAGES(LOG_FORMAT_ENTRY)
+	#undef LOG_FORMAT_ENTRY
+};
+
+struct DECODER
+{
+	FILE *file;
+	std::deque<uint8_t> pending;	// Bytes handed back after a record that did not parse
+	bool timestamps;
+	bool lineOpen;
+	unsigned long records;
+	unsigned long badRecords;
+};
+
+static int nextByte(DECODER &decoder)
+{
+	if (decoder.pending.empty()) return fgetc(decoder.file);
+
+	int c = decoder.pending.front();
+	decoder.pending.pop_front();
+	return c;
+}
+
+static void decodeStream(DECODER &decoder)
+{
+	int c;
+
+	while ((c = nextByte(decoder)) != EOF)
+	{
+		if (c != LOG_SYNC)
+		{
+			putchar(c);
+			decoder.lineOpen = c != '\n';
+			continue;
+		}
+
+		std::string record;
+		int length = nextByte(decoder);
+		while (length != EOF && (int)record.size() < length && (c = nextByte(decoder)) != EOF) record += (char)c;
+		if (length == EOF || (int)record.size() < length) break;
+
+		std::string text;
+		uint32_t stamp;
+		if (!expandLogRecord((const uint8_t *)record.data(), record.size(), formats, sizeof(formats) / sizeof(formats[0]), text, stamp))
+		{
+			// Most likely torn by a plain print, drop the sync byte and look again right after it
+			decoder.badRecords++;
+			decoder.pending.insert(decoder.pending.begin(), record.begin(), record.end());
+			decoder.pending.push_front((uint8_t)length);
+			continue;
+		}
+
+		if (decoder.lineOpen) putchar('\n');
+		if (decoder.timestamps) printf("[%6lu.%03lu] ", (unsigned long)(stamp / 1000), (unsigned long)(stamp % 1000));
+		printf("%s\n", text.c_str());
+		decoder.lineOpen = false;
+		decoder.records++;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	DECODER decoder = {stdin, {}, true, false, 0, 0};
+	int option;
+
+	while ((option = getopt(argc, argv, "n")) != -1)
+	{
+		switch (option)
+		{
+			case 'n':
+				decoder.timestamps = false;
+				break;
+			default:
+				fprintf(stderr, "Usage: %s [-n] [CAPTURE...]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	// Live from a serial port, every line as soon as it is complete
+	setvbuf(stdout, nullptr, _IOLBF, 0);
+
+	if (optind == argc) decodeStream(decoder);
+
+	for (int i = optind; i < argc; i++)
+	{
+		decoder.file = fopen(argv[i], "rb");
+		if (!decoder.file)
+		{
+			perror(argv[i]);
+			return 1;
+		}
+
+		decodeStream(decoder);
+		fclose(decoder.file);
+		decoder.pending.clear();
+	}
+
+	if (decoder.lineOpen) putchar('\n');
+	fprintf(stderr, "%lu records, %lu bad records\n", decoder.records, decoder.badRecords);
+	return decoder.badRecords ? 2 : 0;
+}
@@ -0,0 +1,160 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// Converts the binary OpenLog files written by the system node back to CSV
+//
+// Build:	g++ -std=c++17 -O2 -Wall -o openlog_decode openlog_decode.cpp
+// Usage:	./openlog_decode SEQLOG00.TXT [more files...] > data.csv
+//
+// Frame layout is documented in system_node/lib/sd_card_module/sd_card_module.h
+
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <vector>
+
+#define LOG_MAGIC			0x4C
+#define TRACE_MAGIC			0x54		// Event trace dumps share the card, tools/trace_view reads those
+#define LOG_END				0xC0
+#define LOG_ESC				0xDB
+#define LOG_ESC_END			0xDC
+#define LOG_ESC_ESC			0xDD
+#define LOG_ESC_SUB			0xDE
+#define LOG_OPENLOG_ESC		0x1A
+
+#define LOG_CENTI			100.0
+#define LOG_MILLI			1000.0
+#define HEADER_BYTES		7		// magic, hwid, count, start time
+#define RECORD_BYTES		12
+
+static uint16_t getWord(const std::vector<uint8_t> &frame, size_t pos)
+{
+	return frame[pos] | (frame[pos + 1] << 8);
+}
+
+static uint32_t getLong(const std::vector<uint8_t> &frame, size_t pos)
+{
+	return getWord(frame, pos) | ((uint32_t)getWord(frame, pos + 2) << 16);
+}
+
+static bool decodeFrame(const std::vector<uint8_t> &frame, unsigned long &records)
+{
+	if (frame.size() < HEADER_BYTES + 1 || frame[0] != LOG_MAGIC) return false;
+
+	uint8_t hwid = frame[1];
+	uint8_t count = frame[2];
+	uint8_t checkSum = 0;
+
+	if (frame.size() != (size_t)(HEADER_BYTES + count * RECORD_BYTES + 1)) return false;
+
+	for (size_t i = 0; i < frame.size() - 1; i++) checkSum += frame[i];
+	if (checkSum != frame.back()) return false;
+
+	time_t t = getLong(frame, 3);
+
+	for (uint8_t i = 0; i < count; i++)
+	{
+		size_t pos = HEADER_BYTES + i * RECORD_BYTES;
+		char datetime[20];
+		struct tm timeInfo;
+
+		t += getWord(frame, pos);
+		gmtime_r(&t, &timeInfo);
+		strftime(datetime, sizeof(datetime), "%Y-%m-%d %H:%M:%S", &timeInfo);
+
+		printf("%u,%s,%.2f,%.2f,%.2f,%u,%.3f\n",
+			hwid,
+			datetime,
+			(int16_t)getWord(frame, pos + 2) / LOG_CENTI,
+			getWord(frame, pos + 4) / LOG_CENTI,
+			(int16_t)getWord(frame, pos + 6) / LOG_CENTI,
+			getWord(frame, pos + 8),
+			getWord(frame, pos + 10) / LOG_MILLI);
+	}
+
+	records += count;
+	return true;
+}
+
+static void decodeFile(FILE *file, unsigned long &records, unsigned long &badFrames)
+{
+	std::vector<uint8_t> frame;
+	bool escaped = false;
+	int c;
+
+	while ((c = fgetc(file)) != EOF)
+	{
+		if (c == LOG_END)
+		{
+			// Back to back END bytes close one frame and open the next, skip the empties
+			if (!frame.empty() && frame[0] != TRACE_MAGIC && !decodeFrame(frame, records)) badFrames++;
+			frame.clear();
+			escaped = false;
+		}
+		else if (escaped)
+		{
+			escaped = false;
+			if (c == LOG_ESC_END) frame.push_back(LOG_END);
+			else if (c == LOG_ESC_ESC) frame.push_back(LOG_ESC);
+			else if (c == LOG_ESC_SUB) frame.push_back(LOG_OPENLOG_ESC);
+			else frame.push_back(c);		// Corrupt, the checksum will catch it
+		}
+		else if (c == LOG_ESC)
+		{
+			escaped = true;
+		}
+		else
+		{
+			frame.push_back(c);
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long records = 0;
+	unsigned long badFrames = 0;
+
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s LOGFILE [LOGFILE...]\n", argv[0]);
+		return 1;
+	}
+
+	printf("hw_id,datetime,temperature,humidity,soil_temperature,soil_moisture,battery\n");
+
+	for (int i = 1; i < argc; i++)
+	{
+		FILE *file = fopen(argv[i], "rb");
+		if (!file)
+		{
+			perror(argv[i]);
+			return 1;
+		}
+
+		decodeFile(file, records, badFrames);
+		fclose(file);
+	}
+
+	fprintf(stderr, "%lu records, %lu bad frames\n", records, badFrames);
+	return badFrames ? 2 : 0;
+}
@@ -0,0 +1,492 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// Imports the system nodes' SD card CSV into a tsdb.h store, files parsed in parallel
+//
+// Build:	g++ -std=c++17 -O2 -march=native -Wall -pthread -o sd_import sd_import.cpp
+// Usage:	./sd_import [-n network] [-o store.tsdb] [-t threads] [-w 1800] <card.csv>...
+//
+//	-n	Network the cards' nodes belong to, a card only knows its HW ID. Without it each file's
+//		directory names the network, cards/12/node3.csv is network 12, so a fleet goes in one run
+//	-o	Store to add the samples to, without it the files are only parsed and counted
+//	-t	Parsing threads, one per core by default
+//	-w	Seconds either side of a sample already in the store that make a card sample the same reading
+//
+// Lines are HW_ID,YYYY-MM-DD HH:MM:SS,temp,humi,stmp,smoi,batt, what logData() wrote before the
+// binary batches and what openlog_decode turns those back into, so cards from either firmware
+// come in the same way. Files are memory mapped and indexed a chunk at a time: one vector compare
+// per 32 bytes (16 without AVX2) finds every comma and newline, then each line's fields are read
+// between them with fixed format parsers, no strtod or strptime. Values become integers at the
+// store's precision right in the parser.
+//
+// Samples the radio already delivered are in the store from collectord -d, within -w seconds of
+// a card sample of the same node and metric they are the same reading and the card's is dropped,
+// as are repeats from a card read twice. Import with collectord stopped, into the file its worker
+// for the network writes (<prefix>.<network % workers>.tsdb), or into a file of its own.
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __SSE2__
+#include <immintrin.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "../tsdb/tsdb.h"
+
+#define FIELDS					7
+#define DATETIME_LENGTH			19			// YYYY-MM-DD HH:MM:SS
+#define EARLIEST_YEAR			2020		// The RTC reads 2000-01-01 after losing its coin cell
+#define CHUNK_BYTES				(256 * 1024)
+#define DEFAULT_WINDOW_S		1800		// Half the round interval
+
+struct CARD_ROW
+{
+	uint32_t time;
+	uint16_t network;
+	uint8_t hwid;
+	uint8_t valid;							// Bit per metric, nan and the like leave it clear
+	int32_t values[METRICS];				// At metricDecimals[]
+};
+
+struct FILE_STATS
+{
+	uint64_t bytes = 0;
+	uint64_t lines = 0;
+	uint64_t skipped = 0;					// Headers
+	uint64_t bad = 0;						// Torn or garbled lines
+};
+
+static const int64_t powers[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+
+// Every ',' and '\n' in [start, end) as an offset from the chunk start
+static void indexSeparators(const char *start, const char *end, std::vector<uint32_t> &positions)
+{
+	const char *at = start;
+
+	positions.clear();
+
+#if defined(__AVX2__)
+	const __m256i comma = _mm256_set1_epi8(',');
+	const __m256i newline = _mm256_set1_epi8('\n');
+
+	for (; at + 32 <= end; at += 32)
+	{
+		__m256i bytes = _mm256_loadu_si256((const __m256i*)at);
+		uint32_t mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(bytes, comma), _mm256_cmpeq_epi8(bytes, newline)));
+
+		while (mask)
+		{
+			positions.push_back(at - start + __builtin_ctz(mask));
+			mask &= mask - 1;
+		}
+	}
+#elif defined(__SSE2__)
+	const __m128i comma = _mm_set1_epi8(',');
+	const __m128i newline = _mm_set1_epi8('\n');
+
+	for (; at + 16 <= end; at += 16)
+	{
+		__m128i bytes = _mm_loadu_si128((const __m128i*)at);
+		uint32_t mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(bytes, comma), _mm_cmpeq_epi8(bytes, newline)));
+
+		while (mask)
+		{
+			positions.push_back(at - start + __builtin_ctz(mask));
+			mask &= mask - 1;
+		}
+	}
+#endif
+
+	for (; at < end; at++)
+	{
+		if (*at == ',' || *at == '\n') positions.push_back(at - start);
+	}
+}
+
+static inline bool digit(char c)
+{
+	return (unsigned)(c - '0') < 10;
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date, after Howard Hinnant's days_from_civil
+static inline int64_t daysFromCivil(int year, unsigned month, unsigned day)
+{
+	year -= month <= 2;
+	int era = year / 400;
+	unsigned yearOfEra = year - era * 400;
+	unsigned dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+	unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+
+	return (int64_t)era * 146097 + dayOfEra - 719468;
+}
+
+// YYYY-MM-DD HH:MM:SS at fixed offsets, UTC as the node's clock keeps it
+static bool parseDatetime(const char *text, size_t length, uint32_t &timestamp)
+{
+	if (length != DATETIME_LENGTH || text[4] != '-' || text[7] != '-' || text[10] != ' ' || text[13] != ':' || text[16] != ':') return false;
+
+	static const uint8_t digits[] = { 0, 1, 2, 3, 5, 6, 8, 9, 11, 12, 14, 15, 17, 18 };
+	for (uint8_t position : digits)
+	{
+		if (!digit(text[position])) return false;
+	}
+
+	#define TWO(at)		((text[at] - '0') * 10 + (text[at + 1] - '0'))
+	int year = TWO(0) * 100 + TWO(2);
+	unsigned month = TWO(5), day = TWO(8), hour = TWO(11), minute = TWO(14), second = TWO(17);
+	#undef TWO
+
+	if (year < EARLIEST_YEAR || month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 59) return false;
+
+	timestamp = daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+	return true;
+}
+
+// [-]digits[.digits] to an integer with the given decimals, rounded half away from zero on the
+// next digit. Serial.print() writes nan, inf and ovf for values it cannot show, those fail.
+static bool parseDecimal(const char *text, size_t length, uint8_t decimals, int32_t &value)
+{
+	const char *end = text + length;
+	bool negative = false;
+	int64_t whole = 0, fraction = 0;
+	uint8_t fractionDigits = 0;
+	bool round = false;
+
+	if (text < end && *text == '-') { negative = true; text++; }
+	if (text == end || !digit(*text)) return false;
+
+	for (; text < end && digit(*text); text++)
+	{
+		whole = whole * 10 + (*text - '0');
+		if (whole > INT32_MAX) return false;
+	}
+
+	if (text < end && *text == '.')
+	{
+		for (text++; text < end && digit(*text); text++)
+		{
+			if (fractionDigits < decimals) fraction = fraction * 10 + (*text - '0');
+			else if (fractionDigits == decimals) round = *text >= '5';
+			fractionDigits++;
+		}
+	}
+
+	// Old cards end their lines with \r\n
+	if (text < end && !(*text == '\r' && text + 1 == end)) return false;
+
+	int64_t scaled = whole * powers[decimals] + fraction * powers[decimals - std::min(fractionDigits, decimals)] + round;
+	if (scaled > INT32_MAX) return false;
+
+	value = negative ? -scaled : scaled;
+	return true;
+}
+
+static bool parseUnsigned(const char *text, size_t length, uint32_t &value)
+{
+	if (length == 0 || length > 9) return false;
+
+	value = 0;
+	for (size_t i = 0; i < length; i++)
+	{
+		if (!digit(text[i])) return false;
+		value = value * 10 + (text[i] - '0');
+	}
+
+	return true;
+}
+
+// fields[] are FIELDS + 1 offsets into the chunk, the line start then one past each separator
+static void parseLine(const char *chunk, const uint32_t *fields, uint16_t network, std::vector<CARD_ROW> &rows, FILE_STATS &stats)
+{
+	CARD_ROW row;
+	uint32_t hwid;
+
+	stats.lines++;
+
+	if (!parseUnsigned(chunk + fields[0], fields[1] - fields[0] - 1, hwid) || hwid > UINT8_MAX)
+	{
+		if (chunk[fields[0]] == 'h') stats.skipped++;		// hw_id,datetime,... from openlog_decode
+		else stats.bad++;
+		return;
+	}
+
+	if (!parseDatetime(chunk + fields[1], fields[2] - fields[1] - 1, row.time))
+	{
+		stats.bad++;
+		return;
+	}
+
+	row.network = network;
+	row.hwid = hwid;
+	row.valid = 0;
+	for (uint8_t metric = 0; metric < METRICS; metric++)
+	{
+		const char *text = chunk + fields[2 + metric];
+		size_t length = fields[3 + metric] - fields[2 + metric] - 1;
+
+		if (parseDecimal(text, length, metricDecimals[metric], row.values[metric])) row.valid |= 1 << metric;
+	}
+
+	// Field order on the card is the LoRa request order, the store's metric order
+	if (row.valid == 0) stats.bad++;
+	else rows.push_back(row);
+}
+
+static void parseFile(const char *path, uint16_t network, std::vector<CARD_ROW> &rows, FILE_STATS &stats)
+{
+	int fd = open(path, O_RDONLY);
+	struct stat info;
+
+	if (fd < 0 || fstat(fd, &info) < 0 || info.st_size == 0)
+	{
+		if (fd < 0) perror(path);
+		if (fd >= 0) close(fd);
+		return;
+	}
+
+	const char *data = (const char*)mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		perror(path);
+		return;
+	}
+	madvise((void*)data, info.st_size, MADV_SEQUENTIAL);
+
+	const char *end = data + info.st_size;
+	const char *chunk = data;
+	std::vector<uint32_t> positions;
+	uint32_t fields[FIELDS + 1];
+
+	stats.bytes += info.st_size;
+
+	while (chunk < end)
+	{
+		const char *chunkEnd = std::min(end, chunk + CHUNK_BYTES);
+		uint32_t lineStart = 0;
+		uint8_t count = 0;
+		bool overflow = false;
+
+		indexSeparators(chunk, chunkEnd, positions);
+
+		// The file's last line may have no newline, its end stands in for one
+		if (chunkEnd == end && end[-1] != '\n') positions.push_back(chunkEnd - chunk);
+
+		fields[0] = 0;
+		for (uint32_t position : positions)
+		{
+			bool lineEnd = chunk + position == end || chunk[position] == '\n';
+
+			if (count < FIELDS) fields[++count] = position + 1;
+			else overflow = true;
+
+			if (!lineEnd) continue;
+
+			if (count == FIELDS && !overflow) parseLine(chunk, fields, network, rows, stats);
+			else if (position > lineStart)
+			{
+				stats.lines++;
+				stats.bad++;
+			}
+
+			lineStart = position + 1;
+			fields[0] = lineStart;
+			count = 0;
+			overflow = false;
+		}
+
+		// A line cut by the chunk boundary starts the next chunk, unless the chunk was all one line
+		if (chunkEnd == end) break;
+		chunk = lineStart > 0 ? chunk + lineStart : chunkEnd;
+	}
+
+	munmap((void*)data, info.st_size);
+}
+
+// The directory a card's files were copied into, by network ID
+static int networkOf(const std::string &path)
+{
+	size_t slash = path.rfind('/');
+	if (slash == std::string::npos) return -1;
+
+	size_t start = path.rfind('/', slash - 1);
+	std::string directory = path.substr(start == std::string::npos ? 0 : start + 1, slash - (start == std::string::npos ? 0 : start + 1));
+	uint32_t network;
+
+	return parseUnsigned(directory.c_str(), directory.size(), network) && network <= UINT16_MAX ? (int)network : -1;
+}
+
+static double seconds(std::chrono::steady_clock::time_point since)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+}
+
+int main(int argc, char **argv)
+{
+	unsigned threadCount = std::max(1U, std::thread::hardware_concurrency());
+	uint32_t window = DEFAULT_WINDOW_S;
+	int network = -1;
+	std::string output;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:o:t:w:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'n': network = atoi(optarg); break;
+			case 'o': output = optarg; break;
+			case 't': threadCount = std::max(1, atoi(optarg)); break;
+			case 'w': window = atoi(optarg); break;
+
+			default:
+				fprintf(stderr, "Usage: %s [-n network] [-o store.tsdb] [-t threads] [-w window] <card.csv>...\n", argv[0]);
+				return 1;
+		}
+	}
+
+	std::vector<uint16_t> networks(argc);
+	for (int i = optind; i < argc; i++)
+	{
+		int found = network >= 0 ? network : networkOf(argv[i]);
+		if (found < 0 || found > UINT16_MAX)
+		{
+			fprintf(stderr, "%s: no -n and its directory is not a network ID\n", argv[i]);
+			return 1;
+		}
+		networks[i] = found;
+	}
+	if (optind >= argc)
+	{
+		fprintf(stderr, "No card files\n");
+		return 1;
+	}
+
+	// Files handed out one at a time, a thread's rows and counts are its own until the join
+	std::vector<std::vector<CARD_ROW>> rows(threadCount);
+	std::vector<FILE_STATS> stats(threadCount);
+	std::vector<std::thread> threads;
+	std::atomic<int> next{optind};
+	auto started = std::chrono::steady_clock::now();
+
+	for (unsigned i = 0; i < threadCount; i++)
+	{
+		threads.emplace_back([&, i]()
+		{
+			for (int file = next++; file < argc; file = next++) parseFile(argv[file], networks[file], rows[i], stats[i]);
+		});
+	}
+	for (auto &thread : threads) thread.join();
+
+	FILE_STATS total;
+	std::vector<CARD_ROW> all;
+	for (unsigned i = 0; i < threadCount; i++)
+	{
+		total.bytes += stats[i].bytes;
+		total.lines += stats[i].lines;
+		total.skipped += stats[i].skipped;
+		total.bad += stats[i].bad;
+		all.insert(all.end(), rows[i].begin(), rows[i].end());
+		std::vector<CARD_ROW>().swap(rows[i]);
+	}
+
+	double parsing = seconds(started);
+	fprintf(stderr, "%d files, %.1f MB, %lu lines (%lu bad, %lu headers) in %.3f s, %.0f MB/s\n",
+		argc - optind, total.bytes / 1e6, (unsigned long)total.lines, (unsigned long)total.bad, (unsigned long)total.skipped, parsing, total.bytes / 1e6 / parsing);
+
+	if (output.empty()) return 0;
+
+	// Node by node in time order, the order the store compresses best in
+	started = std::chrono::steady_clock::now();
+	std::sort(all.begin(), all.end(), [](const CARD_ROW &a, const CARD_ROW &b)
+	{
+		if (a.network != b.network) return a.network < b.network;
+		return a.hwid != b.hwid ? a.hwid < b.hwid : a.time < b.time;
+	});
+
+	TSDB_class store;
+	if (!store.open(output))
+	{
+		perror(output.c_str());
+		return 1;
+	}
+
+	uint64_t added = 0, radio = 0, repeated = 0;
+	size_t first = 0;
+
+	while (first < all.size())
+	{
+		size_t last = first;
+		while (last < all.size() && all[last].network == all[first].network && all[last].hwid == all[first].hwid) last++;
+
+		for (uint8_t metric = 0; metric < METRICS; metric++)
+		{
+			uint32_t series = seriesId(all[first].network, all[first].hwid, metric);
+			std::vector<uint32_t> known;
+			uint32_t previous = 0;
+			bool any = false;
+
+			// What the store has for the node, the radio's rounds or an earlier import
+			store.scan(series, 0, UINT32_MAX, [&](uint32_t timestamp, double) { known.push_back(timestamp); });
+			std::sort(known.begin(), known.end());
+
+			for (size_t i = first; i < last; i++)
+			{
+				const CARD_ROW &row = all[i];
+				if (!(row.valid & (1 << metric))) continue;
+
+				if (any && row.time == previous)
+				{
+					repeated++;
+					continue;
+				}
+				previous = row.time;
+				any = true;
+
+				auto near = std::lower_bound(known.begin(), known.end(), row.time > window ? row.time - window : 0);
+				if (near != known.end() && *near <= (uint64_t)row.time + window)
+				{
+					radio++;
+					continue;
+				}
+
+				store.append(series, row.time, (double)row.values[metric] / powers[metricDecimals[metric]], metricDecimals[metric]);
+				added++;
+			}
+		}
+
+		first = last;
+	}
+	store.close();
+
+	fprintf(stderr, "%lu samples added, %lu already in the store, %lu repeated on the cards in %.3f s\n",
+		(unsigned long)added, (unsigned long)radio, (unsigned long)repeated, seconds(started));
+	fprintf(stderr, "total %.3f s\n", parsing + seconds(started));
+
+	return 0;
+}
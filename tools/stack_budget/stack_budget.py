@@ -0,0 +1,219 @@
+#!/usr/bin/env python3
+"""
+Builds the system node with -fstack-usage and fails when its worst-case RAM use does not fit.
+
+    python3 stack_budget.py                         # exit 1 if globals + deepest stack exceed 2048 - 256 bytes
+    python3 stack_budget.py --budget 1900 --path    # a tighter limit, and print the deepest call chain
+
+Needs arduino-cli with the arduino:avr core and the node's libraries, and avr-objdump/avr-size from
+the same toolchain. Frame sizes come from the compiler's .su files, the call graph from the
+disassembly, so the worst case is the deepest chain from main() plus the deepest interrupt handler
+on top of it, two bytes of return address per call. Functions without a .su file (the core's
+assembly, libgcc, avr-libc) are sized by their push and frame setup instructions.
+
+The build is the firmware's own sketch with its own toggles, but without LTO: under LTO the frames
+are only known after the link. Inlining differs a little from the shipped image, so keep the
+reserve for that. A frame the compiler reports as dynamic (a VLA or alloca) has no bound and fails
+the run, as does recursion. Indirect calls (virtual Print::write, the LoRa receive callback) are
+followed only as far as --indirect names their targets, the rest are listed, and fail with --strict.
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+REPO = os.path.normpath(os.path.join(HERE, "..", ".."))
+SKETCH = os.path.join(REPO, "system_node")
+
+RETURN_ADDRESS = 2      # ATmega328, 16-bit program counter
+
+FUNCTION_LINE = re.compile(r"^([0-9a-f]+) <(.+)>:$")
+CALL_LINE = re.compile(r"\t(r?call|r?jmp)\s.*;\s*0x[0-9a-f]+ <([^>+]+)>$")
+PUSH_LINE = re.compile(r"\tpush\t")
+FRAME_LINE = re.compile(r"\t(?:sbiw|subi)\tr28, 0x([0-9A-Fa-f]+)")
+INDIRECT_LINE = re.compile(r"\te?i(?:call|jmp)")
+
+
+def build(fqbn, output):
+    flags = "-fstack-usage -fno-lto"
+    subprocess.run(["arduino-cli", "compile", "--fqbn", fqbn,
+                    "--build-property", "compiler.c.extra_flags=" + flags,
+                    "--build-property", "compiler.cpp.extra_flags=" + flags,
+                    "--build-property", "compiler.c.elf.extra_flags=-fno-lto",
+                    "--build-path", output, SKETCH], check=True)
+    return os.path.join(output, "system_node.ino.elf")
+
+
+def plain(name):
+    # "float* LORA_MODULE_class::getpayloadValues()" and "LORA_MODULE_class::getpayloadValues()" alike
+    name = name.split("(")[0].strip()
+    return name.split()[-1].lstrip("*&") if name else name
+
+
+def frames(output):
+    sizes = {}
+    dynamic = set()
+    for root, _, files in os.walk(output):
+        for file in files:
+            if not file.endswith(".su"):
+                continue
+            with open(os.path.join(root, file)) as lines:
+                for line in lines:
+                    fields = line.rstrip("\n").split("\t")
+                    if len(fields) != 3:
+                        continue
+                    name = plain(fields[0].split(":", 3)[-1])
+                    sizes[name] = max(sizes.get(name, 0), int(fields[1]))
+                    if fields[2].startswith("dynamic") and fields[2] != "dynamic,bounded":
+                        dynamic.add(name)
+    return sizes, dynamic
+
+
+def callgraph(elf):
+    calls = {}
+    pushes = {}
+    indirect = set()
+    current = None
+
+    disassembly = subprocess.run(["avr-objdump", "-d", "-C", elf], capture_output=True, text=True, check=True).stdout
+    for line in disassembly.splitlines():
+        function = FUNCTION_LINE.match(line)
+        if function:
+            current = plain(function.group(2))
+            calls.setdefault(current, {})
+            pushes.setdefault(current, 0)
+            continue
+        if current is None:
+            continue
+
+        call = CALL_LINE.search(line)
+        if call and plain(call.group(2)) != current:
+            # A jump into another function is a tail call, it reuses the caller's return address
+            extra = RETURN_ADDRESS if call.group(1).endswith("call") else 0
+            callee = plain(call.group(2))
+            calls[current][callee] = max(calls[current].get(callee, 0), extra)
+        elif PUSH_LINE.search(line):
+            pushes[current] += 1
+        elif FRAME_LINE.search(line):
+            pushes[current] += int(FRAME_LINE.search(line).group(1), 16)
+        elif INDIRECT_LINE.search(line):
+            indirect.add(current)
+
+    return calls, pushes, indirect
+
+
+def static_ram(elf):
+    sections = {}
+    for line in subprocess.run(["avr-size", "-A", elf], capture_output=True, text=True, check=True).stdout.splitlines():
+        fields = line.split()
+        if len(fields) >= 2 and fields[0].startswith(".") and fields[1].isdigit():
+            sections[fields[0]] = int(fields[1])
+    return sections.get(".data", 0) + sections.get(".bss", 0) + sections.get(".noinit", 0)
+
+
+class Analysis:
+    def __init__(self, sizes, calls, pushes, indirect, targets):
+        self.sizes = sizes
+        self.calls = calls
+        self.pushes = pushes
+        self.indirect = indirect
+        self.targets = targets
+        self.depth = {}
+        self.next = {}
+        self.problems = []
+        self.unresolved = []
+
+    def frame(self, name):
+        return self.sizes[name] if name in self.sizes else self.pushes.get(name, 0)
+
+    def deepest(self, name, chain=()):
+        if name in self.depth:
+            return self.depth[name]
+        if name in chain:
+            self.problems.append("recursion: " + " -> ".join(chain[chain.index(name):] + (name,)))
+            return 0
+
+        callees = dict(self.calls.get(name, {}))
+        if name in self.indirect:
+            if name not in self.targets:
+                self.unresolved.append(name)
+            for target in self.targets.get(name, []):
+                callees[target] = RETURN_ADDRESS
+
+        best, via = 0, None
+        for callee, extra in callees.items():
+            depth = extra + self.deepest(callee, chain + (name,))
+            if depth > best:
+                best, via = depth, callee
+
+        self.depth[name] = self.frame(name) + best
+        self.next[name] = via
+        return self.depth[name]
+
+    def path(self, name):
+        chain = []
+        while name is not None:
+            chain.append("{} ({})".format(name, self.frame(name)))
+            name = self.next.get(name)
+        return chain
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--fqbn", default="arduino:avr:nano:cpu=atmega328", help="Board the node is built for")
+    parser.add_argument("--ram", type=int, default=2048, help="SRAM of the part in bytes")
+    parser.add_argument("--budget", type=int, help="Bytes globals and stack may use, default --ram minus --reserve")
+    parser.add_argument("--reserve", type=int, default=256, help="Kept free for inlining differences and the heap")
+    parser.add_argument("--indirect", action="append", default=[], metavar="CALLER=TARGET,...",
+                        help="Functions an indirect call in CALLER can reach")
+    parser.add_argument("--strict", action="store_true", help="Fail on indirect calls --indirect does not cover")
+    parser.add_argument("--path", action="store_true", help="Print the deepest call chain")
+    args = parser.parse_args()
+    budget = args.budget if args.budget is not None else args.ram - args.reserve
+
+    targets = {}
+    for entry in args.indirect:
+        caller, _, names = entry.partition("=")
+        targets[caller] = [name for name in names.split(",") if name]
+
+    with tempfile.TemporaryDirectory() as output:
+        elf = build(args.fqbn, output)
+        sizes, dynamic = frames(output)
+        calls, pushes, indirect = callgraph(elf)
+        globals_ = static_ram(elf)
+
+    analysis = Analysis(sizes, calls, pushes, indirect, targets)
+    stack = analysis.deepest("main")
+    handlers = [name for name in calls if name.startswith("__vector_")]
+    handler = max(handlers, key=analysis.deepest, default=None)
+    interrupt = analysis.deepest(handler) + RETURN_ADDRESS if handler else 0
+
+    for name in sorted(dynamic & set(analysis.depth)):
+        analysis.problems.append("dynamic frame in {}, no bound".format(name))
+
+    total = globals_ + stack + interrupt
+    print("globals   {:>5} bytes".format(globals_))
+    print("main      {:>5} bytes".format(stack))
+    print("interrupt {:>5} bytes ({})".format(interrupt, handler or "none"))
+    print("total     {:>5} of {} bytes, {} to spare".format(total, budget, budget - total))
+
+    if args.path:
+        for step in analysis.path("main"):
+            print("  " + step)
+        if handler:
+            for step in analysis.path(handler):
+                print("  + " + step)
+
+    for name in analysis.unresolved:
+        print("indirect: {} calls through a pointer, its targets are not counted".format(name))
+    if args.strict:
+        analysis.problems += ["indirect call in " + name for name in analysis.unresolved]
+
+    for problem in analysis.problems:
+        print("problem: " + problem)
+
+    sys.exit(1 if total > budget or analysis.problems else 0)
@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+"""
+Local stand-in for the parts of the ThingSpeak API the basestation uses.
+
+    python3 thingspeak_standin.py --port 8080 [--rate-limit 15] [--chunked]
+    python3 thingspeak_standin.py --outage-every 600 --outage-for 300 --outage-mode reset
+
+Point config::THINGSPEAK_HOST / THINGSPEAK_PORT in basestation_node/lib/config.hpp
+at this machine. Every accepted entry is printed as one line, and each request
+line shows which TCP connection it came in on, so connection reuse is easy to see.
+
+Handles:
+    POST /update                          form body, answers the entry id or 0
+    GET  /update?api_key=...              the old query string form
+    POST /channels/<id>/bulk_update.json  JSON body, answers {"success":true}
+
+Outages, to watch the basestation buffer and then drain its upload store:
+    --outage-every/--outage-for           down for the second number of seconds out of every first
+    POST /standin/outage                  body "on" or "off", switches it by hand (always answered)
+    --outage-mode reset                   drop the connection without an answer
+    --outage-mode 503                     answer 503 Service Unavailable
+    --outage-mode hang                    say nothing until the client times out
+"""
+
+import argparse
+import itertools
+import json
+import socket
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import parse_qs, urlparse
+
+lock = threading.Lock()
+entry_ids = itertools.count(1)
+connection_ids = itertools.count(1)
+last_write = {}
+started = time.monotonic()
+manual_outage = False
+stats = {"connections": 0, "requests": 0, "entries": 0, "rejected": 0, "outages": 0}
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"   # Keep-alive unless the client asks to close
+
+    def setup(self):
+        super().setup()
+        with lock:
+            self.connection_id = next(connection_ids)
+            stats["connections"] += 1
+
+    def log_message(self, fmt, *args):
+        print(f"[conn {self.connection_id}] {fmt % args}", flush=True)
+
+    def do_GET(self):
+        if self.outage():
+            return
+        url = urlparse(self.path)
+        if url.path != "/update":
+            return self.reply(404, "Not Found")
+        fields = {k: v[0] for k, v in parse_qs(url.query).items()}
+        self.single_update(fields)
+
+    def do_POST(self):
+        global manual_outage
+        body = self.rfile.read(int(self.headers.get("Content-Length", 0))).decode()
+        url = urlparse(self.path)
+
+        if url.path == "/standin/outage":
+            manual_outage = body.strip() == "on"
+            print(f"[conn {self.connection_id}] outage {'on' if manual_outage else 'off'}", flush=True)
+            return self.reply(200, "on" if manual_outage else "off")
+        if self.outage():
+            return
+
+        if url.path == "/update":
+            self.single_update({k: v[0] for k, v in parse_qs(body).items()})
+        elif url.path.startswith("/channels/") and url.path.endswith("/bulk_update.json"):
+            try:
+                data = json.loads(body)
+            except ValueError:
+                return self.reply(400, '{"error":"bad json"}')
+            self.bulk_update(url.path.split("/")[2], data)
+        else:
+            self.reply(404, "Not Found")
+
+    def single_update(self, fields):
+        key = fields.pop("api_key", "")
+        if not self.allow(key):
+            return self.reply(200, "0")
+        entry = self.store(key, fields)
+        self.reply(200, str(entry))
+
+    def bulk_update(self, channel, data):
+        key = data.get("write_api_key", "")
+        updates = data.get("updates", [])
+        if not self.allow(key):
+            return self.reply(429, '{"success":false}')
+        for update in updates:
+            self.store(key, update, channel)
+        self.reply(202 if args.bulk_accepted else 200, '{"success":true}')
+
+    def outage(self):
+        down = manual_outage
+        if args.outage_every and args.outage_for:
+            down = down or (time.monotonic() - started) % args.outage_every >= args.outage_every - args.outage_for
+        if not down:
+            return False
+
+        with lock:
+            stats["outages"] += 1
+        print(f"[conn {self.connection_id}] outage, {args.outage_mode} {self.command} {self.path}", flush=True)
+
+        if args.outage_mode == "503":
+            self.reply(503, "Service Unavailable")
+            return True
+        if args.outage_mode == "hang":
+            time.sleep(args.hang)
+        self.close_connection = True
+        self.connection.shutdown(socket.SHUT_RDWR)
+        return True
+
+    def allow(self, key):
+        with lock:
+            stats["requests"] += 1
+            now = time.monotonic()
+            if args.rate_limit and now - last_write.get(key, -1e9) < args.rate_limit:
+                stats["rejected"] += 1
+                print(f"[conn {self.connection_id}] rate limited {key}", flush=True)
+                return False
+            last_write[key] = now
+            return True
+
+    def store(self, key, fields, channel="-"):
+        with lock:
+            entry = next(entry_ids)
+            stats["entries"] += 1
+        created = fields.get("created_at", "now")
+        values = ",".join(f"{name}={fields[name]}" for name in sorted(fields) if name.startswith("field"))
+        if "status" in fields:
+            values += f" status={fields['status']!r}"
+        print(f"ENTRY {entry} key={key} channel={channel} created_at={created} {values}", flush=True)
+        return entry
+
+    def reply(self, code, text):
+        payload = text.encode()
+        self.send_response(code)
+        self.send_header("Content-Type", "text/plain" if not text.startswith("{") else "application/json")
+        if args.chunked:
+            self.send_header("Transfer-Encoding", "chunked")
+            self.end_headers()
+            self.wfile.write(b"%x\r\n%s\r\n0\r\n\r\n" % (len(payload), payload))
+        else:
+            self.send_header("Content-Length", str(len(payload)))
+            self.end_headers()
+            self.wfile.write(payload)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--host", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--rate-limit", type=float, default=0, help="seconds between writes per key, 15 like the free tier")
+    parser.add_argument("--chunked", action="store_true", help="answer with chunked transfer encoding")
+    parser.add_argument("--bulk-accepted", action="store_true", help="answer bulk updates with 202 like the real API")
+    parser.add_argument("--outage-every", type=float, default=0, help="length of one up/down cycle in seconds")
+    parser.add_argument("--outage-for", type=float, default=0, help="seconds of each cycle spent down, at its end")
+    parser.add_argument("--outage-mode", choices=["reset", "503", "hang"], default="reset")
+    parser.add_argument("--hang", type=float, default=5, help="seconds to stall in hang mode")
+    args = parser.parse_args()
+
+    server = ThreadingHTTPServer((args.host, args.port), Handler)
+    print(f"ThingSpeak stand-in on {args.host}:{args.port}", flush=True)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    print(f"connections={stats['connections']} requests={stats['requests']} "
+          f"entries={stats['entries']} rejected={stats['rejected']} outages={stats['outages']}", flush=True)
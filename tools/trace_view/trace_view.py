@@ -0,0 +1,306 @@
+#!/usr/bin/env python3
+"""
+Merges the radio event traces of the basestation and the nodes into one Chrome trace per LoRa round.
+
+    python3 trace_view.py basestation.bin NODE01.TXT NODE02.TXT -o rounds.json
+    python3 trace_view.py --reference 8 --sf 10 --bw 125000 *.bin
+
+Inputs are raw captures holding EVENT_TRACE frames: a node's OpenLog files, the basestation's UART,
+or what turfroofd --trace wrote. Other bytes in the files are skipped. Open the output in Perfetto
+(ui.perfetto.dev) or chrome://tracing: one process per round, one thread per device.
+
+Each device counts its own millis(), and a node's stands still while it sleeps, so a node's
+records are cut into segments at every wake. A segment is placed by the frames it shares with an
+already placed device: a TX_END on one side and the RX of the same bytes on the other happen
+within the radio's interrupt latency of each other, and the median offset over those pairs wins.
+The basestation is placed first, by its NTP epoch. A segment nothing can be matched against is
+marked unaligned and placed by the RTC: the first by the epoch taken when the window opened, the
+last by the one taken at its close, the rest by the second of the hour their wake carries. A
+segment opened by a LoRa wake has no such second and takes the offset of the one after it.
+
+DIO0 only flags RxDone, so an RX slice starts one airtime before the read, with the airtime from
+the radio settings (Semtech AN1200.13).
+"""
+
+import argparse
+import json
+import math
+import statistics
+import struct
+import sys
+import time
+from collections import defaultdict
+
+# SLIP framing shared with the node's OpenLog frames (sd_card_module.h)
+END = 0xC0
+ESC = 0xDB
+ESC_CODES = {0xDC: 0xC0, 0xDD: 0xDB, 0xDE: 0x1A}
+TRACE_MAGIC = 0x54
+HEADER = struct.Struct("<BBHHIIII")
+RECORD = struct.Struct("<IBBH")
+
+# trace_module.h
+RX, INVALID, MERGE, BACKOFF, CSMA_INTERRUPT, TX_START, TX_END, SLEEP, WAKE, REQUEST, CLOSE = range(1, 12)
+NO_TIME = 0xFFFF
+FRAME_KINDS = ["data", "event", "history", "health"]
+HEADERS = ["TEMP", "HUMI", "STMP", "SMOI", "BATT", "BKFL"]
+
+
+def unescape(chunk):
+    data = bytearray()
+    escaped = False
+    for byte in chunk:
+        if escaped:
+            if byte not in ESC_CODES:
+                return None
+            data.append(ESC_CODES[byte])
+            escaped = False
+        elif byte == ESC:
+            escaped = True
+        else:
+            data.append(byte)
+    return None if escaped else bytes(data)
+
+
+def read_dumps(path):
+    with open(path, "rb") as file:
+        raw = file.read()
+
+    dumps = []
+    for chunk in raw.split(bytes([END])):
+        if len(chunk) < HEADER.size + 1 or chunk[0] != TRACE_MAGIC:
+            continue
+        frame = unescape(chunk)
+        if frame is None or len(frame) < HEADER.size + 1 or sum(frame[:-1]) & 0xFF != frame[-1]:
+            continue
+
+        _, hwid, count, dropped, open_epoch, open_millis, epoch, anchor = HEADER.unpack_from(frame)
+        if len(frame) != HEADER.size + count * RECORD.size + 1:
+            continue
+
+        records = [RECORD.unpack_from(frame, HEADER.size + i * RECORD.size) for i in range(count)]
+        dumps.append({"hwid": hwid, "dropped": dropped, "open": (open_epoch, open_millis), "close": (epoch, anchor),
+                      "epoch": epoch, "records": records, "file": path})
+
+    return dumps
+
+
+def airtime_ms(length, args):
+    # SX1276 time on air, explicit header
+    symbol = (2 ** args.sf) / args.bw * 1000
+    low_rate = 1 if symbol > 16 else 0
+    preamble = (args.preamble + 4.25) * symbol
+    bits = 8 * length - 4 * args.sf + 28 + (16 if args.crc else 0)
+    symbols = 8 + max(math.ceil(bits / (4 * (args.sf - 2 * low_rate))) * (args.cr + 4), 0)
+    return preamble + symbols * symbol
+
+
+def segments(dump, reference):
+    # The basestation's millis() never stops, a node's restarts its count of awake time at each wake
+    if dump["hwid"] == reference:
+        return [dump["records"]]
+
+    parts = [[]]
+    for record in dump["records"]:
+        if record[1] == WAKE and parts[-1]:
+            parts.append([])
+        parts[-1].append(record)
+    return [part for part in parts if part]
+
+
+def match_offset(segment, placed, tolerance):
+    # Every pairing of the same frame ID is a candidate, repeats of one frame give one cluster per copy
+    candidates = []
+    for stamp, event, _, arg in segment:
+        if event == RX:
+            candidates += [other - stamp for other in placed[(TX_END, arg)]]
+        elif event == TX_END:
+            candidates += [other - stamp for other in placed[(RX, arg)]]
+
+    best = []
+    for offset in candidates:
+        cluster = [other for other in candidates if abs(other - offset) <= tolerance]
+        if len(cluster) > len(best):
+            best = cluster
+
+    return (statistics.median(best), len(best)) if best else (None, 0)
+
+
+def align(dumps, args):
+    # One entry per segment: device, records and the offset from its millis() to ms since the round's hour
+    hour = min(dump["epoch"] for dump in dumps) // 3600 * 3600
+    placed = defaultdict(list)
+    pending = []
+    done = []
+
+    for dump in dumps:
+        parts = segments(dump, args.reference)
+        for index, segment in enumerate(parts):
+            pending.append({"dump": dump, "index": index, "last": index == len(parts) - 1, "records": segment,
+                            "offset": None, "aligned": False, "matches": 0})
+
+    def place(entry, offset, aligned, matches=0):
+        entry.update(offset=offset, aligned=aligned, matches=matches)
+        for stamp, event, _, arg in entry["records"]:
+            if event in (RX, TX_END):
+                placed[(event, arg)].append(stamp + offset)
+        done.append(entry)
+        pending.remove(entry)
+
+    def anchor(epoch, millis):
+        return (epoch - hour) * 1000 - millis
+
+    def rtc_anchor(entry):
+        dump = entry["dump"]
+        stamp, event, _, second = entry["records"][0]
+        if entry["index"] == 0:
+            return anchor(*dump["open"])
+        if event == WAKE and second != NO_TIME:
+            # The latest time at or before the close with that second of the hour
+            epoch = dump["epoch"]
+            return anchor(epoch - (epoch - second) % 3600, stamp)
+        return anchor(*dump["close"]) if entry["last"] else None
+
+    for entry in [entry for entry in pending if entry["dump"]["hwid"] == args.reference]:
+        place(entry, anchor(*entry["dump"]["open"]), True)
+
+    # Nodes that heard only each other are placed once one of them is
+    progress = True
+    while pending and progress:
+        progress = False
+        for entry in list(pending):
+            offset, matches = match_offset(entry["records"], placed, args.tolerance)
+            if offset is not None:
+                place(entry, offset, True, matches)
+                progress = True
+
+    # The rest, latest segment first, so an earlier one can lean on the one after it
+    for entry in sorted(pending, key=lambda entry: -entry["index"]):
+        offset = rtc_anchor(entry)
+        if offset is None:
+            later = [other for other in done if other["dump"] is entry["dump"] and other["index"] > entry["index"]]
+            offset = min(later, key=lambda other: other["index"])["offset"]
+        place(entry, offset, False)
+
+    return hour, done
+
+
+def device_name(hwid, reference):
+    return "basestation {}".format(hwid) if hwid == reference else "node {}".format(hwid)
+
+
+def chrome_events(hour, entries, args):
+    pid = hour // 3600
+    events = [{"ph": "M", "name": "process_name", "pid": pid,
+               "args": {"name": "round {}".format(time.strftime("%Y-%m-%d %H:00 UTC", time.gmtime(hour)))}}]
+    transmissions = defaultdict(list)
+    receptions = []
+
+    for hwid in sorted({entry["dump"]["hwid"] for entry in entries}):
+        dropped = sum(entry["dump"]["dropped"] for entry in entries if entry["dump"]["hwid"] == hwid and entry["index"] == 0)
+        name = device_name(hwid, args.reference) + (" ({} dropped)".format(dropped) if dropped else "")
+        events.append({"ph": "M", "name": "thread_name", "pid": pid, "tid": hwid, "args": {"name": name}})
+        events.append({"ph": "M", "name": "thread_sort_index", "pid": pid, "tid": hwid, "args": {"sort_index": -1 if hwid == args.reference else hwid}})
+
+    def us(ms):
+        return round(ms * 1000, 1)
+
+    for entry in entries:
+        hwid = entry["dump"]["hwid"]
+        offset = entry["offset"]
+        common = {"pid": pid, "tid": hwid}
+        segment = {"segment": entry["index"], "aligned": entry["aligned"], "matches": entry["matches"]}
+        open_tx = {}
+        open_backoff = None
+        open_request = None
+
+        def instant(name, stamp, extra):
+            events.append(dict(common, ph="i", s="t", name=name, ts=us(stamp + offset), args=dict(segment, **extra)))
+
+        def slice_(name, start, end, extra):
+            events.append(dict(common, ph="X", name=name, ts=us(start + offset), dur=us(max(end - start, 0)), args=dict(segment, **extra)))
+
+        for stamp, event, length, arg in entry["records"]:
+            frame = "0x{:04x}".format(arg)
+
+            if event in (TX_START, CSMA_INTERRUPT) and open_backoff is not None:
+                slice_("backoff", open_backoff[0], stamp, {"attempt": open_backoff[1], "timeout_ms": open_backoff[2]})
+                open_backoff = None
+
+            if event == RX:
+                start = stamp - airtime_ms(length, args)
+                slice_("RX", start, stamp, {"frame": frame, "bytes": length})
+                receptions.append((hwid, arg, stamp + offset))
+            elif event == TX_START:
+                open_tx[arg] = stamp
+            elif event == TX_END:
+                start = open_tx.pop(arg, stamp - airtime_ms(length, args))
+                slice_("TX", start, stamp, {"frame": frame, "bytes": length, "airtime_ms": round(airtime_ms(length, args), 1)})
+                transmissions[arg].append((hwid, start + offset, stamp + offset))
+            elif event == BACKOFF:
+                open_backoff = (stamp, length, arg)
+            elif event == CSMA_INTERRUPT:
+                instant("CSMA interrupted", stamp, {"attempt": length})
+            elif event == INVALID:
+                instant("invalid " + (FRAME_KINDS[length] if length < len(FRAME_KINDS) else str(length)), stamp, {"frame": frame})
+            elif event == MERGE:
+                instant("merge", stamp, {"filled": "{:#06x}".format(arg)})
+            elif event == SLEEP:
+                instant("sleep " + ("deep" if length == 0 else "light"), stamp, {})
+            elif event == WAKE:
+                instant("wake " + ("RTC" if length == 0 else "LoRa"), stamp, {} if arg == NO_TIME else {"rtc_second": arg})
+            elif event == REQUEST:
+                open_request = (stamp, length)
+            elif event == CLOSE:
+                start, index = open_request if open_request else (stamp, length)
+                name = HEADERS[index] if index < len(HEADERS) else str(index)
+                slice_("request " + name, start, stamp, {"reported": "{:#06x}".format(arg)})
+                open_request = None
+
+    # Each reception is linked to the closest transmission of the same bytes by another device
+    for flow, (hwid, frame, end) in enumerate(receptions):
+        senders = [sent for sent in transmissions[frame] if sent[0] != hwid]
+        if not senders:
+            continue
+        sender, start, sent_end = min(senders, key=lambda sent: abs(sent[2] - end))
+        if abs(sent_end - end) > args.tolerance:
+            continue
+        events.append({"ph": "s", "id": flow, "name": "frame", "cat": "radio", "pid": pid, "tid": sender, "ts": us(start)})
+        events.append({"ph": "f", "bp": "e", "id": flow, "name": "frame", "cat": "radio", "pid": pid, "tid": hwid, "ts": us(end)})
+
+    return events
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("files", nargs="+", help="Captures holding trace frames")
+    parser.add_argument("--output", "-o", default="trace.json")
+    parser.add_argument("--reference", type=int, default=8, help="hwid of the basestation, whose clock the others follow")
+    parser.add_argument("--tolerance", type=float, default=50, help="ms two ends of one frame may disagree by")
+    parser.add_argument("--sf", type=int, default=10, help="Spreading factor")
+    parser.add_argument("--bw", type=float, default=125000, help="Bandwidth in Hz")
+    parser.add_argument("--cr", type=int, default=1, help="Coding rate 4/(4+CR)")
+    parser.add_argument("--preamble", type=int, default=8, help="Preamble symbols")
+    parser.add_argument("--no-crc", dest="crc", action="store_false", help="Frames carry no payload CRC")
+    args = parser.parse_args()
+
+    rounds = defaultdict(list)
+    for path in args.files:
+        dumps = read_dumps(path)
+        if not dumps:
+            print("{}: no trace frames".format(path), file=sys.stderr)
+        for dump in dumps:
+            rounds[dump["epoch"] // 3600].append(dump)
+
+    events = []
+    for key in sorted(rounds):
+        hour, entries = align(rounds[key], args)
+        events += chrome_events(hour, entries, args)
+
+        aligned = sum(entry["aligned"] for entry in entries)
+        devices = ", ".join("{}:{}".format(dump["hwid"], len(dump["records"])) for dump in rounds[key])
+        print("{} UTC: {} segments, {} aligned, records {}".format(
+            time.strftime("%Y-%m-%d %H:00", time.gmtime(hour)), len(entries), aligned, devices), file=sys.stderr)
+
+    with open(args.output, "w") as file:
+        json.dump({"traceEvents": events, "displayTimeUnit": "ms"}, file)
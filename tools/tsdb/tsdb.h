@@ -0,0 +1,607 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// Time-series store for round data, one series per (network, HW ID, metric), header only
+//
+// Samples are compressed the way Gorilla (Pelkonen et al., VLDB 2015) does it:
+//	Timestamps	delta-of-delta, '0' for an unchanged interval, so hourly rounds cost one bit each
+//	Values		XOR against the previous value, '0' when equal, otherwise only the bits between the
+//				leading and trailing zeros, reusing the previous window when they fit in it
+//
+// Values are quantized to the series' precision first (hundredths, millivolts, like the upload
+// store) and stored as the float of that integer, 12.34 as 1234.0f. Integral floats end in a long
+// run of zero mantissa bits, so the XOR of two readings is a handful of meaningful bits instead of
+// the noise two decimal fractions give.
+//
+// File layout, little endian, append only:
+//	FILE_HEADER, then BLOCK_HEADER + bits for every sealed block
+//
+// A series fills an open block in memory and seals it to the file at BLOCK_SAMPLES samples, or on
+// flush() and close(). Sealed blocks never change. The file is memory mapped for reading and the
+// time index, each series' block list with its time bounds, is rebuilt from the block headers on
+// open. A torn block at the end, from a crash mid-write, fails its CRC and is cut off. Samples
+// still in open blocks at a crash are lost, the collector's CSV is the record they come back from.
+
+#ifndef tsdb_h
+#define tsdb_h
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define TSDB_MAGIC				0x42445354		// "TSDB"
+#define TSDB_BLOCK_MAGIC		0x4B4C4254		// "TBLK"
+#define TSDB_VERSION			1
+#define BLOCK_SAMPLES			1024			// Six weeks of hourly rounds
+
+// Round metrics, same order as the LoRa requests
+#define METRIC_TEMPERATURE		0
+#define METRIC_HUMIDITY			1
+#define METRIC_SOIL_TEMPERATURE	2
+#define METRIC_SOIL_MOISTURE	3
+#define METRIC_BATTERY			4
+#define METRICS					5
+
+static const char *const metricNames[METRICS] = { "temp", "humi", "stmp", "smoi", "batt" };
+static const uint8_t metricDecimals[METRICS] = { 2, 2, 2, 0, 3 };
+
+struct __attribute__((packed)) FILE_HEADER
+{
+	uint32_t magic;
+	uint32_t version;
+};
+
+struct __attribute__((packed)) BLOCK_HEADER
+{
+	uint32_t magic;
+	uint32_t series;
+	uint32_t minTime;
+	uint32_t maxTime;
+	uint16_t count;
+	uint8_t decimals;
+	uint8_t reserved;
+	uint32_t length;			// Bytes of bits after the header
+	float min;					// Real values, not scaled
+	float max;
+	double sum;
+	uint32_t crc;				// Over the header with this field at 0, then the bits
+};
+
+struct BLOCK_REF
+{
+	uint32_t minTime;
+	uint32_t maxTime;
+	uint64_t offset;			// Of the BLOCK_HEADER in the file
+};
+
+static inline uint32_t seriesId(uint16_t network, uint8_t hwid, uint8_t metric)
+{
+	return (uint32_t)network << 16 | hwid << 8 | metric;
+}
+
+static inline uint32_t crc32(uint32_t crc, const uint8_t *data, size_t length)
+{
+	static uint32_t table[256];
+
+	if (table[1] == 0)
+	{
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t value = i;
+			for (int bit = 0; bit < 8; bit++) value = value & 1 ? 0xEDB88320 ^ (value >> 1) : value >> 1;
+			table[i] = value;
+		}
+	}
+
+	crc = ~crc;
+	while (length--) crc = table[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+
+	return ~crc;
+}
+
+class BIT_WRITER
+{
+	private:
+		std::vector<uint8_t> _bytes;
+		uint64_t _bits = 0;
+
+	public:
+		// Up to 32 bits, most significant first
+		void write(uint32_t value, uint8_t count)
+		{
+			while (count > 0)
+			{
+				if (_bits % 8 == 0) _bytes.push_back(0);
+
+				uint8_t room = 8 - _bits % 8;
+				uint8_t take = std::min(room, count);
+				uint8_t chunk = (value >> (count - take)) & ((1U << take) - 1);
+
+				_bytes.back() |= chunk << (room - take);
+				_bits += take;
+				count -= take;
+			}
+		}
+
+		const std::vector<uint8_t> &bytes() const { return _bytes; }
+		uint64_t bits() const { return _bits; }
+		void clear() { _bytes.clear(); _bits = 0; }
+};
+
+class BIT_READER
+{
+	private:
+		const uint8_t *_data;
+		uint64_t _bit = 0;
+
+	public:
+		BIT_READER(const uint8_t *data) : _data(data) {}
+
+		uint32_t read(uint8_t count)
+		{
+			uint32_t value = 0;
+
+			while (count > 0)
+			{
+				uint8_t room = 8 - _bit % 8;
+				uint8_t take = std::min(room, count);
+				uint8_t chunk = (_data[_bit / 8] >> (room - take)) & ((1U << take) - 1);
+
+				value = value << take | chunk;
+				_bit += take;
+				count -= take;
+			}
+
+			return value;
+		}
+
+		bool bit() { return read(1); }
+};
+
+// Encoder for one block, also what an open block is kept in
+class BLOCK_ENCODER
+{
+	private:
+		BIT_WRITER _bits;
+		uint32_t _lastTime = 0;
+		int64_t _lastDelta = 0;
+		uint32_t _lastValue = 0;
+		uint8_t _leading = 0xFF;
+		uint8_t _trailing = 0;
+
+		void writeTime(uint32_t timestamp)
+		{
+			int64_t delta = (int64_t)timestamp - _lastTime;
+			int64_t dod = delta - _lastDelta;
+
+			if (dod == 0) _bits.write(0, 1);
+			else if (dod >= -64 && dod <= 63) { _bits.write(0b10, 2); _bits.write((uint32_t)dod & 0x7F, 7); }
+			else if (dod >= -256 && dod <= 255) { _bits.write(0b110, 3); _bits.write((uint32_t)dod & 0x1FF, 9); }
+			else if (dod >= -2048 && dod <= 2047) { _bits.write(0b1110, 4); _bits.write((uint32_t)dod & 0xFFF, 12); }
+			else { _bits.write(0b1111, 4); _bits.write((uint32_t)delta, 32); }
+
+			_lastDelta = delta;
+			_lastTime = timestamp;
+		}
+
+		void writeValue(uint32_t value)
+		{
+			uint32_t xored = value ^ _lastValue;
+			_lastValue = value;
+
+			if (xored == 0)
+			{
+				_bits.write(0, 1);
+				return;
+			}
+
+			uint8_t leading = std::min(__builtin_clz(xored), 31);
+			uint8_t trailing = __builtin_ctz(xored);
+
+			// Fits in the previous window, no need to say where it is again
+			if (_leading != 0xFF && leading >= _leading && trailing >= _trailing)
+			{
+				_bits.write(0b10, 2);
+				_bits.write(xored >> _trailing, 32 - _leading - _trailing);
+				return;
+			}
+
+			uint8_t meaningful = 32 - leading - trailing;
+			_bits.write(0b11, 2);
+			_bits.write(leading, 5);
+			_bits.write(meaningful - 1, 5);
+			_bits.write(xored >> trailing, meaningful);
+
+			_leading = leading;
+			_trailing = trailing;
+		}
+
+	public:
+		BLOCK_HEADER header = {};
+
+		void append(uint32_t timestamp, double value, uint8_t decimals)
+		{
+			float scaled = (float)llround(value * pow(10, decimals));
+			double quantized = scaled / pow(10, decimals);
+			uint32_t bits;
+			memcpy(&bits, &scaled, sizeof(bits));
+
+			if (header.count == 0)
+			{
+				header.decimals = decimals;
+				header.minTime = header.maxTime = timestamp;
+				header.min = header.max = quantized;
+
+				// First sample in full
+				_bits.write(timestamp, 32);
+				_bits.write(bits, 32);
+				_lastTime = timestamp;
+				_lastValue = bits;
+			}
+			else
+			{
+				writeTime(timestamp);
+				writeValue(bits);
+			}
+
+			header.count++;
+			header.minTime = std::min(header.minTime, timestamp);
+			header.maxTime = std::max(header.maxTime, timestamp);
+			header.min = std::min(header.min, (float)quantized);
+			header.max = std::max(header.max, (float)quantized);
+			header.sum += quantized;
+		}
+
+		const std::vector<uint8_t> &bytes() const { return _bits.bytes(); }
+
+		void clear()
+		{
+			_bits.clear();
+			_lastDelta = 0;
+			_leading = 0xFF;
+			_trailing = 0;
+			header = {};
+		}
+};
+
+// Calls sample(timestamp, value) for every sample of a block, in the order they were appended
+template <typename F>
+static inline void decodeBlock(const uint8_t *bits, uint16_t count, uint8_t decimals, F sample)
+{
+	BIT_READER reader(bits);
+	double scale = pow(10, -(int)decimals);
+	uint32_t timestamp = 0, value = 0;
+	int64_t delta = 0;
+	uint8_t leading = 0, trailing = 0;
+	float real;
+
+	for (uint16_t i = 0; i < count; i++)
+	{
+		if (i == 0)
+		{
+			timestamp = reader.read(32);
+			value = reader.read(32);
+		}
+		else
+		{
+			// Delta of delta, '0', '10', '110', '1110' or '1111' then the whole delta
+			int64_t dod = 0;
+
+			if (reader.bit())
+			{
+				if (!reader.bit()) dod = (int32_t)(reader.read(7) << 25) >> 25;
+				else if (!reader.bit()) dod = (int32_t)(reader.read(9) << 23) >> 23;
+				else if (!reader.bit()) dod = (int32_t)(reader.read(12) << 20) >> 20;
+				else
+				{
+					delta = (int32_t)reader.read(32);
+					dod = 0;
+				}
+			}
+
+			delta += dod;
+			timestamp += (uint32_t)delta;
+
+			if (reader.bit())
+			{
+				if (reader.bit())
+				{
+					leading = reader.read(5);
+					trailing = 32 - leading - (reader.read(5) + 1);
+				}
+				value ^= reader.read(32 - leading - trailing) << trailing;
+			}
+		}
+
+		memcpy(&real, &value, sizeof(real));
+		sample(timestamp, real * scale);
+	}
+}
+
+class TSDB_class
+{
+	private:
+		int _fd = -1;
+		const uint8_t *_map = nullptr;
+		uint64_t _mapped = 0;
+		uint64_t _size = 0;
+
+		std::unordered_map<uint32_t, std::vector<BLOCK_REF>> _index;
+		std::unordered_map<uint32_t, BLOCK_ENCODER> _open;
+
+		void remap()
+		{
+			if (_mapped == _size) return;
+			if (_map != nullptr) munmap((void*)_map, _mapped);
+
+			_map = _size > 0 ? (const uint8_t*)mmap(NULL, _size, PROT_READ, MAP_SHARED, _fd, 0) : nullptr;
+			_mapped = _map == MAP_FAILED ? 0 : _size;
+			if (_map == MAP_FAILED) _map = nullptr;
+		}
+
+		void seal(uint32_t series, BLOCK_ENCODER &block)
+		{
+			if (block.header.count == 0) return;
+
+			std::vector<uint8_t> record(sizeof(BLOCK_HEADER));
+			BLOCK_HEADER &header = block.header;
+
+			header.magic = TSDB_BLOCK_MAGIC;
+			header.series = series;
+			header.length = block.bytes().size();
+			header.crc = 0;
+			header.crc = crc32(crc32(0, (const uint8_t*)&header, sizeof(header)), block.bytes().data(), header.length);
+
+			memcpy(record.data(), &header, sizeof(header));
+			record.insert(record.end(), block.bytes().begin(), block.bytes().end());
+
+			if (pwrite(_fd, record.data(), record.size(), _size) == (ssize_t)record.size())
+			{
+				_index[series].push_back({ header.minTime, header.maxTime, _size });
+				_size += record.size();
+			}
+
+			block.clear();
+		}
+
+	public:
+		~TSDB_class() { close(); }
+
+		// Opens or creates, and rebuilds the time index from the block headers
+		bool open(const std::string &path)
+		{
+			FILE_HEADER fileHeader = { TSDB_MAGIC, TSDB_VERSION };
+			struct stat info;
+
+			_fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+			if (_fd < 0 || fstat(_fd, &info) < 0) return false;
+
+			_size = info.st_size;
+			if (_size == 0)
+			{
+				if (pwrite(_fd, &fileHeader, sizeof(fileHeader), 0) != sizeof(fileHeader)) return false;
+				_size = sizeof(fileHeader);
+			}
+
+			remap();
+			if (_map == nullptr || memcmp(_map, &fileHeader, sizeof(fileHeader)) != 0) return false;
+
+			uint64_t at = sizeof(FILE_HEADER);
+			while (at + sizeof(BLOCK_HEADER) <= _size)
+			{
+				BLOCK_HEADER header;
+				memcpy(&header, _map + at, sizeof(header));
+
+				uint32_t crc = header.crc;
+				header.crc = 0;
+				if (header.magic != TSDB_BLOCK_MAGIC || at + sizeof(header) + header.length > _size) break;
+				if (crc32(crc32(0, (const uint8_t*)&header, sizeof(header)), _map + at + sizeof(header), header.length) != crc) break;
+
+				_index[header.series].push_back({ header.minTime, header.maxTime, at });
+				at += sizeof(header) + header.length;
+			}
+
+			// Torn tail from a crash mid-write
+			if (at != _size)
+			{
+				if (ftruncate(_fd, at) < 0) return false;
+				_size = at;
+				remap();
+			}
+
+			return true;
+		}
+
+		void close()
+		{
+			if (_fd < 0) return;
+
+			flush();
+			if (_map != nullptr) munmap((void*)_map, _mapped);
+			::close(_fd);
+
+			_fd = -1;
+			_map = nullptr;
+			_mapped = 0;
+			_index.clear();
+		}
+
+		void append(uint32_t series, uint32_t timestamp, double value, uint8_t decimals)
+		{
+			BLOCK_ENCODER &block = _open[series];
+
+			// A change of precision starts a new block, a block has one scale
+			if (block.header.count > 0 && block.header.decimals != decimals) seal(series, block);
+
+			block.append(timestamp, value, decimals);
+			if (block.header.count == BLOCK_SAMPLES) seal(series, block);
+		}
+
+		// Seals every open block, they are on disk once this returns
+		void flush()
+		{
+			for (auto &open : _open) seal(open.first, open.second);
+			_open.clear();
+			fdatasync(_fd);
+		}
+
+		// Every sample with from <= timestamp <= to, block by block, in append order within a series
+		template <typename F>
+		size_t scan(uint32_t series, uint32_t from, uint32_t to, F sample)
+		{
+			size_t count = 0;
+			auto filter = [&](uint32_t timestamp, double value)
+			{
+				if (timestamp < from || timestamp > to) return;
+				sample(timestamp, value);
+				count++;
+			};
+
+			remap();
+
+			auto found = _index.find(series);
+			if (found != _index.end())
+			{
+				for (const BLOCK_REF &block : found->second)
+				{
+					if (block.maxTime < from || block.minTime > to) continue;
+
+					const BLOCK_HEADER *header = (const BLOCK_HEADER*)(_map + block.offset);
+					decodeBlock(_map + block.offset + sizeof(BLOCK_HEADER), header->count, header->decimals, filter);
+				}
+			}
+
+			auto open = _open.find(series);
+			if (open != _open.end() && open->second.header.count > 0 && open->second.header.maxTime >= from && open->second.header.minTime <= to)
+			{
+				decodeBlock(open->second.bytes().data(), open->second.header.count, open->second.header.decimals, filter);
+			}
+
+			return count;
+		}
+
+		// min, max and mean per bucket of the given length, calls bucket(start, min, max, mean, count) in time order.
+		// Blocks wholly inside one bucket and the range come from their header without being decoded.
+		template <typename F>
+		void rollup(uint32_t series, uint32_t from, uint32_t to, uint32_t length, F bucket)
+		{
+			struct AGGREGATE { double min = INFINITY, max = -INFINITY, sum = 0; size_t count = 0; };
+			uint32_t first = UINT32_MAX, last = 0;
+
+			// Only as many buckets as the series has data for, an open ended range is common
+			auto indexed = _index.find(series);
+			if (indexed != _index.end())
+			{
+				for (const BLOCK_REF &block : indexed->second) { first = std::min(first, block.minTime); last = std::max(last, block.maxTime); }
+			}
+			auto head = _open.find(series);
+			if (head != _open.end() && head->second.header.count > 0)
+			{
+				first = std::min(first, head->second.header.minTime);
+				last = std::max(last, head->second.header.maxTime);
+			}
+			if (from > to || first > last || first > to || last < from) return;
+			if (first > from) from += (first - from) / length * length;
+			to = std::min(to, last);
+
+			std::vector<AGGREGATE> buckets((to - from) / length + 1);
+
+			auto add = [&](uint32_t timestamp, double value)
+			{
+				AGGREGATE &aggregate = buckets[(timestamp - from) / length];
+				aggregate.min = std::min(aggregate.min, value);
+				aggregate.max = std::max(aggregate.max, value);
+				aggregate.sum += value;
+				aggregate.count++;
+			};
+
+			remap();
+
+			auto found = _index.find(series);
+			if (found != _index.end())
+			{
+				for (const BLOCK_REF &block : found->second)
+				{
+					if (block.maxTime < from || block.minTime > to) continue;
+
+					const BLOCK_HEADER *header = (const BLOCK_HEADER*)(_map + block.offset);
+
+					if (block.minTime >= from && block.maxTime <= to && (block.minTime - from) / length == (block.maxTime - from) / length)
+					{
+						AGGREGATE &aggregate = buckets[(block.minTime - from) / length];
+						aggregate.min = std::min(aggregate.min, (double)header->min);
+						aggregate.max = std::max(aggregate.max, (double)header->max);
+						aggregate.sum += header->sum;
+						aggregate.count += header->count;
+						continue;
+					}
+
+					decodeBlock(_map + block.offset + sizeof(BLOCK_HEADER), header->count, header->decimals, [&](uint32_t timestamp, double value)
+					{
+						if (timestamp >= from && timestamp <= to) add(timestamp, value);
+					});
+				}
+			}
+
+			auto open = _open.find(series);
+			if (open != _open.end() && open->second.header.count > 0)
+			{
+				decodeBlock(open->second.bytes().data(), open->second.header.count, open->second.header.decimals, [&](uint32_t timestamp, double value)
+				{
+					if (timestamp >= from && timestamp <= to) add(timestamp, value);
+				});
+			}
+
+			for (size_t i = 0; i < buckets.size(); i++)
+			{
+				if (buckets[i].count > 0) bucket(from + i * length, buckets[i].min, buckets[i].max, buckets[i].sum / buckets[i].count, buckets[i].count);
+			}
+		}
+
+		std::vector<uint32_t> series()
+		{
+			std::vector<uint32_t> ids;
+
+			for (auto &entry : _index) ids.push_back(entry.first);
+			for (auto &entry : _open)
+			{
+				if (entry.second.header.count > 0 && _index.find(entry.first) == _index.end()) ids.push_back(entry.first);
+			}
+			std::sort(ids.begin(), ids.end());
+
+			return ids;
+		}
+
+		uint64_t fileSize() { return _size; }
+		size_t blocks() { size_t count = 0; for (auto &entry : _index) count += entry.second.size(); return count; }
+};
+
+#endif
@@ -0,0 +1,193 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// Benchmark for tsdb.h, synthetic turf roof sensors logged every hour for years
+//
+// Build:	g++ -std=c++17 -O2 -Wall -o tsdb_bench tsdb_bench.cpp
+// Usage:	./tsdb_bench [-b 75] [-d 4] [-y 3] [-l 1] [-f bench.tsdb] [-q 1000]
+//
+//	-b	Basestations					-d	Devices per basestation
+//	-y	Years of hourly rounds			-l	Percent of rounds lost, they leave gaps in the timestamps
+//	-f	File, recreated					-q	Random range queries to time
+//
+// Rounds are appended time major, every node's metrics for one hour then the next hour, which is
+// the order the collector sees them in. Reports ingest rate, bytes per sample against the 8 a raw
+// timestamp and float take, open time, full scan throughput and query latencies.
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+#include "tsdb.h"
+
+#define ROUND_INTERVAL_S		3600
+#define START_TIME				1640995200		// 2022-01-01T00:00:00Z
+#define DAY_S					86400
+#define MONTH_S					(30 * DAY_S)
+#define YEAR_S					(365 * DAY_S)
+
+struct NODE
+{
+	double temperature;
+	double soilTemperature;
+	double humidity;
+	double moisture;
+	double battery;
+};
+
+static double seconds(std::chrono::steady_clock::time_point since)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+}
+
+int main(int argc, char **argv)
+{
+	unsigned basestations = 75, devices = 4, years = 3, queries = 1000;
+	double loss = 1;
+	std::string path = "bench.tsdb";
+	int opt;
+
+	while ((opt = getopt(argc, argv, "b:d:y:l:f:q:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'b': basestations = atoi(optarg); break;
+			case 'd': devices = atoi(optarg); break;
+			case 'y': years = atoi(optarg); break;
+			case 'l': loss = atof(optarg); break;
+			case 'f': path = optarg; break;
+			case 'q': queries = atoi(optarg); break;
+
+			default:
+				fprintf(stderr, "Usage: %s [-b basestations] [-d devices] [-y years] [-l loss %%] [-f file] [-q queries]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	std::mt19937 random(1);
+	std::normal_distribution<double> noise(0, 1);
+	std::uniform_real_distribution<double> uniform(0, 100);
+	std::vector<NODE> nodes(basestations * devices);
+	uint32_t rounds = years * YEAR_S / ROUND_INTERVAL_S;
+	uint64_t samples = 0;
+
+	for (NODE &node : nodes) node = { 5, 5, 80, 40, 4.1 };
+
+	unlink(path.c_str());
+	TSDB_class store;
+	if (!store.open(path))
+	{
+		perror(path.c_str());
+		return 1;
+	}
+
+	auto started = std::chrono::steady_clock::now();
+
+	for (uint32_t round = 0; round < rounds; round++)
+	{
+		uint32_t timestamp = START_TIME + round * ROUND_INTERVAL_S;
+		double season = -8 * cos(2 * M_PI * round * ROUND_INTERVAL_S / YEAR_S);
+		double day = -3 * cos(2 * M_PI * (round % 24) / 24);
+
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			NODE &node = nodes[i];
+
+			// Slow drift towards the weather, with sensor noise on top
+			node.temperature += (4 + season + day - node.temperature) * 0.3 + noise(random) * 0.4;
+			node.soilTemperature += (4 + season - node.soilTemperature) * 0.05 + noise(random) * 0.05;
+			node.humidity = std::min(100.0, std::max(20.0, node.humidity + noise(random) * 1.5));
+			node.moisture = std::min(100.0, std::max(0.0, node.moisture + (uniform(random) < 5 ? 10 : -0.1)));
+			node.battery = node.battery < 3.6 ? 4.2 : node.battery - 0.0004 + noise(random) * 0.002;
+
+			if (uniform(random) < loss) continue;
+
+			uint16_t network = i / devices + 1;
+			uint8_t hwid = i % devices * 2 + 1;
+			double values[METRICS] = { node.temperature, node.humidity, node.soilTemperature, std::round(node.moisture), node.battery };
+
+			for (uint8_t metric = 0; metric < METRICS; metric++)
+			{
+				store.append(seriesId(network, hwid, metric), timestamp, values[metric], metricDecimals[metric]);
+			}
+			samples += METRICS;
+		}
+	}
+	store.flush();
+
+	double ingest = seconds(started);
+	uint64_t size = store.fileSize();
+	store.close();
+
+	printf("%zu nodes, %u years hourly: %lu samples\n", nodes.size(), years, (unsigned long)samples);
+	printf("ingest   %.2f s, %.1f M samples/s\n", ingest, samples / ingest / 1e6);
+	printf("file     %.2f MB, %.3f bytes/sample (raw 8), %.1fx\n", size / 1e6, (double)size / samples, 8.0 * samples / size);
+
+	started = std::chrono::steady_clock::now();
+	if (!store.open(path)) return 1;
+	printf("open     %.2f ms, %zu blocks in %zu series\n", seconds(started) * 1000, store.blocks(), store.series().size());
+
+	std::vector<uint32_t> series = store.series();
+	uint32_t end = START_TIME + rounds * ROUND_INTERVAL_S;
+	uint64_t scanned = 0;
+	double sum = 0;
+
+	started = std::chrono::steady_clock::now();
+	for (uint32_t id : series) scanned += store.scan(id, 0, UINT32_MAX, [&](uint32_t, double value) { sum += value; });
+	double full = seconds(started);
+	printf("scan     all %lu samples in %.2f s, %.1f M samples/s\n", (unsigned long)scanned, full, scanned / full / 1e6);
+
+	std::uniform_int_distribution<size_t> pick(0, series.size() - 1);
+	std::uniform_int_distribution<uint32_t> when(START_TIME, end - MONTH_S);
+	scanned = 0;
+
+	started = std::chrono::steady_clock::now();
+	for (unsigned i = 0; i < queries; i++)
+	{
+		uint32_t from = when(random);
+		scanned += store.scan(series[pick(random)], from, from + MONTH_S, [&](uint32_t, double value) { sum += value; });
+	}
+	printf("month    %.3f ms per query, %lu samples each\n", seconds(started) * 1000 / queries, (unsigned long)(scanned / std::max(1U, queries)));
+
+	size_t buckets = 0;
+	started = std::chrono::steady_clock::now();
+	for (unsigned i = 0; i < queries; i++)
+	{
+		store.rollup(series[pick(random)], end - YEAR_S, end, DAY_S, [&](uint32_t, double, double, double mean, size_t) { sum += mean; buckets++; });
+	}
+	printf("daily    %.3f ms per year of daily min/max/mean, %zu days each\n", seconds(started) * 1000 / queries, buckets / std::max(1U, queries));
+
+	buckets = 0;
+	started = std::chrono::steady_clock::now();
+	for (unsigned i = 0; i < queries; i++)
+	{
+		store.rollup(series[pick(random)], START_TIME, end, YEAR_S, [&](uint32_t, double, double, double mean, size_t) { sum += mean; buckets++; });
+	}
+	printf("yearly   %.3f ms per series of yearly min/max/mean, %zu years each\n", seconds(started) * 1000 / queries, buckets / std::max(1U, queries));
+
+	// Keeps the sums from being optimized away
+	if (sum == 0.123) printf("\n");
+
+	return 0;
+}
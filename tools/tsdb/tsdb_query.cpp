@@ -0,0 +1,220 @@
+/*
+	============================================================
+	Master's Thesis in Electrical and Computer Engineering
+	Faculty of Electrical and Computer Engineering
+	School of Engineering and Natural Sciences, University of Iceland
+
+	Title: Design and Implementation of a Low-Power LoRa Mesh Sensor Network 
+				 for Monitoring Soil Conditions on Icelandic Turf Roofs
+
+	Researcher: Jezreel Tan
+	Email: jvt6@hi.is
+
+	Supervisors:
+	Helgi Þorbergsson
+	Email: thorberg@hi.is
+
+	Dórótea Höeg Sigurðardóttir
+	Email: dorotea@hi.is
+
+	============================================================
+*/
+
+// Command line for tsdb.h files: list series, range scans, rollups, and imports of collector CSV
+//
+// Build:	g++ -std=c++17 -O2 -Wall -o tsdb_query tsdb_query.cpp
+// Usage:	./tsdb_query <file.tsdb>... list
+//			./tsdb_query <file.tsdb>... scan <network> <hwid> <metric> [from] [to]
+//			./tsdb_query <file.tsdb>... rollup <network> <hwid> <metric> hour|day|week|<seconds> [from] [to]
+//			./tsdb_query <file.tsdb> import <rounds.csv>...
+//
+// Metrics are temp, humi, stmp, smoi or batt. Times are 2024-05-01, 2024-05-01T12:00:00Z or
+// seconds since the epoch, UTC. collectord -d shards by network, pass every worker's file and the
+// series is found in whichever has it. Importing a collector CSV into an empty file rebuilds a
+// store from the record collectord keeps anyway; predicted values are left out as they are there.
+
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+
+#include "tsdb.h"
+
+#define PREDICTED_COLUMN		8
+
+static bool parseTime(const std::string &text, uint32_t &timestamp)
+{
+	struct tm timeInfo = {};
+	const char *end;
+
+	if (text.find('-') == std::string::npos)
+	{
+		char *last;
+		timestamp = strtoul(text.c_str(), &last, 10);
+		return *last == '\0';
+	}
+
+	end = strptime(text.c_str(), "%Y-%m-%dT%H:%M:%S", &timeInfo);
+	if (end == nullptr) end = strptime(text.c_str(), "%Y-%m-%d", &timeInfo);
+	if (end == nullptr || (*end != '\0' && strcmp(end, "Z") != 0)) return false;
+
+	timestamp = timegm(&timeInfo);
+	return true;
+}
+
+static void formatTime(uint32_t timestamp, char *when)
+{
+	time_t t = timestamp;
+	struct tm timeInfo;
+
+	gmtime_r(&t, &timeInfo);
+	strftime(when, 21, "%Y-%m-%dT%H:%M:%SZ", &timeInfo);
+}
+
+static bool parseSeries(char **argv, uint32_t &series, uint8_t &metric)
+{
+	for (metric = 0; metric < METRICS; metric++)
+	{
+		if (strcmp(argv[2], metricNames[metric]) == 0) break;
+	}
+	if (metric == METRICS) return false;
+
+	series = seriesId(atoi(argv[0]), atoi(argv[1]), metric);
+	return true;
+}
+
+static bool parseRange(int argc, char **argv, int at, uint32_t &from, uint32_t &to)
+{
+	from = 0;
+	to = UINT32_MAX;
+
+	if (argc > at && !parseTime(argv[at], from)) return false;
+	if (argc > at + 1 && !parseTime(argv[at + 1], to)) return false;
+
+	return true;
+}
+
+// time,network,hwid,temperature,humidity,soil_temperature,soil_moisture,battery,predicted
+static size_t import(TSDB_class &store, const char *path)
+{
+	std::ifstream file(path);
+	std::string line;
+	size_t samples = 0;
+
+	while (std::getline(file, line))
+	{
+		std::stringstream fields(line);
+		std::string field;
+		std::vector<std::string> columns;
+		uint32_t timestamp;
+
+		while (std::getline(fields, field, ',')) columns.push_back(field);
+		if (columns.size() <= PREDICTED_COLUMN || !parseTime(columns[0], timestamp)) continue;
+
+		uint16_t network = atoi(columns[1].c_str());
+		uint8_t hwid = atoi(columns[2].c_str());
+		uint8_t predicted = atoi(columns[PREDICTED_COLUMN].c_str());
+
+		for (uint8_t metric = 0; metric < METRICS; metric++)
+		{
+			if (predicted & (1 << metric)) continue;
+			store.append(seriesId(network, hwid, metric), timestamp, atof(columns[3 + metric].c_str()), metricDecimals[metric]);
+			samples++;
+		}
+	}
+
+	return samples;
+}
+
+static int usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s <file.tsdb>... list\n", name);
+	fprintf(stderr, "       %s <file.tsdb>... scan <network> <hwid> <metric> [from] [to]\n", name);
+	fprintf(stderr, "       %s <file.tsdb>... rollup <network> <hwid> <metric> hour|day|week|<seconds> [from] [to]\n", name);
+	fprintf(stderr, "       %s <file.tsdb> import <rounds.csv>...\n", name);
+	return 1;
+}
+
+int main(int argc, char **argv)
+{
+	std::vector<TSDB_class*> stores;
+	int at = 1;
+
+	for (; at < argc && strstr(argv[at], ".tsdb") != nullptr; at++)
+	{
+		TSDB_class *store = new TSDB_class();
+		if (!store->open(argv[at]))
+		{
+			perror(argv[at]);
+			return 1;
+		}
+		stores.push_back(store);
+	}
+	if (stores.empty() || at >= argc) return usage(argv[0]);
+
+	std::string command = argv[at++];
+	int rest = argc - at;
+	char **args = argv + at;
+	uint32_t series, from, to;
+	uint8_t metric;
+	char when[21];
+
+	if (command == "list")
+	{
+		for (TSDB_class *store : stores)
+		{
+			for (uint32_t id : store->series())
+			{
+				size_t samples = store->scan(id, 0, UINT32_MAX, [](uint32_t, double) {});
+				printf("%u %u %s %zu\n", id >> 16, id >> 8 & 0xFF, metricNames[id & 0xFF], samples);
+			}
+		}
+	}
+	else if (command == "scan")
+	{
+		if (rest < 3 || !parseSeries(args, series, metric) || !parseRange(rest, args, 3, from, to)) return usage(argv[0]);
+
+		for (TSDB_class *store : stores)
+		{
+			store->scan(series, from, to, [&](uint32_t timestamp, double value)
+			{
+				formatTime(timestamp, when);
+				printf("%s,%.*f\n", when, metricDecimals[metric], value);
+			});
+		}
+	}
+	else if (command == "rollup")
+	{
+		if (rest < 4 || !parseSeries(args, series, metric) || !parseRange(rest, args, 4, from, to)) return usage(argv[0]);
+
+		std::string bucket = args[3];
+		uint32_t length = bucket == "hour" ? 3600 : bucket == "day" ? 86400 : bucket == "week" ? 604800 : atoi(args[3]);
+		if (length == 0) return usage(argv[0]);
+
+		// Buckets start at midnight UTC, or whatever multiple of their length the range starts on
+		from -= from % length;
+
+		printf("time,min,max,mean,count\n");
+		for (TSDB_class *store : stores)
+		{
+			store->rollup(series, from, to, length, [&](uint32_t start, double min, double max, double mean, size_t count)
+			{
+				formatTime(start, when);
+				printf("%s,%.*f,%.*f,%.*f,%zu\n", when, metricDecimals[metric], min, metricDecimals[metric], max, metricDecimals[metric] + 1, mean, count);
+			});
+		}
+	}
+	else if (command == "import" && stores.size() == 1)
+	{
+		size_t samples = 0;
+
+		for (int i = 0; i < rest; i++) samples += import(*stores[0], args[i]);
+		stores[0]->flush();
+		fprintf(stderr, "%zu samples, %.3f bytes/sample\n", samples, samples ? (double)stores[0]->fileSize() / samples : 0);
+	}
+	else return usage(argv[0]);
+
+	for (TSDB_class *store : stores) delete store;
+
+	return 0;
+}